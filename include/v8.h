@@ -3733,11 +3733,16 @@ class V8EXPORT ResourceConstraints {
   uint32_t* stack_limit() const { return stack_limit_; }
   // Sets an address beyond which the VM's stack may not grow.
   void set_stack_limit(uint32_t* value) { stack_limit_ = value; }
+  int scavenge_pause_target() const { return scavenge_pause_target_; }
+  // Sets the time in milliseconds a young generation collection should not
+  // exceed.  The young generation is resized to meet it.
+  void set_scavenge_pause_target(int value) { scavenge_pause_target_ = value; }
  private:
   int max_young_space_size_;
   int max_old_space_size_;
   int max_executable_size_;
   uint32_t* stack_limit_;
+  int scavenge_pause_target_;
 };
 
 
@@ -3852,6 +3857,13 @@ typedef void (*GCEpilogueCallback)(GCType type, GCCallbackFlags flags);
 
 typedef void (*GCCallback)();
 
+/**
+ * Reports one step of the memory reducer: the bytes of heap memory that it
+ * gave back and the bytes that the heap still holds.
+ */
+typedef void (*MemoryReducerCallback)(size_t released_bytes,
+                                      size_t committed_bytes);
+
 
 /**
  * Collection of V8 heap information.
@@ -3867,6 +3879,10 @@ class V8EXPORT HeapStatistics {
   size_t total_physical_size() { return total_physical_size_; }
   size_t used_heap_size() { return used_heap_size_; }
   size_t heap_size_limit() { return heap_size_limit_; }
+  // Bytes of freed pages kept mapped for reuse by the heap.
+  size_t pooled_page_size() { return pooled_page_size_; }
+  // Number of pages that were taken from that pool.
+  size_t page_pool_hits() { return page_pool_hits_; }
 
  private:
   size_t total_heap_size_;
@@ -3874,6 +3890,8 @@ class V8EXPORT HeapStatistics {
   size_t total_physical_size_;
   size_t used_heap_size_;
   size_t heap_size_limit_;
+  size_t pooled_page_size_;
+  size_t page_pool_hits_;
 
   friend class V8;
   friend class Isolate;
@@ -4675,6 +4693,31 @@ class V8EXPORT V8 {
    */
   static bool IdleNotification(int hint = 1000);
 
+  /**
+   * Like IdleNotification, but the embedder states how long it expects to
+   * stay idle.  V8 only starts GC work that it estimates, from the speed of
+   * recent collections, to finish within idle_time_in_ms milliseconds.
+   * This makes the notification suitable for the gaps between tasks of an
+   * event loop.  Returns true if the embedder should stop calling the
+   * function until real work has been done.
+   */
+  static bool IdleNotificationDeadline(int idle_time_in_ms);
+
+  /**
+   * Optional periodic notification, about once a second, for isolates that
+   * may stop running script for a long time, e.g. those of background tabs.
+   * Once the allocation rate has stayed low for a few seconds, V8 runs a
+   * few compacting garbage collections, releases the freed pages and shrinks
+   * the new space to its minimum.  Returns true if there is nothing left to
+   * reduce until the isolate has allocated again.
+   */
+  static bool MemoryReducerNotification();
+
+  /**
+   * Sets the callback that reports each step of the memory reducer.
+   */
+  static void SetMemoryReducerCallback(MemoryReducerCallback callback);
+
   /**
    * Optional notification that the system is running low on memory.
    * V8 uses these notifications to attempt to free memory.
@@ -5393,7 +5436,7 @@ class Internals {
   static const int kNodeIsIndependentShift = 4;
   static const int kNodeIsPartiallyDependentShift = 5;
 
-  static const int kJSObjectType = 0xb0;
+  static const int kJSObjectType = 0xb1;
   static const int kFirstNonstringType = 0x80;
   static const int kOddballType = 0x83;
   static const int kForeignType = 0x88;
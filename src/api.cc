@@ -616,7 +616,8 @@ ResourceConstraints::ResourceConstraints()
   : max_young_space_size_(0),
     max_old_space_size_(0),
     max_executable_size_(0),
-    stack_limit_(NULL) { }
+    stack_limit_(NULL),
+    scavenge_pause_target_(0) { }
 
 
 bool SetResourceConstraints(ResourceConstraints* constraints) {
@@ -637,6 +638,10 @@ bool SetResourceConstraints(ResourceConstraints* constraints) {
     uintptr_t limit = reinterpret_cast<uintptr_t>(constraints->stack_limit());
     isolate->stack_guard()->SetStackLimit(limit);
   }
+  if (constraints->scavenge_pause_target() > 0) {
+    isolate->heap()->set_scavenge_pause_target(
+        constraints->scavenge_pause_target());
+  }
   return true;
 }
 
@@ -5328,7 +5333,9 @@ HeapStatistics::HeapStatistics(): total_heap_size_(0),
                                   total_heap_size_executable_(0),
                                   total_physical_size_(0),
                                   used_heap_size_(0),
-                                  heap_size_limit_(0) { }
+                                  heap_size_limit_(0),
+                                  pooled_page_size_(0),
+                                  page_pool_hits_(0) { }
 
 
 void v8::V8::GetHeapStatistics(HeapStatistics* heap_statistics) {
@@ -5340,6 +5347,8 @@ void v8::V8::GetHeapStatistics(HeapStatistics* heap_statistics) {
     heap_statistics->total_physical_size_ = 0;
     heap_statistics->used_heap_size_ = 0;
     heap_statistics->heap_size_limit_ = 0;
+    heap_statistics->pooled_page_size_ = 0;
+    heap_statistics->page_pool_hits_ = 0;
     return;
   }
   Isolate* ext_isolate = reinterpret_cast<Isolate*>(isolate);
@@ -5405,6 +5414,27 @@ bool v8::V8::IdleNotification(int hint) {
 }
 
 
+bool v8::V8::IdleNotificationDeadline(int idle_time_in_ms) {
+  i::Isolate* isolate = i::Isolate::Current();
+  if (isolate == NULL || !isolate->IsInitialized()) return true;
+  return i::V8::IdleNotificationDeadline(idle_time_in_ms);
+}
+
+
+bool v8::V8::MemoryReducerNotification() {
+  i::Isolate* isolate = i::Isolate::Current();
+  if (isolate == NULL || !isolate->IsInitialized()) return true;
+  return isolate->heap()->MemoryReducerNotification();
+}
+
+
+void v8::V8::SetMemoryReducerCallback(MemoryReducerCallback callback) {
+  i::Isolate* isolate = i::Isolate::Current();
+  if (IsDeadCheck(isolate, "v8::V8::SetMemoryReducerCallback()")) return;
+  isolate->heap()->SetMemoryReducerCallback(callback);
+}
+
+
 void v8::V8::LowMemoryNotification() {
   i::Isolate* isolate = i::Isolate::Current();
   if (isolate == NULL || !isolate->IsInitialized()) return;
@@ -6923,6 +6953,8 @@ void Isolate::GetHeapStatistics(HeapStatistics* heap_statistics) {
     heap_statistics->total_physical_size_ = 0;
     heap_statistics->used_heap_size_ = 0;
     heap_statistics->heap_size_limit_ = 0;
+    heap_statistics->pooled_page_size_ = 0;
+    heap_statistics->page_pool_hits_ = 0;
     return;
   }
   i::Heap* heap = isolate->heap();
@@ -6932,6 +6964,9 @@ void Isolate::GetHeapStatistics(HeapStatistics* heap_statistics) {
   heap_statistics->total_physical_size_ = heap->CommittedPhysicalMemory();
   heap_statistics->used_heap_size_ = heap->SizeOfObjects();
   heap_statistics->heap_size_limit_ = heap->MaxReserved();
+  i::MemoryAllocator* allocator = isolate->memory_allocator();
+  heap_statistics->pooled_page_size_ = allocator->PoolSize();
+  heap_statistics->page_pool_hits_ = allocator->pool_hits();
 }
 
 
@@ -295,6 +295,10 @@ class SmallMapList {
     list_.Add(handle.location(), zone);
   }
 
+  void Remove(Handle<Map> handle) {
+    list_.RemoveElement(handle.location());
+  }
+
   Handle<Map> at(int i) const {
     return Handle<Map>(list_.at(i));
   }
@@ -352,6 +352,16 @@ static FixedArrayBase* LeftTrimFixedArray(Heap* heap,
 }
 
 
+// Moving the start of an object is not safe while the marking threads may
+// still hold pointers to the old start, and it is never possible in large
+// object space.
+static bool CanLeftTrimFixedArray(Heap* heap, FixedArrayBase* elms) {
+  if (heap->lo_space()->Contains(elms)) return false;
+  return heap->concurrent_marking() == NULL ||
+      !heap->incremental_marking()->IsMarking();
+}
+
+
 static bool ArrayPrototypeHasNoElements(Heap* heap,
                                         Context* native_context,
                                         JSObject* array_proto) {
@@ -630,7 +640,7 @@ BUILTIN(ArrayShift) {
     first = heap->undefined_value();
   }
 
-  if (!heap->lo_space()->Contains(elms_obj)) {
+  if (CanLeftTrimFixedArray(heap, elms_obj)) {
     array->set_elements(LeftTrimFixedArray(heap, elms_obj, 1));
   } else {
     // Shift the elements.
@@ -955,7 +965,7 @@ BUILTIN(ArraySplice) {
   bool elms_changed = false;
   if (item_count < actual_delete_count) {
     // Shrink the array.
-    const bool trim_array = !heap->lo_space()->Contains(elms_obj) &&
+    const bool trim_array = CanLeftTrimFixedArray(heap, elms_obj) &&
       ((actual_start + item_count) <
           (len - actual_delete_count - actual_start));
     if (trim_array) {
@@ -0,0 +1,396 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "v8.h"
+
+#include "concurrent-marking.h"
+
+#include "incremental-marking.h"
+#include "isolate.h"
+#include "mark-compact-inl.h"
+#include "marking-thread.h"
+
+namespace v8 {
+namespace internal {
+
+ConcurrentMarkingTask::ConcurrentMarkingTask(ConcurrentMarking* marking,
+                                             Heap* heap)
+    : marking_(marking),
+      heap_(heap),
+      push_segment_(new MarkingSegment()),
+      pop_segment_(new MarkingSegment()),
+      hand_off_segment_(new MarkingSegment()),
+      recorded_slots_(0) {
+}
+
+
+ConcurrentMarkingTask::~ConcurrentMarkingTask() {
+  delete push_segment_;
+  delete pop_segment_;
+  delete hand_off_segment_;
+}
+
+
+void ConcurrentMarkingTask::Push(HeapObject* object) {
+  if (push_segment_->IsFull()) {
+    marking_->PublishSegment(push_segment_);
+    push_segment_ = new MarkingSegment();
+  }
+  push_segment_->objects[push_segment_->size++] = object;
+}
+
+
+bool ConcurrentMarkingTask::Pop(HeapObject** object) {
+  if (pop_segment_->IsEmpty()) {
+    if (!push_segment_->IsEmpty()) {
+      MarkingSegment* segment = pop_segment_;
+      pop_segment_ = push_segment_;
+      push_segment_ = segment;
+    } else {
+      MarkingSegment* segment = marking_->StealSegment();
+      if (segment == NULL) return false;
+      delete pop_segment_;
+      pop_segment_ = segment;
+    }
+  }
+  *object = pop_segment_->objects[--pop_segment_->size];
+  return true;
+}
+
+
+void ConcurrentMarkingTask::HandOff(HeapObject* object) {
+  if (hand_off_segment_->IsFull()) {
+    marking_->HandOffSegment(hand_off_segment_);
+    hand_off_segment_ = new MarkingSegment();
+  }
+  hand_off_segment_->objects[hand_off_segment_->size++] = object;
+}
+
+
+void ConcurrentMarkingTask::PublishWork() {
+  if (!push_segment_->IsEmpty()) {
+    marking_->PublishSegment(push_segment_);
+    push_segment_ = new MarkingSegment();
+  }
+  if (!pop_segment_->IsEmpty()) {
+    marking_->PublishSegment(pop_segment_);
+    pop_segment_ = new MarkingSegment();
+  }
+  if (!hand_off_segment_->IsEmpty()) {
+    marking_->HandOffSegment(hand_off_segment_);
+    hand_off_segment_ = new MarkingSegment();
+  }
+}
+
+
+void ConcurrentMarkingTask::ProcessWorklist() {
+  HeapObject* object;
+  // The pause request is only checked between objects, a paused thread
+  // never leaves an object half visited.
+  while (!marking_->pause_requested() && Pop(&object)) {
+    VisitObject(object);
+  }
+  PublishWork();
+}
+
+
+void ConcurrentMarkingTask::VisitObject(HeapObject* object) {
+  MarkBit mark_bit = Marking::MarkBitFrom(object);
+  // An object that was queued twice is only visited the first time.
+  if (!Marking::IsGrey(mark_bit)) return;
+  // The object turns black before its fields are read: a store that the
+  // scan misses finds it black in the write barrier, which queues it for
+  // rescanning on the main thread.
+  Marking::GreyToBlackAtomic(mark_bit);
+  MemoryBarrier();
+
+  Map* map = object->map();
+  int size = object->SizeFromMap(map);
+  MemoryChunk::IncrementLiveBytesAtomically(object->address(), size);
+  VisitPointers(HeapObject::RawField(object, 0),
+                HeapObject::RawField(object, size));
+}
+
+
+void ConcurrentMarkingTask::VisitPointers(Object** start, Object** end) {
+  for (Object** slot = start; slot < end; slot++) {
+    Object* value = reinterpret_cast<Object*>(
+        NoBarrier_Load(reinterpret_cast<volatile AtomicWord*>(slot)));
+    if (!value->NonFailureIsHeapObject()) continue;
+    HeapObject* target = HeapObject::cast(value);
+    if (MarkCompactCollector::IsOnEvacuationCandidate(target)) {
+      recorded_slots_.Add(slot);
+    }
+    MarkObject(target);
+  }
+}
+
+
+void ConcurrentMarkingTask::MarkObject(HeapObject* object) {
+  MarkBit mark_bit = Marking::MarkBitFrom(object);
+  if (!Marking::IsWhite(mark_bit)) return;
+  if (mark_bit.data_only()) {
+    if (mark_bit.SetAtomic()) {
+      MemoryChunk::IncrementLiveBytesAtomically(object->address(),
+                                                object->Size());
+    }
+    return;
+  }
+  // Another thread may claim the object at the same time.
+  if (!Marking::WhiteToGreyAtomic(mark_bit)) return;
+  if (ConcurrentMarking::CanBeVisitedConcurrently(heap_, object)) {
+    Push(object);
+  } else {
+    HandOff(object);
+  }
+}
+
+
+void ConcurrentMarkingTask::FlushRecordedSlots(
+    MarkCompactCollector* collector) {
+  for (int i = 0; i < recorded_slots_.length(); i++) {
+    Object** slot = recorded_slots_[i];
+    // The slot is recorded with its current value, the mutator may have
+    // changed it since.
+    Object* value = *slot;
+    if (value->NonFailureIsHeapObject()) {
+      collector->RecordSlot(slot, slot, value);
+    }
+  }
+  recorded_slots_.Rewind(0);
+}
+
+
+ConcurrentMarking::ConcurrentMarking(Heap* heap, int number_of_tasks)
+    : heap_(heap),
+      number_of_tasks_(number_of_tasks),
+      tasks_(new ConcurrentMarkingTask*[number_of_tasks]),
+      running_(false),
+      pool_mutex_(OS::CreateMutex()),
+      pool_(NULL),
+      handed_off_(NULL) {
+  for (int i = 0; i < number_of_tasks; i++) {
+    tasks_[i] = new ConcurrentMarkingTask(this, heap);
+  }
+  NoBarrier_Store(&pool_size_, 0);
+  NoBarrier_Store(&pause_requested_, 0);
+}
+
+
+static void DeleteSegments(MarkingSegment* list) {
+  while (list != NULL) {
+    MarkingSegment* next = list->next;
+    delete list;
+    list = next;
+  }
+}
+
+
+ConcurrentMarking::~ConcurrentMarking() {
+  ASSERT(!running_);
+  DeleteSegments(pool_);
+  DeleteSegments(handed_off_);
+  for (int i = 0; i < number_of_tasks_; i++) {
+    delete tasks_[i];
+  }
+  delete[] tasks_;
+  delete pool_mutex_;
+}
+
+
+bool ConcurrentMarking::CanBeVisitedConcurrently(Heap* heap,
+                                                 HeapObject* object) {
+  // New space objects move in scavenges and large arrays are scanned in
+  // chunks with a progress bar, both are left to the main thread.
+  if (heap->InNewSpace(object)) return false;
+  if (MemoryChunk::FromAddress(object->address())->owner() ==
+      heap->lo_space()) {
+    return false;
+  }
+  Map* map = object->map();
+  switch (map->instance_type()) {
+    case JS_OBJECT_TYPE:
+    case JS_ARRAY_TYPE:
+      return true;
+    case FIXED_ARRAY_TYPE:
+      // Native contexts are fixed arrays with weak fields.
+      return map->visitor_id() == StaticVisitorBase::kVisitFixedArray;
+    default:
+      return false;
+  }
+}
+
+
+void ConcurrentMarking::Resume() {
+  if (running_ || !heap_->incremental_marking()->IsMarking()) return;
+
+  // Take the objects that the threads can visit out of the marking deque.
+  MarkingDeque* deque = heap_->incremental_marking()->marking_deque();
+  int current = deque->bottom();
+  int mask = deque->mask();
+  int limit = deque->top();
+  HeapObject** array = deque->array();
+  int new_top = current;
+
+  Map* filler_map = heap_->one_pointer_filler_map();
+  MarkingSegment* segment = new MarkingSegment();
+
+  while (current != limit) {
+    HeapObject* object = array[current];
+    current = ((current + 1) & mask);
+    if (object->map() != filler_map &&
+        Marking::IsGrey(Marking::MarkBitFrom(object)) &&
+        CanBeVisitedConcurrently(heap_, object)) {
+      if (segment->IsFull()) {
+        PublishSegment(segment);
+        segment = new MarkingSegment();
+      }
+      segment->objects[segment->size++] = object;
+    } else {
+      array[new_top] = object;
+      new_top = ((new_top + 1) & mask);
+    }
+  }
+  deque->set_top(new_top);
+
+  if (segment->IsEmpty()) {
+    delete segment;
+  } else {
+    PublishSegment(segment);
+  }
+
+  if (IsEmpty()) return;
+
+  MarkingThread** threads = heap_->isolate()->marking_threads();
+  for (int i = 0; i < number_of_tasks_; i++) {
+    threads[i]->StartMarking();
+  }
+  running_ = true;
+}
+
+
+bool ConcurrentMarking::Pause() {
+  if (!running_) return false;
+
+  Release_Store(&pause_requested_, 1);
+  MarkingThread** threads = heap_->isolate()->marking_threads();
+  for (int i = 0; i < number_of_tasks_; i++) {
+    threads[i]->WaitForMarkingThread();
+  }
+  Release_Store(&pause_requested_, 0);
+  running_ = false;
+
+  MarkingSegment* handed_off = handed_off_;
+  handed_off_ = NULL;
+  PushToMarkingDeque(handed_off);
+
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i]->FlushRecordedSlots(heap_->mark_compact_collector());
+  }
+  return true;
+}
+
+
+bool ConcurrentMarking::RefillMarkingDeque() {
+  ASSERT(!running_);
+  MarkingSegment* segment = StealSegment();
+  if (segment == NULL) return false;
+  PushToMarkingDeque(segment);
+  return true;
+}
+
+
+void ConcurrentMarking::Finish() {
+  Pause();
+  MarkingSegment* pool = pool_;
+  pool_ = NULL;
+  NoBarrier_Store(&pool_size_, 0);
+  PushToMarkingDeque(pool);
+}
+
+
+void ConcurrentMarking::Abort() {
+  Pause();
+  DeleteSegments(pool_);
+  pool_ = NULL;
+  NoBarrier_Store(&pool_size_, 0);
+}
+
+
+void ConcurrentMarking::MarkConcurrently(int id) {
+  ASSERT(id >= 0 && id < number_of_tasks_);
+  tasks_[id]->ProcessWorklist();
+}
+
+
+void ConcurrentMarking::PushToMarkingDeque(MarkingSegment* list) {
+  if (list == NULL) return;
+  IncrementalMarking* incremental_marking = heap_->incremental_marking();
+  MarkingDeque* deque = incremental_marking->marking_deque();
+  while (list != NULL) {
+    for (int i = 0; i < list->size; i++) {
+      // Objects that do not fit stay grey, the overflow is handled by the
+      // full collector.
+      deque->PushGrey(list->objects[i]);
+    }
+    MarkingSegment* next = list->next;
+    delete list;
+    list = next;
+  }
+  incremental_marking->RestartIfNotMarking();
+}
+
+
+void ConcurrentMarking::PublishSegment(MarkingSegment* segment) {
+  ScopedLock lock(pool_mutex_);
+  segment->next = pool_;
+  pool_ = segment;
+  Release_Store(&pool_size_, Acquire_Load(&pool_size_) + 1);
+}
+
+
+MarkingSegment* ConcurrentMarking::StealSegment() {
+  if (Acquire_Load(&pool_size_) == 0) return NULL;
+  ScopedLock lock(pool_mutex_);
+  MarkingSegment* segment = pool_;
+  if (segment != NULL) {
+    pool_ = segment->next;
+    segment->next = NULL;
+    Release_Store(&pool_size_, Acquire_Load(&pool_size_) - 1);
+  }
+  return segment;
+}
+
+
+void ConcurrentMarking::HandOffSegment(MarkingSegment* segment) {
+  ScopedLock lock(pool_mutex_);
+  segment->next = handed_off_;
+  handed_off_ = segment;
+}
+
+} }  // namespace v8::internal
@@ -0,0 +1,205 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef V8_CONCURRENT_MARKING_H_
+#define V8_CONCURRENT_MARKING_H_
+
+#include "atomicops.h"
+#include "list.h"
+#include "platform.h"
+
+#include "heap.h"
+
+namespace v8 {
+namespace internal {
+
+class ConcurrentMarking;
+
+// A fixed size block of grey objects.  Marking tasks push and pop objects in
+// private segments and exchange whole segments through the pools of the
+// ConcurrentMarking.
+struct MarkingSegment {
+  static const int kCapacity = 64;
+
+  MarkingSegment() : next(NULL), size(0) { }
+
+  bool IsEmpty() { return size == 0; }
+  bool IsFull() { return size == kCapacity; }
+
+  MarkingSegment* next;
+  int size;
+  HeapObject* objects[kCapacity];
+};
+
+
+// The state of one marking thread: its local work list, the objects it hands
+// back to the main thread, and the slots it found that point to evacuation
+// candidates.
+class ConcurrentMarkingTask {
+ public:
+  ConcurrentMarkingTask(ConcurrentMarking* marking, Heap* heap);
+  ~ConcurrentMarkingTask();
+
+  // Scans grey objects until the work runs out or a pause is requested.
+  void ProcessWorklist();
+
+  // Makes the objects still in the local segments available to the main
+  // thread and the other tasks.
+  void PublishWork();
+
+  // Records the collected slots with the mark-compact collector.  Must be
+  // called from the main thread while the marking threads are paused.
+  void FlushRecordedSlots(MarkCompactCollector* collector);
+
+ private:
+  void Push(HeapObject* object);
+  bool Pop(HeapObject** object);
+  void HandOff(HeapObject* object);
+
+  void VisitObject(HeapObject* object);
+  void VisitPointers(Object** start, Object** end);
+  void MarkObject(HeapObject* object);
+
+  ConcurrentMarking* marking_;
+  Heap* heap_;
+
+  MarkingSegment* push_segment_;
+  MarkingSegment* pop_segment_;
+  MarkingSegment* hand_off_segment_;
+
+  List<Object**> recorded_slots_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrentMarkingTask);
+};
+
+
+// Marks the old generation on the marking threads while JavaScript runs
+// (--concurrent-marking).  The threads take over the plain JS objects, JS
+// arrays and fixed arrays of the paged spaces, which make up most of a large
+// heap and have no side effects when they are visited.  All other objects,
+// and everything in new space, are handed back to the main thread and
+// visited by the incremental marker with the regular marking visitor.
+//
+// Both sides change mark bits with atomic operations, and the write barrier
+// always goes through IncrementalMarking::RecordWriteFromCode, which checks
+// colors behind a memory barrier.  The threads are paused for incremental
+// steps, for garbage collections and while the mutator changes the size of
+// an object; they only ever stop at object boundaries, so the main thread
+// sees a consistent heap whenever they are paused.
+class ConcurrentMarking {
+ public:
+  // number_of_tasks is the number of marking threads.
+  ConcurrentMarking(Heap* heap, int number_of_tasks);
+  ~ConcurrentMarking();
+
+  // Moves the objects that the marking threads can visit from the incremental
+  // marking deque to the pool and starts the threads.  Does nothing unless
+  // incremental marking is active or if the threads are already running.
+  void Resume();
+
+  // Stops the marking threads and moves the objects handed back by them to
+  // the incremental marking deque.  Returns whether the threads were running.
+  bool Pause();
+
+  // Moves one segment of the pool to the incremental marking deque, so the
+  // main thread can help during a step.  The threads must be paused.
+  bool RefillMarkingDeque();
+
+  // Pauses the threads and moves all remaining work to the incremental
+  // marking deque, before the marking is finished on the main thread.
+  void Finish();
+
+  // Pauses the threads and drops all remaining work.
+  void Abort();
+
+  // Whether there are grey objects left for the threads.
+  bool IsEmpty() { return Acquire_Load(&pool_size_) == 0; }
+
+  // Called by the marking thread with the given id.
+  void MarkConcurrently(int id);
+
+  bool pause_requested() { return Acquire_Load(&pause_requested_) != 0; }
+
+  Heap* heap() { return heap_; }
+
+ private:
+  friend class ConcurrentMarkingTask;
+
+  // Whether the marking threads may visit the given grey object.
+  static bool CanBeVisitedConcurrently(Heap* heap, HeapObject* object);
+
+  void PublishSegment(MarkingSegment* segment);
+  MarkingSegment* StealSegment();
+  void HandOffSegment(MarkingSegment* segment);
+
+  // Moves the segments in the given list to the incremental marking deque.
+  void PushToMarkingDeque(MarkingSegment* list);
+
+  Heap* heap_;
+  int number_of_tasks_;
+  ConcurrentMarkingTask** tasks_;
+  bool running_;
+
+  Mutex* pool_mutex_;
+  MarkingSegment* pool_;
+  volatile AtomicWord pool_size_;
+  MarkingSegment* handed_off_;
+
+  volatile AtomicWord pause_requested_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrentMarking);
+};
+
+
+// Keeps the marking threads paused while the mutator changes the size of an
+// object in place, which the threads cannot follow.
+class ConcurrentMarkingPauseScope {
+ public:
+  explicit inline ConcurrentMarkingPauseScope(Heap* heap);
+  inline ~ConcurrentMarkingPauseScope();
+
+ private:
+  ConcurrentMarking* marking_;
+  bool resume_;
+};
+
+
+ConcurrentMarkingPauseScope::ConcurrentMarkingPauseScope(Heap* heap)
+    : marking_(heap->concurrent_marking()),
+      resume_(false) {
+  if (marking_ != NULL) resume_ = marking_->Pause();
+}
+
+
+ConcurrentMarkingPauseScope::~ConcurrentMarkingPauseScope() {
+  if (resume_) marking_->Resume();
+}
+
+} }  // namespace v8::internal
+
+#endif  // V8_CONCURRENT_MARKING_H_
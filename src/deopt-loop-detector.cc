@@ -0,0 +1,226 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "v8.h"
+
+#include "deopt-loop-detector.h"
+#include "v8-counters.h"
+
+namespace v8 {
+namespace internal {
+
+// Reasons beyond this number are not printed in the report.
+static const int kReasonsPerFunction = 3;
+
+
+DeoptLoopDetector::DeoptLoopDetector(Isolate* isolate)
+    : isolate_(isolate),
+      cycles_(0),
+      loops_(0),
+      functions_map_(NamesMatch),
+      pending_map_(NULL) {
+}
+
+
+DeoptLoopDetector::~DeoptLoopDetector() {
+  for (int i = 0; i < functions_.length(); ++i) {
+    Function* function = functions_[i];
+    for (int j = 0; j < function->reasons.length(); ++j) {
+      DeleteArray(function->reasons[j].text);
+    }
+    DeleteArray(function->name);
+    delete function;
+  }
+  EndMapChange();
+}
+
+
+DeoptLoopDetector::Function* DeoptLoopDetector::FindOrAddFunction(
+    const char* name) {
+  uint32_t hash = StringHasher::HashSequentialString(
+      name, StrLength(name), kZeroHashSeed);
+  HashMap::Entry* entry =
+      functions_map_.Lookup(const_cast<char*>(name), hash, true);
+  if (entry->value == NULL) {
+    Function* function = new Function;
+    function->name = StrDup(name);
+    function->optimized = false;
+    function->opts = 0;
+    function->deopts = 0;
+    function->cycles = 0;
+    function->opt_failures = 0;
+    function->disables = 0;
+    function->reenables = 0;
+    // The key must outlive the lookup string.
+    entry->key = function->name;
+    entry->value = function;
+    functions_.Add(function);
+  }
+  return reinterpret_cast<Function*>(entry->value);
+}
+
+
+void DeoptLoopDetector::AddReason(Function* function, const char* text) {
+  if (text == NULL) return;
+  for (int i = 0; i < function->reasons.length(); ++i) {
+    Reason& reason = function->reasons[i];
+    if (strcmp(reason.text, text) == 0) {
+      reason.count++;
+      return;
+    }
+  }
+  Reason reason;
+  reason.text = StrDup(text);
+  reason.count = 1;
+  function->reasons.Add(reason);
+}
+
+
+void DeoptLoopDetector::EndMapChange() {
+  if (pending_map_ != NULL) {
+    DeleteArray(pending_map_);
+    pending_map_ = NULL;
+  }
+}
+
+
+void DeoptLoopDetector::RecordOpt(const char* function) {
+  EndMapChange();
+  Function* entry = FindOrAddFunction(function);
+  entry->opts++;
+  entry->optimized = true;
+}
+
+
+void DeoptLoopDetector::RecordDeopt(const char* function, const char* reason) {
+  if (reason != NULL) EndMapChange();
+  Function* entry = FindOrAddFunction(function);
+  entry->deopts++;
+
+  if (reason == NULL && pending_map_ != NULL) {
+    EmbeddedVector<char, 256> text;
+    OS::SNPrintF(text, "map change: %s", pending_map_);
+    AddReason(entry, text.start());
+    isolate_->counters()->deopts_on_map_change()->Increment();
+  } else {
+    AddReason(entry, reason != NULL ? reason : "invalidated");
+  }
+
+  // Lazy deopts of activations of already invalidated code do not close
+  // another cycle.
+  if (!entry->optimized) return;
+  entry->optimized = false;
+  entry->cycles++;
+  cycles_++;
+  isolate_->counters()->opt_deopt_cycles()->Increment();
+  if (entry->cycles == kLoopThreshold) {
+    loops_++;
+    isolate_->counters()->deopt_loops()->Increment();
+  }
+}
+
+
+void DeoptLoopDetector::RecordOptFailed(const char* function) {
+  EndMapChange();
+  FindOrAddFunction(function)->opt_failures++;
+}
+
+
+void DeoptLoopDetector::RecordDisable(const char* function,
+                                      const char* reason) {
+  EndMapChange();
+  Function* entry = FindOrAddFunction(function);
+  entry->disables++;
+  if (reason != NULL) {
+    EmbeddedVector<char, 256> text;
+    OS::SNPrintF(text, "disabled: %s", reason);
+    AddReason(entry, text.start());
+  }
+}
+
+
+void DeoptLoopDetector::RecordReenable(const char* function) {
+  EndMapChange();
+  FindOrAddFunction(function)->reenables++;
+}
+
+
+void DeoptLoopDetector::BeginMapChange(const char* map) {
+  EndMapChange();
+  pending_map_ = StrDup(map);
+}
+
+
+int DeoptLoopDetector::CompareFunctions(Function* const* a,
+                                        Function* const* b) {
+  if ((*a)->cycles != (*b)->cycles) return (*a)->cycles > (*b)->cycles ? -1 : 1;
+  if ((*a)->deopts != (*b)->deopts) return (*a)->deopts > (*b)->deopts ? -1 : 1;
+  return strcmp((*a)->name, (*b)->name);
+}
+
+
+int DeoptLoopDetector::CompareReasons(const Reason* a, const Reason* b) {
+  if (a->count != b->count) return a->count > b->count ? -1 : 1;
+  return strcmp(a->text, b->text);
+}
+
+
+void DeoptLoopDetector::Report(FILE* out, int max_functions) {
+  List<Function*> functions(functions_.length());
+  for (int i = 0; i < functions_.length(); ++i) {
+    if (functions_[i]->deopts > 0) functions.Add(functions_[i]);
+  }
+  functions.Sort(CompareFunctions);
+
+  OS::FPrint(out, "[top deopt loops: %d opt/deopt cycles, %d loops, "
+             "%d deoptimized functions]\n",
+             cycles_, loops_, functions.length());
+  if (functions.is_empty()) return;
+
+  OS::FPrint(out, "%8s %6s %6s %6s %8s %9s  %s\n",
+             "cycles", "opts", "deopts", "failed", "disabled", "reenabled",
+             "function");
+  int count = Min(max_functions, functions.length());
+  for (int i = 0; i < count; ++i) {
+    Function* function = functions[i];
+    OS::FPrint(out, "%8d %6d %6d %6d %8d %9d  %s%s\n",
+               function->cycles, function->opts, function->deopts,
+               function->opt_failures, function->disables,
+               function->reenables, function->name,
+               function->cycles >= kLoopThreshold ? " (loop)" : "");
+
+    function->reasons.Sort(CompareReasons);
+    int reasons = Min(kReasonsPerFunction, function->reasons.length());
+    for (int j = 0; j < reasons; ++j) {
+      OS::FPrint(out, "%8s %6dx %s\n", "",
+                 function->reasons[j].count, function->reasons[j].text);
+    }
+  }
+  fflush(out);
+}
+
+} }  // namespace v8::internal
@@ -0,0 +1,131 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef V8_DEOPT_LOOP_DETECTOR_H_
+#define V8_DEOPT_LOOP_DETECTOR_H_
+
+#include "allocation.h"
+#include "hashmap.h"
+#include "list.h"
+
+namespace v8 {
+namespace internal {
+
+class Isolate;
+
+// Finds the functions that are optimized and deoptimized over and over again
+// (--trace-deopt-loops).  The detector is fed with the FUNCTION_EVENTS_LIST
+// events and BeginDeoptOnMap by the Logger, online and without a log file.
+// Every deoptimization of optimized code closes one opt/deopt cycle of the
+// function; the report ranks the functions by their number of cycles and
+// lists why they were deoptimized, including the map changes that
+// invalidated their code.
+//
+// Functions are identified by their closure mark (name@Lline), so all the
+// closures of one function literal share a single entry.  The cycles are
+// also counted by the V8.OptDeoptCycles, V8.DeoptLoops and
+// V8.DeoptsOnMapChange stats counters.
+class DeoptLoopDetector {
+ public:
+  // A function deoptimized this many times after being optimized is a loop.
+  static const int kLoopThreshold = 2;
+
+  explicit DeoptLoopDetector(Isolate* isolate);
+  ~DeoptLoopDetector();
+
+  // Optimized code has been installed for function.
+  void RecordOpt(const char* function);
+
+  // The optimized code of function has been thrown away because of reason.
+  // If reason is NULL the code has been invalidated from outside, by the
+  // pending map change if any.
+  void RecordDeopt(const char* function, const char* reason);
+
+  // Optimization of function has failed, or has been disabled or reenabled.
+  void RecordOptFailed(const char* function);
+  void RecordDisable(const char* function, const char* reason);
+  void RecordReenable(const char* function);
+
+  // The code depending on map is about to be invalidated.  The deopts
+  // without a reason that follow are attributed to map, up to the next event
+  // of another kind.
+  void BeginMapChange(const char* map);
+
+  int cycles() const { return cycles_; }
+  int loops() const { return loops_; }
+
+  // Prints the functions with the most opt/deopt cycles first, at most
+  // max_functions of them.
+  void Report(FILE* out, int max_functions);
+
+ private:
+  struct Reason {
+    char* text;
+    int count;
+  };
+
+  struct Function {
+    char* name;
+    bool optimized;
+    int opts;
+    int deopts;
+    int cycles;
+    int opt_failures;
+    int disables;
+    int reenables;
+    List<Reason> reasons;
+  };
+
+  Function* FindOrAddFunction(const char* name);
+  void AddReason(Function* function, const char* text);
+  void EndMapChange();
+
+  static int CompareFunctions(Function* const* a, Function* const* b);
+  static int CompareReasons(const Reason* a, const Reason* b);
+
+  static bool NamesMatch(void* key1, void* key2) {
+    return strcmp(reinterpret_cast<char*>(key1),
+                  reinterpret_cast<char*>(key2)) == 0;
+  }
+
+  Isolate* isolate_;
+  int cycles_;
+  int loops_;
+
+  HashMap functions_map_;
+  List<Function*> functions_;
+
+  // Description of the map whose dependent code is being invalidated.
+  char* pending_map_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeoptLoopDetector);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_DEOPT_LOOP_DETECTOR_H_
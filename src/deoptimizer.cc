@@ -376,6 +376,14 @@ class DeoptimizeAllFilter : public OptimizedFunctionFilter {
 };
 
 
+class DeoptimizeMarkedCodeFilter : public OptimizedFunctionFilter {
+ public:
+  virtual bool TakeFunction(JSFunction* function) {
+    return function->code()->marked_for_deoptimization();
+  }
+};
+
+
 class DeoptimizeWithMatchingCodeFilter : public OptimizedFunctionFilter {
  public:
   explicit DeoptimizeWithMatchingCodeFilter(Code* code) : code_(code) {}
@@ -414,6 +422,12 @@ void Deoptimizer::DeoptimizeGlobalObject(JSObject* object) {
 }
 
 
+void Deoptimizer::DeoptimizeMarkedCode(Isolate* isolate) {
+  DeoptimizeMarkedCodeFilter filter;
+  DeoptimizeAllFunctionsWith(isolate, &filter);
+}
+
+
 void Deoptimizer::DeoptimizeFunction(JSFunction* function) {
   if (!function->IsOptimized()) return;
   Code* code = function->code();
@@ -820,7 +834,7 @@ void Deoptimizer::DoComputeOutputFrames() {
   }
 
   // We log deoptimization events before going on
-  if ( FLAG_trace_internals &&
+  if ( (FLAG_trace_internals || FLAG_trace_deopt_loops) &&
 		function_->IsJSFunction() ) {
 	  // function_ may be a SMI, which indicates a builtin function
 	  SharedFunctionInfo* shared = function_->shared();
@@ -833,7 +847,7 @@ void Deoptimizer::DoComputeOutputFrames() {
 	  /*HeapObject* obj = HeapObject::cast(deopt_roots[0]);
 	  Map* exp_map = Map::cast(deopt_roots[1]);*/
 
-	  LOG(isolate(),
+	  LOG_OPT_EVENT(isolate(),
 		  EmitFunctionEvent(
 		  Logger::RegularDeopt,
 			function_,
@@ -194,6 +194,9 @@ class Deoptimizer : public Malloced {
 
   static void DeoptimizeGlobalObject(JSObject* object);
 
+  // Deoptimize all functions whose code is marked for deoptimization.
+  static void DeoptimizeMarkedCode(Isolate* isolate);
+
   static void DeoptimizeAllFunctionsWith(Isolate* isolate,
                                          OptimizedFunctionFilter* filter);
 
@@ -195,6 +195,10 @@ DEFINE_bool(clever_optimizations,
             true,
             "Optimize object size, Array shift, DOM strings and string +")
 DEFINE_bool(pretenuring, true, "allocate objects in old space")
+DEFINE_bool(allocation_site_pretenuring, true,
+            "pretenure array literals whose objects survive scavenges")
+DEFINE_bool(trace_pretenuring, false,
+            "trace pretenuring decisions of allocation sites")
 DEFINE_bool(track_fields, true, "track fields with only smi values")
 DEFINE_bool(track_double_fields, true, "track fields with double values")
 DEFINE_bool(track_heap_object_fields, true, "track fields with heap values")
@@ -212,9 +216,13 @@ DEFINE_bool(crankshaft, true, "use crankshaft")
 DEFINE_string(hydrogen_filter, "", "optimization filter")
 DEFINE_bool(use_range, true, "use hydrogen range analysis")
 DEFINE_bool(use_gvn, true, "use hydrogen global value numbering")
+DEFINE_bool(use_load_elimination, true, "use hydrogen load elimination")
+DEFINE_bool(use_check_elimination, true, "use hydrogen map check elimination")
 DEFINE_bool(use_canonicalizing, true, "use hydrogen instruction canonicalizing")
 DEFINE_bool(use_inlining, true, "use function inlining")
-DEFINE_bool(use_escape_analysis, false, "use hydrogen escape analysis")
+DEFINE_bool(use_escape_analysis, true, "use hydrogen escape analysis")
+DEFINE_int(escape_analysis_iterations, 2,
+           "maximum number of escape analysis fix-point iterations")
 DEFINE_int(max_inlined_source_size, 600,
            "maximum source size in bytes considered for a single inlining")
 DEFINE_int(max_inlined_nodes, 196,
@@ -234,6 +242,9 @@ DEFINE_bool(trace_alloc, false, "trace register allocator")
 DEFINE_bool(trace_all_uses, false, "trace all use positions")
 DEFINE_bool(trace_range, false, "trace range analysis")
 DEFINE_bool(trace_gvn, false, "trace global value numbering")
+DEFINE_bool(trace_load_elimination, false, "trace hydrogen load elimination")
+DEFINE_bool(trace_check_elimination, false,
+            "trace hydrogen map check elimination")
 DEFINE_bool(trace_representation, false, "trace representation types")
 DEFINE_bool(trace_escape_analysis, false, "trace hydrogen escape analysis")
 DEFINE_bool(trace_track_allocation_sites, false,
@@ -450,6 +461,10 @@ DEFINE_bool(always_inline_smi_code, false,
 DEFINE_int(max_new_space_size, 0, "max size of the new generation (in kBytes)")
 DEFINE_int(max_old_space_size, 0, "max size of the old generation (in Mbytes)")
 DEFINE_int(max_executable_size, 0, "max size of executable memory (in Mbytes)")
+DEFINE_bool(dynamic_new_space_sizing, true,
+            "size the semispaces from the survival ratio and allocation rate")
+DEFINE_int(scavenge_pause_target, 2,
+           "pause time a scavenge should not exceed (in ms)")
 DEFINE_bool(gc_global, false, "always perform global GCs")
 DEFINE_int(gc_interval, -1, "garbage collect after <n> allocations")
 DEFINE_bool(trace_gc, false,
@@ -486,12 +501,37 @@ DEFINE_bool(trace_incremental_marking, false,
             "trace progress of the incremental marking")
 DEFINE_bool(track_gc_object_stats, false,
             "track object counts and memory usage")
-DEFINE_bool(parallel_sweeping, true, "enable parallel sweeping")
-DEFINE_bool(concurrent_sweeping, false, "enable concurrent sweeping")
+DEFINE_bool(parallel_sweeping, false, "enable parallel sweeping")
+DEFINE_bool(concurrent_sweeping, true, "enable concurrent sweeping")
 DEFINE_int(sweeper_threads, 0,
            "number of parallel and concurrent sweeping threads")
+DEFINE_bool(parallel_compaction, false,
+            "evacuate pages and update pointers to them on the sweeper "
+            "threads")
 DEFINE_bool(parallel_marking, false, "enable parallel marking")
+DEFINE_bool(concurrent_marking, false,
+            "mark the old generation on the marking threads while "
+            "JavaScript runs")
 DEFINE_int(marking_threads, 0, "number of parallel marking threads")
+DEFINE_bool(parallel_scavenge, false,
+            "copy surviving objects with helper threads in the scavenger")
+DEFINE_int(scavenger_threads, 0,
+           "number of parallel scavenging threads besides the main thread")
+DEFINE_bool(parallel_store_buffer, true,
+            "process the store buffer with the scavenger threads")
+DEFINE_bool(concurrent_store_buffer_dedup, true,
+            "deduplicate the store buffer on a scavenger thread between "
+            "scavenges")
+DEFINE_bool(card_marking, true,
+            "record the pointers to new space in large fixed arrays in card "
+            "tables instead of scanning the arrays on scavenge")
+DEFINE_bool(concurrent_unmapping, true,
+            "release the memory of freed chunks on a background thread")
+DEFINE_int(max_pooled_pages, 8,
+           "number of freed pages kept mapped for reuse by new pages")
+DEFINE_bool(heap_range, false,
+            "allocate the heap from one 4GB reservation aligned to 4GB, so "
+            "that heap addresses share their upper 32 bits (x64 only)")
 #ifdef VERIFY_HEAP
 DEFINE_bool(verify_heap, false, "verify heap pointers before and after GC")
 #endif
@@ -499,6 +539,13 @@ DEFINE_bool(verify_heap, false, "verify heap pointers before and after GC")
 // v8.cc
 DEFINE_bool(use_idle_notification, true,
             "Use idle notification to reduce memory footprint.")
+DEFINE_bool(trace_idle_notification, false,
+            "print the GC work chosen for each idle notification deadline")
+DEFINE_bool(memory_reducer, true,
+            "shrink the heap when the memory reducer notifications find the "
+            "allocation rate low")
+DEFINE_bool(trace_memory_reducer, false,
+            "print the decisions and results of the memory reducer")
 // ic.cc
 DEFINE_bool(use_ic, true, "use inline caching")
 
@@ -744,6 +791,29 @@ DEFINE_implication(log_internal_timer_events, prof)
 
 // Xiao's extension
 DEFINE_bool(trace_internals, false, "Trace internal states evolutioin graphs for performance debugging")
+DEFINE_bool(trace_internals_binary, false,
+            "write --trace-internals events in the compact binary format")
+DEFINE_implication(trace_internals_binary, trace_internals)
+DEFINE_int(trace_internals_buffer_size, 4096,
+           "size of the ring buffer for binary internal events (in KB)")
+DEFINE_bool(trace_internals_aggregate, false,
+            "aggregate --trace-internals object events into per allocation "
+            "site state machines, written out at exit")
+DEFINE_implication(trace_internals_aggregate, trace_internals)
+DEFINE_int(trace_internals_sample_rate, 1,
+           "trace the object events of one in N allocation sites only")
+DEFINE_bool(trace_deopt_loops, false,
+            "detect functions that are repeatedly optimized and deoptimized, "
+            "and print the top deopt loops at exit")
+DEFINE_int(trace_deopt_loops_top, 10,
+           "number of functions in the top deopt loops report")
+DEFINE_bool(trace_map_hotspots, false,
+            "print the allocation sites with the most map transitions, "
+            "slow-mode conversions and field generalizations at exit")
+DEFINE_implication(trace_map_hotspots, trace_internals_aggregate)
+DEFINE_implication(trace_map_hotspots, trace_internals)
+DEFINE_int(trace_map_hotspots_top, 20,
+           "number of allocation sites in the map transition hotspots report")
 
 //
 // Disassembler only flags
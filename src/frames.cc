@@ -1447,7 +1447,8 @@ Code* InnerPointerToCodeCache::GcSafeFindCodeForInnerPointer(
   // after the inner pointer.
   Page* page = Page::FromAddress(inner_pointer);
 
-  Address addr = page->skip_list()->StartFor(inner_pointer);
+  Address addr = page->object_starts()->StartFor(inner_pointer);
+  ASSERT(addr != NULL);
 
   Address top = heap->code_space()->top();
   Address limit = heap->code_space()->limit();
@@ -0,0 +1,182 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "v8.h"
+
+#include "gc-idle-time-handler.h"
+
+namespace v8 {
+namespace internal {
+
+const double GCIdleTimeHandler::kConservativeTimeRatio = 0.9;
+
+
+const char* GCIdleTimeAction::ToString() {
+  switch (type) {
+    case DONE: return "done";
+    case DO_NOTHING: return "no action";
+    case DO_INCREMENTAL_MARKING: return "incremental marking";
+    case DO_FINALIZE_MARKING: return "finalize marking";
+    case DO_SCAVENGE: return "scavenge";
+    case DO_SWEEPING: return "sweeping";
+    case DO_FULL_GC: return "full GC";
+  }
+  UNREACHABLE();
+  return NULL;
+}
+
+
+void GCSpeedTracker::Add(intptr_t bytes, double duration_in_ms) {
+  // Timer granularity makes very short durations meaningless.
+  if (bytes <= 0 || duration_in_ms <= 0) return;
+  bytes_[next_] = bytes;
+  durations_[next_] = duration_in_ms;
+  next_ = (next_ + 1) % kLength;
+  if (length_ < kLength) length_++;
+}
+
+
+intptr_t GCSpeedTracker::Speed() {
+  if (length_ == 0) return initial_speed_;
+  double bytes = 0;
+  double durations = 0;
+  for (int i = 0; i < length_; i++) {
+    bytes += bytes_[i];
+    durations += durations_[i];
+  }
+  return Max(static_cast<intptr_t>(bytes / durations),
+             static_cast<intptr_t>(1));
+}
+
+
+intptr_t GCIdleTimeHandler::EstimateStepSize(double idle_time_in_ms,
+                                             intptr_t speed) {
+  if (idle_time_in_ms <= 0) return 0;
+  double step_size = idle_time_in_ms * speed;
+  if (step_size >= kMaxStepSize) return kMaxStepSize;
+  return static_cast<intptr_t>(step_size);
+}
+
+
+double GCIdleTimeHandler::EstimateTimeInMs(intptr_t bytes, intptr_t speed) {
+  return static_cast<double>(bytes) / speed;
+}
+
+
+void GCIdleTimeHandler::RecordMarkCompact(intptr_t size_of_objects,
+                                          double duration_in_ms,
+                                          bool finalized_incremental_marking) {
+  if (finalized_incremental_marking) {
+    finalize_speed_.Add(size_of_objects, duration_in_ms);
+  } else {
+    mark_compact_speed_.Add(size_of_objects, duration_in_ms);
+  }
+}
+
+
+void GCIdleTimeHandler::RecordScavenge(intptr_t new_space_size,
+                                       double duration_in_ms) {
+  scavenge_speed_.Add(new_space_size, duration_in_ms);
+}
+
+
+void GCIdleTimeHandler::RecordMarkingStep(intptr_t step_size,
+                                          double duration_in_ms) {
+  marking_speed_.Add(step_size, duration_in_ms);
+}
+
+
+void GCIdleTimeHandler::RecordSweepingStep(intptr_t step_size,
+                                           double duration_in_ms) {
+  sweeping_speed_.Add(step_size, duration_in_ms);
+}
+
+
+// The work is picked in this order:
+// 1. a full GC after a context was disposed, since most of the heap is
+//    likely garbage by now,
+// 2. the finalization of incremental marking,
+// 3. a scavenge when new space is close to full, so that the next one does
+//    not happen while the mutator runs,
+// 4. lazy sweeping,
+// 5. a full GC towards the end of an idle round, which also compacts the
+//    code space and flushes unused code,
+// 6. incremental marking steps.
+// Work whose estimated duration does not fit into the idle time is skipped.
+GCIdleTimeAction GCIdleTimeHandler::Compute(double idle_time_in_ms,
+                                            const HeapState& state) {
+  double budget_in_ms = idle_time_in_ms * kConservativeTimeRatio;
+  if (budget_in_ms <= 0) return GCIdleTimeAction::Nothing();
+
+  bool full_gc_fits =
+      EstimateTimeInMs(state.size_of_objects, mark_compact_speed_.Speed()) <=
+      budget_in_ms;
+
+  if (state.contexts_disposed > 0 && state.incremental_marking_stopped &&
+      full_gc_fits) {
+    return GCIdleTimeAction::FullGC();
+  }
+
+  if (state.incremental_marking_complete) {
+    if (EstimateTimeInMs(state.size_of_objects, finalize_speed_.Speed()) <=
+        budget_in_ms) {
+      return GCIdleTimeAction::FinalizeMarking();
+    }
+    return GCIdleTimeAction::Nothing();
+  }
+
+  if (state.new_space_size * 100 >=
+          state.new_space_capacity * kScavengeNewSpaceFullPercent &&
+      EstimateTimeInMs(state.new_space_size, scavenge_speed_.Speed()) <=
+          budget_in_ms) {
+    return GCIdleTimeAction::Scavenge();
+  }
+
+  if (state.incremental_marking_stopped && state.sweeping_in_progress) {
+    intptr_t step_size =
+        EstimateStepSize(budget_in_ms, sweeping_speed_.Speed());
+    if (step_size == 0) return GCIdleTimeAction::Nothing();
+    return GCIdleTimeAction::Sweeping(step_size);
+  }
+
+  if (state.idle_round_finished) return GCIdleTimeAction::Done();
+
+  if (state.incremental_marking_stopped) {
+    if (state.remaining_mark_sweeps_in_idle_round <= 2 && full_gc_fits) {
+      return GCIdleTimeAction::FullGC();
+    }
+    if (!state.can_start_incremental_marking) {
+      return GCIdleTimeAction::Nothing();
+    }
+  }
+
+  intptr_t step_size = EstimateStepSize(budget_in_ms, marking_speed_.Speed());
+  if (step_size == 0) return GCIdleTimeAction::Nothing();
+  return GCIdleTimeAction::IncrementalMarking(step_size);
+}
+
+} }  // namespace v8::internal
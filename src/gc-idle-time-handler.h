@@ -0,0 +1,182 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_GC_IDLE_TIME_HANDLER_H_
+#define V8_GC_IDLE_TIME_HANDLER_H_
+
+#include "globals.h"
+
+namespace v8 {
+namespace internal {
+
+enum GCIdleTimeActionType {
+  DONE,
+  DO_NOTHING,
+  DO_INCREMENTAL_MARKING,
+  DO_FINALIZE_MARKING,
+  DO_SCAVENGE,
+  DO_SWEEPING,
+  DO_FULL_GC
+};
+
+
+class GCIdleTimeAction {
+ public:
+  static GCIdleTimeAction Done() {
+    return GCIdleTimeAction(DONE, 0);
+  }
+
+  static GCIdleTimeAction Nothing() {
+    return GCIdleTimeAction(DO_NOTHING, 0);
+  }
+
+  static GCIdleTimeAction IncrementalMarking(intptr_t step_size) {
+    return GCIdleTimeAction(DO_INCREMENTAL_MARKING, step_size);
+  }
+
+  static GCIdleTimeAction FinalizeMarking() {
+    return GCIdleTimeAction(DO_FINALIZE_MARKING, 0);
+  }
+
+  static GCIdleTimeAction Scavenge() {
+    return GCIdleTimeAction(DO_SCAVENGE, 0);
+  }
+
+  static GCIdleTimeAction Sweeping(intptr_t step_size) {
+    return GCIdleTimeAction(DO_SWEEPING, step_size);
+  }
+
+  // A non-incremental mark-compact that also compacts the code space and
+  // flushes the code of functions that have not run lately.
+  static GCIdleTimeAction FullGC() {
+    return GCIdleTimeAction(DO_FULL_GC, 0);
+  }
+
+  const char* ToString();
+
+  GCIdleTimeActionType type;
+  // Bytes of work for the marking and sweeping steps.
+  intptr_t parameter;
+
+ private:
+  GCIdleTimeAction(GCIdleTimeActionType type, intptr_t parameter)
+      : type(type), parameter(parameter) { }
+};
+
+
+// The speed of one kind of GC work, averaged over the last few times it
+// was done.
+class GCSpeedTracker {
+ public:
+  explicit GCSpeedTracker(intptr_t initial_speed)
+      : initial_speed_(initial_speed), length_(0), next_(0) { }
+
+  void Add(intptr_t bytes, double duration_in_ms);
+
+  // Bytes per millisecond, or the initial speed if nothing was recorded.
+  intptr_t Speed();
+
+ private:
+  static const int kLength = 8;
+
+  intptr_t initial_speed_;
+  intptr_t bytes_[kLength];
+  double durations_[kLength];
+  int length_;
+  int next_;
+};
+
+
+// Decides which GC work fits into the idle time the embedder reports.  The
+// cost of each kind of work is estimated from the speed at which it was
+// done recently; the heap reports the durations through the GC tracer and
+// around the idle steps.
+class GCIdleTimeHandler {
+ public:
+  // Only this share of the idle time is planned for, to leave a margin for
+  // the estimates being off.
+  static const double kConservativeTimeRatio;
+
+  // Used until the first measurement of each kind of work.
+  static const intptr_t kInitialConservativeMarkCompactSpeed = 2 * MB;
+  static const intptr_t kInitialConservativeFinalizeSpeed = 2 * MB;
+  static const intptr_t kInitialConservativeScavengeSpeed = 100 * KB;
+  static const intptr_t kInitialConservativeMarkingSpeed = 100 * KB;
+  static const intptr_t kInitialConservativeSweepingSpeed = 1 * MB;
+
+  // The longest step the handler asks for, however long the idle time.
+  static const intptr_t kMaxStepSize = 8 * MB;
+
+  // A scavenge is worth doing in idle time once new space is this full.
+  static const int kScavengeNewSpaceFullPercent = 80;
+
+  struct HeapState {
+    int contexts_disposed;
+    intptr_t size_of_objects;
+    intptr_t new_space_size;
+    intptr_t new_space_capacity;
+    bool incremental_marking_stopped;
+    bool incremental_marking_complete;
+    bool can_start_incremental_marking;
+    // Lazy sweeping that is left to the main thread.
+    bool sweeping_in_progress;
+    // No more mark-sweeps are wanted until the mutator makes more garbage.
+    bool idle_round_finished;
+    int remaining_mark_sweeps_in_idle_round;
+  };
+
+  GCIdleTimeHandler()
+      : mark_compact_speed_(kInitialConservativeMarkCompactSpeed),
+        finalize_speed_(kInitialConservativeFinalizeSpeed),
+        scavenge_speed_(kInitialConservativeScavengeSpeed),
+        marking_speed_(kInitialConservativeMarkingSpeed),
+        sweeping_speed_(kInitialConservativeSweepingSpeed) { }
+
+  GCIdleTimeAction Compute(double idle_time_in_ms, const HeapState& state);
+
+  void RecordMarkCompact(intptr_t size_of_objects, double duration_in_ms,
+                         bool finalized_incremental_marking);
+  void RecordScavenge(intptr_t new_space_size, double duration_in_ms);
+  void RecordMarkingStep(intptr_t step_size, double duration_in_ms);
+  void RecordSweepingStep(intptr_t step_size, double duration_in_ms);
+
+  static intptr_t EstimateStepSize(double idle_time_in_ms, intptr_t speed);
+  static double EstimateTimeInMs(intptr_t bytes, intptr_t speed);
+
+ private:
+  GCSpeedTracker mark_compact_speed_;
+  GCSpeedTracker finalize_speed_;
+  GCSpeedTracker scavenge_speed_;
+  GCSpeedTracker marking_speed_;
+  GCSpeedTracker sweeping_speed_;
+
+  DISALLOW_COPY_AND_ASSIGN(GCIdleTimeHandler);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_GC_IDLE_TIME_HANDLER_H_
@@ -198,13 +198,14 @@ MaybeObject* Heap::AllocateTwoByteInternalizedString(Vector<const uc16> str,
   return answer;
 }
 
-MaybeObject* Heap::CopyFixedArray(FixedArray* src) {
-  return CopyFixedArrayWithMap(src, src->map());
+MaybeObject* Heap::CopyFixedArray(FixedArray* src, PretenureFlag pretenure) {
+  return CopyFixedArrayWithMap(src, src->map(), pretenure);
 }
 
 
-MaybeObject* Heap::CopyFixedDoubleArray(FixedDoubleArray* src) {
-  return CopyFixedDoubleArrayWithMap(src, src->map());
+MaybeObject* Heap::CopyFixedDoubleArray(FixedDoubleArray* src,
+                                        PretenureFlag pretenure) {
+  return CopyFixedDoubleArrayWithMap(src, src->map(), pretenure);
 }
 
 
@@ -379,12 +380,17 @@ bool Heap::ShouldBePromoted(Address old_address, int object_size) {
   // An object should be promoted if:
   // - the object has survived a scavenge operation or
   // - to space is already 25% full.
+  return IsBelowAgeMark(old_address) ||
+      (new_space_.Size() + object_size) >=
+          (new_space_.EffectiveCapacity() >> 2);
+}
+
+
+bool Heap::IsBelowAgeMark(Address old_address) {
   NewSpacePage* page = NewSpacePage::FromAddress(old_address);
   Address age_mark = new_space_.age_mark();
-  bool below_mark = page->IsFlagSet(MemoryChunk::NEW_SPACE_BELOW_AGE_MARK) &&
+  return page->IsFlagSet(MemoryChunk::NEW_SPACE_BELOW_AGE_MARK) &&
       (!page->ContainsLimit(age_mark) || old_address < age_mark);
-  return below_mark || (new_space_.Size() + object_size) >=
-                        (new_space_.EffectiveCapacity() >> 2);
 }
 
 
@@ -470,6 +476,28 @@ void Heap::ScavengePointer(HeapObject** p) {
 }
 
 
+void Heap::UpdateAllocationSiteFeedback(Map* map, HeapObject* object) {
+  if (map->instance_type() != JS_ARRAY_TYPE) return;
+
+  // The memento has to be on the object's page and below the allocation top
+  // at the time of the flip, otherwise the words behind the object are stale.
+  Address memento_address = object->address() + map->instance_size();
+  Address memento_end = memento_address + AllocationSiteInfo::kSize;
+  NewSpacePage* object_page = NewSpacePage::FromAddress(object->address());
+  if (NewSpacePage::FromLimit(memento_end) != object_page) return;
+  if (NewSpacePage::FromLimit(from_space_top_) == object_page &&
+      memento_end > from_space_top_) {
+    return;
+  }
+
+  HeapObject* candidate = HeapObject::FromAddress(memento_address);
+  if (candidate->map() != allocation_site_info_map()) return;
+  AllocationSiteInfo* memento = AllocationSiteInfo::cast(candidate);
+  if (!memento->IsAllocationSite()) return;
+  memento->GetAllocationSite()->IncrementMementoFoundCount();
+}
+
+
 void Heap::ScavengeObject(HeapObject** p, HeapObject* object) {
   ASSERT(HEAP->InFromSpace(object));
 
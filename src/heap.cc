@@ -32,6 +32,7 @@
 #include "bootstrapper.h"
 #include "codegen.h"
 #include "compilation-cache.h"
+#include "concurrent-marking.h"
 #include "cpu-profiler.h"
 #include "debug.h"
 #include "deoptimizer.h"
@@ -43,6 +44,8 @@
 #include "objects-visiting.h"
 #include "objects-visiting-inl.h"
 #include "once.h"
+#include "parallel-evacuator.h"
+#include "parallel-scavenger.h"
 #include "runtime-profiler.h"
 #include "scopeinfo.h"
 #include "snapshot.h"
@@ -93,6 +96,11 @@ Heap::Heap()
 // Will be 4 * reserved_semispace_size_ to ensure that young
 // generation can be aligned to its size.
       survived_since_last_expansion_(0),
+      scavenge_pause_target_ms_(0),
+      new_space_size_at_last_gc_(0),
+      new_space_survival_ratio_(0.0),
+      scavenge_speed_(0.0),
+      new_space_allocation_rate_(0.0),
       sweep_generation_(0),
       always_allocate_scope_depth_(0),
       linear_allocation_scope_depth_(0),
@@ -119,6 +127,7 @@ Heap::Heap()
       disallow_allocation_failure_(false),
 #endif  // DEBUG
       new_space_high_promotion_mode_active_(false),
+      from_space_top_(NULL),
       old_generation_allocation_limit_(kMinimumOldGenerationAllocationLimit),
       size_of_old_gen_at_last_old_space_gc_(0),
       external_allocation_limit_(0),
@@ -155,12 +164,18 @@ Heap::Heap()
       mark_sweeps_since_idle_round_started_(0),
       gc_count_at_last_idle_gc_(0),
       scavenges_since_last_idle_round_(kIdleScavengeThreshold),
+      memory_reducer_callback_(NULL),
+      allocation_counter_(0),
       gcs_since_last_deopt_(0),
 #ifdef VERIFY_HEAP
       no_weak_embedded_maps_verification_scope_depth_(0),
 #endif
       promotion_queue_(this),
       configured_(false),
+      parallel_scavenger_(NULL),
+      scavenging_in_parallel_(false),
+      concurrent_marking_(NULL),
+      parallel_evacuator_(NULL),
       chunks_queued_for_free_(NULL),
       relocation_mutex_(NULL) {
   // Allow build-time customization of the max semispace size. Building
@@ -182,6 +197,7 @@ Heap::Heap()
   memset(roots_, 0, sizeof(roots_[0]) * kRootListLength);
   native_contexts_list_ = NULL;
   array_buffers_list_ = Smi::FromInt(0);
+  allocation_sites_list_ = Smi::FromInt(0);
   mark_compact_collector_.heap_ = this;
   external_string_table_.heap_ = this;
   // Put a dummy entry in the remembered pages so we can find the list the
@@ -437,6 +453,7 @@ void Heap::GarbageCollectionPrologue() {
     ClearJSFunctionResultCaches();
     gc_count_++;
     unflattened_strings_length_ = 0;
+    allocation_counter_ = AllocationCounter();
 
     if (FLAG_flush_code && FLAG_flush_code_incrementally) {
       mark_compact_collector()->EnableCodeFlushing(true);
@@ -513,6 +530,8 @@ void Heap::GarbageCollectionEpilogue() {
   isolate_->counters()->alive_after_last_gc()->Set(
       static_cast<int>(SizeOfObjects()));
 
+  new_space_size_at_last_gc_ = new_space_.SizeAsInt();
+
   isolate_->counters()->string_table_capacity()->Set(
       string_table()->Capacity());
   isolate_->counters()->number_of_symbols()->Set(
@@ -665,6 +684,10 @@ bool Heap::CollectGarbage(AllocationSpace space,
     }
   }
 
+  // The marking threads stay paused until incremental marking is resumed or
+  // restarted below.
+  ConcurrentMarkingPauseScope pause_concurrent_marking(this);
+
   bool next_gc_likely_to_collect_more = false;
 
   { GCTracer tracer(this, gc_reason, collector_reason);
@@ -703,6 +726,7 @@ bool Heap::CollectGarbage(AllocationSpace space,
 
 
 void Heap::PerformScavenge() {
+  ConcurrentMarkingPauseScope pause_concurrent_marking(this);
   GCTracer tracer(this, NULL, NULL);
   if (incremental_marking()->IsStopped()) {
     PerformGarbageCollection(SCAVENGER, &tracer);
@@ -1187,6 +1211,74 @@ void Heap::CheckNewSpaceExpansionCriteria() {
 }
 
 
+void Heap::ResizeNewSpace(int allocated, int survived, double pause_ms) {
+  // Weight of the latest scavenge in the moving averages.
+  const double kSampleWeight = 0.3;
+  // Scavenges that copy less than this are too short to time.
+  const int kMinSampleBytes = 64 * KB;
+  // A semispace that takes the mutator longer than this to fill holds
+  // memory that is not needed.
+  const double kMaxScavengeIntervalMs = 1000.0;
+  // Survival ratios below this are taken as noise.
+  const double kMinSurvivalRatio = 0.01;
+
+  if (allocated <= 0) return;
+  double mutator_ms = last_gc_end_timestamp_ > 0
+      ? OS::TimeCurrentMillis() - pause_ms - last_gc_end_timestamp_ : 0;
+
+  double survival_ratio = Min(1.0, static_cast<double>(survived) / allocated);
+  new_space_survival_ratio_ = (new_space_survival_ratio_ == 0)
+      ? survival_ratio
+      : (1 - kSampleWeight) * new_space_survival_ratio_ +
+            kSampleWeight * survival_ratio;
+  if (survived >= kMinSampleBytes && pause_ms > 0) {
+    double speed = survived / pause_ms;
+    scavenge_speed_ = (scavenge_speed_ == 0)
+        ? speed
+        : (1 - kSampleWeight) * scavenge_speed_ + kSampleWeight * speed;
+  }
+  if (mutator_ms > 0) {
+    double rate = allocated / mutator_ms;
+    new_space_allocation_rate_ = (new_space_allocation_rate_ == 0)
+        ? rate
+        : (1 - kSampleWeight) * new_space_allocation_rate_ +
+              kSampleWeight * rate;
+  }
+  if (scavenge_speed_ == 0 || new_space_allocation_rate_ == 0) return;
+
+  // The pause grows with the survivors, which grow with the capacity.
+  double pause_capacity = scavenge_pause_target_ms_ * scavenge_speed_ /
+      Max(new_space_survival_ratio_, kMinSurvivalRatio);
+  double rate_capacity = new_space_allocation_rate_ * kMaxScavengeIntervalMs;
+  bool quiet = rate_capacity < pause_capacity;
+  double desired = Min(Min(pause_capacity, rate_capacity),
+                       static_cast<double>(new_space_.MaximumCapacity()));
+
+  int capacity = static_cast<int>(new_space_.Capacity());
+  int new_capacity = RoundUp(static_cast<int>(desired), Page::kPageSize);
+  if (new_capacity > capacity && !new_space_high_promotion_mode_active_) {
+    new_space_.GrowTo(new_capacity);
+  } else if (new_capacity < capacity / 2) {
+    new_space_.ShrinkTo(new_capacity);
+    // The mutator is not allocating enough to need the pages of from space
+    // before the next scavenge.
+    if (quiet) new_space_.DiscardFromSpace();
+  } else {
+    return;
+  }
+
+  if (FLAG_trace_gc_verbose) {
+    PrintPID("New space: survival %.1f%%, %.0f KB/ms scavenged, "
+             "%.0f KB/ms allocated, capacity %d KB -> %d KB\n",
+             new_space_survival_ratio_ * 100,
+             scavenge_speed_ / KB,
+             new_space_allocation_rate_ / KB,
+             capacity / KB,
+             static_cast<int>(new_space_.Capacity()) / KB);
+  }
+}
+
+
 static bool IsUnscavengedHeapObject(Heap* heap, Object** p) {
   return heap->InNewSpace(*p) &&
       !HeapObject::cast(*p)->map_word().IsForwardingAddress();
@@ -1326,7 +1418,11 @@ void Heap::Scavenge() {
   // Used for updating survived_since_last_expansion_ at function end.
   intptr_t survived_watermark = PromotedSpaceSizeOfObjects();
 
-  CheckNewSpaceExpansionCriteria();
+  // Used for sizing the semispaces at function end.
+  double start_time = OS::TimeCurrentMillis();
+  int allocated = new_space_.SizeAsInt() - new_space_size_at_last_gc_;
+
+  if (!FLAG_dynamic_new_space_sizing) CheckNewSpaceExpansionCriteria();
 
   SelectScavengingVisitorsTable();
 
@@ -1335,8 +1431,13 @@ void Heap::Scavenge() {
   paged_space(OLD_DATA_SPACE)->EnsureSweeperProgress(new_space_.Size());
   paged_space(OLD_POINTER_SPACE)->EnsureSweeperProgress(new_space_.Size());
 
+  // The store buffer and the scan-on-scavenge pages can refer to slots in
+  // dead objects, which the sweeper threads may be freeing right now.
+  mark_compact_collector()->EnsurePagesSwept(old_pointer_space());
+
   // Flip the semispaces.  After flipping, to space is empty, from space has
   // live objects.
+  from_space_top_ = new_space_.top();
   new_space_.Flip();
   new_space_.ResetAllocationInfo();
 
@@ -1360,6 +1461,11 @@ void Heap::Scavenge() {
   Address new_space_front = new_space_.ToSpaceStart();
   promotion_queue_.Initialize();
 
+  // When scavenging in parallel the visitors below run the main thread's
+  // scavenging task, and DoScavenge hands the copied objects to the
+  // scavenger threads.
+  if (scavenging_in_parallel_) parallel_scavenger_->Prepare();
+
 #ifdef DEBUG
   store_buffer()->Clean();
 #endif
@@ -1373,7 +1479,12 @@ void Heap::Scavenge() {
     StoreBufferRebuildScope scope(this,
                                   store_buffer(),
                                   &ScavengeStoreBufferCallback);
-    store_buffer()->IteratePointersToNewSpace(&ScavengeObject);
+    if (scavenging_in_parallel_ && FLAG_parallel_store_buffer) {
+      store_buffer()->IteratePointersToNewSpaceInParallel(parallel_scavenger_,
+                                                          &ScavengeObject);
+    } else {
+      store_buffer()->IteratePointersToNewSpace(&ScavengeObject);
+    }
   }
 
   // Copy objects reachable from simple cells by scavenging cell values
@@ -1433,6 +1544,8 @@ void Heap::Scavenge() {
 
   error_object_list_.UpdateReferencesInNewSpace(this);
 
+  if (scavenging_in_parallel_) parallel_scavenger_->Finish();
+
   promotion_queue_.Destroy();
 
   if (!FLAG_watch_ic_patching) {
@@ -1443,17 +1556,26 @@ void Heap::Scavenge() {
   ScavengeWeakObjectRetainer weak_object_retainer(this);
   ProcessWeakReferences(&weak_object_retainer);
 
+  if (FLAG_allocation_site_pretenuring) ProcessPretenuringFeedback();
+
   ASSERT(new_space_front == new_space_.top());
 
   // Set age mark.
   new_space_.set_age_mark(new_space_.top());
 
+  // Update how much has survived scavenge.
+  int survived = static_cast<int>(
+      (PromotedSpaceSizeOfObjects() - survived_watermark) + new_space_.Size());
+  IncrementYoungSurvivorsCounter(survived);
+
+  if (FLAG_dynamic_new_space_sizing) {
+    ResizeNewSpace(allocated, survived, OS::TimeCurrentMillis() - start_time);
+  }
+
   new_space_.LowerInlineAllocationLimit(
       new_space_.inline_allocation_limit_step());
 
-  // Update how much has survived scavenge.
-  IncrementYoungSurvivorsCounter(static_cast<int>(
-      (PromotedSpaceSizeOfObjects() - survived_watermark) + new_space_.Size()));
+  LOG_INTERNAL_EVENT(isolate_, RemoveDeadInternalObjects());
 
   LOG(isolate_, ResourceEvent("scavenge", "end"));
 
@@ -1662,6 +1784,7 @@ void Heap::ProcessWeakReferences(WeakObjectRetainer* retainer) {
       mark_compact_collector()->is_compacting();
   ProcessArrayBuffers(retainer, record_slots);
   ProcessNativeContexts(retainer, record_slots);
+  ProcessAllocationSites(retainer, record_slots);
 }
 
 void Heap::ProcessNativeContexts(WeakObjectRetainer* retainer,
@@ -1744,6 +1867,39 @@ void Heap::ProcessArrayBuffers(WeakObjectRetainer* retainer,
 }
 
 
+template<>
+struct WeakListVisitor<AllocationSite> {
+  static void SetWeakNext(AllocationSite* obj, Object* next) {
+    obj->set_weak_next(next);
+  }
+
+  static Object* WeakNext(AllocationSite* obj) {
+    return obj->weak_next();
+  }
+
+  static void VisitLiveObject(Heap* heap,
+                              AllocationSite* site,
+                              WeakObjectRetainer* retainer,
+                              bool record_slots) {}
+
+  static void VisitPhantomObject(Heap* heap, AllocationSite* phantom) {}
+
+  static int WeakNextOffset() {
+    return AllocationSite::kWeakNextOffset;
+  }
+};
+
+
+void Heap::ProcessAllocationSites(WeakObjectRetainer* retainer,
+                                  bool record_slots) {
+  Object* allocation_site_obj =
+      VisitWeakList<AllocationSite>(this,
+                                    allocation_sites_list(),
+                                    retainer, record_slots);
+  set_allocation_sites_list(allocation_site_obj);
+}
+
+
 void Heap::TearDownArrayBuffers() {
   Object* undefined = undefined_value();
   for (Object* o = array_buffers_list(); o != undefined;) {
@@ -1819,6 +1975,15 @@ class NewSpaceScavenger : public StaticNewSpaceVisitor<NewSpaceScavenger> {
 
 Address Heap::DoScavenge(ObjectVisitor* scavenge_visitor,
                          Address new_space_front) {
+  if (scavenging_in_parallel_) {
+    parallel_scavenger_->ProcessWorklists();
+    StoreBufferRebuildScope scope(this,
+                                  store_buffer(),
+                                  &ScavengeStoreBufferCallback);
+    parallel_scavenger_->FlushRecordedSlots();
+    return new_space_.top();
+  }
+
   do {
     SemiSpace::AssertValidRange(new_space_front, new_space_.top());
     // The addresses new_space_front and new_space_.top() define a
@@ -2000,11 +2165,12 @@ class ScavengingVisitor : public StaticVisitorBase {
     // Copy the content of source to target.
     heap->CopyBlock(target->address(), source->address(), size);
 
+    // The map of source is still readable here.
+    LOG_INTERNAL_EVENT(heap->isolate(),
+                       EmitGCMoveEvent(source, target, size));
+
     // Set the forwarding address.
     source->set_map_word(MapWord::FromForwardingAddress(target));
-	
-	// It's dangerous to retrive the map of source object
-	LOG_INTERNAL_EVENT(heap->isolate(), EmitGCMoveEvent(source, target));
 
     if (logging_and_profiling_mode == LOGGING_AND_PROFILING_ENABLED) {
       // Update NewSpace stats if necessary.
@@ -2272,6 +2438,17 @@ void Heap::SelectScavengingVisitorsTable() {
       (isolate()->heap_profiler() != NULL &&
        isolate()->heap_profiler()->is_profiling());
 
+  // The parallel scavenger neither transfers marks nor reports moves, and it
+  // does not short-circuit cons strings.
+  scavenging_in_parallel_ = parallel_scavenger_ != NULL &&
+      !incremental_marking()->IsMarking() &&
+      !logging_and_profiling &&
+      !FLAG_trace_internals;
+  if (scavenging_in_parallel_) {
+    scavenging_visitors_table_.CopyFrom(ParallelScavenger::GetTable());
+    return;
+  }
+
   if (!incremental_marking()->IsMarking()) {
     if (!logging_and_profiling) {
       scavenging_visitors_table_.CopyFrom(
@@ -2307,12 +2484,56 @@ void Heap::SelectScavengingVisitorsTable() {
 }
 
 
+Code* Heap::TopOptimizedCodeWithoutLazyDeopt() {
+  for (StackFrameIterator it(isolate(), isolate()->thread_local_top());
+       !it.done(); it.Advance()) {
+    if (it.frame()->type() == StackFrame::JAVA_SCRIPT) return NULL;
+    if (it.frame()->type() == StackFrame::OPTIMIZED) {
+      Code* code = it.frame()->LookupCode();
+      return code->CanDeoptAt(it.frame()->pc()) ? NULL : code;
+    }
+  }
+  return NULL;
+}
+
+
+void Heap::ProcessPretenuringFeedback() {
+  bool deopt = false;
+  Code* top_code = TopOptimizedCodeWithoutLazyDeopt();
+  Object* undefined = undefined_value();
+  for (Object* o = allocation_sites_list(); o != undefined;) {
+    AllocationSite* site = AllocationSite::cast(o);
+    // The feedback of a site the top frame depends on is kept for the next
+    // scavenge.
+    if (top_code != NULL && site->dependent_code()->Contains(
+            DependentCode::kAllocationSiteTenuringChangedGroup, top_code)) {
+      o = site->weak_next();
+      continue;
+    }
+    if (site->DigestPretenuringFeedback()) {
+      DependentCode* dependent_code = site->dependent_code();
+      if (dependent_code->MarkCodeForDeoptimization(
+              isolate(), DependentCode::kAllocationSiteTenuringChangedGroup)) {
+        deopt = true;
+      }
+    }
+    o = site->weak_next();
+  }
+  if (deopt) Deoptimizer::DeoptimizeMarkedCode(isolate());
+}
+
+
 void Heap::ScavengeObjectSlow(HeapObject** p, HeapObject* object) {
   SLOW_ASSERT(HEAP->InFromSpace(object));
   MapWord first_word = object->map_word();
   SLOW_ASSERT(!first_word.IsForwardingAddress());
   Map* map = first_word.ToMap();
-  map->GetHeap()->DoScavengeObject(map, p, object);
+  Heap* heap = map->GetHeap();
+  // The parallel scavenger counts the mementos of the objects it copies.
+  if (FLAG_allocation_site_pretenuring && !heap->scavenging_in_parallel_) {
+    heap->UpdateAllocationSiteFeedback(map, object);
+  }
+  heap->DoScavengeObject(map, p, object);
 }
 
 
@@ -2872,6 +3093,20 @@ MaybeObject* Heap::AllocatePropertyCell(Object* value) {
 }
 
 
+MaybeObject* Heap::AllocateAllocationSite(JSObject* boilerplate) {
+  AllocationSite* site;
+  MaybeObject* maybe_result = AllocateStruct(ALLOCATION_SITE_TYPE);
+  if (!maybe_result->To(&site)) return maybe_result;
+  site->Initialize();
+  site->set_transition_info(boilerplate);
+
+  // Link the site into the weak list of allocation sites.
+  site->set_weak_next(allocation_sites_list());
+  set_allocation_sites_list(site);
+  return site;
+}
+
+
 MaybeObject* Heap::AllocateBox(Object* value, PretenureFlag pretenure) {
   Box* result;
   MaybeObject* maybe_result = AllocateStruct(BOX_TYPE);
@@ -4840,7 +5075,7 @@ MaybeObject* Heap::AllocateGlobalObject(JSFunction* constructor) {
 }
 
 
-MaybeObject* Heap::CopyJSObject(JSObject* source) {
+MaybeObject* Heap::CopyJSObject(JSObject* source, PretenureFlag pretenure) {
   // Never used to copy functions.  If functions need to be copied we
   // have to be careful to clear the literals array.
   SLOW_ASSERT(!source->IsJSFunction());
@@ -4854,9 +5089,11 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
 
   // If we're forced to always allocate, we use the general allocation
   // functions which may leave us with an object in old space.
-  if (always_allocate()) {
+  if (always_allocate() || pretenure == TENURED) {
+    AllocationSpace space =
+        pretenure == TENURED ? OLD_POINTER_SPACE : NEW_SPACE;
     { MaybeObject* maybe_clone =
-          AllocateRaw(object_size, NEW_SPACE, OLD_POINTER_SPACE);
+          AllocateRaw(object_size, space, OLD_POINTER_SPACE);
       if (!maybe_clone->ToObject(&clone)) return maybe_clone;
     }
     Address clone_address = HeapObject::cast(clone)->address();
@@ -4892,9 +5129,10 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
       if (elements->map() == fixed_cow_array_map()) {
         maybe_elem = FixedArray::cast(elements);
       } else if (source->HasFastDoubleElements()) {
-        maybe_elem = CopyFixedDoubleArray(FixedDoubleArray::cast(elements));
+        maybe_elem = CopyFixedDoubleArray(FixedDoubleArray::cast(elements),
+                                          pretenure);
       } else {
-        maybe_elem = CopyFixedArray(FixedArray::cast(elements));
+        maybe_elem = CopyFixedArray(FixedArray::cast(elements), pretenure);
       }
       if (!maybe_elem->ToObject(&elem)) return maybe_elem;
     }
@@ -4903,7 +5141,7 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
   // Update properties if necessary.
   if (properties->length() > 0) {
     Object* prop;
-    { MaybeObject* maybe_prop = CopyFixedArray(properties);
+    { MaybeObject* maybe_prop = CopyFixedArray(properties, pretenure);
       if (!maybe_prop->ToObject(&prop)) return maybe_prop;
     }
     JSObject::cast(clone)->set_properties(FixedArray::cast(prop), wb_mode);
@@ -4917,7 +5155,8 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
 }
 
 
-MaybeObject* Heap::CopyJSObjectWithAllocationSite(JSObject* source) {
+MaybeObject* Heap::CopyJSObjectWithAllocationSite(JSObject* source,
+                                                  AllocationSite* site) {
   // Never used to copy functions.  If functions need to be copied we
   // have to be careful to clear the literals array.
   SLOW_ASSERT(!source->IsJSFunction());
@@ -4967,7 +5206,7 @@ MaybeObject* Heap::CopyJSObjectWithAllocationSite(JSObject* source) {
       AllocationSiteInfo* alloc_info;
       if (maybe_alloc_info->To(&alloc_info)) {
         alloc_info->set_map_no_write_barrier(allocation_site_info_map());
-        alloc_info->set_payload(source, SKIP_WRITE_BARRIER);
+        alloc_info->set_payload(site, SKIP_WRITE_BARRIER);
       }
     }
   } else {
@@ -4989,7 +5228,9 @@ MaybeObject* Heap::CopyJSObjectWithAllocationSite(JSObject* source) {
     AllocationSiteInfo* alloc_info = reinterpret_cast<AllocationSiteInfo*>(
         reinterpret_cast<Address>(clone) + object_size);
     alloc_info->set_map_no_write_barrier(allocation_site_info_map());
-    alloc_info->set_payload(source, SKIP_WRITE_BARRIER);
+    alloc_info->set_payload(site, SKIP_WRITE_BARRIER);
+    // Only mementos behind new space objects are found by the scavenger.
+    if (InNewSpace(clone)) site->IncrementMementoCreateCount();
   }
 
   SLOW_ASSERT(
@@ -5456,10 +5697,14 @@ MaybeObject* Heap::AllocateRawFixedArray(int length) {
 }
 
 
-MaybeObject* Heap::CopyFixedArrayWithMap(FixedArray* src, Map* map) {
+MaybeObject* Heap::CopyFixedArrayWithMap(FixedArray* src,
+                                          Map* map,
+                                          PretenureFlag pretenure) {
   int len = src->length();
   Object* obj;
-  { MaybeObject* maybe_obj = AllocateRawFixedArray(len);
+  { MaybeObject* maybe_obj = pretenure == TENURED
+        ? AllocateRawFixedArray(len, TENURED)
+        : AllocateRawFixedArray(len);
     if (!maybe_obj->ToObject(&obj)) return maybe_obj;
   }
   if (InNewSpace(obj)) {
@@ -5483,10 +5728,11 @@ MaybeObject* Heap::CopyFixedArrayWithMap(FixedArray* src, Map* map) {
 
 
 MaybeObject* Heap::CopyFixedDoubleArrayWithMap(FixedDoubleArray* src,
-                                               Map* map) {
+                                               Map* map,
+                                               PretenureFlag pretenure) {
   int len = src->length();
   Object* obj;
-  { MaybeObject* maybe_obj = AllocateRawFixedDoubleArray(len, NOT_TENURED);
+  { MaybeObject* maybe_obj = AllocateRawFixedDoubleArray(len, pretenure);
     if (!maybe_obj->ToObject(&obj)) return maybe_obj;
   }
   HeapObject* dst = HeapObject::cast(obj);
@@ -5911,19 +6157,24 @@ void Heap::AdvanceIdleIncrementalMarking(intptr_t step_size) {
                               IncrementalMarking::NO_GC_VIA_STACK_GUARD);
 
   if (incremental_marking()->IsComplete()) {
-    bool uncommit = false;
-    if (gc_count_at_last_idle_gc_ == gc_count_) {
-      // No GC since the last full GC, the mutator is probably not active.
-      isolate_->compilation_cache()->Clear();
-      uncommit = true;
-    }
-    CollectAllGarbage(kNoGCFlags, "idle notification: finalize incremental");
-    mark_sweeps_since_idle_round_started_++;
-    gc_count_at_last_idle_gc_ = gc_count_;
-    if (uncommit) {
-      new_space_.Shrink();
-      UncommitFromSpace();
-    }
+    FinalizeIdleIncrementalMarking();
+  }
+}
+
+
+void Heap::FinalizeIdleIncrementalMarking() {
+  bool uncommit = false;
+  if (gc_count_at_last_idle_gc_ == gc_count_) {
+    // No GC since the last full GC, the mutator is probably not active.
+    isolate_->compilation_cache()->Clear();
+    uncommit = true;
+  }
+  CollectAllGarbage(kNoGCFlags, "idle notification: finalize incremental");
+  mark_sweeps_since_idle_round_started_++;
+  gc_count_at_last_idle_gc_ = gc_count_;
+  if (uncommit) {
+    new_space_.Shrink();
+    UncommitFromSpace();
   }
 }
 
@@ -6026,6 +6277,166 @@ bool Heap::IdleNotification(int hint) {
 }
 
 
+bool Heap::IdleNotificationDeadline(int idle_time_in_ms) {
+  double deadline = OS::TimeCurrentMillis() + idle_time_in_ms;
+
+  // After context disposal there is likely a lot of garbage remaining, and
+  // a finished idle round is restarted once the mutator made enough of it.
+  if (contexts_disposed_ > 0 ||
+      (mark_sweeps_since_idle_round_started_ >= kMaxMarkSweepsInIdleRound &&
+       EnoughGarbageSinceLastIdleRound())) {
+    StartIdleRound();
+  }
+
+  // The handler is asked again after every action that finishes a phase of
+  // the GC, until nothing more fits into the idle time.  There is at most
+  // one mark-compact per notification; the next one is left for the next
+  // notification, when the mutator may have made more garbage.
+  bool phase_finished = true;
+  while (phase_finished) {
+    double idle_time_left = deadline - OS::TimeCurrentMillis();
+    GCIdleTimeAction action = gc_idle_time_handler_.Compute(
+        idle_time_left, ComputeHeapStateForIdleTime());
+    if (FLAG_trace_idle_notification) {
+      PrintPID("Idle notification: %d ms requested, %.1f ms left, %s",
+               idle_time_in_ms, idle_time_left, action.ToString());
+      if (action.parameter > 0) {
+        PrintF(" (%" V8_PTR_PREFIX "d KB)", action.parameter / KB);
+      }
+      PrintF("\n");
+    }
+    if (action.type == DONE) return true;
+    phase_finished = PerformIdleTimeAction(action);
+    if (mark_sweeps_since_idle_round_started_ >= kMaxMarkSweepsInIdleRound) {
+      FinishIdleRound();
+      return true;
+    }
+  }
+  contexts_disposed_ = 0;
+  return false;
+}
+
+
+GCIdleTimeHandler::HeapState Heap::ComputeHeapStateForIdleTime() {
+  GCIdleTimeHandler::HeapState state;
+  // Tests that expose gc do the full collections themselves.
+  state.contexts_disposed = FLAG_expose_gc ? 0 : contexts_disposed_;
+  state.size_of_objects = SizeOfObjects();
+  state.new_space_size = new_space_.Size();
+  state.new_space_capacity = new_space_.Capacity();
+  state.incremental_marking_stopped = incremental_marking()->IsStopped();
+  state.incremental_marking_complete = incremental_marking()->IsComplete();
+  state.can_start_incremental_marking =
+      FLAG_incremental_marking && FLAG_incremental_marking_steps &&
+      !FLAG_expose_gc && !Serializer::enabled();
+  state.sweeping_in_progress =
+      !mark_compact_collector()->AreSweeperThreadsActivated() &&
+      !IsSweepingComplete();
+  state.idle_round_finished =
+      mark_sweeps_since_idle_round_started_ >= kMaxMarkSweepsInIdleRound;
+  state.remaining_mark_sweeps_in_idle_round =
+      kMaxMarkSweepsInIdleRound - mark_sweeps_since_idle_round_started_;
+  return state;
+}
+
+
+bool Heap::PerformIdleTimeAction(GCIdleTimeAction action) {
+  switch (action.type) {
+    case DONE:
+    case DO_NOTHING:
+      return false;
+    case DO_INCREMENTAL_MARKING: {
+      if (incremental_marking()->IsStopped()) incremental_marking()->Start();
+      double start = OS::TimeCurrentMillis();
+      incremental_marking()->Step(action.parameter,
+                                  IncrementalMarking::NO_GC_VIA_STACK_GUARD);
+      // A step that runs out of work ends early and would overstate the
+      // speed.
+      if (!incremental_marking()->IsComplete()) {
+        gc_idle_time_handler_.RecordMarkingStep(
+            action.parameter, OS::TimeCurrentMillis() - start);
+      }
+      return incremental_marking()->IsComplete();
+    }
+    case DO_FINALIZE_MARKING:
+      FinalizeIdleIncrementalMarking();
+      return false;
+    case DO_SCAVENGE:
+      CollectGarbage(NEW_SPACE, "idle notification: scavenge");
+      return true;
+    case DO_SWEEPING: {
+      double start = OS::TimeCurrentMillis();
+      bool sweeping_complete = AdvanceSweepers(
+          static_cast<int>(action.parameter));
+      if (!sweeping_complete) {
+        gc_idle_time_handler_.RecordSweepingStep(
+            action.parameter, OS::TimeCurrentMillis() - start);
+      }
+      return sweeping_complete;
+    }
+    case DO_FULL_GC:
+      if (contexts_disposed_ > 0) {
+        // Aged inline caches do not keep objects of the old context alive.
+        AgeInlineCaches();
+        HistogramTimerScope scope(isolate_->counters()->gc_context());
+        CollectAllGarbage(kReduceMemoryFootprintMask,
+                          "idle notification: contexts disposed");
+      } else {
+        CollectAllGarbage(kReduceMemoryFootprintMask,
+                          "idle notification: finalize idle round");
+      }
+      mark_sweeps_since_idle_round_started_++;
+      return false;
+  }
+  UNREACHABLE();
+  return false;
+}
+
+
+bool Heap::MemoryReducerNotification() {
+  if (!FLAG_memory_reducer) return true;
+  if (!memory_reducer_.NotifyTick(OS::TimeCurrentMillis(),
+                                  AllocationCounter())) {
+    return memory_reducer_.state() == MemoryReducer::DONE;
+  }
+  intptr_t released = ReduceMemory();
+  memory_reducer_.NotifyRun(OS::TimeCurrentMillis(),
+                            AllocationCounter(),
+                            released);
+  if (FLAG_trace_memory_reducer) {
+    PrintPID("Memory reducer: run %d released %" V8_PTR_PREFIX "d KB, "
+             "%" V8_PTR_PREFIX "d KB committed, %s\n",
+             memory_reducer_.runs(),
+             released / KB,
+             CommittedMemory() / KB,
+             memory_reducer_.state() == MemoryReducer::DONE ? "done" : "wait");
+  }
+  return memory_reducer_.state() == MemoryReducer::DONE;
+}
+
+
+intptr_t Heap::ReduceMemory() {
+  MemoryAllocator* allocator = isolate_->memory_allocator();
+  intptr_t committed_before = CommittedMemory() + allocator->PoolSize();
+  // The mutator has been quiet for a while, so the cached code is unlikely
+  // to be needed soon.
+  isolate_->compilation_cache()->Clear();
+  CollectAllGarbage(kReduceMemoryFootprintMask, "memory reducer");
+  new_space_.Shrink();
+  UncommitFromSpace();
+  incremental_marking()->UncommitMarkingDeque();
+  allocator->ReleasePooledChunks();
+  intptr_t committed = CommittedMemory() + allocator->PoolSize();
+  intptr_t released = Max(committed_before - committed,
+                          static_cast<intptr_t>(0));
+  if (memory_reducer_callback_ != NULL) {
+    memory_reducer_callback_(static_cast<size_t>(released),
+                             static_cast<size_t>(committed));
+  }
+  return released;
+}
+
+
 bool Heap::IdleGlobalGC() {
   static const int kIdlesBeforeScavenge = 4;
   static const int kIdlesBeforeMarkSweep = 7;
@@ -6202,6 +6613,9 @@ bool Heap::InSpace(Address addr, AllocationSpace space) {
 void Heap::Verify() {
   CHECK(HasBeenSetUp());
 
+  // The store buffer verification scans the pages of old pointer space.
+  mark_compact_collector()->EnsurePagesSwept(old_pointer_space());
+
   store_buffer()->Verify();
 
   VerifyPointersVisitor visitor;
@@ -6769,6 +7183,7 @@ V8_DECLARE_ONCE(initialize_gc_once);
 static void InitializeGCOnce() {
   InitializeScavengingVisitorsTables();
   NewSpaceScavenger::Initialize();
+  ParallelScavenger::Initialize();
   MarkCompactCollector::Initialize();
 }
 
@@ -6788,6 +7203,9 @@ bool Heap::SetUp() {
   if (!configured_) {
     if (!ConfigureHeapDefault()) return false;
   }
+  if (scavenge_pause_target_ms_ <= 0) {
+    scavenge_pause_target_ms_ = FLAG_scavenge_pause_target;
+  }
 
   CallOnce(&initialize_gc_once, &InitializeGCOnce);
 
@@ -6874,6 +7292,19 @@ bool Heap::SetUp() {
 
   store_buffer()->SetUp();
 
+  if (FLAG_scavenger_threads > 0) {
+    parallel_scavenger_ =
+        new ParallelScavenger(this, FLAG_scavenger_threads + 1);
+  }
+
+  if (FLAG_concurrent_marking && FLAG_marking_threads > 0) {
+    concurrent_marking_ = new ConcurrentMarking(this, FLAG_marking_threads);
+  }
+
+  if (FLAG_parallel_compaction && FLAG_sweeper_threads > 0) {
+    parallel_evacuator_ = new ParallelEvacuator(this, FLAG_sweeper_threads + 1);
+  }
+
   if (FLAG_parallel_recompilation) relocation_mutex_ = OS::CreateMutex();
 #ifdef DEBUG
   relocation_mutex_locked_by_optimizer_thread_ = false;
@@ -6892,6 +7323,7 @@ bool Heap::CreateHeapObjects() {
 
   native_contexts_list_ = undefined_value();
   array_buffers_list_ = undefined_value();
+  allocation_sites_list_ = undefined_value();
   return true;
 }
 
@@ -6991,6 +7423,15 @@ void Heap::TearDown() {
 
   isolate_->memory_allocator()->TearDown();
 
+  delete parallel_scavenger_;
+  parallel_scavenger_ = NULL;
+
+  delete concurrent_marking_;
+  concurrent_marking_ = NULL;
+
+  delete parallel_evacuator_;
+  parallel_evacuator_ = NULL;
+
   delete relocation_mutex_;
 }
 
@@ -7577,9 +8018,13 @@ GCTracer::GCTracer(Heap* heap,
       heap_(heap),
       gc_reason_(gc_reason),
       collector_reason_(collector_reason) {
-  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
+  // The idle time handler estimates the cost of collections from these.
   start_time_ = OS::TimeCurrentMillis();
   start_object_size_ = heap_->SizeOfObjects();
+  start_new_space_size_ = heap_->new_space()->Size();
+  incremental_marking_in_progress_ = !heap_->incremental_marking()->IsStopped();
+
+  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
   start_memory_size_ = heap_->isolate()->memory_allocator()->Size();
 
   for (int i = 0; i < Scope::kNumberOfScopes; i++) {
@@ -7606,9 +8051,6 @@ GCTracer::GCTracer(Heap* heap,
 
 
 GCTracer::~GCTracer() {
-  // Printf ONE line iff flag is set.
-  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
-
   bool first_gc = (heap_->last_gc_end_timestamp_ == 0);
 
   heap_->alive_after_last_gc_ = heap_->SizeOfObjects();
@@ -7616,6 +8058,16 @@ GCTracer::~GCTracer() {
 
   double time = heap_->last_gc_end_timestamp_ - start_time_;
 
+  if (collector_ == SCAVENGER) {
+    heap_->gc_idle_time_handler_.RecordScavenge(start_new_space_size_, time);
+  } else {
+    heap_->gc_idle_time_handler_.RecordMarkCompact(
+        start_object_size_, time, incremental_marking_in_progress_);
+  }
+
+  // Printf ONE line iff flag is set.
+  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
+
   // Update cumulative GC statistics if required.
   if (FLAG_print_cumulative_gc_stat) {
     heap_->total_gc_time_ms_ += time;
@@ -32,10 +32,12 @@
 
 #include "allocation.h"
 #include "assert-scope.h"
+#include "gc-idle-time-handler.h"
 #include "globals.h"
 #include "incremental-marking.h"
 #include "list.h"
 #include "mark-compact.h"
+#include "memory-reducer.h"
 #include "objects-visiting.h"
 #include "spaces.h"
 #include "splay-tree-inl.h"
@@ -303,6 +305,9 @@ namespace internal {
 class GCTracer;
 class HeapStats;
 class Isolate;
+class ConcurrentMarking;
+class ParallelEvacuator;
+class ParallelScavenger;
 class WeakObjectRetainer;
 
 
@@ -521,6 +526,10 @@ class Heap {
                      intptr_t max_executable_size);
   bool ConfigureHeapDefault();
 
+  // Sets how long a scavenge should take at most, in milliseconds.  With
+  // --dynamic-new-space-sizing the semispaces are sized to meet it.
+  void set_scavenge_pause_target(int ms) { scavenge_pause_target_ms_ = ms; }
+
   // Prepares the heap, setting up memory areas that are needed in the isolate
   // without actually creating any objects.
   bool SetUp();
@@ -716,9 +725,19 @@ class Heap {
   // Returns a deep copy of the JavaScript object.
   // Properties and elements are copied too.
   // Returns failure if allocation failed.
-  MUST_USE_RESULT MaybeObject* CopyJSObject(JSObject* source);
+  MUST_USE_RESULT MaybeObject* CopyJSObject(
+      JSObject* source,
+      PretenureFlag pretenure = NOT_TENURED);
+
+  // Copies an array boilerplate and places a memento pointing to the site
+  // behind the copy, the site counts the mementos it has handed out.
+  MUST_USE_RESULT MaybeObject* CopyJSObjectWithAllocationSite(
+      JSObject* source,
+      AllocationSite* site);
 
-  MUST_USE_RESULT MaybeObject* CopyJSObjectWithAllocationSite(JSObject* source);
+  // Allocates a tenured allocation site for the given array boilerplate and
+  // links it into the list of allocation sites.
+  MUST_USE_RESULT MaybeObject* AllocateAllocationSite(JSObject* boilerplate);
 
   // Allocates the function prototype.
   // Returns Failure::RetryAfterGC(requested_bytes, space) if the allocation
@@ -977,21 +996,29 @@ class Heap {
 
   // Make a copy of src and return it. Returns
   // Failure::RetryAfterGC(requested_bytes, space) if the allocation failed.
-  MUST_USE_RESULT inline MaybeObject* CopyFixedArray(FixedArray* src);
+  MUST_USE_RESULT inline MaybeObject* CopyFixedArray(
+      FixedArray* src,
+      PretenureFlag pretenure = NOT_TENURED);
 
   // Make a copy of src, set the map, and return the copy. Returns
   // Failure::RetryAfterGC(requested_bytes, space) if the allocation failed.
-  MUST_USE_RESULT MaybeObject* CopyFixedArrayWithMap(FixedArray* src, Map* map);
+  MUST_USE_RESULT MaybeObject* CopyFixedArrayWithMap(
+      FixedArray* src,
+      Map* map,
+      PretenureFlag pretenure = NOT_TENURED);
 
   // Make a copy of src and return it. Returns
   // Failure::RetryAfterGC(requested_bytes, space) if the allocation failed.
   MUST_USE_RESULT inline MaybeObject* CopyFixedDoubleArray(
-      FixedDoubleArray* src);
+      FixedDoubleArray* src,
+      PretenureFlag pretenure = NOT_TENURED);
 
   // Make a copy of src, set the map, and return the copy. Returns
   // Failure::RetryAfterGC(requested_bytes, space) if the allocation failed.
   MUST_USE_RESULT MaybeObject* CopyFixedDoubleArrayWithMap(
-      FixedDoubleArray* src, Map* map);
+      FixedDoubleArray* src,
+      Map* map,
+      PretenureFlag pretenure = NOT_TENURED);
 
   // Allocates a fixed array initialized with the hole values.
   // Returns Failure::RetryAfterGC(requested_bytes, space) if the allocation
@@ -1327,6 +1354,10 @@ class Heap {
     global_gc_epilogue_callback_ = callback;
   }
 
+  void SetMemoryReducerCallback(v8::MemoryReducerCallback callback) {
+    memory_reducer_callback_ = callback;
+  }
+
   // Heap root getters.  We have versions with and without type::cast() here.
   // You can't use type::cast during GC because the assert fails.
   // TODO(1490): Try removing the unchecked accessors, now that GC marking does
@@ -1369,6 +1400,16 @@ class Heap {
   }
   Object* array_buffers_list() { return array_buffers_list_; }
 
+  void set_allocation_sites_list(Object* object) {
+    allocation_sites_list_ = object;
+  }
+  Object* allocation_sites_list() { return allocation_sites_list_; }
+
+  // Returns the code of the topmost optimized frame if that frame cannot be
+  // lazily deoptimized at its current pc, NULL otherwise.  Allocation sites
+  // that this code depends on must not change their pretenuring decision.
+  Code* TopOptimizedCodeWithoutLazyDeopt();
+
 
   // Number of mark-sweeps.
   unsigned int ms_count() { return ms_count_; }
@@ -1533,6 +1574,10 @@ class Heap {
   static inline void ScavengePointer(HeapObject** p);
   static inline void ScavengeObject(HeapObject** p, HeapObject* object);
 
+  // Counts the memento behind a surviving array literal, if there is one, as
+  // found by its allocation site.  The object must still be in from space.
+  inline void UpdateAllocationSiteFeedback(Map* map, HeapObject* object);
+
   // Commits from space if it is uncommitted.
   void EnsureFromSpaceIsCommitted();
 
@@ -1616,6 +1661,20 @@ class Heap {
   // Implements the corresponding V8 API function.
   bool IdleNotification(int hint);
 
+  // Implements the corresponding V8 API function.  Only GC work that is
+  // expected to finish within idle_time_in_ms milliseconds is done.
+  bool IdleNotificationDeadline(int idle_time_in_ms);
+
+  // Implements the corresponding V8 API function.
+  bool MemoryReducerNotification();
+
+  // Bytes allocated since the heap was set up, estimated from the growth of
+  // the heap between collections.
+  intptr_t AllocationCounter() {
+    return allocation_counter_ +
+        Max(SizeOfObjects() - alive_after_last_gc_, static_cast<intptr_t>(0));
+  }
+
   // Declare all the root indices.
   enum RootListIndex {
 #define ROOT_INDEX_DECLARATION(type, name, camel_name) k##camel_name##RootIndex,
@@ -1672,6 +1731,12 @@ class Heap {
   // Check new space expansion criteria and expand semispaces if it was hit.
   void CheckNewSpaceExpansionCriteria();
 
+  // Picks the semispace capacity from the allocation rate, the survival
+  // ratio and the scavenging speed, so that scavenges fit into the pause
+  // target and the semispaces do not hold memory the mutator does not use.
+  // Replaces CheckNewSpaceExpansionCriteria with --dynamic-new-space-sizing.
+  void ResizeNewSpace(int allocated, int survived, double pause_ms);
+
   inline void IncrementYoungSurvivorsCounter(int survived) {
     ASSERT(survived >= 0);
     young_survivors_after_last_gc_ = survived;
@@ -1707,6 +1772,9 @@ class Heap {
   // we try to promote this object.
   inline bool ShouldBePromoted(Address old_address, int object_size);
 
+  // True if the object at old_address has already survived a scavenge.
+  inline bool IsBelowAgeMark(Address old_address);
+
   int MaxObjectSizeInNewSpace() { return kMaxObjectSizeInNewSpace; }
 
   void ClearJSFunctionResultCaches();
@@ -1758,6 +1826,21 @@ class Heap {
     return &store_buffer_;
   }
 
+  // NULL unless --parallel-scavenge is on.
+  ParallelScavenger* parallel_scavenger() {
+    return parallel_scavenger_;
+  }
+
+  // NULL unless --concurrent-marking is on.
+  ConcurrentMarking* concurrent_marking() {
+    return concurrent_marking_;
+  }
+
+  // NULL unless --parallel-compaction is on.
+  ParallelEvacuator* parallel_evacuator() {
+    return parallel_evacuator_;
+  }
+
   Marking* marking() {
     return &marking_;
   }
@@ -1940,6 +2023,14 @@ class Heap {
   // scavenge since last new space expansion.
   int survived_since_last_expansion_;
 
+  // For sizing the semispaces with --dynamic-new-space-sizing.  The ratio
+  // and the rates are moving averages over the recent scavenges.
+  int scavenge_pause_target_ms_;
+  int new_space_size_at_last_gc_;
+  double new_space_survival_ratio_;
+  double scavenge_speed_;  // Bytes scavenged per millisecond.
+  double new_space_allocation_rate_;  // Bytes allocated per millisecond.
+
   // For keeping track on when to flush RegExp code.
   int sweep_generation_;
 
@@ -2012,6 +2103,10 @@ class Heap {
   // TODO(hpayer): change to bool if no longer accessed from generated code
   intptr_t new_space_high_promotion_mode_active_;
 
+  // Allocation top of new space before the last flip, objects in from space
+  // lie below it.
+  Address from_space_top_;
+
   // Limit that triggers a global GC on the next (normally caused) GC.  This
   // is checked when we have already decided to do a GC to help determine
   // which collector to invoke, before expanding a paged space in the old
@@ -2040,6 +2135,8 @@ class Heap {
 
   Object* array_buffers_list_;
 
+  Object* allocation_sites_list_;
+
   StoreBufferRebuilder store_buffer_rebuilder_;
 
   struct StringTypeTable {
@@ -2188,6 +2285,8 @@ class Heap {
 
   void ProcessNativeContexts(WeakObjectRetainer* retainer, bool record_slots);
   void ProcessArrayBuffers(WeakObjectRetainer* retainer, bool record_slots);
+  void ProcessAllocationSites(WeakObjectRetainer* retainer,
+                              bool record_slots);
 
   // Called on heap tear-down.
   void TearDownArrayBuffers();
@@ -2199,6 +2298,10 @@ class Heap {
   // Slow part of scavenge object.
   static void ScavengeObjectSlow(HeapObject** p, HeapObject* object);
 
+  // Lets the allocation sites digest the mementos found by the last
+  // scavenge and deoptimizes code that depends on changed decisions.
+  void ProcessPretenuringFeedback();
+
   // Initializes a function with a shared part and prototype.
   // Note: this code was factored out of AllocateFunction such that
   // other parts of the VM could use it. Specifically, a function that creates
@@ -2321,6 +2424,20 @@ class Heap {
 
   void AdvanceIdleIncrementalMarking(intptr_t step_size);
 
+  void FinalizeIdleIncrementalMarking();
+
+  GCIdleTimeHandler::HeapState ComputeHeapStateForIdleTime();
+
+  // Does the work the idle time handler asked for.  Returns true if the
+  // work finished a marking, sweeping or scavenging phase, after which the
+  // handler may ask for more work in the same idle period.
+  bool PerformIdleTimeAction(GCIdleTimeAction action);
+
+  // One run of the memory reducer: a compacting collection that gives the
+  // freed pages back and shrinks the new space to its minimum.  Returns the
+  // bytes of committed memory released.
+  intptr_t ReduceMemory();
+
   void ClearObjectStats(bool clear_last_time_stats = false);
 
   static const int kInitialStringTableSize = 2048;
@@ -2372,6 +2489,14 @@ class Heap {
   unsigned int gc_count_at_last_idle_gc_;
   int scavenges_since_last_idle_round_;
 
+  GCIdleTimeHandler gc_idle_time_handler_;
+
+  MemoryReducer memory_reducer_;
+  v8::MemoryReducerCallback memory_reducer_callback_;
+
+  // AllocationCounter() at the start of the last collection.
+  intptr_t allocation_counter_;
+
   // If the --deopt_every_n_garbage_collections flag is set to a positive value,
   // this variable holds the number of garbage collections since the last
   // deoptimization triggered by garbage collection.
@@ -2397,6 +2522,15 @@ class Heap {
 
   VisitorDispatchTable<ScavengingCallback> scavenging_visitors_table_;
 
+  ParallelScavenger* parallel_scavenger_;
+  // Set by SelectScavengingVisitorsTable when the current scavenge copies
+  // objects with the scavenger threads.
+  bool scavenging_in_parallel_;
+
+  ConcurrentMarking* concurrent_marking_;
+
+  ParallelEvacuator* parallel_evacuator_;
+
   MemoryChunk* chunks_queued_for_free_;
 
   Mutex* relocation_mutex_;
@@ -2811,6 +2945,12 @@ class GCTracer BASE_EMBEDDED {
   // Size of objects in heap set in constructor.
   intptr_t start_object_size_;
 
+  // Size of objects in new space set in constructor.
+  intptr_t start_new_space_size_;
+
+  // Whether the collection finishes incremental marking.
+  bool incremental_marking_in_progress_;
+
   // Size of memory allocated from OS set in constructor.
   intptr_t start_memory_size_;
 
@@ -0,0 +1,436 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "hydrogen-check-elimination.h"
+
+namespace v8 {
+namespace internal {
+
+
+static const int kMaxTrackedObjects = 32;
+
+
+// A set of maps, identified by their unique ids. Sets are never modified
+// once they are in a table, so tables can share them.
+typedef ZoneList<UniqueValueId> MapSet;
+
+
+static bool Contains(const MapSet* set, UniqueValueId map) {
+  for (int i = 0; i < set->length(); ++i) {
+    if (set->at(i) == map) return true;
+  }
+  return false;
+}
+
+
+static bool IsSubset(const MapSet* a, const MapSet* b) {
+  for (int i = 0; i < a->length(); ++i) {
+    if (!Contains(b, a->at(i))) return false;
+  }
+  return true;
+}
+
+
+static MapSet* Copy(const MapSet* set, Zone* zone) {
+  MapSet* result = new(zone) MapSet(set->length(), zone);
+  result->AddAll(*set, zone);
+  return result;
+}
+
+
+static MapSet* Singleton(UniqueValueId map, Zone* zone) {
+  MapSet* result = new(zone) MapSet(1, zone);
+  result->Add(map, zone);
+  return result;
+}
+
+
+static MapSet* Union(const MapSet* a, const MapSet* b, Zone* zone) {
+  MapSet* result = new(zone) MapSet(a->length() + b->length(), zone);
+  result->AddAll(*a, zone);
+  for (int i = 0; i < b->length(); ++i) {
+    if (!Contains(a, b->at(i))) result->Add(b->at(i), zone);
+  }
+  return result;
+}
+
+
+static MapSet* Intersect(const MapSet* a, const MapSet* b, Zone* zone) {
+  MapSet* result = new(zone) MapSet(a->length(), zone);
+  for (int i = 0; i < a->length(); ++i) {
+    if (Contains(b, a->at(i))) result->Add(a->at(i), zone);
+  }
+  return result;
+}
+
+
+static MapSet* Without(const MapSet* set, UniqueValueId map, Zone* zone) {
+  MapSet* result = new(zone) MapSet(set->length(), zone);
+  for (int i = 0; i < set->length(); ++i) {
+    if (set->at(i) != map) result->Add(set->at(i), zone);
+  }
+  return result;
+}
+
+
+// Map checks pass their value through, so what is known about a check is
+// known about the checked value.
+static HValue* ObjectOf(HValue* value) {
+  value = value->ActualValue();
+  while (value->IsCheckMaps()) {
+    value = HCheckMaps::cast(value)->value()->ActualValue();
+  }
+  return value;
+}
+
+
+static bool IsAllocation(HValue* value) {
+  return value->IsAllocate() || value->IsAllocateObject();
+}
+
+
+static bool MayAlias(HValue* a, HValue* b) {
+  if (a == b) return true;
+  // Allocations produce objects that differ from each other and from
+  // anything that existed before, including constants.
+  if (IsAllocation(a)) return !IsAllocation(b) && !b->IsConstant();
+  if (IsAllocation(b)) return !a->IsConstant();
+  return true;
+}
+
+
+// The sets of maps that values are known to have at a point of the graph.
+class HCheckTable : public ZoneObject {
+ public:
+  explicit HCheckTable(Zone* zone)
+      : zone_(zone),
+        objects_(kMaxTrackedObjects, zone),
+        maps_(kMaxTrackedObjects, zone) { }
+
+  HCheckTable* Copy() {
+    HCheckTable* copy = new(zone_) HCheckTable(zone_);
+    copy->objects_.AddAll(objects_, zone_);
+    copy->maps_.AddAll(maps_, zone_);
+    return copy;
+  }
+
+  MapSet* Find(HValue* object) {
+    int index = IndexOf(object);
+    return index < 0 ? NULL : maps_[index];
+  }
+
+  void Insert(HValue* object, MapSet* maps) {
+    int index = IndexOf(object);
+    if (index >= 0) {
+      maps_[index] = maps;
+      return;
+    }
+    if (objects_.length() == kMaxTrackedObjects) RemoveAt(0);
+    objects_.Add(object, zone_);
+    maps_.Add(maps, zone_);
+  }
+
+  void Remove(HValue* object) {
+    int index = IndexOf(object);
+    if (index >= 0) RemoveAt(index);
+  }
+
+  // Forgets the maps of every value that may be the given object.
+  void KillAliases(HValue* object) {
+    for (int i = objects_.length() - 1; i >= 0; --i) {
+      if (MayAlias(objects_[i], object)) RemoveAt(i);
+    }
+  }
+
+  void KillAll() {
+    objects_.Rewind(0);
+    maps_.Rewind(0);
+  }
+
+  // Accounts for an elements kind transition of the given object, which
+  // only happens if the object has the original map.
+  void Transition(HValue* object, UniqueValueId from, UniqueValueId to) {
+    for (int i = 0; i < objects_.length(); ++i) {
+      if (!Contains(maps_[i], from)) continue;
+      if (objects_[i] == object) {
+        maps_[i] = Union(Without(maps_[i], from, zone_),
+                         Singleton(to, zone_), zone_);
+      } else if (MayAlias(objects_[i], object)) {
+        maps_[i] = Union(maps_[i], Singleton(to, zone_), zone_);
+      }
+    }
+  }
+
+  // Keeps the values known on both sides of a join, with the maps they
+  // may have on either side.
+  void Merge(HCheckTable* other) {
+    for (int i = objects_.length() - 1; i >= 0; --i) {
+      MapSet* other_maps = other->Find(objects_[i]);
+      if (other_maps == NULL) {
+        RemoveAt(i);
+      } else {
+        maps_[i] = Union(maps_[i], other_maps, zone_);
+      }
+    }
+  }
+
+ private:
+  int IndexOf(HValue* object) {
+    for (int i = 0; i < objects_.length(); ++i) {
+      if (objects_[i] == object) return i;
+    }
+    return -1;
+  }
+
+  void RemoveAt(int index) {
+    objects_.Remove(index);
+    maps_.Remove(index);
+  }
+
+  Zone* zone_;
+  ZoneList<HValue*> objects_;
+  ZoneList<MapSet*> maps_;
+};
+
+
+HCheckEliminationPhase::HCheckEliminationPhase(HGraph* graph)
+    : HPhase("H_Check elimination", graph),
+      tables_(graph->blocks()->length(), zone()),
+      loop_side_effects_(graph->blocks()->length(), zone()),
+      removed_(0),
+      narrowed_(0) {
+  int block_count = graph->blocks()->length();
+  tables_.AddBlock(NULL, block_count, zone());
+  loop_side_effects_.AddBlock(GVNFlagSet(), block_count, zone());
+}
+
+
+void HCheckEliminationPhase::ComputeLoopSideEffects() {
+  for (int i = graph()->blocks()->length() - 1; i >= 0; --i) {
+    HBasicBlock* block = graph()->blocks()->at(i);
+    int id = block->block_id();
+    GVNFlagSet side_effects;
+    for (HInstructionIterator it(block); !it.Done(); it.Advance()) {
+      side_effects.Add(it.Current()->ChangesFlags());
+    }
+
+    // Loop headers are part of their loop.
+    if (block->IsLoopHeader()) {
+      loop_side_effects_[id].Add(side_effects);
+    }
+
+    // Propagate loop side effects upwards.
+    if (block->HasParentLoopHeader()) {
+      int header_id = block->parent_loop_header()->block_id();
+      loop_side_effects_[header_id].Add(block->IsLoopHeader()
+                                        ? loop_side_effects_[id]
+                                        : side_effects);
+    }
+  }
+}
+
+
+HCheckTable* HCheckEliminationPhase::StateOnEdge(HBasicBlock* predecessor,
+                                                 HBasicBlock* successor) {
+  HCheckTable* table = tables_[predecessor->block_id()];
+  if (table == NULL) return NULL;
+
+  // A map compare tells which map the value has on each of its branches.
+  HControlInstruction* end = predecessor->end();
+  if (end != NULL && end->IsCompareMap() &&
+      end->SuccessorAt(0) != end->SuccessorAt(1)) {
+    HCompareMap* compare = HCompareMap::cast(end);
+    HValue* object = ObjectOf(compare->value());
+    UniqueValueId map = compare->map_unique_id();
+    MapSet* known = table->Find(object);
+    table = table->Copy();
+    if (successor == compare->SuccessorAt(0)) {
+      table->Insert(object, Singleton(map, zone()));
+    } else if (known != NULL) {
+      MapSet* remaining = Without(known, map, zone());
+      if (remaining->is_empty()) {
+        table->Remove(object);
+      } else {
+        table->Insert(object, remaining);
+      }
+    }
+  }
+  return table;
+}
+
+
+HCheckTable* HCheckEliminationPhase::StateAtBlockEntry(HBasicBlock* block) {
+  const ZoneList<HBasicBlock*>* predecessors = block->predecessors();
+  if (predecessors->is_empty()) return new(zone()) HCheckTable(zone());
+
+  ZoneList<HCheckTable*> incoming(predecessors->length(), zone());
+  for (int i = 0; i < predecessors->length(); ++i) {
+    HBasicBlock* predecessor = predecessors->at(i);
+    // Back edges are accounted for by the loop's side effects below.
+    if (block->IsLoopHeader() &&
+        predecessor->block_id() >= block->block_id()) {
+      incoming.Add(NULL, zone());
+      continue;
+    }
+    HCheckTable* edge = StateOnEdge(predecessor, block);
+    if (edge == NULL) return new(zone()) HCheckTable(zone());
+    incoming.Add(edge, zone());
+  }
+
+  HCheckTable* state = NULL;
+  for (int i = 0; i < incoming.length(); ++i) {
+    if (incoming[i] == NULL) continue;
+    if (state == NULL) {
+      state = incoming[i]->Copy();
+    } else {
+      state->Merge(incoming[i]);
+    }
+  }
+  ASSERT(state != NULL);
+
+  if (block->IsLoopHeader()) {
+    GVNFlagSet side_effects = loop_side_effects_[block->block_id()];
+    if (side_effects.Contains(kChangesMaps) ||
+        side_effects.Contains(kChangesElementsKind)) {
+      state->KillAll();
+    }
+  } else {
+    // A phi has one of the maps of its inputs.
+    for (int i = 0; i < block->phis()->length(); ++i) {
+      HPhi* phi = block->phis()->at(i);
+      MapSet* maps = NULL;
+      for (int j = 0; j < phi->OperandCount(); ++j) {
+        MapSet* input_maps = incoming[j]->Find(ObjectOf(phi->OperandAt(j)));
+        if (input_maps == NULL) {
+          maps = NULL;
+          break;
+        }
+        maps = maps == NULL ? input_maps : Union(maps, input_maps, zone());
+      }
+      if (maps != NULL) state->Insert(phi, maps);
+    }
+  }
+  return state;
+}
+
+
+void HCheckEliminationPhase::ReduceCheckMaps(HCheckMaps* check,
+                                             HCheckTable* table) {
+  HValue* object = ObjectOf(check->value());
+  const MapSet* checked = check->map_unique_ids();
+  if (checked->length() != check->map_set()->length()) {
+    // The unique ids of the maps have not been computed.
+    table->Remove(object);
+    return;
+  }
+
+  MapSet* known = table->Find(object);
+  if (known != NULL) {
+    if (IsSubset(known, checked)) {
+      if (FLAG_trace_check_elimination) {
+        PrintF("Removing check-maps %d of #%d\n", check->id(), object->id());
+      }
+      check->DeleteAndReplaceWith(check->value());
+      removed_++;
+      return;
+    }
+    MapSet* intersection = Intersect(checked, known, zone());
+    if (!intersection->is_empty()) {
+      if (intersection->length() < checked->length()) {
+        if (FLAG_trace_check_elimination) {
+          PrintF("Narrowing check-maps %d of #%d from %d to %d maps\n",
+                 check->id(), object->id(), checked->length(),
+                 intersection->length());
+        }
+        for (int i = checked->length() - 1; i >= 0; --i) {
+          if (!Contains(known, checked->at(i))) check->RemoveMapAt(i);
+        }
+        narrowed_++;
+      }
+      table->Insert(object, intersection);
+      return;
+    }
+  }
+  table->Insert(object, Copy(checked, zone()));
+}
+
+
+void HCheckEliminationPhase::ProcessBlock(HBasicBlock* block,
+                                          HCheckTable* table) {
+  HInstruction* instr = block->first();
+  while (instr != NULL) {
+    HInstruction* next = instr->next();
+    if (instr->IsCheckMaps()) {
+      ReduceCheckMaps(HCheckMaps::cast(instr), table);
+    } else if (instr->IsStoreNamedField()) {
+      HStoreNamedField* store = HStoreNamedField::cast(instr);
+      HValue* object = ObjectOf(store->object());
+      if (store->access().Equals(HObjectAccess::ForMap())) {
+        table->KillAliases(object);
+        if (store->value()->IsConstant()) {
+          HConstant* map = HConstant::cast(store->value());
+          table->Insert(object, Singleton(map->unique_id(), zone()));
+        }
+      } else if (!store->transition().is_null()) {
+        table->KillAliases(object);
+        table->Insert(object,
+                      Singleton(store->transition_unique_id(), zone()));
+      }
+    } else if (instr->IsTransitionElementsKind()) {
+      HTransitionElementsKind* transition =
+          HTransitionElementsKind::cast(instr);
+      table->Transition(ObjectOf(transition->object()),
+                        transition->original_map_unique_id(),
+                        transition->transitioned_map_unique_id());
+    } else {
+      GVNFlagSet changes = instr->ChangesFlags();
+      if (changes.Contains(kChangesMaps) ||
+          changes.Contains(kChangesElementsKind)) {
+        table->KillAll();
+      }
+    }
+    instr = next;
+  }
+}
+
+
+void HCheckEliminationPhase::EliminateChecks() {
+  // Blocks are ordered so that all forward predecessors of a block come
+  // before it.
+  for (int i = 0; i < graph()->blocks()->length(); ++i) {
+    HBasicBlock* block = graph()->blocks()->at(i);
+    HCheckTable* table = StateAtBlockEntry(block);
+    ProcessBlock(block, table);
+    tables_[block->block_id()] = table;
+  }
+  if (FLAG_trace_check_elimination) {
+    PrintF("Removed %d and narrowed %d map checks\n", removed_, narrowed_);
+  }
+}
+
+
+} }  // namespace v8::internal
@@ -31,21 +31,194 @@ namespace v8 {
 namespace internal {
 
 
-void HEscapeAnalysisPhase::CollectIfNoEscapingUses(HInstruction* instr) {
-  for (HUseIterator it(instr->uses()); !it.Done(); it.Advance()) {
+// Checks whether a named field access can be tracked as a scalar value of an
+// allocation with the given size.
+static bool IsCapturableFieldAccess(HObjectAccess access, int size) {
+  int offset = access.offset();
+  return access.IsInobject() &&
+      offset >= 0 &&
+      offset < size &&
+      offset % kPointerSize == 0;
+}
+
+
+// Checks whether a keyed access into an allocated fixed array with the given
+// size uses a constant key that refers to one of the allocated elements.
+static bool IsCapturableElementAccess(HValue* key, int size) {
+  HValue* actual_key = key->ActualValue();
+  if (!actual_key->IsInteger32Constant()) return false;
+  int index = actual_key->GetInteger32Constant();
+  int length = (size - FixedArray::kHeaderSize) / kPointerSize;
+  return index >= 0 && index < length;
+}
+
+
+void HEscapeAnalysisPhase::Run() {
+  // Captured objects are not supported in OSR entries, because values that
+  // are live across the OSR entry could not be described there.
+  if (graph()->has_osr()) return;
+  if (graph()->info()->IsStub()) return;
+  for (int i = 0; i < FLAG_escape_analysis_iterations; i++) {
+    CollectCapturedValues();
+    if (captured_.is_empty()) break;
+    PerformScalarReplacement();
+    captured_.Clear();
+  }
+}
+
+
+bool HEscapeAnalysisPhase::HasNoEscapingUses(HValue* value,
+                                             HAllocate* allocate,
+                                             int size) {
+  for (HUseIterator it(value->uses()); !it.Done(); it.Advance()) {
     HValue* use = it.value();
-    if (use->HasEscapingOperandAt(it.index())) {
+    int index = it.index();
+    bool escapes = true;
+    switch (use->opcode()) {
+      case HValue::kSimulate:
+      case HValue::kCapturedObject:
+        escapes = false;
+        break;
+      case HValue::kCheckHeapObject:
+        escapes = !HasNoEscapingUses(use, allocate, size);
+        break;
+      case HValue::kCheckMaps:
+        if (index == 0) {
+          map_checks_.Add(HCheckMaps::cast(use), zone());
+          escapes = !HasNoEscapingUses(use, allocate, size);
+        } else {
+          // The allocation is only used as a type check dependency.
+          escapes = false;
+        }
+        break;
+      case HValue::kLoadNamedField: {
+        HLoadNamedField* load = HLoadNamedField::cast(use);
+        escapes = index == 0 &&
+            !IsCapturableFieldAccess(load->access(), size);
+        break;
+      }
+      case HValue::kStoreNamedField: {
+        HStoreNamedField* store = HStoreNamedField::cast(use);
+        if (index != 0) break;
+        if (!IsCapturableFieldAccess(store->access(), size)) break;
+        escapes = false;
+        if (store->access().offset() == HeapObject::kMapOffset) {
+          HValue* map = store->value();
+          if (map->IsConstant() &&
+              HConstant::cast(map)->unique_id().IsInitialized()) {
+            stored_maps_.Add(HConstant::cast(map)->unique_id(), zone());
+          } else {
+            escapes = true;
+          }
+        }
+        if (!store->transition().is_null()) {
+          stored_maps_.Add(store->transition_unique_id(), zone());
+        }
+        break;
+      }
+      case HValue::kLoadKeyed: {
+        HLoadKeyed* load = HLoadKeyed::cast(use);
+        ElementsKind kind = load->elements_kind();
+        if (index == 2) {
+          // The allocation is only used as a load dependency.
+          escapes = false;
+        } else if (index == 0) {
+          // Only loads from packed backing stores are tracked, loads from
+          // holey backing stores would need to check for the hole.
+          escapes = !IsFastSmiOrObjectElementsKind(kind) ||
+              IsFastHoleyElementsKind(kind) ||
+              !IsCapturableElementAccess(load->key(), size);
+        }
+        break;
+      }
+      case HValue::kStoreKeyed: {
+        HStoreKeyed* store = HStoreKeyed::cast(use);
+        ElementsKind kind = store->elements_kind();
+        if (index == 0) {
+          escapes = !(IsFastObjectElementsKind(kind) ||
+                      kind == FAST_SMI_ELEMENTS) ||
+              !IsCapturableElementAccess(store->key(), size);
+        }
+        break;
+      }
+      case HValue::kInnerAllocatedObject: {
+        // The allocation site info placed behind an object is dropped when
+        // the object is captured, it is only ever initialized.
+        HInnerAllocatedObject* inner = HInnerAllocatedObject::cast(use);
+        if (inner->offset() + AllocationSiteInfo::kSize != size) break;
+        escapes = false;
+        for (HUseIterator it(inner->uses()); !it.Done(); it.Advance()) {
+          if (!it.value()->IsStoreNamedField() || it.index() != 0) {
+            escapes = true;
+            break;
+          }
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    if (escapes) {
       if (FLAG_trace_escape_analysis) {
-        PrintF("#%d (%s) escapes through #%d (%s) @%d\n", instr->id(),
-               instr->Mnemonic(), use->id(), use->Mnemonic(), it.index());
+        PrintF("#%d (%s) escapes through #%d (%s) @%d\n", allocate->id(),
+               allocate->Mnemonic(), use->id(), use->Mnemonic(), index);
       }
-      return;
+      return false;
     }
   }
-  if (FLAG_trace_escape_analysis) {
-    PrintF("#%d (%s) is being captured\n", instr->id(), instr->Mnemonic());
+  return true;
+}
+
+
+bool HEscapeAnalysisPhase::HasCapturableMaps(HAllocate* allocate) {
+  if (stored_maps_.is_empty()) return false;
+
+  // The deoptimizer can only materialize heap numbers, fixed arrays and
+  // objects with fast properties that were allocated as such.
+  Heap* heap = isolate()->heap();
+  UniqueValueId heap_number_map(heap->heap_number_map());
+  UniqueValueId fixed_array_map(heap->fixed_array_map());
+  UniqueValueId fixed_double_array_map(heap->fixed_double_array_map());
+  UniqueValueId free_space_map(heap->free_space_map());
+  int heap_numbers = 0;
+  int fixed_arrays = 0;
+  for (int i = 0; i < stored_maps_.length(); i++) {
+    UniqueValueId map = stored_maps_[i];
+    if (map == heap_number_map) {
+      heap_numbers++;
+    } else if (map == fixed_array_map) {
+      fixed_arrays++;
+    } else if (map == fixed_double_array_map || map == free_space_map) {
+      return false;
+    }
+  }
+  int count = stored_maps_.length();
+  if (heap_numbers != 0 || fixed_arrays != 0) {
+    if (heap_numbers != count && fixed_arrays != count) return false;
+  } else if (!allocate->CalculateInferredType().IsJSObject()) {
+    return false;
+  }
+
+  // Map checks can only be removed when they are known to succeed for all
+  // the maps the object might have.
+  for (int i = 0; i < map_checks_.length(); i++) {
+    const ZoneList<UniqueValueId>* checked = map_checks_[i]->map_unique_ids();
+    for (int j = 0; j < stored_maps_.length(); j++) {
+      if (!checked->Contains(stored_maps_[j])) return false;
+    }
   }
-  captured_.Add(instr, zone());
+  return true;
+}
+
+
+bool HEscapeAnalysisPhase::IsCapturable(HAllocate* allocate) {
+  if (!allocate->size()->IsInteger32Constant()) return false;
+  int size = allocate->size()->GetInteger32Constant();
+  if (size <= 0 || size % kPointerSize != 0) return false;
+  stored_maps_.Clear();
+  map_checks_.Clear();
+  return HasNoEscapingUses(allocate, allocate, size) &&
+      HasCapturableMaps(allocate);
 }
 
 
@@ -55,10 +228,302 @@ void HEscapeAnalysisPhase::CollectCapturedValues() {
     HBasicBlock* block = graph()->blocks()->at(i);
     for (HInstructionIterator it(block); !it.Done(); it.Advance()) {
       HInstruction* instr = it.Current();
-      if (instr->IsAllocate() || instr->IsAllocateObject()) {
-        CollectIfNoEscapingUses(instr);
+      if (!instr->IsAllocate()) continue;
+      if (!IsCapturable(HAllocate::cast(instr))) continue;
+      if (FLAG_trace_escape_analysis) {
+        PrintF("#%d (%s) is being captured\n", instr->id(), instr->Mnemonic());
+      }
+      captured_.Add(instr, zone());
+    }
+  }
+}
+
+
+HPhi* HEscapeAnalysisPhase::NewPhiAndInsert(
+    HBasicBlock* block, HValue* incoming_value, int index) {
+  Zone* zone = graph()->zone();
+  HPhi* phi = new(zone) HPhi(HPhi::kInvalidMergedIndex, zone);
+  for (int i = 0; i < block->predecessors()->length(); i++) {
+    phi->AddInput(incoming_value);
+  }
+  block->AddPhi(phi);
+  return phi;
+}
+
+
+HValue* HEscapeAnalysisPhase::NewStoredValue(HInstruction* store,
+                                             HValue* value,
+                                             Representation representation) {
+  // Stores into tracked fields still have to enforce the representation of
+  // the field, a mismatch deoptimizes just like the original store would.
+  if (!representation.IsSmi() && !representation.IsDouble()) return value;
+  if (value->representation().Equals(representation)) return value;
+  HInstruction* forced =
+      new(graph()->zone()) HForceRepresentation(value, representation);
+  forced->InsertBefore(store);
+  return forced;
+}
+
+
+HCapturedObject* HEscapeAnalysisPhase::NewState(HInstruction* previous) {
+  Zone* zone = graph()->zone();
+  HCapturedObject* state =
+      new(zone) HCapturedObject(number_of_values_, number_of_objects_, zone);
+  state->InsertAfter(previous);
+  return state;
+}
+
+
+// Create a new state for replacing HAllocate instructions.
+HCapturedObject* HEscapeAnalysisPhase::NewStateForAllocation(
+    HInstruction* previous) {
+  HConstant* undefined = graph()->GetConstantUndefined();
+  HCapturedObject* state = NewState(previous);
+  for (int index = 0; index < number_of_values_; index++) {
+    state->SetOperandAt(index, undefined);
+  }
+  return state;
+}
+
+
+// Create a new state full of phis for loop header entries.
+HCapturedObject* HEscapeAnalysisPhase::NewStateForLoopHeader(
+    HInstruction* previous, HCapturedObject* old_state) {
+  HBasicBlock* block = previous->block();
+  HCapturedObject* state = NewState(previous);
+  for (int index = 0; index < number_of_values_; index++) {
+    HValue* operand = old_state->OperandAt(index);
+    HPhi* phi = NewPhiAndInsert(block, operand, index);
+    state->SetOperandAt(index, phi);
+  }
+  return state;
+}
+
+
+// Create a new state by copying an existing one.
+HCapturedObject* HEscapeAnalysisPhase::NewStateCopy(
+    HInstruction* previous, HCapturedObject* old_state) {
+  HCapturedObject* state = NewState(previous);
+  for (int index = 0; index < number_of_values_; index++) {
+    HValue* operand = old_state->OperandAt(index);
+    state->SetOperandAt(index, operand);
+  }
+  return state;
+}
+
+
+// Create a new state by copying an existing one, the new state describes the
+// object right after the given store has been performed.
+HCapturedObject* HEscapeAnalysisPhase::NewStateBeforeStore(
+    HInstruction* store, HCapturedObject* old_state) {
+  Zone* zone = graph()->zone();
+  HCapturedObject* state =
+      new(zone) HCapturedObject(number_of_values_, number_of_objects_, zone);
+  state->InsertBefore(store);
+  for (int index = 0; index < number_of_values_; index++) {
+    state->SetOperandAt(index, old_state->OperandAt(index));
+  }
+  return state;
+}
+
+
+// Analyze the data-flow of the given allocation and replace all loads and
+// stores of its fields by the values tracked in captured object states.
+void HEscapeAnalysisPhase::AnalyzeDataFlow(HInstruction* allocate) {
+  HBasicBlock* allocate_block = allocate->block();
+  block_states_.AddBlock(NULL, graph()->blocks()->length(), zone());
+
+  // Iterate all blocks starting with the allocation block, since the
+  // allocation cannot dominate blocks that come before.
+  int start = allocate_block->block_id();
+  for (int i = start; i < graph()->blocks()->length(); i++) {
+    HBasicBlock* block = graph()->blocks()->at(i);
+    HCapturedObject* state = StateAt(block);
+
+    // Skip blocks that are not dominated by the captured allocation.
+    if (!allocate_block->Dominates(block) && allocate_block != block) continue;
+    if (FLAG_trace_escape_analysis) {
+      PrintF("Analyzing data-flow in B%d\n", block->block_id());
+    }
+
+    // Go through all instructions of the current block.
+    for (HInstructionIterator it(block); !it.Done(); it.Advance()) {
+      HInstruction* instr = it.Current();
+      switch (instr->opcode()) {
+        case HValue::kAllocate: {
+          if (instr != allocate) continue;
+          state = NewStateForAllocation(allocate);
+          break;
+        }
+        case HValue::kCheckHeapObject: {
+          HCheckHeapObject* check = HCheckHeapObject::cast(instr);
+          if (check->value() != allocate) continue;
+          check->DeleteAndReplaceWith(allocate);
+          break;
+        }
+        case HValue::kCheckMaps: {
+          HCheckMaps* check = HCheckMaps::cast(instr);
+          if (check->value() == allocate) {
+            // The maps were verified to be known when collecting the
+            // allocation, hence the check always succeeds.
+            check->DeleteAndReplaceWith(allocate);
+          } else if (check->OperandAt(1) == allocate) {
+            check->SetOperandAt(1, check->value());
+          }
+          break;
+        }
+        case HValue::kLoadNamedField: {
+          HLoadNamedField* load = HLoadNamedField::cast(instr);
+          if (load->object() == allocate) {
+            int index = load->access().offset() / kPointerSize;
+            HValue* replacement = state->OperandAt(index);
+            if (FLAG_trace_escape_analysis) {
+              PrintF("Replacing load #%d with #%d (%s)\n", instr->id(),
+                     replacement->id(), replacement->Mnemonic());
+            }
+            load->DeleteAndReplaceWith(replacement);
+          } else if (load->OperandAt(1) == allocate) {
+            load->SetOperandAt(1, load->object());
+          }
+          break;
+        }
+        case HValue::kLoadKeyed: {
+          HLoadKeyed* load = HLoadKeyed::cast(instr);
+          if (load->elements() == allocate) {
+            int key = load->key()->ActualValue()->GetInteger32Constant();
+            int index = FixedArray::kHeaderSize / kPointerSize + key;
+            HValue* replacement = state->OperandAt(index);
+            if (FLAG_trace_escape_analysis) {
+              PrintF("Replacing load #%d with #%d (%s)\n", instr->id(),
+                     replacement->id(), replacement->Mnemonic());
+            }
+            load->DeleteAndReplaceWith(replacement);
+          } else if (load->OperandAt(2) == allocate) {
+            load->SetOperandAt(2, load->elements());
+          }
+          break;
+        }
+        case HValue::kStoreNamedField: {
+          HStoreNamedField* store = HStoreNamedField::cast(instr);
+          if (store->object() != allocate) continue;
+          int index = store->access().offset() / kPointerSize;
+          HValue* value = NewStoredValue(store, store->value(),
+              store->RequiredInputRepresentation(1));
+          state = NewStateBeforeStore(store, state);
+          state->SetOperandAt(index, value);
+          if (!store->transition().is_null()) {
+            HConstant* transition = new(graph()->zone()) HConstant(
+                store->transition(), store->transition_unique_id(),
+                Representation::Tagged(), HType::Tagged(),
+                false, true, true);
+            transition->InsertBefore(store);
+            state->SetOperandAt(0, transition);
+          }
+          if (FLAG_trace_escape_analysis) {
+            PrintF("Replacing store #%d with state #%d\n", instr->id(),
+                   state->id());
+          }
+          store->DeleteAndReplaceWith(NULL);
+          break;
+        }
+        case HValue::kStoreKeyed: {
+          HStoreKeyed* store = HStoreKeyed::cast(instr);
+          if (store->elements() != allocate) continue;
+          int key = store->key()->ActualValue()->GetInteger32Constant();
+          int index = FixedArray::kHeaderSize / kPointerSize + key;
+          HValue* value = NewStoredValue(store, store->value(),
+              store->RequiredInputRepresentation(2));
+          state = NewStateBeforeStore(store, state);
+          state->SetOperandAt(index, value);
+          if (FLAG_trace_escape_analysis) {
+            PrintF("Replacing store #%d with state #%d\n", instr->id(),
+                   state->id());
+          }
+          store->DeleteAndReplaceWith(NULL);
+          break;
+        }
+        case HValue::kInnerAllocatedObject: {
+          HInnerAllocatedObject* inner = HInnerAllocatedObject::cast(instr);
+          if (inner->base_object() != allocate) continue;
+          // Delete the initializing stores first, they are only reachable
+          // through the use list of the inner object.
+          while (!inner->HasNoUses()) {
+            HUseIterator use_it(inner->uses());
+            HInstruction::cast(use_it.value())->DeleteAndReplaceWith(NULL);
+          }
+          inner->DeleteAndReplaceWith(NULL);
+          break;
+        }
+        case HValue::kSimulate:
+        case HValue::kCapturedObject: {
+          if (state == NULL) continue;
+          for (int index = 0; index < instr->OperandCount(); index++) {
+            if (instr->OperandAt(index) != allocate) continue;
+            instr->SetOperandAt(index, state);
+          }
+          break;
+        }
+        default:
+          break;
       }
     }
+
+    // Propagate the block state forward to all successor blocks.
+    for (int j = 0; j < block->end()->SuccessorCount(); j++) {
+      HBasicBlock* succ = block->end()->SuccessorAt(j);
+      if (!allocate_block->Dominates(succ)) continue;
+      if (succ->predecessors()->length() == 1) {
+        // Case 1: This is the only predecessor, just reuse state.
+        SetStateAt(succ, state);
+      } else if (StateAt(succ) == NULL && succ->IsLoopHeader()) {
+        // Case 2: This is a state that enters a loop header, be
+        // pessimistic about loop headers, add phis for all values.
+        SetStateAt(succ, NewStateForLoopHeader(succ->first(), state));
+      } else if (StateAt(succ) == NULL) {
+        // Case 3: This is the first state propagated forward to the
+        // successor, leave a copy of the current state.
+        SetStateAt(succ, NewStateCopy(succ->first(), state));
+      } else {
+        // Case 4: This is a state that needs merging with previously
+        // propagated states, potentially introducing new phis lazily or
+        // adding values to existing phis.
+        HCapturedObject* succ_state = StateAt(succ);
+        for (int index = 0; index < number_of_values_; index++) {
+          HValue* operand = state->OperandAt(index);
+          HValue* succ_operand = succ_state->OperandAt(index);
+          if (succ_operand->IsPhi() && succ_operand->block() == succ) {
+            // Phi already exists, add operand.
+            HPhi* phi = HPhi::cast(succ_operand);
+            phi->SetOperandAt(succ->PredecessorIndexOf(block), operand);
+          } else if (succ_operand != operand) {
+            // Phi does not exist, introduce one.
+            HPhi* phi = NewPhiAndInsert(succ, succ_operand, index);
+            phi->SetOperandAt(succ->PredecessorIndexOf(block), operand);
+            succ_state->SetOperandAt(index, phi);
+          }
+        }
+      }
+    }
+  }
+
+  // All uses have been handled.
+  ASSERT(allocate->HasNoUses());
+  allocate->DeleteAndReplaceWith(NULL);
+}
+
+
+void HEscapeAnalysisPhase::PerformScalarReplacement() {
+  for (int i = 0; i < captured_.length(); i++) {
+    HAllocate* allocate = HAllocate::cast(captured_.at(i));
+
+    // Compute number of scalar values and start with clean slate.
+    int size_in_bytes = allocate->size()->GetInteger32Constant();
+    number_of_values_ = size_in_bytes / kPointerSize;
+    number_of_objects_++;
+    block_states_.Clear();
+
+    // Perform actual analysis steps.
+    AnalyzeDataFlow(allocate);
   }
 }
 
@@ -35,20 +35,70 @@ namespace v8 {
 namespace internal {
 
 
+// Finds allocations that do not escape the optimized function and replaces
+// them by scalar values (scalar replacement). Loads and stores of fields of a
+// captured allocation become SSA values, the object itself is described by
+// HCapturedObject states so that the deoptimizer can materialize it again.
 class HEscapeAnalysisPhase : public HPhase {
  public:
   explicit HEscapeAnalysisPhase(HGraph* graph)
-      : HPhase("H_Escape analysis", graph), captured_(0, zone()) { }
+      : HPhase("H_Escape analysis", graph),
+        captured_(0, zone()),
+        stored_maps_(0, zone()),
+        map_checks_(0, zone()),
+        number_of_objects_(0),
+        number_of_values_(0),
+        block_states_(graph->blocks()->length(), zone()) { }
 
-  void Run() {
-    CollectCapturedValues();
-  }
+  void Run();
 
  private:
   void CollectCapturedValues();
-  void CollectIfNoEscapingUses(HInstruction* instr);
+  bool IsCapturable(HAllocate* allocate);
+  bool HasNoEscapingUses(HValue* value, HAllocate* allocate, int size);
+  bool HasCapturableMaps(HAllocate* allocate);
+  void PerformScalarReplacement();
+  void AnalyzeDataFlow(HInstruction* instr);
+
+  HCapturedObject* NewState(HInstruction* previous);
+  HCapturedObject* NewStateForAllocation(HInstruction* previous);
+  HCapturedObject* NewStateForLoopHeader(HInstruction* previous,
+                                         HCapturedObject* old_state);
+  HCapturedObject* NewStateCopy(HInstruction* previous,
+                                HCapturedObject* old_state);
+  HCapturedObject* NewStateBeforeStore(HInstruction* store,
+                                       HCapturedObject* old_state);
+
+  HPhi* NewPhiAndInsert(HBasicBlock* block, HValue* incoming_value, int index);
+  HValue* NewStoredValue(HInstruction* store,
+                         HValue* value,
+                         Representation representation);
+
+  HCapturedObject* StateAt(HBasicBlock* block) {
+    return block_states_.at(block->block_id());
+  }
+
+  void SetStateAt(HBasicBlock* block, HCapturedObject* state) {
+    block_states_.Set(block->block_id(), state);
+  }
+
+  // List of allocations captured during the collection phase.
+  ZoneList<HInstruction*> captured_;
+
+  // Maps stored into and maps checked on the allocation that is currently
+  // being examined by the collection phase.
+  ZoneList<UniqueValueId> stored_maps_;
+  ZoneList<HCheckMaps*> map_checks_;
+
+  // Number of captured objects on which scalar replacement was done.
+  int number_of_objects_;
+
+  // Number of scalar values tracked for the current captured object.
+  int number_of_values_;
 
-  ZoneList<HValue*> captured_;
+  // Map of block IDs to the data-flow state at block entry during the
+  // scalar replacement phase.
+  ZoneList<HCapturedObject*> block_states_;
 };
 
 
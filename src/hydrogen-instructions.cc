@@ -1674,6 +1674,13 @@ void HCheckMaps::SetSideEffectDominator(GVNFlag side_effect,
 }
 
 
+void HCheckMaps::RemoveMapAt(int index) {
+  ASSERT(map_set_.length() == map_unique_ids_.length());
+  map_set_.Remove(map_set_.at(index));
+  map_unique_ids_.Remove(index);
+}
+
+
 void HCheckMaps::PrintDataTo(StringStream* stream) {
   value()->PrintNameTo(stream);
   stream->Add(" [%p", *map_set()->first());
@@ -2137,6 +2144,59 @@ void HSimulate::PrintDataTo(StringStream* stream) {
 }
 
 
+void HCapturedObject::PrintDataTo(StringStream* stream) {
+  stream->Add("#%d", capture_id());
+  for (int i = 0; i < length(); ++i) {
+    stream->Add(" ");
+    OperandAt(i)->PrintNameTo(stream);
+  }
+}
+
+
+// Returns the value that has to replace the given environment value after a
+// new state of a captured object became active, or NULL if the value does not
+// describe the same captured object. States of other captured objects that
+// contain the object are copied rather than modified, because they might be
+// shared with environments of other blocks.
+HValue* HCapturedObject::ReplayValue(HValue* value,
+                                     HCapturedObject* state,
+                                     Zone* zone) {
+  if (value == NULL || !value->IsCapturedObject()) return NULL;
+  HCapturedObject* captured = HCapturedObject::cast(value);
+  if (captured->capture_id() == state->capture_id()) {
+    return captured == state ? NULL : state;
+  }
+  HCapturedObject* copy = NULL;
+  for (int i = 0; i < captured->length(); ++i) {
+    HValue* replacement = ReplayValue(captured->OperandAt(i), state, zone);
+    if (replacement == NULL) continue;
+    if (copy == NULL) {
+      copy = new(zone) HCapturedObject(captured->length(),
+                                       captured->capture_id(),
+                                       zone);
+      for (int j = 0; j < captured->length(); ++j) {
+        copy->InternalSetOperandAt(j, captured->OperandAt(j));
+      }
+    }
+    // The copy is never linked into the graph, so it does not register any
+    // uses of its operands.
+    copy->InternalSetOperandAt(i, replacement);
+  }
+  return copy;
+}
+
+
+void HCapturedObject::ReplayEnvironment(HEnvironment* env) {
+  while (env != NULL) {
+    for (int i = 0; i < env->length(); ++i) {
+      HValue* replacement = ReplayValue(env->values()->at(i), this, env->zone());
+      if (replacement != NULL) env->SetValueAt(i, replacement);
+    }
+    env = env->outer();
+  }
+}
+
+
 void HDeoptimize::PrintDataTo(StringStream* stream) {
   if (OperandCount() == 0) return;
   OperandAt(0)->PrintNameTo(stream);
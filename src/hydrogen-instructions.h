@@ -87,6 +87,7 @@ class LChunkBuilder;
   V(CallNewArray)                              \
   V(CallRuntime)                               \
   V(CallStub)                                  \
+  V(CapturedObject)                            \
   V(Change)                                    \
   V(CheckFunction)                             \
   V(CheckHeapObject)                           \
@@ -1654,15 +1655,21 @@ class HCompareMap: public HUnaryControlInstruction {
   virtual void PrintDataTo(StringStream* stream);
 
   Handle<Map> map() const { return map_; }
+  UniqueValueId map_unique_id() const { return map_unique_id_; }
 
   virtual Representation RequiredInputRepresentation(int index) {
     return Representation::Tagged();
   }
 
+  virtual void FinalizeUniqueValueId() {
+    map_unique_id_ = UniqueValueId(map_);
+  }
+
   DECLARE_CONCRETE_INSTRUCTION(CompareMap)
 
  private:
   Handle<Map> map_;
+  UniqueValueId map_unique_id_;
 };
 
 
@@ -2792,6 +2799,12 @@ class HCheckMaps: public HTemplateInstruction<2> {
 
   HValue* value() { return OperandAt(0); }
   SmallMapList* map_set() { return &map_set_; }
+  const ZoneList<UniqueValueId>* map_unique_ids() const {
+    return &map_unique_ids_;
+  }
+
+  // Drops a map the checked value is known not to have.
+  void RemoveMapAt(int index);
 
   virtual void FinalizeUniqueValueId();
 
@@ -3041,6 +3054,10 @@ class HCheckPrototypeMaps: public HTemplateInstruction<0> {
 
 class HPhi: public HValue {
  public:
+  // Phis introduced by passes that do not work on environment slots (e.g.
+  // escape analysis) do not correspond to a merged environment index.
+  static const int kInvalidMergedIndex = -1;
+
   HPhi(int merged_index, Zone* zone)
       : inputs_(2, zone),
         merged_index_(merged_index),
@@ -3049,7 +3066,7 @@ class HPhi: public HValue {
       non_phi_uses_[i] = 0;
       indirect_uses_[i] = 0;
     }
-    ASSERT(merged_index >= 0);
+    ASSERT(merged_index >= 0 || merged_index == kInvalidMergedIndex);
     SetFlag(kFlexibleRepresentation);
     SetFlag(kAllowUndefinedAsNaN);
   }
@@ -3074,6 +3091,7 @@ class HPhi: public HValue {
   bool IsReceiver() const { return merged_index_ == 0; }
 
   int merged_index() const { return merged_index_; }
+  bool HasMergedIndex() const { return merged_index_ != kInvalidMergedIndex; }
 
   virtual void AddInformativeDefinitions();
 
@@ -3192,13 +3210,43 @@ class HInductionVariableAnnotation : public HUnaryOperation {
 };
 
 
-class HArgumentsObject: public HTemplateInstruction<0> {
+// Common base class for objects that are not materialized in optimized code
+// but whose contents are described by their operands so that the deoptimizer
+// can materialize them when needed.
+class HDematerializedObject: public HInstruction {
  public:
-  HArgumentsObject(int count, Zone* zone) : values_(count, zone) {
+  HDematerializedObject(int count, Zone* zone) : values_(count, zone) {}
+
+  virtual int OperandCount() { return values_.length(); }
+  virtual HValue* OperandAt(int index) const { return values_[index]; }
+
+  virtual bool HasEscapingOperandAt(int index) { return false; }
+  virtual Representation RequiredInputRepresentation(int index) {
+    return Representation::None();
+  }
+
+ protected:
+  virtual void InternalSetOperandAt(int index, HValue* value) {
+    values_[index] = value;
+  }
+
+  // List of values tracked by this marker.
+  ZoneList<HValue*> values_;
+
+ private:
+  virtual bool IsDeletable() const { return true; }
+};
+
+
+class HArgumentsObject: public HDematerializedObject {
+ public:
+  HArgumentsObject(int count, Zone* zone) : HDematerializedObject(count, zone) {
     set_representation(Representation::Tagged());
     SetFlag(kIsArguments);
   }
 
+  // The values contain a list of all elements in the arguments object
+  // including the receiver object, which is skipped when materializing.
   const ZoneList<HValue*>* arguments_values() const { return &values_; }
   int arguments_count() const { return values_.length(); }
 
@@ -3207,25 +3255,48 @@ class HArgumentsObject: public HTemplateInstruction<0> {
     SetOperandAt(values_.length() - 1, argument);
   }
 
-  virtual int OperandCount() { return values_.length(); }
-  virtual HValue* OperandAt(int index) const { return values_[index]; }
+  DECLARE_CONCRETE_INSTRUCTION(ArgumentsObject)
+};
 
-  virtual bool HasEscapingOperandAt(int index) { return false; }
-  virtual Representation RequiredInputRepresentation(int index) {
-    return Representation::None();
+
+// Describes the state of a captured (i.e. scalar replaced) allocation at a
+// given point in the program. The operands hold the current values of all
+// fields of the object, one per pointer-sized word.
+class HCapturedObject: public HDematerializedObject {
+ public:
+  HCapturedObject(int length, int capture_id, Zone* zone)
+      : HDematerializedObject(length, zone), capture_id_(capture_id) {
+    set_representation(Representation::Tagged());
+    values_.AddBlock(NULL, length, zone);  // Resize list.
   }
 
-  DECLARE_CONCRETE_INSTRUCTION(ArgumentsObject)
+  // The values contain a list of all in-object fields of the captured
+  // object, indexed by field index. Properties in the properties or elements
+  // backing store are described by captured objects of their own.
+  const ZoneList<HValue*>* values() const { return &values_; }
+  int length() const { return values_.length(); }
+  int capture_id() const { return capture_id_; }
 
- protected:
-  virtual void InternalSetOperandAt(int index, HValue* value) {
-    values_[index] = value;
-  }
+  // The map of the captured object is always stored at field index 0.
+  HValue* map_value() const { return values()->first(); }
+
+  // Replays the effects of this state on an environment of the Lithium
+  // builder: every value describing the same captured object, including
+  // values nested inside other captured objects, is replaced by this state.
+  void ReplayEnvironment(HEnvironment* env);
+
+  virtual void PrintDataTo(StringStream* stream);
+
+  DECLARE_CONCRETE_INSTRUCTION(CapturedObject)
 
  private:
-  virtual bool IsDeletable() const { return true; }
+  static HValue* ReplayValue(HValue* value, HCapturedObject* state, Zone* zone);
 
-  ZoneList<HValue*> values_;
+  int capture_id_;
+
+  // Captured states have to stay in the graph even without uses, because
+  // they describe the object for the environments of the Lithium builder.
+  virtual bool IsDeletable() const { return false; }
 };
 
 
@@ -3354,6 +3425,7 @@ class HConstant: public HTemplateInstruction<0> {
   }
 
   bool BooleanValue() const { return boolean_value_; }
+  UniqueValueId unique_id() const { return unique_id_; }
 
   virtual intptr_t Hashcode() {
     if (has_int32_value_) {
@@ -5317,6 +5389,18 @@ class HObjectAccess {
     return HObjectAccess(kInobject, AllocationSiteInfo::kPayloadOffset);
   }
 
+  static HObjectAccess ForAllocationSiteTransitionInfo() {
+    return HObjectAccess(kInobject, AllocationSite::kTransitionInfoOffset);
+  }
+
+  static HObjectAccess ForAllocationSiteMementoCreateCount() {
+    return HObjectAccess(kInobject, AllocationSite::kMementoCreateCountOffset);
+  }
+
+  static HObjectAccess ForAllocationSitePretenureDecision() {
+    return HObjectAccess(kInobject, AllocationSite::kPretenureDecisionOffset);
+  }
+
   // Create an access to an offset in a fixed array header.
   static HObjectAccess ForFixedArrayHeader(int offset);
 
@@ -5644,6 +5728,8 @@ class HLoadKeyed
     return RequiredInputRepresentation(index);
   }
 
+  virtual bool HasEscapingOperandAt(int index) { return false; }
+
   virtual void PrintDataTo(StringStream* stream);
 
   bool UsesMustHandleHole() const;
@@ -6053,6 +6139,12 @@ class HTransitionElementsKind: public HTemplateInstruction<2> {
   HValue* context() { return OperandAt(1); }
   Handle<Map> original_map() { return original_map_; }
   Handle<Map> transitioned_map() { return transitioned_map_; }
+  UniqueValueId original_map_unique_id() const {
+    return original_map_unique_id_;
+  }
+  UniqueValueId transitioned_map_unique_id() const {
+    return transitioned_map_unique_id_;
+  }
   ElementsKind from_kind() { return from_kind_; }
   ElementsKind to_kind() { return to_kind_; }
 
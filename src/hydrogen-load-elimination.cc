@@ -0,0 +1,485 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "hydrogen-load-elimination.h"
+
+namespace v8 {
+namespace internal {
+
+
+static const int kMaxTrackedLocations = 32;
+
+
+static bool IsKeyedAccess(HValue* access) {
+  return access->IsLoadKeyed() || access->IsStoreKeyed();
+}
+
+
+static bool IsStore(HValue* access) {
+  return access->IsStoreNamedField() || access->IsStoreKeyed();
+}
+
+
+// Named field accesses and element accesses of fast smi or object arrays.
+// Stores into double and external arrays canonicalize or truncate the value,
+// so a later load does not necessarily see what was stored.
+static bool IsTrackedAccess(HValue* instr) {
+  if (instr->IsLoadNamedField() || instr->IsStoreNamedField()) return true;
+  if (instr->IsLoadKeyed()) {
+    return IsFastSmiOrObjectElementsKind(
+        HLoadKeyed::cast(instr)->elements_kind());
+  }
+  if (instr->IsStoreKeyed()) {
+    return IsFastSmiOrObjectElementsKind(
+        HStoreKeyed::cast(instr)->elements_kind());
+  }
+  return false;
+}
+
+
+static HValue* ObjectOf(HValue* access) {
+  if (access->IsLoadNamedField()) {
+    return HLoadNamedField::cast(access)->object()->ActualValue();
+  } else if (access->IsStoreNamedField()) {
+    return HStoreNamedField::cast(access)->object()->ActualValue();
+  } else if (access->IsLoadKeyed()) {
+    return HLoadKeyed::cast(access)->elements()->ActualValue();
+  }
+  return HStoreKeyed::cast(access)->elements()->ActualValue();
+}
+
+
+static HObjectAccess FieldOf(HValue* access) {
+  return access->IsLoadNamedField()
+      ? HLoadNamedField::cast(access)->access()
+      : HStoreNamedField::cast(access)->access();
+}
+
+
+static HValue* KeyOf(HValue* access) {
+  return access->IsLoadKeyed()
+      ? HLoadKeyed::cast(access)->key()->ActualValue()
+      : HStoreKeyed::cast(access)->key()->ActualValue();
+}
+
+
+static uint32_t IndexOffsetOf(HValue* access) {
+  return access->IsLoadKeyed()
+      ? HLoadKeyed::cast(access)->index_offset()
+      : HStoreKeyed::cast(access)->index_offset();
+}
+
+
+// The value a later load of the location accessed by the given load or
+// store produces.
+static HValue* ValueOf(HValue* access) {
+  if (access->IsStoreNamedField()) {
+    return HStoreNamedField::cast(access)->value();
+  } else if (access->IsStoreKeyed()) {
+    return HStoreKeyed::cast(access)->value();
+  }
+  return access;
+}
+
+
+// The side effects that invalidate what a load or store tells about its
+// location.
+static GVNFlagSet DependsOf(HValue* access) {
+  if (IsStore(access)) {
+    return HValue::ConvertChangesToDependsFlags(access->ChangesFlags());
+  }
+  return access->DependsOnFlags();
+}
+
+
+static bool IsAllocation(HValue* value) {
+  return value->IsAllocate() || value->IsAllocateObject();
+}
+
+
+static bool IsSameLocation(HValue* a, HValue* b) {
+  if (IsKeyedAccess(a) != IsKeyedAccess(b)) return false;
+  if (ObjectOf(a) != ObjectOf(b)) return false;
+  if (IsKeyedAccess(a)) {
+    return KeyOf(a) == KeyOf(b) && IndexOffsetOf(a) == IndexOffsetOf(b);
+  }
+  return FieldOf(a).Equals(FieldOf(b));
+}
+
+
+// Whether a later load of the same location may be replaced by the value
+// the given load or store left there.
+static bool CanForward(HValue* known, HValue* load) {
+  HValue* value = ValueOf(known);
+  if (!value->representation().Equals(load->representation())) return false;
+  if (load->IsLoadKeyed()) {
+    // A load that deoptimizes on the hole must not take over the result
+    // of one that does not.
+    if (known->IsLoadKeyed()) {
+      return HLoadKeyed::cast(known)->hole_mode() ==
+          HLoadKeyed::cast(load)->hole_mode();
+    }
+    return !HStoreKeyed::cast(known)->IsConstantHoleStore();
+  }
+  return true;
+}
+
+
+// A store may be removed when a later store overwrites it only if the
+// field held a valid value before, so that neither the GC nor the
+// deoptimizer can see an uninitialized field in between, and if the store
+// does not also change the map.
+static bool IsRemovableStore(HStoreNamedField* store) {
+  HValue* object = store->object()->ActualValue();
+  return store->transition().is_null() &&
+      FieldOf(store).offset() != HeapObject::kMapOffset &&
+      !IsAllocation(object) &&
+      !object->IsInnerAllocatedObject();
+}
+
+
+// Instructions that can neither read an object field nor run arbitrary
+// code, and therefore cannot observe a store that is later overwritten.
+static bool PreservesPendingStores(HInstruction* instr) {
+  if (instr->HasObservableSideEffects()) return false;
+  return instr->IsConstant() ||
+      instr->IsChange() ||
+      instr->IsCheckHeapObject() ||
+      instr->IsCheckMaps() ||
+      instr->IsBinaryOperation();
+}
+
+
+// The loads and stores whose locations still hold the value they loaded or
+// stored at a given point of the graph.
+class HLoadEliminationTable : public ZoneObject {
+ public:
+  HLoadEliminationTable(Zone* zone, BitVector* captured)
+      : zone_(zone),
+        captured_(captured),
+        accesses_(kMaxTrackedLocations, zone) { }
+
+  HLoadEliminationTable* Copy(Zone* zone) {
+    HLoadEliminationTable* copy =
+        new(zone) HLoadEliminationTable(zone, captured_);
+    copy->accesses_.AddAll(accesses_, zone);
+    return copy;
+  }
+
+  bool IsCaptured(HValue* object) {
+    return captured_->Contains(object->id());
+  }
+
+  // Returns the latest load or store of the location the given load reads.
+  HValue* Lookup(HValue* load) {
+    for (int i = accesses_.length() - 1; i >= 0; --i) {
+      if (IsSameLocation(accesses_[i], load)) return accesses_[i];
+    }
+    return NULL;
+  }
+
+  void Insert(HValue* access) {
+    for (int i = accesses_.length() - 1; i >= 0; --i) {
+      if (IsSameLocation(accesses_[i], access)) accesses_.Remove(i);
+    }
+    if (accesses_.length() == kMaxTrackedLocations) accesses_.Remove(0);
+    accesses_.Add(access, zone_);
+  }
+
+  // Forgets every location the given store may write.
+  void KillAliases(HValue* store) {
+    bool writes_map = store->IsStoreNamedField() &&
+        !HStoreNamedField::cast(store)->transition().is_null();
+    for (int i = accesses_.length() - 1; i >= 0; --i) {
+      HValue* access = accesses_[i];
+      if (MayOverlap(store, access) ||
+          (writes_map && !IsKeyedAccess(access) &&
+           FieldOf(access).offset() == HeapObject::kMapOffset &&
+           MayAlias(ObjectOf(store), ObjectOf(access)))) {
+        accesses_.Remove(i);
+      }
+    }
+  }
+
+  // Forgets the locations the given side effects may change. Side effects
+  // of stores into captured allocations only affect captured allocations,
+  // and all other side effects only affect the remaining objects.
+  void Kill(GVNFlagSet changes, bool captured) {
+    if (changes.IsEmpty()) return;
+    GVNFlagSet depends_flags = HValue::ConvertChangesToDependsFlags(changes);
+    for (int i = accesses_.length() - 1; i >= 0; --i) {
+      HValue* access = accesses_[i];
+      if (IsCaptured(ObjectOf(access)) == captured &&
+          DependsOf(access).ContainsAnyOf(depends_flags)) {
+        accesses_.Remove(i);
+      }
+    }
+  }
+
+  bool MayAlias(HValue* a, HValue* b) {
+    if (a == b) return true;
+    // Nothing else can refer to an allocation that does not escape.
+    if (IsCaptured(a) || IsCaptured(b)) return false;
+    // Allocations produce objects that differ from each other and from
+    // anything that existed before, including constants.
+    if (IsAllocation(a)) return !IsAllocation(b) && !b->IsConstant();
+    if (IsAllocation(b)) return !a->IsConstant();
+    return true;
+  }
+
+  // Named fields and elements are never assumed to overlap, just as GVN
+  // keeps them apart through different side effect flags.
+  bool MayOverlap(HValue* a, HValue* b) {
+    if (IsKeyedAccess(a) != IsKeyedAccess(b)) return false;
+    if (!MayAlias(ObjectOf(a), ObjectOf(b))) return false;
+    if (IsKeyedAccess(a)) {
+      HValue* key_a = KeyOf(a);
+      HValue* key_b = KeyOf(b);
+      if (key_a->IsConstant() && key_b->IsConstant() &&
+          HConstant::cast(key_a)->HasInteger32Value() &&
+          HConstant::cast(key_b)->HasInteger32Value()) {
+        return HConstant::cast(key_a)->Integer32Value() + IndexOffsetOf(a) ==
+            HConstant::cast(key_b)->Integer32Value() + IndexOffsetOf(b);
+      }
+      return true;
+    }
+    return FieldOf(a).offset() == FieldOf(b).offset();
+  }
+
+ private:
+  Zone* zone_;
+  BitVector* captured_;
+  ZoneList<HValue*> accesses_;
+};
+
+
+HLoadEliminationPhase::HLoadEliminationPhase(HGraph* graph)
+    : HPhase("H_Load elimination", graph),
+      captured_(graph->GetMaximumValueID(), zone()),
+      block_side_effects_(graph->blocks()->length(), zone()),
+      block_captured_side_effects_(graph->blocks()->length(), zone()),
+      loop_side_effects_(graph->blocks()->length(), zone()),
+      loop_captured_side_effects_(graph->blocks()->length(), zone()),
+      visited_on_paths_(zone(), graph->blocks()->length()) {
+  int block_count = graph->blocks()->length();
+  block_side_effects_.AddBlock(GVNFlagSet(), block_count, zone());
+  block_captured_side_effects_.AddBlock(GVNFlagSet(), block_count, zone());
+  loop_side_effects_.AddBlock(GVNFlagSet(), block_count, zone());
+  loop_captured_side_effects_.AddBlock(GVNFlagSet(), block_count, zone());
+}
+
+
+void HLoadEliminationPhase::CollectCapturedValues() {
+  int block_count = graph()->blocks()->length();
+  for (int i = 0; i < block_count; ++i) {
+    HBasicBlock* block = graph()->blocks()->at(i);
+    for (HInstructionIterator it(block); !it.Done(); it.Advance()) {
+      HInstruction* instr = it.Current();
+      if (!IsAllocation(instr)) continue;
+      bool escapes = false;
+      for (HUseIterator uses(instr->uses()); !uses.Done(); uses.Advance()) {
+        if (uses.value()->HasEscapingOperandAt(uses.index())) {
+          escapes = true;
+          break;
+        }
+      }
+      if (!escapes) captured_.Add(instr->id());
+    }
+  }
+}
+
+
+bool HLoadEliminationPhase::IsCapturedStore(HInstruction* instr) {
+  if (instr->IsStoreNamedField()) {
+    HValue* object = HStoreNamedField::cast(instr)->object()->ActualValue();
+    return captured_.Contains(object->id());
+  } else if (instr->IsStoreKeyed()) {
+    HValue* elements = HStoreKeyed::cast(instr)->elements()->ActualValue();
+    return captured_.Contains(elements->id());
+  }
+  return false;
+}
+
+
+void HLoadEliminationPhase::ComputeBlockSideEffects() {
+  for (int i = graph()->blocks()->length() - 1; i >= 0; --i) {
+    HBasicBlock* block = graph()->blocks()->at(i);
+    int id = block->block_id();
+    GVNFlagSet side_effects;
+    GVNFlagSet captured_side_effects;
+    for (HInstructionIterator it(block); !it.Done(); it.Advance()) {
+      HInstruction* instr = it.Current();
+      if (IsCapturedStore(instr)) {
+        captured_side_effects.Add(instr->ChangesFlags());
+      } else {
+        side_effects.Add(instr->ChangesFlags());
+      }
+    }
+    block_side_effects_[id].Add(side_effects);
+    block_captured_side_effects_[id].Add(captured_side_effects);
+
+    // Loop headers are part of their loop.
+    if (block->IsLoopHeader()) {
+      loop_side_effects_[id].Add(side_effects);
+      loop_captured_side_effects_[id].Add(captured_side_effects);
+    }
+
+    // Propagate loop side effects upwards.
+    if (block->HasParentLoopHeader()) {
+      int header_id = block->parent_loop_header()->block_id();
+      loop_side_effects_[header_id].Add(block->IsLoopHeader()
+                                        ? loop_side_effects_[id]
+                                        : side_effects);
+      loop_captured_side_effects_[header_id].Add(block->IsLoopHeader()
+          ? loop_captured_side_effects_[id]
+          : captured_side_effects);
+    }
+  }
+}
+
+
+void HLoadEliminationPhase::CollectSideEffectsOnPathsToDominatedBlock(
+    HBasicBlock* dominator,
+    HBasicBlock* dominated,
+    GVNFlagSet* side_effects,
+    GVNFlagSet* captured_side_effects) {
+  for (int i = 0; i < dominated->predecessors()->length(); ++i) {
+    HBasicBlock* block = dominated->predecessors()->at(i);
+    int id = block->block_id();
+    if (dominator->block_id() < id &&
+        id < dominated->block_id() &&
+        visited_on_paths_.Add(id)) {
+      side_effects->Add(block_side_effects_[id]);
+      captured_side_effects->Add(block_captured_side_effects_[id]);
+      if (block->IsLoopHeader()) {
+        side_effects->Add(loop_side_effects_[id]);
+        captured_side_effects->Add(loop_captured_side_effects_[id]);
+      }
+      CollectSideEffectsOnPathsToDominatedBlock(
+          dominator, block, side_effects, captured_side_effects);
+    }
+  }
+}
+
+
+void HLoadEliminationPhase::EliminateLoadsAndStores() {
+  int block_count = graph()->blocks()->length();
+  ZoneList<HLoadEliminationTable*> tables(block_count, zone());
+  tables.AddBlock(NULL, block_count, zone());
+
+  for (int i = 0; i < block_count; ++i) {
+    HBasicBlock* block = graph()->blocks()->at(i);
+    HBasicBlock* dominator = block->dominator();
+    HLoadEliminationTable* table;
+    if (dominator == NULL) {
+      table = new(zone()) HLoadEliminationTable(zone(), &captured_);
+    } else {
+      // Start from what holds at the end of the dominator, minus everything
+      // killed on any path between the dominator and this block.
+      table = tables[dominator->block_id()]->Copy(zone());
+      if (dominator->block_id() + 1 < block->block_id()) {
+        GVNFlagSet side_effects;
+        GVNFlagSet captured_side_effects;
+        visited_on_paths_.Clear();
+        CollectSideEffectsOnPathsToDominatedBlock(
+            dominator, block, &side_effects, &captured_side_effects);
+        table->Kill(side_effects, false);
+        table->Kill(captured_side_effects, true);
+      }
+    }
+
+    // If this is a loop header kill everything killed by the loop.
+    if (block->IsLoopHeader()) {
+      table->Kill(loop_side_effects_[block->block_id()], false);
+      table->Kill(loop_captured_side_effects_[block->block_id()], true);
+    }
+
+    ProcessBlock(block, table);
+    tables[block->block_id()] = table;
+  }
+}
+
+
+void HLoadEliminationPhase::ProcessBlock(HBasicBlock* block,
+                                         HLoadEliminationTable* table) {
+  // Field stores that may still be overwritten before anything observes
+  // them. A simulate makes a store observable, since deoptimizing after it
+  // would not execute the store again.
+  ZoneList<HStoreNamedField*> pending(4, zone());
+
+  HInstruction* instr = block->first();
+  while (instr != NULL) {
+    HInstruction* next = instr->next();
+    if (!IsTrackedAccess(instr)) {
+      table->Kill(instr->ChangesFlags(), IsCapturedStore(instr));
+      if (!PreservesPendingStores(instr)) pending.Rewind(0);
+    } else if (IsStore(instr)) {
+      table->KillAliases(instr);
+      if (instr->IsStoreNamedField()) {
+        HStoreNamedField* store = HStoreNamedField::cast(instr);
+        for (int i = pending.length() - 1; i >= 0; --i) {
+          HStoreNamedField* previous = pending[i];
+          if (IsSameLocation(previous, store)) {
+            if (FLAG_trace_load_elimination) {
+              PrintF("Removing store %d overwritten by store %d\n",
+                     previous->id(), store->id());
+            }
+            previous->DeleteAndReplaceWith(NULL);
+            pending.Remove(i);
+          }
+        }
+        if (IsRemovableStore(store)) pending.Add(store, zone());
+      }
+      if (!instr->IsStoreKeyed() ||
+          !HStoreKeyed::cast(instr)->IsConstantHoleStore()) {
+        table->Insert(instr);
+      }
+    } else {
+      HValue* known = table->Lookup(instr);
+      if (known != NULL && CanForward(known, instr)) {
+        if (FLAG_trace_load_elimination) {
+          PrintF("Replacing load %d (%s) with value %d (%s) from %d (%s)\n",
+                 instr->id(), instr->Mnemonic(),
+                 ValueOf(known)->id(), ValueOf(known)->Mnemonic(),
+                 known->id(), known->Mnemonic());
+        }
+        instr->DeleteAndReplaceWith(ValueOf(known));
+      } else {
+        table->Insert(instr);
+        if (instr->IsLoadNamedField()) {
+          for (int i = pending.length() - 1; i >= 0; --i) {
+            if (table->MayOverlap(pending[i], instr)) pending.Remove(i);
+          }
+        }
+      }
+    }
+    instr = next;
+  }
+}
+
+
+} }  // namespace v8::internal
@@ -0,0 +1,90 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_HYDROGEN_LOAD_ELIMINATION_H_
+#define V8_HYDROGEN_LOAD_ELIMINATION_H_
+
+#include "data-flow.h"
+#include "hydrogen.h"
+#include "hydrogen-gvn.h"
+
+namespace v8 {
+namespace internal {
+
+
+class HLoadEliminationTable;
+
+
+// Forward values written by field and element stores, or read by earlier
+// loads, to later loads of the same location, and remove field stores that
+// are overwritten before anything can observe them. Unlike GVN the phase
+// knows which location a store writes, so a store to one field does not
+// invalidate loads of another, and fields of allocations that never escape
+// survive calls.
+class HLoadEliminationPhase : public HPhase {
+ public:
+  explicit HLoadEliminationPhase(HGraph* graph);
+
+  void Run() {
+    CollectCapturedValues();
+    ComputeBlockSideEffects();
+    EliminateLoadsAndStores();
+  }
+
+ private:
+  void CollectCapturedValues();
+  void ComputeBlockSideEffects();
+  void CollectSideEffectsOnPathsToDominatedBlock(
+      HBasicBlock* dominator,
+      HBasicBlock* dominated,
+      GVNFlagSet* side_effects,
+      GVNFlagSet* captured_side_effects);
+  void EliminateLoadsAndStores();
+  void ProcessBlock(HBasicBlock* block, HLoadEliminationTable* table);
+  bool IsCapturedStore(HInstruction* instr);
+
+  // Allocations none of whose uses let the object escape.
+  BitVector captured_;
+
+  // Side effects of each block and loop, split into those that can only
+  // change captured allocations and all others.
+  ZoneList<GVNFlagSet> block_side_effects_;
+  ZoneList<GVNFlagSet> block_captured_side_effects_;
+  ZoneList<GVNFlagSet> loop_side_effects_;
+  ZoneList<GVNFlagSet> loop_captured_side_effects_;
+
+  // Used when collecting side effects on paths from dominator to
+  // dominated.
+  SparseSet visited_on_paths_;
+
+  DISALLOW_COPY_AND_ASSIGN(HLoadEliminationPhase);
+};
+
+
+} }  // namespace v8::internal
+
+#endif  // V8_HYDROGEN_LOAD_ELIMINATION_H_
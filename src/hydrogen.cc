@@ -33,10 +33,12 @@
 #include "codegen.h"
 #include "full-codegen.h"
 #include "hashmap.h"
+#include "hydrogen-check-elimination.h"
 #include "hydrogen-environment-liveness.h"
 #include "hydrogen-escape-analysis.h"
 #include "hydrogen-infer-representation.h"
 #include "hydrogen-gvn.h"
+#include "hydrogen-load-elimination.h"
 #include "hydrogen-osr.h"
 #include "hydrogen-uint32-analysis.h"
 #include "lithium-allocator.h"
@@ -1613,6 +1615,7 @@ void HGraphBuilder::BuildCopyElements(HValue* context,
 
 HValue* HGraphBuilder::BuildCloneShallowArray(HContext* context,
                                               HValue* boilerplate,
+                                              HValue* allocation_site,
                                               AllocationSiteMode mode,
                                               ElementsKind kind,
                                               int length) {
@@ -1649,7 +1652,8 @@ HValue* HGraphBuilder::BuildCloneShallowArray(HContext* context,
 
   // Create an allocation site info if requested.
   if (mode == TRACK_ALLOCATION_SITE) {
-    BuildCreateAllocationSiteInfo(object, JSArray::kSize, boilerplate);
+    BuildCreateAllocationSiteInfo(object, JSArray::kSize, allocation_site);
+    BuildIncrementMementoCreateCount(context, allocation_site);
   }
 
   if (length > 0) {
@@ -1734,6 +1738,20 @@ HValue* HGraphBuilder::BuildCreateAllocationSiteInfo(HValue* previous_object,
 }
 
 
+void HGraphBuilder::BuildIncrementMementoCreateCount(
+    HValue* context,
+    HValue* allocation_site) {
+  if (!FLAG_allocation_site_pretenuring) return;
+  HObjectAccess access = HObjectAccess::ForAllocationSiteMementoCreateCount();
+  HValue* create_count = AddLoad(allocation_site, access, NULL,
+                                 Representation::Smi());
+  HValue* new_count = AddInstruction(
+      HAdd::New(zone(), context, create_count, graph()->GetConstant1()));
+  new_count->ClearFlag(HValue::kCanOverflow);
+  AddStore(allocation_site, access, new_count, Representation::Smi());
+}
+
+
 HInstruction* HGraphBuilder::BuildGetNativeContext(HValue* context) {
   // Get the global context, then the native context
   HInstruction* global_object = Add<HGlobalObject>(context);
@@ -3607,6 +3625,11 @@ bool HGraph::Optimize(SmartArrayPointer<char>* bailout_reason) {
   if (FLAG_dead_code_elimination) {
     DeadCodeElimination("H_Eliminate early dead code");
   }
+
+  // Scalar replacement introduces new phis and has to see the uses of
+  // allocations before any representation changes are inserted.
+  if (FLAG_use_escape_analysis) Run<HEscapeAnalysisPhase>();
+
   CollectPhis();
 
   if (has_osr()) osr()->FinishOsrValues();
@@ -3630,10 +3653,12 @@ bool HGraph::Optimize(SmartArrayPointer<char>* bailout_reason) {
 
   if (FLAG_use_canonicalizing) Canonicalize();
 
-  if (FLAG_use_escape_analysis) Run<HEscapeAnalysisPhase>();
-
   if (FLAG_use_gvn) Run<HGlobalValueNumberingPhase>();
 
+  if (FLAG_use_load_elimination) Run<HLoadEliminationPhase>();
+
+  if (FLAG_use_check_elimination) Run<HCheckEliminationPhase>();
+
   if (FLAG_use_range) {
     HRangeAnalysis range_analysis(this);
     range_analysis.Analyze();
@@ -4220,7 +4245,7 @@ void HGraph::RemoveDeadInstructions() {
     HPhi* phi = dead_phis.RemoveLast();
     HBasicBlock* block = phi->block();
     phi->DeleteAndReplaceWith(NULL);
-    block->RecordDeletedPhi(phi->merged_index());
+    if (phi->HasMergedIndex()) block->RecordDeletedPhi(phi->merged_index());
   }
 }
 
@@ -5296,9 +5321,7 @@ static bool LookupSetter(Handle<Map> map,
 // size of all objects that are part of the graph.
 static bool IsFastLiteral(Handle<JSObject> boilerplate,
                           int max_depth,
-                          int* max_properties,
-                          int* data_size,
-                          int* pointer_size) {
+                          int* max_properties) {
   if (boilerplate->map()->is_deprecated()) {
     Handle<Object> result =
         JSObject::TryMigrateInstance(boilerplate);
@@ -5312,9 +5335,7 @@ static bool IsFastLiteral(Handle<JSObject> boilerplate,
   Handle<FixedArrayBase> elements(boilerplate->elements());
   if (elements->length() > 0 &&
       elements->map() != isolate->heap()->fixed_cow_array_map()) {
-    if (boilerplate->HasFastDoubleElements()) {
-      *data_size += FixedDoubleArray::SizeFor(elements->length());
-    } else if (boilerplate->HasFastObjectElements()) {
+    if (boilerplate->HasFastObjectElements()) {
       Handle<FixedArray> fast_elements = Handle<FixedArray>::cast(elements);
       int length = elements->length();
       for (int i = 0; i < length; i++) {
@@ -5324,15 +5345,12 @@ static bool IsFastLiteral(Handle<JSObject> boilerplate,
           Handle<JSObject> value_object = Handle<JSObject>::cast(value);
           if (!IsFastLiteral(value_object,
                              max_depth - 1,
-                             max_properties,
-                             data_size,
-                             pointer_size)) {
+                             max_properties)) {
             return false;
           }
         }
       }
-      *pointer_size += FixedArray::SizeFor(length);
-    } else {
+    } else if (!boilerplate->HasFastDoubleElements()) {
       return false;
     }
   }
@@ -5347,7 +5365,6 @@ static bool IsFastLiteral(Handle<JSObject> boilerplate,
     for (int i = 0; i < limit; i++) {
       PropertyDetails details = descriptors->GetDetails(i);
       if (details.type() != FIELD) continue;
-      Representation representation = details.representation();
       int index = descriptors->GetFieldIndex(i);
       if ((*max_properties)-- == 0) return false;
       Handle<Object> value(boilerplate->InObjectPropertyAt(index), isolate);
@@ -5355,18 +5372,13 @@ static bool IsFastLiteral(Handle<JSObject> boilerplate,
         Handle<JSObject> value_object = Handle<JSObject>::cast(value);
         if (!IsFastLiteral(value_object,
                            max_depth - 1,
-                           max_properties,
-                           data_size,
-                           pointer_size)) {
+                           max_properties)) {
           return false;
         }
-      } else if (representation.IsDouble()) {
-        *data_size += HeapNumber::kSize;
       }
     }
   }
 
-  *pointer_size += boilerplate->map()->instance_size();
   return true;
 }
 
@@ -5380,28 +5392,26 @@ void HOptimizedGraphBuilder::VisitObjectLiteral(ObjectLiteral* expr) {
   HInstruction* literal;
 
   // Check whether to use fast or slow deep-copying for boilerplate.
-  int data_size = 0;
-  int pointer_size = 0;
   int max_properties = kMaxFastLiteralProperties;
   Handle<Object> original_boilerplate(closure->literals()->get(
       expr->literal_index()), isolate());
   if (!FLAG_trace_internals && original_boilerplate->IsJSObject() &&
       IsFastLiteral(Handle<JSObject>::cast(original_boilerplate),
                     kMaxFastLiteralDepth,
-                    &max_properties,
-                    &data_size,
-                    &pointer_size)) {
+                    &max_properties)) {
     Handle<JSObject> original_boilerplate_object =
         Handle<JSObject>::cast(original_boilerplate);
     Handle<JSObject> boilerplate_object =
         DeepCopy(original_boilerplate_object);
+    PretenureFlag pretenure_flag =
+        isolate()->heap()->ShouldGloballyPretenure() ? TENURED : NOT_TENURED;
 
     literal = BuildFastLiteral(context,
                                boilerplate_object,
                                original_boilerplate_object,
-                               data_size,
-                               pointer_size,
-                               DONT_TRACK_ALLOCATION_SITE);
+                               Handle<Object>::null(),
+                               DONT_TRACK_ALLOCATION_SITE,
+                               pretenure_flag);
   } else {
     NoObservableSideEffectsScope no_effects(this);
     Handle<FixedArray> closure_literals(closure->literals(), isolate());
@@ -5522,22 +5532,29 @@ void HOptimizedGraphBuilder::VisitArrayLiteral(ArrayLiteral* expr) {
   HInstruction* literal;
 
   Handle<FixedArray> literals(environment()->closure()->literals(), isolate());
-  Handle<Object> raw_boilerplate(literals->get(expr->literal_index()),
-                                 isolate());
+  Handle<Object> literals_cell(literals->get(expr->literal_index()),
+                               isolate());
+  Handle<Object> raw_boilerplate;
+  Handle<AllocationSite> site;
 
   bool uninitialized = false;
-  if (raw_boilerplate->IsUndefined()) {
+  if (literals_cell->IsUndefined()) {
     uninitialized = true;
     raw_boilerplate = Runtime::CreateArrayLiteralBoilerplate(
         isolate(), literals, expr->constant_elements());
     if (raw_boilerplate.is_null()) {
       return Bailout("array boilerplate creation failed");
     }
-    literals->set(expr->literal_index(), *raw_boilerplate);
+    site = isolate()->factory()->NewAllocationSite(
+        Handle<JSObject>::cast(raw_boilerplate));
+    literals->set(expr->literal_index(), *site);
     if (JSObject::cast(*raw_boilerplate)->elements()->map() ==
         isolate()->heap()->fixed_cow_array_map()) {
       isolate()->counters()->cow_arrays_created_runtime()->Increment();
     }
+  } else {
+    site = Handle<AllocationSite>::cast(literals_cell);
+    raw_boilerplate = Handle<Object>(site->transition_info(), isolate());
   }
 
   Handle<JSObject> original_boilerplate_object =
@@ -5551,26 +5568,31 @@ void HOptimizedGraphBuilder::VisitArrayLiteral(ArrayLiteral* expr) {
   AllocationSiteMode mode = AllocationSiteInfo::GetMode(
       boilerplate_elements_kind);
 
+  // The code is deoptimized when the site changes its mind about tenuring.
+  PretenureFlag pretenure_flag =
+      isolate()->heap()->ShouldGloballyPretenure() ? TENURED : NOT_TENURED;
+  if (FLAG_allocation_site_pretenuring) {
+    site->AddDependentCompilationInfo(top_info());
+    if (FLAG_track_allocation_sites) mode = TRACK_ALLOCATION_SITE;
+    if (site->GetPretenureMode() == TENURED) {
+      pretenure_flag = TENURED;
+      // Objects in old space are not seen by the scavenger.
+      mode = DONT_TRACK_ALLOCATION_SITE;
+    }
+  }
+
   // Check whether to use fast or slow deep-copying for boilerplate.
-  int data_size = 0;
-  int pointer_size = 0;
   int max_properties = kMaxFastLiteralProperties;
   if (!FLAG_trace_internals && IsFastLiteral(original_boilerplate_object,
                     kMaxFastLiteralDepth,
-                    &max_properties,
-                    &data_size,
-                    &pointer_size)) {
-    if (mode == TRACK_ALLOCATION_SITE) {
-      pointer_size += AllocationSiteInfo::kSize;
-    }
-
+                    &max_properties)) {
     Handle<JSObject> boilerplate_object = DeepCopy(original_boilerplate_object);
     literal = BuildFastLiteral(context,
                                boilerplate_object,
                                original_boilerplate_object,
-                               data_size,
-                               pointer_size,
-                               mode);
+                               site,
+                               mode,
+                               pretenure_flag);
   } else {
     NoObservableSideEffectsScope no_effects(this);
     // Boilerplate already exists and constant elements are never accessed,
@@ -9425,148 +9447,121 @@ HInstruction* HOptimizedGraphBuilder::BuildThisFunction() {
 }
 
 
+// Pretenured literals are allocated in the old space that matches their
+// contents, everything else is allocated in new space.
+static HAllocate::Flags LiteralAllocationFlags(PretenureFlag pretenure_flag,
+                                               ElementsKind kind,
+                                               bool contains_pointers) {
+  HAllocate::Flags flags = HAllocate::DefaultFlags(kind);
+  if (pretenure_flag == TENURED) {
+    flags = static_cast<HAllocate::Flags>(flags | (contains_pointers
+        ? HAllocate::CAN_ALLOCATE_IN_OLD_POINTER_SPACE
+        : HAllocate::CAN_ALLOCATE_IN_OLD_DATA_SPACE));
+  }
+  return flags;
+}
+
+
 HInstruction* HOptimizedGraphBuilder::BuildFastLiteral(
     HValue* context,
     Handle<JSObject> boilerplate_object,
     Handle<JSObject> original_boilerplate_object,
-    int data_size,
-    int pointer_size,
-    AllocationSiteMode mode) {
+    Handle<Object> allocation_site,
+    AllocationSiteMode mode,
+    PretenureFlag pretenure_flag) {
   NoObservableSideEffectsScope no_effects(this);
-
-  HInstruction* target = NULL;
-  HInstruction* data_target = NULL;
-
-  HAllocate::Flags flags = HAllocate::DefaultFlags();
-
-  if (isolate()->heap()->ShouldGloballyPretenure()) {
-    if (data_size != 0) {
-      HAllocate::Flags data_flags =
-          static_cast<HAllocate::Flags>(HAllocate::DefaultFlags() |
-              HAllocate::CAN_ALLOCATE_IN_OLD_DATA_SPACE);
-      HValue* size_in_bytes = Add<HConstant>(data_size);
-      data_target = Add<HAllocate>(context, size_in_bytes,
-                                   HType::JSObject(), data_flags);
-      Handle<Map> free_space_map = isolate()->factory()->free_space_map();
-      AddStoreMapConstant(data_target, free_space_map);
-      HObjectAccess access =
-          HObjectAccess::ForJSObjectOffset(FreeSpace::kSizeOffset);
-      AddStore(data_target, access, size_in_bytes);
-    }
-    if (pointer_size != 0) {
-      flags = static_cast<HAllocate::Flags>(
-          flags | HAllocate::CAN_ALLOCATE_IN_OLD_POINTER_SPACE);
-      HValue* size_in_bytes = Add<HConstant>(pointer_size);
-      target = Add<HAllocate>(context, size_in_bytes, HType::JSObject(), flags);
-    }
-  } else {
-    HValue* size_in_bytes = Add<HConstant>(data_size + pointer_size);
-    target = Add<HAllocate>(context, size_in_bytes, HType::JSObject(), flags);
-  }
-
-  int offset = 0;
-  int data_offset = 0;
-  BuildEmitDeepCopy(boilerplate_object, original_boilerplate_object, target,
-                    &offset, data_target, &data_offset, mode);
-  return target;
+  return BuildEmitDeepCopy(context, boilerplate_object,
+                           original_boilerplate_object, allocation_site,
+                           mode, pretenure_flag);
 }
 
 
-void HOptimizedGraphBuilder::BuildEmitDeepCopy(
+HInstruction* HOptimizedGraphBuilder::BuildEmitDeepCopy(
+    HValue* context,
     Handle<JSObject> boilerplate_object,
     Handle<JSObject> original_boilerplate_object,
-    HInstruction* target,
-    int* offset,
-    HInstruction* data_target,
-    int* data_offset,
-    AllocationSiteMode mode) {
+    Handle<Object> allocation_site,
+    AllocationSiteMode mode,
+    PretenureFlag pretenure_flag) {
   Handle<FixedArrayBase> elements(boilerplate_object->elements());
   Handle<FixedArrayBase> original_elements(
       original_boilerplate_object->elements());
   ElementsKind kind = boilerplate_object->map()->elements_kind();
 
-  int object_offset = *offset;
-  int object_size = boilerplate_object->map()->instance_size();
-  int elements_size = (elements->length() > 0 &&
-      elements->map() != isolate()->heap()->fixed_cow_array_map()) ?
-          elements->Size() : 0;
-  int elements_offset = 0;
-
-  if (data_target != NULL && boilerplate_object->HasFastDoubleElements()) {
-    elements_offset = *data_offset;
-    *data_offset += elements_size;
-  } else {
-    // Place elements right after this object.
-    elements_offset = *offset + object_size;
-    *offset += elements_size;
+  // Every part of the literal is a separate allocation, so that parts which
+  // do not escape can be replaced by scalars independently. Nested objects
+  // and the elements are built before the object itself, hence no allocation
+  // happens while the object is only partially initialized.
+  HValue* object_elements = NULL;
+  if (elements->length() > 0 &&
+      elements->map() != isolate()->heap()->fixed_cow_array_map()) {
+    object_elements = BuildEmitElements(context, elements, original_elements,
+                                        kind, pretenure_flag);
   }
-  // Increase the offset so that subsequent objects end up right after this
-  // object (and it's elements if they are allocated in the same space).
-  *offset += object_size;
 
-  // Copy object elements if non-COW.
-  HValue* object_elements = BuildEmitObjectHeader(boilerplate_object, target,
-      data_target, object_offset, elements_offset, elements_size);
-  if (object_elements != NULL) {
-    BuildEmitElements(elements, original_elements, kind, object_elements,
-        target, offset, data_target, data_offset);
+  ZoneList<HValue*> property_values(0, zone());
+  if (boilerplate_object->map()->NumberOfFields() != 0) {
+    BuildEmitInObjectPropertyValues(context, boilerplate_object,
+        original_boilerplate_object, pretenure_flag, &property_values);
   }
 
+  // The allocation site info goes right behind the object.
+  int object_size = boilerplate_object->map()->instance_size();
+  bool create_allocation_site_info = mode == TRACK_ALLOCATION_SITE &&
+      boilerplate_object->map()->CanTrackAllocationSite();
+  int allocation_size = object_size;
+  if (create_allocation_site_info) {
+    allocation_size += AllocationSiteInfo::kSize;
+  }
+  HType type = boilerplate_object->IsJSArray()
+      ? HType::JSArray() : HType::JSObject();
+  HInstruction* object = Add<HAllocate>(context,
+      Add<HConstant>(allocation_size), type,
+      LiteralAllocationFlags(pretenure_flag, FAST_ELEMENTS, true));
+
+  BuildEmitObjectHeader(boilerplate_object, object, object_elements);
+
   // Copy in-object properties.
   if (boilerplate_object->map()->NumberOfFields() != 0) {
-    HValue* object_properties =
-        Add<HInnerAllocatedObject>(target, object_offset);
-    BuildEmitInObjectProperties(boilerplate_object, original_boilerplate_object,
-        object_properties, target, offset, data_target, data_offset);
+    BuildEmitInObjectProperties(boilerplate_object, object, &property_values);
   }
 
   // Create allocation site info.
-  if (mode == TRACK_ALLOCATION_SITE &&
-      boilerplate_object->map()->CanTrackAllocationSite()) {
-    elements_offset += AllocationSiteInfo::kSize;
-    *offset += AllocationSiteInfo::kSize;
-    HInstruction* original_boilerplate =
-        Add<HConstant>(original_boilerplate_object);
-    BuildCreateAllocationSiteInfo(target, JSArray::kSize, original_boilerplate);
+  if (create_allocation_site_info) {
+    HInstruction* allocation_site_constant = Add<HConstant>(allocation_site);
+    BuildCreateAllocationSiteInfo(object, object_size,
+                                  allocation_site_constant);
+    BuildIncrementMementoCreateCount(environment()->LookupContext(),
+                                     allocation_site_constant);
   }
+
+  return object;
 }
 
 
-HValue* HOptimizedGraphBuilder::BuildEmitObjectHeader(
+void HOptimizedGraphBuilder::BuildEmitObjectHeader(
     Handle<JSObject> boilerplate_object,
-    HInstruction* target,
-    HInstruction* data_target,
-    int object_offset,
-    int elements_offset,
-    int elements_size) {
+    HInstruction* object,
+    HValue* object_elements) {
   ASSERT(boilerplate_object->properties()->length() == 0);
-  HValue* result = NULL;
 
-  HValue* object_header = Add<HInnerAllocatedObject>(target, object_offset);
   Handle<Map> boilerplate_object_map(boilerplate_object->map());
-  AddStoreMapConstant(object_header, boilerplate_object_map);
+  AddStoreMapConstant(object, boilerplate_object_map);
 
-  HInstruction* elements;
-  if (elements_size == 0) {
+  HValue* elements = object_elements;
+  if (elements == NULL) {
     Handle<Object> elements_field =
         Handle<Object>(boilerplate_object->elements(), isolate());
     elements = Add<HConstant>(elements_field);
-  } else {
-    if (data_target != NULL && boilerplate_object->HasFastDoubleElements()) {
-      elements = Add<HInnerAllocatedObject>(data_target, elements_offset);
-    } else {
-      elements = Add<HInnerAllocatedObject>(target, elements_offset);
-    }
-    result = elements;
   }
-  AddStore(object_header, HObjectAccess::ForElementsPointer(), elements);
+  AddStore(object, HObjectAccess::ForElementsPointer(), elements);
 
   Handle<Object> properties_field =
       Handle<Object>(boilerplate_object->properties(), isolate());
   ASSERT(*properties_field == isolate()->heap()->empty_fixed_array());
   HInstruction* properties = Add<HConstant>(properties_field);
   HObjectAccess access = HObjectAccess::ForPropertiesPointer();
-  AddStore(object_header, access, properties);
+  AddStore(object, access, properties);
 
   if (boilerplate_object->IsJSArray()) {
     Handle<JSArray> boilerplate_array =
@@ -9579,69 +9574,48 @@ HValue* HOptimizedGraphBuilder::BuildEmitObjectHeader(
     Representation representation =
         IsFastElementsKind(boilerplate_array->GetElementsKind())
         ? Representation::Smi() : Representation::Tagged();
-    AddStore(object_header, HObjectAccess::ForArrayLength(),
+    AddStore(object, HObjectAccess::ForArrayLength(),
         length, representation);
   }
-
-  return result;
 }
 
 
-void HOptimizedGraphBuilder::BuildEmitInObjectProperties(
+void HOptimizedGraphBuilder::BuildEmitInObjectPropertyValues(
+    HValue* context,
     Handle<JSObject> boilerplate_object,
     Handle<JSObject> original_boilerplate_object,
-    HValue* object_properties,
-    HInstruction* target,
-    int* offset,
-    HInstruction* data_target,
-    int* data_offset) {
+    PretenureFlag pretenure_flag,
+    ZoneList<HValue*>* values) {
   Handle<DescriptorArray> descriptors(
       boilerplate_object->map()->instance_descriptors());
   int limit = boilerplate_object->map()->NumberOfOwnDescriptors();
 
-  int copied_fields = 0;
   for (int i = 0; i < limit; i++) {
     PropertyDetails details = descriptors->GetDetails(i);
     if (details.type() != FIELD) continue;
-    copied_fields++;
     int index = descriptors->GetFieldIndex(i);
-    int property_offset = boilerplate_object->GetInObjectPropertyOffset(index);
-    Handle<Name> name(descriptors->GetKey(i));
     Handle<Object> value =
         Handle<Object>(boilerplate_object->InObjectPropertyAt(index),
         isolate());
 
-    // The access for the store depends on the type of the boilerplate.
-    HObjectAccess access = boilerplate_object->IsJSArray() ?
-        HObjectAccess::ForJSArrayOffset(property_offset) :
-        HObjectAccess::ForJSObjectOffset(property_offset);
-
     if (value->IsJSObject()) {
       Handle<JSObject> value_object = Handle<JSObject>::cast(value);
       Handle<JSObject> original_value_object = Handle<JSObject>::cast(
           Handle<Object>(original_boilerplate_object->InObjectPropertyAt(index),
               isolate()));
-      HInstruction* value_instruction = Add<HInnerAllocatedObject>(target,
-                                                                   *offset);
-
-      AddStore(object_properties, access, value_instruction);
-
-      BuildEmitDeepCopy(value_object, original_value_object, target,
-          offset, data_target, data_offset, DONT_TRACK_ALLOCATION_SITE);
+      HInstruction* value_instruction = BuildEmitDeepCopy(context,
+          value_object, original_value_object, Handle<Object>::null(),
+          DONT_TRACK_ALLOCATION_SITE, pretenure_flag);
+      values->Add(value_instruction, zone());
     } else {
       Representation representation = details.representation();
       HInstruction* value_instruction = Add<HConstant>(value);
 
       if (representation.IsDouble()) {
         // Allocate a HeapNumber box and store the value into it.
-        HInstruction* double_box;
-        if (data_target != NULL) {
-          double_box = Add<HInnerAllocatedObject>(data_target, *data_offset);
-          *data_offset += HeapNumber::kSize;
-        } else {
-          double_box = Add<HInnerAllocatedObject>(target, *offset);
-          *offset += HeapNumber::kSize;
-        }
+        HInstruction* double_box = Add<HAllocate>(context,
+            Add<HConstant>(HeapNumber::kSize), HType::HeapNumber(),
+            LiteralAllocationFlags(pretenure_flag, FAST_ELEMENTS, false));
         AddStoreMapConstant(double_box,
             isolate()->factory()->heap_number_map());
         AddStore(double_box, HObjectAccess::ForHeapNumberValue(),
@@ -9649,9 +9623,34 @@ void HOptimizedGraphBuilder::BuildEmitInObjectProperties(
         value_instruction = double_box;
       }
 
-      AddStore(object_properties, access, value_instruction);
+      values->Add(value_instruction, zone());
     }
   }
+}
+
+
+void HOptimizedGraphBuilder::BuildEmitInObjectProperties(
+    Handle<JSObject> boilerplate_object,
+    HInstruction* object,
+    ZoneList<HValue*>* values) {
+  Handle<DescriptorArray> descriptors(
+      boilerplate_object->map()->instance_descriptors());
+  int limit = boilerplate_object->map()->NumberOfOwnDescriptors();
+
+  int copied_fields = 0;
+  for (int i = 0; i < limit; i++) {
+    PropertyDetails details = descriptors->GetDetails(i);
+    if (details.type() != FIELD) continue;
+    int index = descriptors->GetFieldIndex(i);
+    int property_offset = boilerplate_object->GetInObjectPropertyOffset(index);
+
+    // The access for the store depends on the type of the boilerplate.
+    HObjectAccess access = boilerplate_object->IsJSArray() ?
+        HObjectAccess::ForJSArrayOffset(property_offset) :
+        HObjectAccess::ForJSObjectOffset(property_offset);
+
+    AddStore(object, access, values->at(copied_fields++));
+  }
 
   int inobject_properties = boilerplate_object->map()->inobject_properties();
   HInstruction* value_instruction =
@@ -9660,43 +9659,42 @@ void HOptimizedGraphBuilder::BuildEmitInObjectProperties(
     ASSERT(boilerplate_object->IsJSObject());
     int property_offset = boilerplate_object->GetInObjectPropertyOffset(i);
     HObjectAccess access = HObjectAccess::ForJSObjectOffset(property_offset);
-    AddStore(object_properties, access, value_instruction);
+    AddStore(object, access, value_instruction);
   }
 }
 
 
-void HOptimizedGraphBuilder::BuildEmitElements(
+HInstruction* HOptimizedGraphBuilder::BuildEmitElements(
+    HValue* context,
     Handle<FixedArrayBase> elements,
     Handle<FixedArrayBase> original_elements,
     ElementsKind kind,
-    HValue* object_elements,
-    HInstruction* target,
-    int* offset,
-    HInstruction* data_target,
-    int* data_offset) {
-  int elements_length = elements->length();
-  HValue* object_elements_length = Add<HConstant>(elements_length);
-
-  BuildInitializeElementsHeader(object_elements, kind, object_elements_length);
-
+    PretenureFlag pretenure_flag) {
   // Copy elements backing store content.
   if (elements->IsFixedDoubleArray()) {
-    BuildEmitFixedDoubleArray(elements, kind, object_elements);
+    return BuildEmitFixedDoubleArray(context, elements, kind, pretenure_flag);
   } else if (elements->IsFixedArray()) {
-    BuildEmitFixedArray(elements, original_elements, kind, object_elements,
-        target, offset, data_target, data_offset);
-  } else {
-    UNREACHABLE();
+    return BuildEmitFixedArray(context, elements, original_elements, kind,
+                               pretenure_flag);
   }
+  UNREACHABLE();
+  return NULL;
 }
 
 
-void HOptimizedGraphBuilder::BuildEmitFixedDoubleArray(
+HInstruction* HOptimizedGraphBuilder::BuildEmitFixedDoubleArray(
+    HValue* context,
     Handle<FixedArrayBase> elements,
     ElementsKind kind,
-    HValue* object_elements) {
-  HInstruction* boilerplate_elements = Add<HConstant>(elements);
+    PretenureFlag pretenure_flag) {
   int elements_length = elements->length();
+  HInstruction* object_elements = Add<HAllocate>(context,
+      Add<HConstant>(elements->Size()), HType::Tagged(),
+      LiteralAllocationFlags(pretenure_flag, kind, false));
+  BuildInitializeElementsHeader(object_elements, kind,
+                                Add<HConstant>(elements_length));
+
+  HInstruction* boilerplate_elements = Add<HConstant>(elements);
   for (int i = 0; i < elements_length; i++) {
     HValue* key_constant = Add<HConstant>(i);
     HInstruction* value_instruction =
@@ -9707,43 +9705,57 @@ void HOptimizedGraphBuilder::BuildEmitFixedDoubleArray(
                                            value_instruction, kind);
     store->SetFlag(HValue::kAllowUndefinedAsNaN);
   }
+  return object_elements;
 }
 
 
-void HOptimizedGraphBuilder::BuildEmitFixedArray(
+HInstruction* HOptimizedGraphBuilder::BuildEmitFixedArray(
+    HValue* context,
     Handle<FixedArrayBase> elements,
     Handle<FixedArrayBase> original_elements,
     ElementsKind kind,
-    HValue* object_elements,
-    HInstruction* target,
-    int* offset,
-    HInstruction* data_target,
-    int* data_offset) {
-  HInstruction* boilerplate_elements = Add<HConstant>(elements);
+    PretenureFlag pretenure_flag) {
   int elements_length = elements->length();
   Handle<FixedArray> fast_elements = Handle<FixedArray>::cast(elements);
   Handle<FixedArray> original_fast_elements =
       Handle<FixedArray>::cast(original_elements);
+
+  // Build nested objects first, the values of all other elements are loaded
+  // from the boilerplate below.
+  ZoneList<HValue*> nested_values(elements_length, zone());
   for (int i = 0; i < elements_length; i++) {
     Handle<Object> value(fast_elements->get(i), isolate());
-    HValue* key_constant = Add<HConstant>(i);
+    HInstruction* value_instruction = NULL;
     if (value->IsJSObject()) {
       Handle<JSObject> value_object = Handle<JSObject>::cast(value);
       Handle<JSObject> original_value_object = Handle<JSObject>::cast(
           Handle<Object>(original_fast_elements->get(i), isolate()));
-      HInstruction* value_instruction = Add<HInnerAllocatedObject>(target,
-                                                                   *offset);
-      Add<HStoreKeyed>(object_elements, key_constant, value_instruction, kind);
-      BuildEmitDeepCopy(value_object, original_value_object, target,
-          offset, data_target, data_offset, DONT_TRACK_ALLOCATION_SITE);
-    } else {
-      HInstruction* value_instruction =
+      value_instruction = BuildEmitDeepCopy(context, value_object,
+          original_value_object, Handle<Object>::null(),
+          DONT_TRACK_ALLOCATION_SITE, pretenure_flag);
+    }
+    nested_values.Add(value_instruction, zone());
+  }
+
+  HInstruction* object_elements = Add<HAllocate>(context,
+      Add<HConstant>(elements->Size()), HType::Tagged(),
+      LiteralAllocationFlags(pretenure_flag, kind, true));
+  BuildInitializeElementsHeader(object_elements, kind,
+                                Add<HConstant>(elements_length));
+
+  HInstruction* boilerplate_elements = Add<HConstant>(elements);
+  for (int i = 0; i < elements_length; i++) {
+    HValue* key_constant = Add<HConstant>(i);
+    HValue* value_instruction = nested_values[i];
+    if (value_instruction == NULL) {
+      value_instruction =
           Add<HLoadKeyed>(boilerplate_elements, key_constant,
                           static_cast<HValue*>(NULL), kind,
                           ALLOW_RETURN_HOLE);
-      Add<HStoreKeyed>(object_elements, key_constant, value_instruction, kind);
     }
+    Add<HStoreKeyed>(object_elements, key_constant, value_instruction, kind);
   }
+  return object_elements;
 }
 
 void HOptimizedGraphBuilder::VisitThisFunction(ThisFunction* expr) {
@@ -1405,6 +1405,7 @@ class HGraphBuilder {
 
   HValue* BuildCloneShallowArray(HContext* context,
                                  HValue* boilerplate,
+                                 HValue* allocation_site,
                                  AllocationSiteMode mode,
                                  ElementsKind kind,
                                  int length);
@@ -1419,6 +1420,11 @@ class HGraphBuilder {
                                         int previous_object_size,
                                         HValue* payload);
 
+  // Counts a memento handed out by the allocation site, the scavenger counts
+  // the ones that survive.
+  void BuildIncrementMementoCreateCount(HValue* context,
+                                        HValue* allocation_site);
+
   HInstruction* BuildGetNativeContext(HValue* context);
   HInstruction* BuildGetArrayFunction(HValue* context);
 
@@ -1868,55 +1874,48 @@ class HOptimizedGraphBuilder: public HGraphBuilder, public AstVisitor {
   HInstruction* BuildFastLiteral(HValue* context,
                                  Handle<JSObject> boilerplate_object,
                                  Handle<JSObject> original_boilerplate_object,
-                                 int data_size,
-                                 int pointer_size,
-                                 AllocationSiteMode mode);
-
-  void BuildEmitDeepCopy(Handle<JSObject> boilerplat_object,
-                         Handle<JSObject> object,
-                         HInstruction* target,
-                         int* offset,
-                         HInstruction* data_target,
-                         int* data_offset,
-                         AllocationSiteMode mode);
-
-  MUST_USE_RESULT HValue* BuildEmitObjectHeader(
-      Handle<JSObject> boilerplat_object,
-      HInstruction* target,
-      HInstruction* data_target,
-      int object_offset,
-      int elements_offset,
-      int elements_size);
+                                 Handle<Object> allocation_site,
+                                 AllocationSiteMode mode,
+                                 PretenureFlag pretenure_flag);
+
+  HInstruction* BuildEmitDeepCopy(HValue* context,
+                                  Handle<JSObject> boilerplate_object,
+                                  Handle<JSObject> original_boilerplate_object,
+                                  Handle<Object> allocation_site,
+                                  AllocationSiteMode mode,
+                                  PretenureFlag pretenure_flag);
+
+  void BuildEmitObjectHeader(Handle<JSObject> boilerplate_object,
+                             HInstruction* object,
+                             HValue* object_elements);
+
+  void BuildEmitInObjectPropertyValues(
+      HValue* context,
+      Handle<JSObject> boilerplate_object,
+      Handle<JSObject> original_boilerplate_object,
+      PretenureFlag pretenure_flag,
+      ZoneList<HValue*>* values);
 
   void BuildEmitInObjectProperties(Handle<JSObject> boilerplate_object,
-                                   Handle<JSObject> original_boilerplate_object,
-                                   HValue* object_properties,
-                                   HInstruction* target,
-                                   int* offset,
-                                   HInstruction* data_target,
-                                   int* data_offset);
-
-  void BuildEmitElements(Handle<FixedArrayBase> elements,
-                         Handle<FixedArrayBase> original_elements,
-                         ElementsKind kind,
-                         HValue* object_elements,
-                         HInstruction* target,
-                         int* offset,
-                         HInstruction* data_target,
-                         int* data_offset);
-
-  void BuildEmitFixedDoubleArray(Handle<FixedArrayBase> elements,
-                                 ElementsKind kind,
-                                 HValue* object_elements);
-
-  void BuildEmitFixedArray(Handle<FixedArrayBase> elements,
-                           Handle<FixedArrayBase> original_elements,
-                           ElementsKind kind,
-                           HValue* object_elements,
-                           HInstruction* target,
-                           int* offset,
-                           HInstruction* data_target,
-                           int* data_offset);
+                                   HInstruction* object,
+                                   ZoneList<HValue*>* values);
+
+  HInstruction* BuildEmitElements(HValue* context,
+                                  Handle<FixedArrayBase> elements,
+                                  Handle<FixedArrayBase> original_elements,
+                                  ElementsKind kind,
+                                  PretenureFlag pretenure_flag);
+
+  HInstruction* BuildEmitFixedDoubleArray(HValue* context,
+                                          Handle<FixedArrayBase> elements,
+                                          ElementsKind kind,
+                                          PretenureFlag pretenure_flag);
+
+  HInstruction* BuildEmitFixedArray(HValue* context,
+                                    Handle<FixedArrayBase> elements,
+                                    Handle<FixedArrayBase> original_elements,
+                                    ElementsKind kind,
+                                    PretenureFlag pretenure_flag);
 
   void AddCheckPrototypeMaps(Handle<JSObject> holder,
                              Handle<Map> receiver_map);
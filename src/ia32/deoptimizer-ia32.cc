@@ -196,7 +196,7 @@ void Deoptimizer::DeoptimizeFunctionWithPreparedFunctionList(
   data->deoptimizing_code_list_ = node;
 
   // Log the action before the code submitted for GC
-  if ( FLAG_trace_internals ) {
+  if ( FLAG_trace_internals || FLAG_trace_deopt_loops ) {
 	// Generate deopt events for all functions on the code list
 	SharedFunctionInfo* shared = function->shared();
 	Code* new_code = shared->code();
@@ -206,7 +206,7 @@ void Deoptimizer::DeoptimizeFunctionWithPreparedFunctionList(
 	while (current != undefined) {
 	  JSFunction* func = JSFunction::cast(current);
 	  current = func->next_function_link();
-	  LOG(isolate,
+	  LOG_OPT_EVENT(isolate,
 		EmitFunctionEvent(
 		  Logger::ForceDeopt,
 		  func,
@@ -45,7 +45,11 @@ bool IncrementalMarking::BaseRecordWrite(HeapObject* obj,
       MemoryChunk* chunk = MemoryChunk::FromAddress(obj->address());
       if (chunk->IsFlagSet(MemoryChunk::HAS_PROGRESS_BAR)) {
         if (chunk->IsLeftOfProgressBar(slot)) {
-          WhiteToGreyAndPush(value_heap_obj, value_bit);
+          if (heap_->concurrent_marking() == NULL) {
+            WhiteToGreyAndPush(value_heap_obj, value_bit);
+          } else if (Marking::WhiteToGreyAtomic(value_bit)) {
+            marking_deque_.PushGrey(value_heap_obj);
+          }
           RestartIfNotMarking();
         } else {
           return false;
@@ -92,6 +96,7 @@ void IncrementalMarking::RecordWriteIntoCode(HeapObject* obj,
 
 void IncrementalMarking::RecordWrites(HeapObject* obj) {
   if (IsMarking()) {
+    if (heap_->concurrent_marking() != NULL) MemoryBarrier();
     MarkBit obj_bit = Marking::MarkBitFrom(obj);
     if (Marking::IsBlack(obj_bit)) {
       MemoryChunk* chunk = MemoryChunk::FromAddress(obj->address());
@@ -110,9 +115,15 @@ void IncrementalMarking::BlackToGreyAndUnshift(HeapObject* obj,
   ASSERT(Marking::MarkBitFrom(obj) == mark_bit);
   ASSERT(obj->Size() >= 2*kPointerSize);
   ASSERT(IsMarking());
-  Marking::BlackToGrey(mark_bit);
   int obj_size = obj->Size();
-  MemoryChunk::IncrementLiveBytesFromGC(obj->address(), -obj_size);
+  if (heap_->concurrent_marking() == NULL) {
+    Marking::BlackToGrey(mark_bit);
+    MemoryChunk::IncrementLiveBytesFromGC(obj->address(), -obj_size);
+  } else {
+    // The marking threads may be changing other bits of the same cells.
+    Marking::BlackToGreyAtomic(mark_bit);
+    MemoryChunk::IncrementLiveBytesAtomically(obj->address(), -obj_size);
+  }
   bytes_scanned_ -= obj_size;
   int64_t old_bytes_rescanned = bytes_rescanned_;
   bytes_rescanned_ = old_bytes_rescanned + obj_size;
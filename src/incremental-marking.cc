@@ -31,6 +31,7 @@
 
 #include "code-stubs.h"
 #include "compilation-cache.h"
+#include "concurrent-marking.h"
 #include "objects-visiting.h"
 #include "objects-visiting-inl.h"
 #include "v8conversions.h"
@@ -67,6 +68,9 @@ void IncrementalMarking::TearDown() {
 void IncrementalMarking::RecordWriteSlow(HeapObject* obj,
                                          Object** slot,
                                          Object* value) {
+  // The store must be visible to the marking threads before the colors are
+  // checked, a thread that blackens the object afterwards will see it.
+  if (heap_->concurrent_marking() != NULL) MemoryBarrier();
   if (BaseRecordWrite(obj, slot, value) && slot != NULL) {
     MarkBit obj_bit = Marking::MarkBitFrom(obj);
     if (Marking::IsBlack(obj_bit)) {
@@ -86,13 +90,20 @@ void IncrementalMarking::RecordWriteFromCode(HeapObject* obj,
   ASSERT(!marking->is_compacting_);
 
   MemoryChunk* chunk = MemoryChunk::FromAddress(obj->address());
-  int counter = chunk->write_barrier_counter();
-  if (counter < (MemoryChunk::kWriteBarrierCounterGranularity / 2)) {
-    marking->write_barriers_invoked_since_last_step_ +=
-        MemoryChunk::kWriteBarrierCounterGranularity -
-            chunk->write_barrier_counter();
-    chunk->set_write_barrier_counter(
-        MemoryChunk::kWriteBarrierCounterGranularity);
+  if (isolate->heap()->concurrent_marking() != NULL) {
+    // The colors are only checked here while the marking threads run, see
+    // SetOldSpacePageFlags.
+    marking->write_barriers_invoked_since_last_step_++;
+    chunk->set_write_barrier_counter(0);
+  } else {
+    int counter = chunk->write_barrier_counter();
+    if (counter < (MemoryChunk::kWriteBarrierCounterGranularity / 2)) {
+      marking->write_barriers_invoked_since_last_step_ +=
+          MemoryChunk::kWriteBarrierCounterGranularity -
+              chunk->write_barrier_counter();
+      chunk->set_write_barrier_counter(
+          MemoryChunk::kWriteBarrierCounterGranularity);
+    }
   }
 
   marking->RecordWrite(obj, slot, *slot);
@@ -107,13 +118,20 @@ void IncrementalMarking::RecordWriteForEvacuationFromCode(HeapObject* obj,
   ASSERT(marking->is_compacting_);
 
   MemoryChunk* chunk = MemoryChunk::FromAddress(obj->address());
-  int counter = chunk->write_barrier_counter();
-  if (counter < (MemoryChunk::kWriteBarrierCounterGranularity / 2)) {
-    marking->write_barriers_invoked_since_last_step_ +=
-        MemoryChunk::kWriteBarrierCounterGranularity -
-            chunk->write_barrier_counter();
-    chunk->set_write_barrier_counter(
-        MemoryChunk::kWriteBarrierCounterGranularity);
+  if (isolate->heap()->concurrent_marking() != NULL) {
+    // The colors are only checked here while the marking threads run, see
+    // SetOldSpacePageFlags.
+    marking->write_barriers_invoked_since_last_step_++;
+    chunk->set_write_barrier_counter(0);
+  } else {
+    int counter = chunk->write_barrier_counter();
+    if (counter < (MemoryChunk::kWriteBarrierCounterGranularity / 2)) {
+      marking->write_barriers_invoked_since_last_step_ +=
+          MemoryChunk::kWriteBarrierCounterGranularity -
+              chunk->write_barrier_counter();
+      chunk->set_write_barrier_counter(
+          MemoryChunk::kWriteBarrierCounterGranularity);
+    }
   }
 
   marking->RecordWrite(obj, slot, *slot);
@@ -143,6 +161,7 @@ void IncrementalMarking::RecordCodeTargetPatch(Address pc, HeapObject* value) {
 void IncrementalMarking::RecordWriteOfCodeEntrySlow(JSFunction* host,
                                                     Object** slot,
                                                     Code* value) {
+  if (heap_->concurrent_marking() != NULL) MemoryBarrier();
   if (BaseRecordWrite(host, slot, value)) {
     ASSERT(slot != NULL);
     heap_->mark_compact_collector()->
@@ -154,6 +173,7 @@ void IncrementalMarking::RecordWriteOfCodeEntrySlow(JSFunction* host,
 void IncrementalMarking::RecordWriteIntoCodeSlow(HeapObject* obj,
                                                  RelocInfo* rinfo,
                                                  Object* value) {
+  if (heap_->concurrent_marking() != NULL) MemoryBarrier();
   MarkBit value_bit = Marking::MarkBitFrom(HeapObject::cast(value));
   if (Marking::IsWhite(value_bit)) {
     MarkBit obj_bit = Marking::MarkBitFrom(obj);
@@ -393,6 +413,13 @@ void IncrementalMarking::SetOldSpacePageFlags(MemoryChunk* chunk,
         is_compacting) {
       chunk->SetFlag(MemoryChunk::RESCAN_ON_EVACUATION);
     }
+
+    // The write barrier stub checks colors inline while the counter of the
+    // page is positive.  That is not safe against the marking threads, so
+    // every barrier goes to RecordWriteFromCode instead.
+    if (chunk->heap()->concurrent_marking() != NULL) {
+      chunk->set_write_barrier_counter(0);
+    }
   } else if (chunk->owner()->identity() == CELL_SPACE ||
              chunk->owner()->identity() == PROPERTY_CELL_SPACE ||
              chunk->scan_on_scavenge()) {
@@ -410,6 +437,9 @@ void IncrementalMarking::SetNewSpacePageFlags(NewSpacePage* chunk,
   chunk->SetFlag(MemoryChunk::POINTERS_TO_HERE_ARE_INTERESTING);
   if (is_marking) {
     chunk->SetFlag(MemoryChunk::POINTERS_FROM_HERE_ARE_INTERESTING);
+    if (chunk->heap()->concurrent_marking() != NULL) {
+      chunk->set_write_barrier_counter(0);
+    }
   } else {
     chunk->ClearFlag(MemoryChunk::POINTERS_FROM_HERE_ARE_INTERESTING);
   }
@@ -469,6 +499,16 @@ void IncrementalMarking::ActivateIncrementalWriteBarrier(NewSpace* space) {
     NewSpacePage* p = it.next();
     SetNewSpacePageFlags(p, true);
   }
+
+  if (space->heap()->concurrent_marking() != NULL &&
+      space->IsFromSpaceCommitted()) {
+    // From space pages become to space pages in the next scavenge.
+    NewSpacePageIterator from_it(space->FromSpaceStart(),
+                                 space->FromSpaceEnd());
+    while (from_it.has_next()) {
+      from_it.next()->set_write_barrier_counter(0);
+    }
+  }
 }
 
 
@@ -650,6 +690,10 @@ void IncrementalMarking::StartMarking(CompactionFlag flag) {
   if (FLAG_trace_incremental_marking) {
     PrintF("[IncrementalMarking] Running\n");
   }
+
+  if (heap_->concurrent_marking() != NULL) {
+    heap_->concurrent_marking()->Resume();
+  }
 }
 
 
@@ -735,7 +779,7 @@ void IncrementalMarking::VisitObject(Map* map, HeapObject* obj, int size) {
 }
 
 
-void IncrementalMarking::ProcessMarkingDeque(intptr_t bytes_to_process) {
+intptr_t IncrementalMarking::ProcessMarkingDeque(intptr_t bytes_to_process) {
   Map* filler_map = heap_->one_pointer_filler_map();
   while (!marking_deque_.IsEmpty() && bytes_to_process > 0) {
     HeapObject* obj = marking_deque_.Pop();
@@ -750,6 +794,7 @@ void IncrementalMarking::ProcessMarkingDeque(intptr_t bytes_to_process) {
     VisitObject(map, obj, size);
     bytes_to_process -= (size - unscanned_bytes_of_large_object_);
   }
+  return bytes_to_process;
 }
 
 
@@ -769,6 +814,9 @@ void IncrementalMarking::ProcessMarkingDeque() {
 
 
 void IncrementalMarking::Hurry() {
+  if (heap_->concurrent_marking() != NULL) {
+    heap_->concurrent_marking()->Finish();
+  }
   if (state() == MARKING) {
     double start = 0.0;
     if (FLAG_trace_incremental_marking || FLAG_print_cumulative_gc_stat) {
@@ -822,6 +870,9 @@ void IncrementalMarking::Abort() {
   if (FLAG_trace_incremental_marking) {
     PrintF("[IncrementalMarking] Aborting.\n");
   }
+  if (heap_->concurrent_marking() != NULL) {
+    heap_->concurrent_marking()->Abort();
+  }
   heap_->new_space()->LowerInlineAllocationLimit(0);
   IncrementalMarking::set_should_hurry(false);
   ResetStepCounters();
@@ -934,8 +985,25 @@ void IncrementalMarking::Step(intptr_t allocated_bytes,
       StartMarking(PREVENT_COMPACTION);
     }
   } else if (state_ == MARKING) {
-    ProcessMarkingDeque(bytes_to_process);
-    if (marking_deque_.IsEmpty()) MarkingComplete(action);
+    ConcurrentMarking* concurrent_marking = heap_->concurrent_marking();
+    if (concurrent_marking == NULL) {
+      ProcessMarkingDeque(bytes_to_process);
+      if (marking_deque_.IsEmpty()) MarkingComplete(action);
+    } else {
+      // The objects handed back by the marking threads are only available
+      // while they are paused.  Whatever budget is left after that is used
+      // to help with the work of the threads.
+      concurrent_marking->Pause();
+      intptr_t bytes_left = ProcessMarkingDeque(bytes_to_process);
+      while (bytes_left > 0 && concurrent_marking->RefillMarkingDeque()) {
+        bytes_left = ProcessMarkingDeque(bytes_left);
+      }
+      if (marking_deque_.IsEmpty() && concurrent_marking->IsEmpty()) {
+        MarkingComplete(action);
+      } else {
+        concurrent_marking->Resume();
+      }
+    }
   }
 
   steps_count_++;
@@ -34,6 +34,7 @@
 #include "bootstrapper.h"
 #include "codegen.h"
 #include "compilation-cache.h"
+#include "concurrent-marking.h"
 #include "cpu-profiler.h"
 #include "debug.h"
 #include "deoptimizer.h"
@@ -48,6 +49,7 @@
 #include "regexp-stack.h"
 #include "runtime-profiler.h"
 #include "sampler.h"
+#include "scavenger-thread.h"
 #include "scopeinfo.h"
 #include "serialize.h"
 #include "simulator.h"
@@ -148,6 +150,12 @@ int SystemThreadManager::NumberOfParallelSystemThreads(
     return number_of_threads - 1;
   } else if (type == PARALLEL_MARKING) {
     return number_of_threads;
+  } else if (type == CONCURRENT_MARKING) {
+    // JavaScript keeps running on the main thread.
+    return number_of_threads - 1;
+  } else if (type == PARALLEL_SCAVENGING) {
+    // The main thread takes part in the scavenge.
+    return number_of_threads - 1;
   }
   return 1;
 }
@@ -1788,6 +1796,7 @@ Isolate::Isolate()
       optimizing_compiler_thread_(this),
       marking_thread_(NULL),
       sweeper_thread_(NULL),
+      scavenger_thread_(NULL),
       callback_table_(NULL) {
   id_ = NoBarrier_AtomicIncrement(&isolate_counter_, 1);
   TRACE_ISOLATE(constructor);
@@ -1886,6 +1895,10 @@ void Isolate::Deinit() {
       delete[] sweeper_thread_;
     }
 
+    if (heap_.concurrent_marking() != NULL) {
+      heap_.concurrent_marking()->Pause();
+    }
+
     if (FLAG_marking_threads > 0) {
       for (int i = 0; i < FLAG_marking_threads; i++) {
         marking_thread_[i]->Stop();
@@ -1894,6 +1907,15 @@ void Isolate::Deinit() {
       delete[] marking_thread_;
     }
 
+    if (FLAG_scavenger_threads > 0) {
+      heap_.store_buffer()->FinishConcurrentDeduplication();
+      for (int i = 0; i < FLAG_scavenger_threads; i++) {
+        scavenger_thread_[i]->Stop();
+        delete scavenger_thread_[i];
+      }
+      delete[] scavenger_thread_;
+    }
+
     if (FLAG_hydrogen_stats) GetHStatistics()->Print();
 
     // We must stop the logger before we tear down other components.
@@ -2329,7 +2351,7 @@ bool Isolate::Init(Deserializer* des) {
   if (FLAG_marking_threads > 0) {
     marking_thread_ = new MarkingThread*[FLAG_marking_threads];
     for (int i = 0; i < FLAG_marking_threads; i++) {
-      marking_thread_[i] = new MarkingThread(this);
+      marking_thread_[i] = new MarkingThread(this, i);
       marking_thread_[i]->Start();
     }
   }
@@ -2337,11 +2359,19 @@ bool Isolate::Init(Deserializer* des) {
   if (FLAG_sweeper_threads > 0) {
     sweeper_thread_ = new SweeperThread*[FLAG_sweeper_threads];
     for (int i = 0; i < FLAG_sweeper_threads; i++) {
-      sweeper_thread_[i] = new SweeperThread(this);
+      sweeper_thread_[i] = new SweeperThread(this, i + 1);
       sweeper_thread_[i]->Start();
     }
   }
 
+  if (FLAG_scavenger_threads > 0) {
+    scavenger_thread_ = new ScavengerThread*[FLAG_scavenger_threads];
+    for (int i = 0; i < FLAG_scavenger_threads; i++) {
+      scavenger_thread_[i] = new ScavengerThread(this, i + 1);
+      scavenger_thread_[i]->Start();
+    }
+  }
+
   initialized_from_snapshot_ = (des != NULL);
 
   return true;
@@ -79,6 +79,7 @@ class MarkingThread;
 class PreallocatedMemoryThread;
 class RegExpStack;
 class SaveContext;
+class ScavengerThread;
 class UnicodeCache;
 class ConsStringIteratorOp;
 class StringTracker;
@@ -298,6 +299,8 @@ class SystemThreadManager {
     PARALLEL_SWEEPING,
     CONCURRENT_SWEEPING,
     PARALLEL_MARKING,
+    CONCURRENT_MARKING,
+    PARALLEL_SCAVENGING,
     PARALLEL_RECOMPILATION
   };
 
@@ -1104,6 +1107,10 @@ class Isolate {
     return sweeper_thread_;
   }
 
+  ScavengerThread** scavenger_threads() {
+    return scavenger_thread_;
+  }
+
   CallbackTable* callback_table() {
     return callback_table_;
   }
@@ -1358,6 +1365,7 @@ class Isolate {
   OptimizingCompilerThread optimizing_compiler_thread_;
   MarkingThread** marking_thread_;
   SweeperThread** sweeper_thread_;
+  ScavengerThread** scavenger_thread_;
   CallbackTable* callback_table_;
 
   friend class ExecutionAccess;
@@ -1365,6 +1373,7 @@ class Isolate {
   friend class IsolateInitializer;
   friend class MarkingThread;
   friend class OptimizingCompilerThread;
+  friend class ScavengerThread;
   friend class SweeperThread;
   friend class ThreadManager;
   friend class Simulator;
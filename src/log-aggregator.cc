@@ -0,0 +1,427 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "v8.h"
+
+#include "log-aggregator.h"
+
+namespace v8 {
+namespace internal {
+
+static const char* const kUntrackedName = "Untracked";
+
+
+// Labels are printed between double quotes in the graphviz output.
+static char* CopyLabel(const char* str) {
+  int length = StrLength(str);
+  char* copy = NewArray<char>(length + 1);
+  for (int i = 0; i < length; ++i) {
+    char c = str[i];
+    copy[i] = (c == '"' || c == '\\' || c == '\n') ? '_' : c;
+  }
+  copy[length] = '\0';
+  return copy;
+}
+
+
+// script:line:column of the start of the function.
+static char* SourcePosition(SharedFunctionInfo* shared) {
+  Object* maybe_script = shared->script();
+  if (!maybe_script->IsScript()) return NULL;
+
+  HandleScope scope(shared->GetIsolate());
+  Handle<Script> script(Script::cast(maybe_script));
+  int position = shared->start_position();
+  SmartArrayPointer<char> script_name;
+  if (script->name()->IsString()) {
+    script_name = String::cast(script->name())->ToCString();
+  }
+
+  EmbeddedVector<char, 256> buffer;
+  OS::SNPrintF(buffer, "%s:%d:%d",
+               *script_name != NULL ? *script_name : "<anonymous>",
+               GetScriptLineNumber(script, position) + 1,
+               GetScriptColumnNumber(script, position) + 1);
+  return StrDup(buffer.start());
+}
+
+
+static int CountEvents(const int* counts, const int* events, int length) {
+  int sum = 0;
+  for (int i = 0; i < length; ++i) sum += counts[events[i]];
+  return sum;
+}
+
+
+static uint32_t EdgeHash(void* site, int from, int to, int event) {
+  uint32_t hash = ComputePointerHash(site);
+  hash = ComputeIntegerHash(hash ^ static_cast<uint32_t>(from), kZeroHashSeed);
+  hash = ComputeIntegerHash(hash ^ static_cast<uint32_t>(to), kZeroHashSeed);
+  return ComputeIntegerHash(hash ^ static_cast<uint32_t>(event), kZeroHashSeed);
+}
+
+
+InternalEventAggregator::InternalEventAggregator(
+    const char* const* event_names, int events_count)
+    : event_names_(event_names),
+      events_count_(events_count),
+      dumps_(0),
+      sites_map_(SitesMatch),
+      edges_map_(EdgesMatch) {
+  map_labels_.Add(NULL);
+}
+
+
+InternalEventAggregator::~InternalEventAggregator() {
+  for (int i = 0; i < sites_.length(); ++i) {
+    Site* site = sites_[i];
+    for (int j = 0; j < site->edges.length(); ++j) {
+      Edge* edge = site->edges[j];
+      if (edge->field != NULL) DeleteArray(edge->field);
+      delete edge;
+    }
+    DeleteArray(site->name);
+    if (site->position != NULL) DeleteArray(site->position);
+    DeleteArray(site->counts);
+    delete site;
+  }
+  for (int i = 1; i < map_labels_.length(); ++i) {
+    DeleteArray(map_labels_[i]);
+  }
+}
+
+
+bool InternalEventAggregator::EdgesMatch(void* key1, void* key2) {
+  Edge* edge1 = reinterpret_cast<Edge*>(key1);
+  Edge* edge2 = reinterpret_cast<Edge*>(key2);
+  return edge1->site == edge2->site &&
+         edge1->from == edge2->from &&
+         edge1->to == edge2->to &&
+         edge1->event == edge2->event;
+}
+
+
+InternalEventAggregator::Site* InternalEventAggregator::FindOrAddSite(
+    const char* name, SharedFunctionInfo* source) {
+  uint32_t hash = StringHasher::HashSequentialString(
+      name, StrLength(name), kZeroHashSeed);
+  HashMap::Entry* entry =
+      sites_map_.Lookup(const_cast<char*>(name), hash, true);
+  if (entry->value == NULL) {
+    Site* site = new Site;
+    site->name = CopyLabel(name);
+    site->position = source != NULL ? SourcePosition(source) : NULL;
+    site->counts = NewArray<int>(events_count_);
+    memset(site->counts, 0, events_count_ * sizeof(site->counts[0]));
+    site->objects = 0;
+    site->transitions = 0;
+    site->longest_chain = 0;
+    // The key must outlive the lookup string.
+    entry->key = site->name;
+    entry->value = site;
+    sites_.Add(site);
+  }
+  return reinterpret_cast<Site*>(entry->value);
+}
+
+
+int InternalEventAggregator::FindOrAddMap(Map* map) {
+  int* id_ptr = maps_.Find(map->address());
+  if (id_ptr == NULL) {
+    int id = map_labels_.length();
+    EmbeddedVector<char, 128> label;
+    OS::SNPrintF(label, "M%d\\n%d fields, %s%s",
+                 id,
+                 map->NumberOfOwnDescriptors(),
+                 ElementsKindToString(map->elements_kind()),
+                 map->is_dictionary_map() ? ", dictionary" : "");
+    map_labels_.Add(StrDup(label.start()));
+    id_ptr = maps_.Set(map->address(), id);
+  }
+  return *id_ptr;
+}
+
+
+InternalEventAggregator::Edge* InternalEventAggregator::FindOrAddEdge(
+    Site* site, int from, int to, int event, Name* field) {
+  Edge key = { site, from, to, event, 0, NULL };
+  HashMap::Entry* entry =
+      edges_map_.Lookup(&key, EdgeHash(site, from, to, event), true);
+  if (entry->value == NULL) {
+    Edge* edge = new Edge(key);
+    // Field names are only converted once per edge: a transition between
+    // two given maps always adds or changes the same field.
+    if (field != NULL) {
+      if (field->IsString()) {
+        SmartArrayPointer<char> name = String::cast(field)->ToCString();
+        edge->field = CopyLabel(*name);
+      } else {
+        edge->field = CopyLabel("?field");
+      }
+    }
+    entry->key = edge;
+    entry->value = edge;
+    site->edges.Add(edge);
+  }
+  return reinterpret_cast<Edge*>(entry->value);
+}
+
+
+InternalEventAggregator::TrackedObject* InternalEventAggregator::FindObject(
+    HeapObject* obj) {
+  return objects_.Find(obj->address());
+}
+
+
+void InternalEventAggregator::AddObject(HeapObject* obj,
+                                        Site* site,
+                                        int map,
+                                        int event) {
+  TrackedObject tracked = { site, map, 0 };
+  objects_.Set(obj->address(), tracked);
+
+  site->objects++;
+  if (event != kUntracked) site->counts[event]++;
+  FindOrAddEdge(site, 0, map, event, NULL)->count++;
+}
+
+
+void InternalEventAggregator::RecordCreation(HeapObject* obj,
+                                             Map* map,
+                                             const char* site,
+                                             int event,
+                                             SharedFunctionInfo* source) {
+  AddObject(obj, FindOrAddSite(site, source), FindOrAddMap(map), event);
+}
+
+
+bool InternalEventAggregator::RecordCopy(HeapObject* obj,
+                                         HeapObject* source,
+                                         int event) {
+  TrackedObject* source_info = FindObject(source);
+  if (source_info == NULL) return false;
+  AddObject(obj, source_info->site, FindOrAddMap(obj->map()), event);
+  return true;
+}
+
+
+bool InternalEventAggregator::RecordEvent(HeapObject* obj, int event) {
+  TrackedObject* tracked = FindObject(obj);
+  if (tracked == NULL) return false;
+  tracked->site->counts[event]++;
+  return true;
+}
+
+
+bool InternalEventAggregator::RecordTransition(HeapObject* obj,
+                                               int event,
+                                               Map* old_map,
+                                               Map* new_map,
+                                               Name* field) {
+  TrackedObject* tracked = FindObject(obj);
+  if (tracked == NULL) return false;
+
+  int from = old_map != NULL ? FindOrAddMap(old_map) : tracked->map;
+  int to = FindOrAddMap(new_map);
+  Site* site = tracked->site;
+  tracked->map = to;
+  tracked->transitions++;
+
+  site->counts[event]++;
+  site->transitions++;
+  if (tracked->transitions > site->longest_chain) {
+    site->longest_chain = tracked->transitions;
+  }
+  FindOrAddEdge(site, from, to, event, field)->count++;
+  return true;
+}
+
+
+void InternalEventAggregator::RecordFunctionEvent(const char* site,
+                                                  int event) {
+  FindOrAddSite(site)->counts[event]++;
+}
+
+
+void InternalEventAggregator::MoveObject(Address from, Address to) {
+  objects_.Move(from, to);
+}
+
+
+void InternalEventAggregator::MoveMap(Address from, Address to) {
+  maps_.Move(from, to);
+}
+
+
+void InternalEventAggregator::RemoveDeadObjects(Heap* heap) {
+  objects_.RemoveDeadObjects(heap);
+  // The ids of dead maps are kept, the edges of the graphs refer to them.
+  maps_.RemoveDeadObjects(heap);
+}
+
+
+const char* InternalEventAggregator::EventName(int event) {
+  return event == kUntracked ? kUntrackedName : event_names_[event];
+}
+
+
+int InternalEventAggregator::CompareSites(Site* const* a, Site* const* b) {
+  int weight_a = (*a)->objects + (*a)->transitions;
+  int weight_b = (*b)->objects + (*b)->transitions;
+  if (weight_a != weight_b) return weight_a > weight_b ? -1 : 1;
+  return strcmp((*a)->name, (*b)->name);
+}
+
+
+void InternalEventAggregator::DumpSite(FILE* out, int index, Site* site) {
+  OS::FPrint(out, "digraph G%d {\n", index);
+  OS::FPrint(out, "\tlabel=\"%s: %d objects, %d transitions\";\n",
+             site->name, site->objects, site->transitions);
+  OS::FPrint(out, "\tnode [shape=box];\n");
+  OS::FPrint(out, "\t0 [shape=ellipse, label=\"%s\"];\n", site->name);
+
+  // Declare every map the graph refers to once.
+  List<int> maps;
+  for (int i = 0; i < site->edges.length(); ++i) {
+    Edge* edge = site->edges[i];
+    if (edge->from != 0) maps.Add(edge->from);
+    maps.Add(edge->to);
+  }
+  maps.Sort();
+  for (int i = 0; i < maps.length(); ++i) {
+    if (i > 0 && maps[i] == maps[i - 1]) continue;
+    OS::FPrint(out, "\t%d [label=\"%s\"];\n", maps[i], map_labels_[maps[i]]);
+  }
+
+  for (int i = 0; i < site->edges.length(); ++i) {
+    Edge* edge = site->edges[i];
+    OS::FPrint(out, "\t%d -> %d [label=\"%s%s%s x%d\"];\n",
+               edge->from, edge->to,
+               EventName(edge->event),
+               edge->field != NULL ? " " : "",
+               edge->field != NULL ? edge->field : "",
+               edge->count);
+  }
+
+  // Events that do not show up as edges, e.g. code events of functions.
+  OS::FPrint(out, "\t//");
+  for (int i = 0; i < events_count_; ++i) {
+    if (site->counts[i] != 0) {
+      OS::FPrint(out, " %s=%d", event_names_[i], site->counts[i]);
+    }
+  }
+  OS::FPrint(out, "\n}\n");
+}
+
+
+void InternalEventAggregator::Dump(FILE* out) {
+  List<Site*> sites(sites_.length());
+  sites.AddAll(sites_);
+  sites.Sort(CompareSites);
+
+  OS::FPrint(out, "// aggregated internal events, dump %d: "
+             "%d sites, %d maps, %d live objects\n",
+             dumps_++, sites.length(), map_labels_.length() - 1,
+             objects_.length());
+  for (int i = 0; i < sites.length(); ++i) {
+    DumpSite(out, i, sites[i]);
+  }
+  fflush(out);
+}
+
+
+int InternalEventAggregator::CompareHotspots(const Hotspot* a,
+                                             const Hotspot* b) {
+  if (a->site->transitions != b->site->transitions) {
+    return a->site->transitions > b->site->transitions ? -1 : 1;
+  }
+  if (a->slow != b->slow) return a->slow > b->slow ? -1 : 1;
+  if (a->generalized != b->generalized) {
+    return a->generalized > b->generalized ? -1 : 1;
+  }
+  return strcmp(a->site->name, b->site->name);
+}
+
+
+void InternalEventAggregator::ReportHotspots(FILE* out,
+                                             int max_sites,
+                                             const int* slow_events,
+                                             int slow_events_count,
+                                             const int* generalize_events,
+                                             int generalize_events_count) {
+  List<Hotspot> hotspots;
+  int transitions = 0;
+  for (int i = 0; i < sites_.length(); ++i) {
+    Site* site = sites_[i];
+    // Function sites only count code events.
+    if (site->transitions == 0) continue;
+    Hotspot hotspot = {
+      site,
+      CountEvents(site->counts, slow_events, slow_events_count),
+      CountEvents(site->counts, generalize_events, generalize_events_count)
+    };
+    hotspots.Add(hotspot);
+    transitions += site->transitions;
+  }
+  hotspots.Sort(CompareHotspots);
+
+  OS::FPrint(out, "[map transition hotspots: %d transitions, "
+             "%d sites, %d maps]\n",
+             transitions, hotspots.length(), map_labels_.length() - 1);
+  if (hotspots.is_empty()) return;
+
+  OS::FPrint(out, "%11s %7s %7s %4s %11s %7s  %s\n",
+             "transitions", "objects", "longest", "slow", "generalized",
+             "maps", "site");
+  int count = Min(max_sites, hotspots.length());
+  for (int i = 0; i < count; ++i) {
+    Site* site = hotspots[i].site;
+
+    // Maps reached by the objects of the site, the site itself excluded.
+    List<int> maps;
+    for (int j = 0; j < site->edges.length(); ++j) {
+      maps.Add(site->edges[j]->to);
+    }
+    maps.Sort();
+    int distinct_maps = 0;
+    for (int j = 0; j < maps.length(); ++j) {
+      if (j == 0 || maps[j] != maps[j - 1]) distinct_maps++;
+    }
+
+    OS::FPrint(out, "%11d %7d %7d %4d %11d %7d  %s\n",
+               site->transitions, site->objects, site->longest_chain,
+               hotspots[i].slow, hotspots[i].generalized, distinct_maps,
+               site->name);
+    if (site->position != NULL) {
+      OS::FPrint(out, "%53s at %s\n", "", site->position);
+    }
+  }
+  fflush(out);
+}
+
+} }  // namespace v8::internal
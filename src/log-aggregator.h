@@ -0,0 +1,182 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef V8_LOG_AGGREGATOR_H_
+#define V8_LOG_AGGREGATOR_H_
+
+#include "allocation.h"
+#include "hashmap.h"
+#include "list.h"
+#include "log-internals.h"
+
+namespace v8 {
+namespace internal {
+
+class Heap;
+class HeapObject;
+class Map;
+class Name;
+class SharedFunctionInfo;
+
+// Builds the per-allocation-site state machines of --trace-internals inside
+// the VM (--trace-internals-aggregate).  Every traced object is attributed to
+// the site that created it, and each map transition of the object increments
+// an edge of that site's transition graph.  Nothing is logged per event:
+// the summarized graphs are written out by Dump(), in the graphviz format of
+// tools/vm_tracer, at exit or on demand.
+//
+// Objects and maps are identified by address and followed through the GC move
+// events.  Entries of dead objects are dropped by RemoveDeadObjects() so that
+// the tables stay proportional to the live heap.
+//
+// ReportHotspots() ranks the same sites by their map transitions, slow-mode
+// conversions and field generalizations (--trace-map-hotspots).
+class InternalEventAggregator {
+ public:
+  // Creation event of objects first seen in a non-creation event.
+  static const int kUntracked = -1;
+
+  InternalEventAggregator(const char* const* event_names, int events_count);
+  ~InternalEventAggregator();
+
+  // obj has been created by site (with event) and has map.  The source
+  // position of a new site is resolved through the script of source, if any.
+  void RecordCreation(HeapObject* obj, Map* map, const char* site, int event,
+                      SharedFunctionInfo* source = NULL);
+
+  // obj has been copied from source and joins the site of source.
+  // Returns false without recording anything if source is not tracked.
+  bool RecordCopy(HeapObject* obj, HeapObject* source, int event);
+
+  // Counts an event that keeps the map of obj.
+  // Returns false without recording anything if obj is not tracked.
+  bool RecordEvent(HeapObject* obj, int event);
+
+  // Counts the transition of obj from old_map to new_map.  If old_map is NULL
+  // the last map recorded for obj is used.  The name of field, if any, labels
+  // the edge.  Returns false without recording anything if obj is not tracked.
+  bool RecordTransition(HeapObject* obj, int event,
+                        Map* old_map, Map* new_map, Name* field);
+
+  // Counts a code event of the function named site.
+  void RecordFunctionEvent(const char* site, int event);
+
+  // GC move events.
+  void MoveObject(Address from, Address to);
+  void MoveMap(Address from, Address to);
+
+  // Forgets the objects and maps that did not survive the current GC.  Must
+  // be called at the end of a scavenge or right after the marking phase of a
+  // full collection.
+  void RemoveDeadObjects(Heap* heap);
+
+  // Writes the transition graph of every site, busiest sites first.
+  void Dump(FILE* out);
+
+  // Prints the max_sites sites with the most map transitions, with their
+  // slow-mode conversions and field generalizations.  Events are identified
+  // by their index in event_names.
+  void ReportHotspots(FILE* out, int max_sites,
+                      const int* slow_events, int slow_events_count,
+                      const int* generalize_events, int generalize_events_count);
+
+ private:
+  struct Edge;
+
+  struct Site {
+    char* name;
+    // script:line:column of the function, NULL if unknown
+    char* position;
+    int* counts;
+    int objects;
+    int transitions;
+    // Most transitions made by a single object
+    int longest_chain;
+    List<Edge*> edges;
+  };
+
+  struct Edge {
+    Site* site;
+    int from;
+    int to;
+    int event;
+    int count;
+    char* field;
+  };
+
+  struct TrackedObject {
+    Site* site;
+    int map;
+    int transitions;
+  };
+
+  Site* FindOrAddSite(const char* name, SharedFunctionInfo* source = NULL);
+  int FindOrAddMap(Map* map);
+  Edge* FindOrAddEdge(Site* site, int from, int to, int event, Name* field);
+  TrackedObject* FindObject(HeapObject* obj);
+  void AddObject(HeapObject* obj, Site* site, int map, int event);
+  const char* EventName(int event);
+  void DumpSite(FILE* out, int index, Site* site);
+
+  struct Hotspot {
+    Site* site;
+    int slow;
+    int generalized;
+  };
+
+  static int CompareSites(Site* const* a, Site* const* b);
+  static int CompareHotspots(const Hotspot* a, const Hotspot* b);
+
+  static bool SitesMatch(void* key1, void* key2) {
+    return strcmp(reinterpret_cast<char*>(key1),
+                  reinterpret_cast<char*>(key2)) == 0;
+  }
+
+  static bool EdgesMatch(void* key1, void* key2);
+
+  const char* const* event_names_;
+  int events_count_;
+  int dumps_;
+
+  HashMap sites_map_;
+  List<Site*> sites_;
+
+  HashMap edges_map_;
+
+  // Map ids start at 1, id 0 stands for the allocation site itself.
+  InternalObjectMap<int> maps_;
+  List<char*> map_labels_;
+
+  InternalObjectMap<TrackedObject> objects_;
+
+  DISALLOW_COPY_AND_ASSIGN(InternalEventAggregator);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_LOG_AGGREGATOR_H_
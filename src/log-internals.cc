@@ -0,0 +1,271 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "v8.h"
+
+#include "log-internals.h"
+#include "log-utils.h"
+
+namespace v8 {
+namespace internal {
+
+
+InternalEventBuffer::InternalEventBuffer(int capacity)
+    : capacity_(capacity),
+      mask_(static_cast<uint32_t>(capacity - 1)),
+      data_(NewArray<byte>(capacity)),
+      data_available_(OS::CreateSemaphore(0)) {
+  ASSERT(IsPowerOf2(capacity));
+  NoBarrier_Store(&head_, 0);
+  NoBarrier_Store(&tail_, 0);
+}
+
+
+InternalEventBuffer::~InternalEventBuffer() {
+  delete data_available_;
+  DeleteArray(data_);
+}
+
+
+void InternalEventBuffer::Put(const byte* data, int length) {
+  ASSERT(length <= capacity_);
+  uint32_t head = static_cast<uint32_t>(NoBarrier_Load(&head_));
+  uint32_t tail = static_cast<uint32_t>(Acquire_Load(&tail_));
+  uint32_t half = static_cast<uint32_t>(capacity_ / 2);
+
+  while (head + length - tail > static_cast<uint32_t>(capacity_)) {
+    // The writer is lagging behind, hand over the CPU until it catches up.
+    data_available_->Signal();
+    OS::Sleep(1);
+    tail = static_cast<uint32_t>(Acquire_Load(&tail_));
+  }
+
+  int offset = static_cast<int>(head & mask_);
+  int first = Min(length, capacity_ - offset);
+  OS::MemCopy(data_ + offset, data, first);
+  if (first < length) OS::MemCopy(data_, data + first, length - first);
+  Release_Store(&head_, static_cast<Atomic32>(head + length));
+
+  // Wake up the writer when the buffer crosses the half full mark, it
+  // otherwise only polls every InternalEventWriter::kFlushIntervalUs.
+  uint32_t used = head + length - tail;
+  if (used >= half && used - length < half) data_available_->Signal();
+}
+
+
+int InternalEventBuffer::Peek(const byte** data) {
+  uint32_t tail = static_cast<uint32_t>(NoBarrier_Load(&tail_));
+  uint32_t head = static_cast<uint32_t>(Acquire_Load(&head_));
+  int offset = static_cast<int>(tail & mask_);
+  *data = data_ + offset;
+  return Min(static_cast<int>(head - tail), capacity_ - offset);
+}
+
+
+void InternalEventBuffer::Consume(int length) {
+  uint32_t tail = static_cast<uint32_t>(NoBarrier_Load(&tail_));
+  Release_Store(&tail_, static_cast<Atomic32>(tail + length));
+}
+
+
+const char InternalEventEncoder::kMagic[] = { 'J', 'S', 'W', 'B' };
+
+
+InternalEventEncoder::InternalEventEncoder(InternalEventBuffer* buffer)
+    : buffer_(buffer),
+      event_(0),
+      pos_(kHeaderSize),
+      strings_(&StringEquals),
+      next_string_id_(0) {
+}
+
+
+InternalEventEncoder::~InternalEventEncoder() {
+  for (HashMap::Entry* p = strings_.Start(); p != NULL; p = strings_.Next(p)) {
+    DeleteArray(static_cast<char*>(p->key));
+  }
+}
+
+
+bool InternalEventEncoder::StringEquals(void* lhs, void* rhs) {
+  return strcmp(static_cast<const char*>(lhs),
+                static_cast<const char*>(rhs)) == 0;
+}
+
+
+void InternalEventEncoder::WriteHeader() {
+  byte header[sizeof(kMagic) + 2];
+  OS::MemCopy(header, kMagic, sizeof(kMagic));
+  header[sizeof(kMagic)] = kVersion;
+  header[sizeof(kMagic) + 1] = static_cast<byte>(kPointerSize);
+  buffer_->Put(header, sizeof(header));
+}
+
+
+void InternalEventEncoder::Begin(int event) {
+  ASSERT(event >= 0 && event < kStringRecord);
+  event_ = event;
+  pos_ = kHeaderSize;
+}
+
+
+int InternalEventEncoder::WriteVarint(uintptr_t value, byte* out) {
+  int size = 0;
+  while (value >= 0x80) {
+    out[size++] = static_cast<byte>(value | 0x80);
+    value >>= 7;
+  }
+  out[size++] = static_cast<byte>(value);
+  return size;
+}
+
+
+void InternalEventEncoder::AppendVarint(uintptr_t value) {
+  ASSERT(pos_ + kMaxVarintLength <= kHeaderSize + kMaxRecordSize);
+  pos_ += WriteVarint(value, record_ + pos_);
+}
+
+
+void InternalEventEncoder::AppendAddress(const void* addr) {
+  AppendVarint(reinterpret_cast<uintptr_t>(addr));
+}
+
+
+void InternalEventEncoder::AppendInt(int value) {
+  // Zigzag encoding keeps small negative values (e.g. -1 line numbers) short.
+  uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^
+      static_cast<uint32_t>(value >> 31);
+  AppendVarint(zigzag);
+}
+
+
+void InternalEventEncoder::AppendString(const char* str) {
+  AppendVarint(InternString(str));
+}
+
+
+void InternalEventEncoder::End() {
+  // The body length is written right in front of the body, so the record
+  // starts somewhere in the reserved header area.
+  byte length_bytes[kMaxVarintLength];
+  int length_size = WriteVarint(pos_ - kHeaderSize, length_bytes);
+
+  int start = kHeaderSize - length_size - 1;
+  record_[start] = static_cast<byte>(event_);
+  OS::MemCopy(record_ + start + 1, length_bytes, length_size);
+  buffer_->Put(record_ + start, pos_ - start);
+}
+
+
+int InternalEventEncoder::InternString(const char* str) {
+  int length = StrLength(str);
+  if (length > kMaxStringLength) length = kMaxStringLength;
+
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < length; ++i) {
+    hash = (hash ^ static_cast<byte>(str[i])) * 16777619u;
+  }
+
+  char* key = NewArray<char>(length + 1);
+  OS::MemCopy(key, str, length);
+  key[length] = '\0';
+
+  HashMap::Entry* entry = strings_.Lookup(key, hash, true);
+  if (entry->value != NULL) {
+    DeleteArray(key);
+    return static_cast<int>(reinterpret_cast<intptr_t>(entry->value)) - 1;
+  }
+
+  // Ids are stored biased by one, NULL marks a fresh entry.
+  int id = next_string_id_++;
+  entry->value = reinterpret_cast<void*>(static_cast<intptr_t>(id + 1));
+
+  byte header[1 + 2 * kMaxVarintLength];
+  int size = 0;
+  header[size++] = kStringRecord;
+  size += WriteVarint(id, header + size);
+  size += WriteVarint(length, header + size);
+  buffer_->Put(header, size);
+  buffer_->Put(reinterpret_cast<const byte*>(key), length);
+  return id;
+}
+
+
+InternalEventWriter::InternalEventWriter(InternalEventBuffer* buffer, Log* log)
+    : Thread("v8:InternalEventWriter"),
+      buffer_(buffer),
+      log_(log) {
+  NoBarrier_Store(&stop_thread_, static_cast<AtomicWord>(false));
+}
+
+
+void InternalEventWriter::Run() {
+  while (!Acquire_Load(&stop_thread_)) {
+    buffer_->data_available()->Wait(kFlushIntervalUs);
+    Flush();
+  }
+  Flush();
+}
+
+
+void InternalEventWriter::Stop() {
+  Release_Store(&stop_thread_, static_cast<AtomicWord>(true));
+  buffer_->data_available()->Signal();
+  Join();
+}
+
+
+void InternalEventWriter::Flush() {
+  const byte* data;
+  int length;
+  while ((length = buffer_->Peek(&data)) > 0) {
+    {
+      ScopedLock lock(log_->mutex_);
+      if (log_->IsEnabled()) {
+        log_->WriteToFile(reinterpret_cast<const char*>(data), length);
+      }
+    }
+    buffer_->Consume(length);
+  }
+}
+
+
+bool InternalObjectMapBase::IsLive(Heap* heap, Address addr) {
+  if (heap->gc_state() == Heap::SCAVENGE) {
+    // Survivors have been evacuated, dead objects are left in from space.
+    return !heap->new_space()->FromSpaceContains(addr);
+  }
+
+  ASSERT(heap->gc_state() == Heap::MARK_COMPACT);
+  // The large object page of a stale address may have been released.
+  LargePage* page = heap->lo_space()->FindPage(addr);
+  if (page != NULL && page->GetObject()->address() != addr) return false;
+  return Marking::MarkBitFrom(HeapObject::FromAddress(addr)).Get();
+}
+
+} }  // namespace v8::internal
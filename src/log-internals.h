@@ -0,0 +1,272 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef V8_LOG_INTERNALS_H_
+#define V8_LOG_INTERNALS_H_
+
+#include "allocation.h"
+#include "atomicops.h"
+#include "hashmap.h"
+#include "list.h"
+#include "platform.h"
+#include "utils.h"
+
+namespace v8 {
+namespace internal {
+
+class Heap;
+class Log;
+
+// Lock-free ring buffer carrying the binary --trace-internals stream from
+// the VM thread (single producer) to the InternalEventWriter thread (single
+// consumer).  Unlike SamplingCircularQueue records are never overwritten:
+// when the buffer is full the producer waits for the writer to catch up,
+// because a lost event would corrupt the state machines rebuilt offline.
+class InternalEventBuffer {
+ public:
+  // capacity must be a power of 2.
+  explicit InternalEventBuffer(int capacity);
+  ~InternalEventBuffer();
+
+  // Executed on the VM thread.
+  void Put(const byte* data, int length);
+
+  // Executed on the writer thread.
+  // Peek returns the number of contiguous bytes ready to be written and
+  // stores their start in *data.  Consume releases them to the producer.
+  int Peek(const byte** data);
+  void Consume(int length);
+
+  // Woken up by the producer when the buffer fills up.
+  Semaphore* data_available() { return data_available_; }
+
+ private:
+  int capacity_;
+  uint32_t mask_;
+  byte* data_;
+  // Monotonic positions, wrapped with mask_ when indexing data_.
+  volatile Atomic32 head_;
+  volatile Atomic32 tail_;
+  Semaphore* data_available_;
+
+  DISALLOW_COPY_AND_ASSIGN(InternalEventBuffer);
+};
+
+
+// Encodes --trace-internals events into an InternalEventBuffer.
+//
+// The stream starts with a header (kMagic, kVersion, pointer size) followed
+// by records of the form
+//
+//   [event: 1 byte][body length: varint][body]
+//
+// The body holds the fields of the text format in the same order.
+// Addresses and sizes are unsigned LEB128 varints, signed integers are
+// zigzag encoded varints, and strings are varint ids.  A string is defined
+// by a [kStringRecord][id][length][bytes] record emitted right before the
+// first record that refers to it.
+class InternalEventEncoder {
+ public:
+  static const char kMagic[];
+  static const byte kVersion = 1;
+  static const byte kStringRecord = 0xff;
+  static const int kMaxRecordSize = 256;
+  static const int kMaxStringLength = 1024;
+
+  explicit InternalEventEncoder(InternalEventBuffer* buffer);
+  ~InternalEventEncoder();
+
+  void WriteHeader();
+
+  void Begin(int event);
+  void AppendAddress(const void* addr);
+  void AppendInt(int value);
+  void AppendString(const char* str);
+  void End();
+
+ private:
+  static const int kMaxVarintLength = 10;
+  static const int kHeaderSize = 1 + kMaxVarintLength;
+
+  static int WriteVarint(uintptr_t value, byte* out);
+  void AppendVarint(uintptr_t value);
+  int InternString(const char* str);
+
+  static bool StringEquals(void* lhs, void* rhs);
+
+  InternalEventBuffer* buffer_;
+  byte record_[kHeaderSize + kMaxRecordSize];
+  int event_;
+  int pos_;
+  HashMap strings_;
+  int next_string_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(InternalEventEncoder);
+};
+
+
+// Background thread draining an InternalEventBuffer into the log file.
+class InternalEventWriter : public Thread {
+ public:
+  InternalEventWriter(InternalEventBuffer* buffer, Log* log);
+
+  virtual void Run();
+
+  // Writes out everything still buffered and joins the thread.
+  void Stop();
+
+ private:
+  // How often the writer wakes up if the buffer does not fill up.
+  static const int kFlushIntervalUs = 10000;
+
+  void Flush();
+
+  InternalEventBuffer* buffer_;
+  Log* log_;
+  volatile AtomicWord stop_thread_;
+};
+
+
+
+class InternalObjectMapBase {
+ protected:
+  // Whether the object at addr survives the current GC.  Only valid at the
+  // end of a scavenge or right after the marking phase of a full GC.
+  static bool IsLive(Heap* heap, Address addr);
+
+  static bool AddressesMatch(void* key1, void* key2) {
+    return key1 == key2;
+  }
+
+  static uint32_t AddressHash(Address addr) {
+    return ComputeIntegerHash(
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(addr)),
+        v8::internal::kZeroHashSeed);
+  }
+};
+
+
+// Traced heap objects indexed by address.  Entries follow the objects
+// through the GC move events and RemoveDeadObjects() drops the objects that
+// died, in the same way as HeapObjectsMap.
+template <typename Value>
+class InternalObjectMap : public InternalObjectMapBase {
+ public:
+  InternalObjectMap() : map_(AddressesMatch) {
+    // The dummy entry guarantees that all values stored in map_ are greater
+    // than 0, see HeapObjectsMap.
+    entries_.Add(Entry(NULL, Value()));
+  }
+
+  // Returns NULL if addr is not tracked.
+  Value* Find(Address addr) {
+    HashMap::Entry* entry = map_.Lookup(addr, AddressHash(addr), false);
+    if (entry == NULL) return NULL;
+    return &entries_.at(IndexOf(entry->value)).value;
+  }
+
+  // Starts tracking addr, or replaces the value of a dead object whose
+  // address has been reused.
+  Value* Set(Address addr, const Value& value) {
+    HashMap::Entry* entry = map_.Lookup(addr, AddressHash(addr), true);
+    if (entry->value == NULL) {
+      entry->value = reinterpret_cast<void*>(entries_.length());
+      entries_.Add(Entry(addr, value));
+    } else {
+      entries_.at(IndexOf(entry->value)).value = value;
+    }
+    return &entries_.at(IndexOf(entry->value)).value;
+  }
+
+  void Remove(Address addr) {
+    void* value = map_.Remove(addr, AddressHash(addr));
+    if (value != NULL) entries_.at(IndexOf(value)).addr = NULL;
+  }
+
+  // Returns false if from is not tracked.
+  bool Move(Address from, Address to) {
+    if (from == to) return Find(from) != NULL;
+    void* from_value = map_.Remove(from, AddressHash(from));
+    if (from_value == NULL) {
+      // An untracked object moved over a dead tracked one.
+      Remove(to);
+      return false;
+    }
+    HashMap::Entry* to_entry = map_.Lookup(to, AddressHash(to), true);
+    if (to_entry->value != NULL) {
+      entries_.at(IndexOf(to_entry->value)).addr = NULL;
+    }
+    entries_.at(IndexOf(from_value)).addr = to;
+    to_entry->value = from_value;
+    return true;
+  }
+
+  void RemoveDeadObjects(Heap* heap) {
+    int first_free_entry = 1;
+    for (int i = 1; i < entries_.length(); ++i) {
+      Entry& entry_info = entries_.at(i);
+      if (entry_info.addr == NULL) continue;
+      if (IsLive(heap, entry_info.addr)) {
+        if (first_free_entry != i) {
+          entries_.at(first_free_entry) = entry_info;
+        }
+        HashMap::Entry* entry = map_.Lookup(
+            entry_info.addr, AddressHash(entry_info.addr), false);
+        ASSERT(entry != NULL);
+        entry->value = reinterpret_cast<void*>(first_free_entry);
+        ++first_free_entry;
+      } else {
+        map_.Remove(entry_info.addr, AddressHash(entry_info.addr));
+      }
+    }
+    entries_.Rewind(first_free_entry);
+    ASSERT(static_cast<uint32_t>(entries_.length()) - 1 == map_.occupancy());
+  }
+
+  int length() const { return entries_.length() - 1; }
+
+ private:
+  struct Entry {
+    Entry(Address addr, const Value& value) : addr(addr), value(value) { }
+    Address addr;
+    Value value;
+  };
+
+  static int IndexOf(void* value) {
+    return static_cast<int>(reinterpret_cast<intptr_t>(value));
+  }
+
+  HashMap map_;
+  List<Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(InternalObjectMap);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_LOG_INTERNALS_H_
@@ -112,6 +112,7 @@ class Log {
 
   friend class Logger;
   friend class LogMessageBuilder;
+  friend class InternalEventWriter;
 };
 
 
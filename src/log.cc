@@ -417,7 +417,13 @@ Logger::Logger(Isolate* isolate)
     epoch_(0),
     jsw_msg(NULL),
     jsw_pos(0),
-    jsw_func_info(NULL) {
+    jsw_func_info(NULL),
+    jsw_events(NULL),
+    jsw_encoder(NULL),
+    jsw_writer(NULL),
+    jsw_aggregator(NULL),
+    jsw_sampled(NULL),
+    jsw_deopt_loops(NULL) {
   
 }
 
@@ -652,21 +658,17 @@ void Logger::CodeDeoptEvent(Code* code) {
 }
 
 
-void Logger::get_closure_mark(SharedFunctionInfo* shared)
+const char* Logger::get_closure_mark(SharedFunctionInfo* shared,
+				     bool may_allocate)
 {
   if ( shared == NULL ) {
-    //jsw_log('1');
-    jsw_log("closure*");
-    return;
+    return "closure*";
   }
   
   // Lookup the cache
   map<SharedFunctionInfo*, char*>::iterator it = jsw_func_info->find(shared);
   if ( it != jsw_func_info->end() ) {
-    const char *str = it->second;
-    //jsw_log('2');
-    jsw_log(str);
-    return;
+    return it->second;
   }
   
 
@@ -684,15 +686,27 @@ void Logger::get_closure_mark(SharedFunctionInfo* shared)
     HandleScope scope(isolate_);
     Handle<Script> script(Script::cast(maybe_script));
     // Line_num == -1: a library function likes Array.push
-    line_num = GetScriptLineNumber( script, 
-				    shared->start_position()) + 1;
+    // Computing the line ends of the script allocates on the heap
+    if ( may_allocate )
+      line_num = GetScriptLineNumber( script, 
+				      shared->start_position()) + 1;
+    else
+      line_num = GetScriptLineNumberSafe( script,
+					  shared->start_position()) + 1;
   }
   
   // Name
   // This is a global object
   // We cannot know its name currently
   //pstr = "AryOrObj";
-  if ( shared == isolate_->array_function()->shared() )
+  // The native context is not complete while bootstrapping
+  Object* array_function = NULL;
+  Context* context = isolate_->context();
+  if ( context != NULL && context->native_context()->IsNativeContext() )
+    array_function = context->native_context()->get(Context::ARRAY_FUNCTION_INDEX);
+
+  if ( array_function != NULL && array_function->IsJSFunction() &&
+       shared == JSFunction::cast(array_function)->shared() )
     //msg.Append("G-Array");
     pstr = "JSArray";
   else
@@ -721,8 +735,7 @@ void Logger::get_closure_mark(SharedFunctionInfo* shared)
     
   // Cache the result
   (*jsw_func_info)[shared] = name_buf;
-  //jsw_log('3');
-  jsw_log(name_buf);
+  return name_buf;
 }
 
 
@@ -771,6 +784,71 @@ void Logger::jsw_log(char c)
 }
 
 
+// Field emitters shared by the text and the binary (--trace-internals-binary)
+// formats. The text format separates fields by spaces and ends the
+// event with a newline.
+void Logger::jsw_begin(InternalEvent event)
+{
+  // Keep the events ordered after the GC moves they may refer to
+  if ( !jsw_moves.is_empty() && event != GCMoveRanges )
+    jsw_flush_moves();
+
+  if ( jsw_encoder != NULL )
+    jsw_encoder->Begin(event);
+  else
+    jsw_log("%d", event);
+}
+
+
+void Logger::jsw_addr(const void* addr)
+{
+  if ( jsw_encoder != NULL )
+    jsw_encoder->AppendAddress(addr);
+  else
+    jsw_log(" %x", addr);
+}
+
+
+void Logger::jsw_int(int value)
+{
+  if ( jsw_encoder != NULL )
+    jsw_encoder->AppendInt(value);
+  else
+    jsw_log(" %d", value);
+}
+
+
+void Logger::jsw_str(const char* s)
+{
+  // Keep what printf would show for a missing message
+  if ( s == NULL ) s = "(null)";
+
+  if ( jsw_encoder != NULL )
+    jsw_encoder->AppendString(s);
+  else
+    jsw_log(" %s", s);
+}
+
+
+void Logger::jsw_end()
+{
+  if ( jsw_encoder != NULL )
+    jsw_encoder->End();
+  else
+    jsw_log('\n');
+}
+
+
+static const char* const kInternalEventNames[Logger::events_count] = {
+#define GetEventString(name, handler) #name,
+  OBJECT_EVENTS_LIST(GetEventString)
+  FUNCTION_EVENTS_LIST(GetEventString)
+  MAP_EVENTS_LIST(GetEventString)
+  SYS_EVENTS_LIST(GetEventString)
+#undef GetEventString
+};
+
+
 // Obtain current JS top frame
 JSFunction* Logger::get_events_context()
 {
@@ -794,17 +872,306 @@ JSFunction* Logger::get_events_context()
 }
 
 
+// Sites are chosen by a hash of their SharedFunctionInfo and literal index
+// which does not depend on addresses, the same sites are sampled in every run
+bool Logger::jsw_sample_site(SharedFunctionInfo* shared, int index)
+{
+  const char* mark = get_closure_mark(shared);
+  uint32_t hash = StringHasher::HashSequentialString(mark, StrLength(mark),
+						     kZeroHashSeed);
+  hash = ComputeIntegerHash(hash ^ static_cast<uint32_t>(index),
+			    kZeroHashSeed);
+  return hash % FLAG_trace_internals_sample_rate == 0;
+}
+
+
+// Same arguments as EmitObjectEvent
+// The objects created by a sampled site are remembered in jsw_sampled,
+// all later events of these objects are traced
+bool Logger::jsw_sample(InternalEvent event, JSObject* obj, va_list args)
+{
+  bool sampled;
+
+  switch (event)
+  {
+  case CreateObjBoilerplate:
+  case CreateArrayBoilerplate:
+  case CreateObjectLiteral:
+  case CreateArrayLiteral:
+	{
+	  // A boilerplate and its literals are sampled together
+	  if ( event == CreateObjectLiteral || event == CreateArrayLiteral )
+	    va_arg(args, HeapObject*);
+	  int index = va_arg(args, int);
+	  JSFunction* def_function = get_events_context();
+	  sampled = jsw_sample_site(def_function != NULL ?
+				    def_function->shared() : NULL, index);
+	}
+	break;
+
+  case CreateNewObject:
+  case CreateNewArray:
+	{
+	  JSFunction* constructor = va_arg(args, JSFunction*);
+	  sampled = jsw_sample_site(constructor->shared(), -1);
+	}
+	break;
+
+  case CreateFunction:
+	{
+	  SharedFunctionInfo* alloc_sig = va_arg(args, SharedFunctionInfo*);
+	  sampled = jsw_sample_site(alloc_sig, -1);
+	}
+	break;
+
+  case CopyObject:
+	{
+	  JSObject* source_obj = va_arg(args, JSObject*);
+	  sampled = jsw_sampled->Find(source_obj->address()) != NULL;
+	}
+	break;
+
+  default:
+	return jsw_sampled->Find(obj->address()) != NULL;
+  }
+
+  if ( sampled )
+    jsw_sampled->Set(obj->address(), true);
+  else
+    // Forget a dead sampled object at the same address
+    jsw_sampled->Remove(obj->address());
+  return sampled;
+}
+
+
+// The site of an object whose creation has not been traced
+// Its constructor, if any, is stored to *source
+const char* Logger::jsw_untracked_site(JSObject* obj, Vector<char> buffer,
+				       SharedFunctionInfo** source)
+{
+  Object* constructor = obj->map()->constructor();
+  *source = NULL;
+  if ( !constructor->IsJSFunction() )
+    return "Untracked";
+
+  *source = JSFunction::cast(constructor)->shared();
+  OS::SNPrintF(buffer, "New(%s)", get_closure_mark(*source));
+  return buffer.start();
+}
+
+
+// Same arguments as EmitObjectEvent
+// The enclosing function is only looked up for literals
+void Logger::jsw_aggregate(InternalEvent event, JSObject* obj, va_list args)
+{
+  InternalEventAggregator* agg = jsw_aggregator;
+  Map* cur_map = obj->map();
+  Map* old_map = NULL;
+  Name* f_name = NULL;
+  SharedFunctionInfo* source = NULL;
+  EmbeddedVector<char, 256> name;
+
+  switch (event)
+  {
+  case CreateObjBoilerplate:
+  case CreateArrayBoilerplate:
+  case CreateObjectLiteral:
+  case CreateArrayLiteral:
+	{
+	  if ( event == CreateObjectLiteral || event == CreateArrayLiteral )
+	    va_arg(args, HeapObject*);
+	  int index = va_arg(args, int);
+	  JSFunction* def_function = get_events_context();
+	  if ( def_function != NULL ) source = def_function->shared();
+	  const char* mark = source != NULL ?
+	    get_closure_mark(source) : "global-var";
+
+	  if ( event == CreateObjBoilerplate || event == CreateArrayBoilerplate )
+	    OS::SNPrintF(name, "Boilerplate(%s#%d)", mark, index);
+	  else
+	    OS::SNPrintF(name, "%s#%d", mark, index);
+	  agg->RecordCreation(obj, cur_map, name.start(), event, source);
+	}
+	return;
+
+  case CreateNewObject:
+  case CreateNewArray:
+	{
+	  JSFunction* constructor = va_arg(args, JSFunction*);
+	  source = constructor->shared();
+	  OS::SNPrintF(name, "New(%s)", get_closure_mark(source));
+	  agg->RecordCreation(obj, cur_map, name.start(), event, source);
+	}
+	return;
+
+  case CreateFunction:
+	{
+	  SharedFunctionInfo* alloc_sig = va_arg(args, SharedFunctionInfo*);
+	  agg->RecordCreation(obj, cur_map, get_closure_mark(alloc_sig), event,
+			      alloc_sig);
+	}
+	return;
+
+  case CopyObject:
+	{
+	  JSObject* source_obj = va_arg(args, JSObject*);
+	  if ( !agg->RecordCopy(obj, source_obj, event) ) {
+	    const char* site = jsw_untracked_site(source_obj, name, &source);
+	    agg->RecordCreation(obj, cur_map, site, event, source);
+	  }
+	}
+	return;
+
+  case ChangeFuncPrototype:
+  case CowCopy:
+  case ExpandArray:
+	if ( !agg->RecordEvent(obj, event) ) {
+	  const char* site = jsw_untracked_site(obj, name, &source);
+	  agg->RecordCreation(obj, cur_map, site,
+			      InternalEventAggregator::kUntracked, source);
+	  agg->RecordEvent(obj, event);
+	}
+	return;
+
+  case NewField:
+  case DelField:
+  case UpdateField:
+	f_name = va_arg(args, Name*);
+	old_map = va_arg(args, Map*);
+	break;
+
+  case ChangeObjPrototype:
+  case MigrateToMap:
+  case ElemTransition:
+  case ElemToSlowMode:
+  case PropertyToSlowMode:
+	old_map = va_arg(args, Map*);
+	break;
+
+  case ElemToFastMode:
+  case PropertyToFastMode:
+	old_map = va_arg(args, Map*);
+	if ( old_map == NULL ) old_map = cur_map;
+	break;
+
+  case SetMap:
+	// The source is the last map seen for obj
+	break;
+
+  default:
+	return;
+  }
+
+  // Map transitions
+  if ( !agg->RecordTransition(obj, event, old_map, cur_map, f_name) ) {
+    const char* site = jsw_untracked_site(obj, name, &source);
+    agg->RecordCreation(obj, old_map != NULL ? old_map : cur_map, site,
+			InternalEventAggregator::kUntracked, source);
+    agg->RecordTransition(obj, event, old_map, cur_map, f_name);
+  }
+}
+
+
+void Logger::jsw_detect_deopt_loop(InternalEvent event, JSFunction* func,
+				   SharedFunctionInfo* shared, va_list args)
+{
+  if ( shared == NULL && func != NULL ) shared = func->shared();
+  // ForceDeopt is emitted while the code is patched, nothing may move
+  const char* name = get_closure_mark(shared, event != ForceDeopt);
+
+  switch(event) {
+  case GenOptCode:
+  case GenOsrCode:
+    jsw_deopt_loops->RecordOpt(name);
+    break;
+
+  case OptFailed:
+    jsw_deopt_loops->RecordOptFailed(name);
+    break;
+
+  case DisableOpt:
+    jsw_deopt_loops->RecordDisable(name, va_arg(args, const char*));
+    break;
+
+  case ReenableOpt:
+    jsw_deopt_loops->RecordReenable(name);
+    break;
+
+  case RegularDeopt:
+    {
+      // The failed object and expected map are not reliable enough to be
+      // inspected here, the bailout describes the deopt
+      va_arg(args, Code*);
+      va_arg(args, HeapObject*);
+      va_arg(args, Map*);
+      const char* add_msg = va_arg(args, const char*);
+      jsw_deopt_loops->RecordDeopt(name, add_msg);
+    }
+    break;
+
+  case DeoptAsInline:
+    {
+      va_arg(args, Code*);
+      JSFunction* real_deopt_func = va_arg(args, JSFunction*);
+      EmbeddedVector<char, 128> reason;
+      OS::SNPrintF(reason, "inlined in %s",
+		   get_closure_mark(real_deopt_func->shared(), false));
+      jsw_deopt_loops->RecordDeopt(name, reason.start());
+    }
+    break;
+
+  case ForceDeopt:
+    // Attributed to the pending map change if any
+    jsw_deopt_loops->RecordDeopt(name, NULL);
+    break;
+
+  default:
+    break;
+  }
+}
+
+
+const char* Logger::jsw_map_name(Map* map, Vector<char> buffer)
+{
+  Object* constructor = map->constructor();
+  const char* name = constructor->IsJSFunction() ?
+    get_closure_mark(JSFunction::cast(constructor)->shared(), false) :
+    "Object";
+
+  OS::SNPrintF(buffer, "%s{%d fields, %s%s}",
+	       name,
+	       map->NumberOfOwnDescriptors(),
+	       ElementsKindToString(map->elements_kind()),
+	       map->is_dictionary_map() ? ", dictionary" : "");
+  return buffer.start();
+}
+
+
 void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
 {
   if (!log_->IsEnabled()) return;
 
-  //LogMessageBuilder msg(this);
+  if ( jsw_sampled != NULL ) {
+    va_list arg_ptr;
+    va_start(arg_ptr, obj);
+    bool sampled = jsw_sample(event, obj, arg_ptr);
+    va_end(arg_ptr);
+    if ( !sampled ) return;
+  }
+
+  if ( jsw_aggregator != NULL ) {
+    va_list arg_ptr;
+    va_start(arg_ptr, obj);
+    jsw_aggregate(event, obj, arg_ptr);
+    va_end(arg_ptr);
+    return;
+  }
+
   JSFunction* def_function = get_events_context();
   
-  jsw_log( "%d %x %x",
-	   event,
-	   def_function,
-	   obj);
+  jsw_begin(event);
+  jsw_addr(def_function);
+  jsw_addr(obj);
 
 
   // In case some events need more options
@@ -821,7 +1188,8 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
 	  int index = va_arg(arg_ptr, int);
 	  va_end(arg_ptr);
 
-	  jsw_log( " %x %d", cur_map, index );
+	  jsw_addr(cur_map);
+	  jsw_int(index);
 	}
 	break;
 
@@ -835,15 +1203,16 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
 	  int index = va_arg(arg_ptr, int);
 	  va_end(arg_ptr);
 
-	  jsw_log( " %x %x ", constructor, cur_map);
+	  jsw_addr(constructor);
+	  jsw_addr(cur_map);
 	  
 	  // Print the name of elcosing function for log readability
-	  if ( def_function != NULL )
-	    get_closure_mark(def_function->shared());
-	  else
-	    jsw_log("global-var");
-
-	  jsw_log("#%d", index);
+	  EmbeddedVector<char, 256> name;
+	  OS::SNPrintF(name, "%s#%d",
+		       def_function != NULL ?
+		       get_closure_mark(def_function->shared()) : "global-var",
+		       index);
+	  jsw_str(name.start());
 	}
 	break;
 
@@ -855,13 +1224,13 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
 	  JSFunction* constructor = va_arg(arg_ptr, JSFunction*);
 	  va_end(arg_ptr);
 
-	  jsw_log( " %x %x", constructor, cur_map );
+	  jsw_addr(constructor);
+	  jsw_addr(cur_map);
 
 	  // Obtain the name for the constructor function
-	  jsw_log(" New(");
-	  SharedFunctionInfo* shared = constructor->shared();
-	  get_closure_mark(shared);
-	  jsw_log(")");
+	  EmbeddedVector<char, 256> name;
+	  OS::SNPrintF(name, "New(%s)", get_closure_mark(constructor->shared()));
+	  jsw_str(name.start());
 	}
 	break;
 
@@ -874,8 +1243,10 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
 
 	  JSFunction* function = JSFunction::cast(obj);
 	  Code* code = function->code();
-	  jsw_log(" %x %x %x ", alloc_sig, cur_map, code);
-	  get_closure_mark(alloc_sig);
+	  jsw_addr(alloc_sig);
+	  jsw_addr(cur_map);
+	  jsw_addr(code);
+	  jsw_str(get_closure_mark(alloc_sig));
 	}
 	break;
 
@@ -884,7 +1255,7 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
 	  va_start(arg_ptr, obj);
 	  JSObject* source_obj = va_arg(arg_ptr, JSObject*);
 	  va_end(arg_ptr);
-	  jsw_log(" %x", source_obj);
+	  jsw_addr(source_obj);
 	}
 	break;
 
@@ -894,7 +1265,7 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
       va_start(arg_ptr, obj);
       JSObject* new_proto = va_arg(arg_ptr, JSObject*);
       va_end(arg_ptr);
-      jsw_log(" %x", new_proto);
+      jsw_addr(new_proto);
     }
     break;
 
@@ -905,14 +1276,16 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
       Map* old_map = va_arg(arg_ptr, Map*);
       JSObject* new_proto = va_arg(arg_ptr, JSObject*);
       va_end(arg_ptr);
-      jsw_log(" %x %x %x", old_map, cur_map, new_proto);
+      jsw_addr(old_map);
+      jsw_addr(cur_map);
+      jsw_addr(new_proto);
     }
     break;
 
   case SetMap:
 	{
 	  // Introduce a new map
-	  jsw_log(" %x", cur_map);
+	  jsw_addr(cur_map);
 	}
 	break;
 
@@ -921,7 +1294,8 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
       va_start(arg_ptr, obj);
       Map* old_map = va_arg(arg_ptr, Map*);
       va_end(arg_ptr);
-      jsw_log(" %x %x", old_map, cur_map);
+      jsw_addr(old_map);
+      jsw_addr(cur_map);
     }
     break;
 
@@ -935,15 +1309,16 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
 	  va_end(arg_ptr);
 
 	  // map transitions
-	  jsw_log(" %x %x", old_map, cur_map);
+	  jsw_addr(old_map);
+	  jsw_addr(cur_map);
 	  
 	  // Then, the field name
 	  if ( f_name->IsString() && f_name->Size() > 0) {
 	    String* s = String::cast(f_name);
-		jsw_log(" %s", *(s->ToCString()));
+		jsw_str(*(s->ToCString()));
 	  }
 	  else
-	    jsw_log(" ?field");
+	    jsw_str("?field");
 	}
 	break;
 
@@ -954,7 +1329,8 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
 	  va_end(arg_ptr);
 
 	  // map transitions
-	  jsw_log(" %x %x", old_map, cur_map);
+	  jsw_addr(old_map);
+	  jsw_addr(cur_map);
 	}
 	// Fall through
   case CowCopy:
@@ -964,7 +1340,7 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
 	  int base_size = IsFastDoubleElementsKind(kind) ? kDoubleSize : kPointerSize;
 	  int capacity = obj->elements()->length();
 	  int bytes = base_size * capacity;
-	  jsw_log( " %d", bytes );
+	  jsw_int(bytes);
 	}
 	break;
 
@@ -976,7 +1352,8 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
 	  va_end(arg_ptr);
 
 	  // Introduce a new map
-	  jsw_log(" %x %x", old_map, cur_map);
+	  jsw_addr(old_map);
+	  jsw_addr(cur_map);
 	}
 	break;
 
@@ -989,33 +1366,47 @@ void Logger::EmitObjectEvent(InternalEvent event, JSObject* obj, ...)
 
 	  // Introduce a new map
 	  if ( old_map == NULL ) old_map = cur_map;
-	  jsw_log(" %x %x", old_map, cur_map);
+	  jsw_addr(old_map);
+	  jsw_addr(cur_map);
 	}
 	break;
 	
   default:
 	break;
   }
-  jsw_log('\n');
-  //msg.WriteToLogFile();
+  jsw_end();
 }
 
 
 void Logger::EmitFunctionEvent(InternalEvent event, JSFunction* func,
 			       Code* new_code, SharedFunctionInfo* shared, ...) {
-  if (!log_->IsEnabled()) return;
-  
-  //LogMessageBuilder msg(this);
-  
-  jsw_log("%d %x", event, func);
-
   va_list arg_ptr;
 
+  if ( jsw_deopt_loops != NULL ) {
+    va_start(arg_ptr, shared);
+    jsw_detect_deopt_loop(event, func, shared, arg_ptr);
+    va_end(arg_ptr);
+  }
+
+  if ( !FLAG_trace_internals || !is_logging() || !log_->IsEnabled() ) return;
+
+  if ( jsw_aggregator != NULL ) {
+    // Only count the event for the function
+    // ForceDeopt is emitted while the code is patched, nothing may move
+    if ( shared == NULL && func != NULL ) shared = func->shared();
+    jsw_aggregator->RecordFunctionEvent(
+	get_closure_mark(shared, event != ForceDeopt), event);
+    return;
+  }
+  
+  jsw_begin(event);
+  jsw_addr(func);
+
   // Followed are handlers for different event types
   switch(event) {
   case GenFullCode:
     {
-      jsw_log(" %x", new_code);
+      jsw_addr(new_code);
     }
     break;
 
@@ -1025,16 +1416,16 @@ void Logger::EmitFunctionEvent(InternalEvent event, JSFunction* func,
 	  const int kMaxOptCount =
 		(FLAG_deopt_every_n_times == 0 ? FLAG_max_opt_count : 1000) + 1;
 
-	    jsw_log(" %x %d|%d",
-		  new_code,
-		  shared->opt_count(), 
-		  kMaxOptCount ); 
+	  EmbeddedVector<char, 32> opt_count;
+	  OS::SNPrintF(opt_count, "%d|%d", shared->opt_count(), kMaxOptCount);
+	  jsw_addr(new_code);
+	  jsw_str(opt_count.start());
 	}
 	break;
 
   case SetCode:
 	{
-	  jsw_log(" %x", new_code);
+	  jsw_addr(new_code);
 	}
 	break;
 
@@ -1044,14 +1435,15 @@ void Logger::EmitFunctionEvent(InternalEvent event, JSFunction* func,
 	  va_start(arg_ptr, shared);
 	  const char* add_msg = va_arg(arg_ptr, const char*);
 	  va_end(arg_ptr);
-	  jsw_log(" %x %s", shared, add_msg);
+	  jsw_addr(shared);
+	  jsw_str(add_msg);
 	}
 	break;
 
   case OptFailed:
 	{
 	  // We also output the new code, for the case it is different to old code
-	  jsw_log( " %x", new_code );
+	  jsw_addr(new_code);
 
 	  // Then we output the failed message if possible
 	  va_start(arg_ptr, shared);
@@ -1059,10 +1451,10 @@ void Logger::EmitFunctionEvent(InternalEvent event, JSFunction* func,
 	  va_end(arg_ptr);
 
 	  if ( add_msg != NULL )
-		jsw_log(" %s", add_msg);
+		jsw_str(add_msg);
 	  else
 		// Use the error message issued by DisableOpt
-		jsw_log(" -");
+		jsw_str("-");
 	}
 	break;
 
@@ -1081,11 +1473,12 @@ void Logger::EmitFunctionEvent(InternalEvent event, JSFunction* func,
 
 	  // Perhaps sometimes we miss code generation
 	  // We also output the old code to indicate this case, :<
-	  jsw_log(" %x %x %x %x %x %s",
-		  context,
-		  old_code, new_code, 
-		  failed_obj, expected_map,
-		  add_msg);
+	  jsw_addr(context);
+	  jsw_addr(old_code);
+	  jsw_addr(new_code);
+	  jsw_addr(failed_obj);
+	  jsw_addr(expected_map);
+	  jsw_str(add_msg);
 	}
 	break;
 
@@ -1098,10 +1491,10 @@ void Logger::EmitFunctionEvent(InternalEvent event, JSFunction* func,
 	  va_end(arg_ptr);
 
 	  JSFunction* context =  get_events_context();
-	  jsw_log( " %x %x %x %x",
-		   context,
-		   old_code, new_code, 
-		   real_deopt_func ); 
+	  jsw_addr(context);
+	  jsw_addr(old_code);
+	  jsw_addr(new_code);
+	  jsw_addr(real_deopt_func);
 	}
 	break;
 
@@ -1112,10 +1505,9 @@ void Logger::EmitFunctionEvent(InternalEvent event, JSFunction* func,
 	  va_end(arg_ptr);
 	  
 	  JSFunction* context =  get_events_context();
-	  jsw_log(" %x %x %x",
-		  context,
-		  old_code,
-		  new_code); 
+	  jsw_addr(context);
+	  jsw_addr(old_code);
+	  jsw_addr(new_code);
 	}
 	break;
 
@@ -1123,27 +1515,36 @@ void Logger::EmitFunctionEvent(InternalEvent event, JSFunction* func,
 	break;
   }
 
-  jsw_log('\n');
-  //msg.WriteToLogFile();
+  jsw_end();
 }
 
 
 void Logger::EmitMapEvent(InternalEvent event, ...)
 {
-  if (!log_->IsEnabled()) return;
+  va_list arg_ptr;
 
-  //LogMessageBuilder msg(this);
-  
-  jsw_log("%d", event);
+  if ( jsw_deopt_loops != NULL && event == BeginDeoptOnMap ) {
+    // The deopts forced by the map change follow right away
+    va_start(arg_ptr, event);
+    Map* trigger_map = va_arg(arg_ptr, Map*);
+    va_end(arg_ptr);
+
+    EmbeddedVector<char, 128> name;
+    jsw_deopt_loops->BeginMapChange(jsw_map_name(trigger_map, name));
+  }
+
+  if ( !FLAG_trace_internals || !log_->IsEnabled() ||
+       jsw_aggregator != NULL ) return;
+
+  jsw_begin(event);
 
-  va_list arg_ptr;
   switch(event) {
   case BeginDeoptOnMap:
 	{
 	  va_start(arg_ptr, event);
 	  Map* trigger_map = va_arg(arg_ptr, Map*);
 	  va_end(arg_ptr);
-	  jsw_log(" %x", trigger_map); 
+	  jsw_addr(trigger_map);
 	}
 	break;
 
@@ -1151,34 +1552,70 @@ void Logger::EmitMapEvent(InternalEvent event, ...)
 	break;
   }
 
-  jsw_log('\n');
-  //msg.WriteToLogFile();
+  jsw_end();
 }
 
 
-void Logger::EmitGCMoveEvent(HeapObject* from, HeapObject* to)
+void Logger::EmitGCMoveEvent(HeapObject* from, HeapObject* to, int size)
 {
   if (!log_->IsEnabled()) return;
 
-  InternalEvent event = GCMoveObject;
+  // Only the objects of sampled sites are followed
+  if ( jsw_sampled != NULL ) {
+    if ( from->IsJSObject() ) {
+      if ( !jsw_sampled->Move(from->address(), to->address()) ) return;
+    }
+    else if ( !from->IsCode() && !from->IsSharedFunctionInfo() &&
+	      !from->IsMap() ) {
+      return;
+    }
+  }
 
-  // We use from because the target address might be undefined memory chunck
-  if ( !from->IsJSObject() ) {
-	if ( from->IsCode() ) {
-	  event = GCMoveCode;
-	}
-	else if ( from->IsSharedFunctionInfo() ) {
-	  event = GCMoveShared;
-	}
-	else if ( from->IsMap() ) {
-	  event = GCMoveMap;
-	}
+  if ( jsw_aggregator != NULL ) {
+    if ( from->IsMap() )
+      jsw_aggregator->MoveMap(from->address(), to->address());
+    else if ( from->IsJSObject() )
+      jsw_aggregator->MoveObject(from->address(), to->address());
+    return;
   }
 
-  // LogMessageBuilder msg(this);
-  jsw_log("%d %x %x\n", event, from, to);
+  // The evacuation copies live objects one after the other, so most moves
+  // extend the last range
+  Address from_addr = from->address();
+  Address to_addr = to->address();
+  if ( !jsw_moves.is_empty() ) {
+    MoveRange& last = jsw_moves.last();
+    if ( last.from + last.size == from_addr &&
+	 last.to + last.size == to_addr ) {
+      last.size += size;
+      return;
+    }
+  }
 
-  //msg.WriteToLogFile();
+  if ( jsw_moves.length() >= jsw_max_pending_moves )
+    jsw_flush_moves();
+  jsw_moves.Add(MoveRange(from_addr, to_addr, size));
+}
+
+
+void Logger::jsw_flush_moves()
+{
+  int length = jsw_moves.length();
+
+  for ( int i = 0; i < length; i += jsw_moves_per_record ) {
+    int count = Min(jsw_moves_per_record, length - i);
+    jsw_begin(GCMoveRanges);
+    jsw_int(count);
+    for ( int j = i; j < i + count; ++j ) {
+      MoveRange& range = jsw_moves[j];
+      jsw_addr(range.from);
+      jsw_addr(range.to);
+      jsw_int(range.size);
+    }
+    jsw_end();
+  }
+
+  jsw_moves.Rewind(0);
 }
 
 
@@ -1191,10 +1628,9 @@ void Logger::EmitGCMoveEvent(HeapObject* from, HeapObject* to)
 //  }
 void Logger::EmitSysEvent(InternalEvent event, ...)
 {
-  if (!log_->IsEnabled()) return;
+  if (!log_->IsEnabled() || jsw_aggregator != NULL) return;
 
-  //LogMessageBuilder msg(this);
-  jsw_log("%d", event);
+  jsw_begin(event);
 
   va_list arg_ptr;
 
@@ -1208,7 +1644,7 @@ void Logger::EmitSysEvent(InternalEvent event, ...)
 	va_start(arg_ptr, event);
 	int checkpoint_id = va_arg(arg_ptr, int);
 	va_end(arg_ptr);
-	jsw_log(" %d", checkpoint_id);
+	jsw_int(checkpoint_id);
       */
     }
     break;
@@ -1218,7 +1654,7 @@ void Logger::EmitSysEvent(InternalEvent event, ...)
 	  va_start(arg_ptr, event);
 	  const char* s = va_arg(arg_ptr, const char*);
 	  va_end(arg_ptr);
-	  jsw_log(" %s", s);
+	  jsw_str(s);
 	}
 	break;
 
@@ -1226,8 +1662,54 @@ void Logger::EmitSysEvent(InternalEvent event, ...)
 	break;
   }
 
-  jsw_log('\n');
-  //msg.WriteToLogFile();
+  jsw_end();
+}
+
+
+void Logger::DumpInternalEvents()
+{
+  if ( !FLAG_trace_internals || !log_->IsEnabled() ) return;
+
+  if ( jsw_aggregator != NULL ) {
+    ScopedLock lock(log_->mutex_);
+    jsw_aggregator->Dump(log_->output_handle_);
+    return;
+  }
+
+  jsw_flush_moves();
+  if ( jsw_encoder == NULL )
+    jsw_output(true);
+}
+
+
+void Logger::ReportDeoptLoops()
+{
+  if ( jsw_deopt_loops != NULL )
+    jsw_deopt_loops->Report(stdout, FLAG_trace_deopt_loops_top);
+}
+
+
+void Logger::ReportMapHotspots()
+{
+  if ( !FLAG_trace_map_hotspots || jsw_aggregator == NULL ) return;
+
+  // Dictionary mode conversions, and transitions caused by a field whose
+  // representation or constness has been generalized
+  static const int kSlowEvents[] = { PropertyToSlowMode, ElemToSlowMode };
+  static const int kGeneralizeEvents[] = { UpdateField, MigrateToMap };
+
+  jsw_aggregator->ReportHotspots(stdout, FLAG_trace_map_hotspots_top,
+				 kSlowEvents, ARRAY_SIZE(kSlowEvents),
+				 kGeneralizeEvents, ARRAY_SIZE(kGeneralizeEvents));
+}
+
+
+void Logger::RemoveDeadInternalObjects()
+{
+  if ( jsw_aggregator != NULL )
+    jsw_aggregator->RemoveDeadObjects(isolate_->heap());
+  if ( jsw_sampled != NULL )
+    jsw_sampled->RemoveDeadObjects(isolate_->heap());
 }
 
 
@@ -2361,9 +2843,32 @@ bool Logger::SetUp(Isolate* isolate) {
 
   if (FLAG_log_internal_timer_events || FLAG_prof) epoch_ = OS::Ticks();
 
-  if ( FLAG_trace_internals ) {
+  if ( FLAG_trace_internals || FLAG_trace_deopt_loops )
     jsw_func_info = new map<SharedFunctionInfo*, char*>;
+
+  if ( FLAG_trace_deopt_loops )
+    jsw_deopt_loops = new DeoptLoopDetector(isolate);
+
+  if ( FLAG_trace_internals ) {
     jsw_msg = new char[jsw_buf_limit];
+
+    if ( FLAG_trace_internals_sample_rate > 1 )
+      jsw_sampled = new InternalObjectMap<bool>;
+
+    if ( FLAG_trace_internals_aggregate && log_->IsEnabled() ) {
+      // Only the summarized state machines are written out
+      jsw_aggregator = new InternalEventAggregator(kInternalEventNames,
+						   events_count);
+    }
+    else if ( FLAG_trace_internals_binary && log_->IsEnabled() ) {
+      // Events are encoded on the VM thread and written out by jsw_writer
+      int capacity = RoundUpToPowerOf2(FLAG_trace_internals_buffer_size * KB);
+      jsw_events = new InternalEventBuffer(capacity);
+      jsw_encoder = new InternalEventEncoder(jsw_events);
+      jsw_encoder->WriteHeader();
+      jsw_writer = new InternalEventWriter(jsw_events, log_);
+      jsw_writer->Start();
+    }
   }
   
   return true;
@@ -2402,8 +2907,39 @@ FILE* Logger::TearDown() {
   ticker_ = NULL;
 
   if ( FLAG_trace_internals ) {
-    jsw_output(true);
+    if ( jsw_aggregator != NULL ) {
+      ReportMapHotspots();
+      DumpInternalEvents();
+      delete jsw_aggregator;
+      jsw_aggregator = NULL;
+    }
+    else if ( jsw_writer != NULL ) {
+      jsw_flush_moves();
+      jsw_writer->Stop();
+      delete jsw_writer;
+      delete jsw_encoder;
+      delete jsw_events;
+      jsw_writer = NULL;
+      jsw_encoder = NULL;
+      jsw_events = NULL;
+    }
+    else {
+      jsw_flush_moves();
+      jsw_output(true);
+    }
     
+    delete jsw_msg;
+    delete jsw_sampled;
+    jsw_sampled = NULL;
+  }
+
+  if ( jsw_deopt_loops != NULL ) {
+    ReportDeoptLoops();
+    delete jsw_deopt_loops;
+    jsw_deopt_loops = NULL;
+  }
+
+  if ( jsw_func_info != NULL ) {
     map<SharedFunctionInfo*, char*>::iterator it, end;
     end = jsw_func_info->end();
     
@@ -2413,7 +2949,7 @@ FILE* Logger::TearDown() {
     }
     
     delete jsw_func_info;
-    delete jsw_msg;
+    jsw_func_info = NULL;
   }
 
   return log_->Close();
@@ -33,6 +33,9 @@
 #include "objects.h"
 #include "platform.h"
 #include "log-utils.h"
+#include "log-aggregator.h"
+#include "log-internals.h"
+#include "deopt-loop-detector.h"
 
 using std::map;
 
@@ -110,6 +113,18 @@ class CompilationInfo;
 	}												\
   } while (false)
 
+// Function events and BeginDeoptOnMap also feed the deopt loop detector
+// (--trace-deopt-loops), which works without --trace-internals
+#define LOG_OPT_EVENT(isolate, Call)                \
+  do {                                              \
+    if ( FLAG_trace_internals ||                    \
+         FLAG_trace_deopt_loops ) {                 \
+      v8::internal::Logger* logger =                \
+        (isolate)->logger();                        \
+      logger->Call;                                 \
+    }                                               \
+  } while (false)
+
 
 #define LOG_EVENTS_AND_TAGS_LIST(V)                                     \
   V(CODE_CREATION_EVENT,            "code-creation")                    \
@@ -341,7 +356,7 @@ class Logger {
 
   void RegExpCompileEvent(Handle<JSRegExp> regexp, bool in_cache);
 
-  // Log an event reported from generated code
+  // Log an event reported from generated code
   void LogRuntime(Vector<const char> format, JSArray* args);
 
   // ==== Events logged by --trace-internals ===
@@ -391,7 +406,8 @@ class Logger {
     V(GCMoveMap,gc_move_map)			   \
     V(NotifyStackDeoptAll,notify_stack_deopt_all)  \
     V(SetCheckpoint,set_checkpoint)		   \
-    V(ForDebug,  for_debug)
+    V(ForDebug,  for_debug)			   \
+    V(GCMoveRanges,gc_move_ranges)
 
   enum InternalEvent {
 #define GetEventName(name, handler) name,
@@ -420,11 +436,26 @@ class Logger {
   void EmitMapEvent(InternalEvent event, ...);
 
   // We separate gc moving events for efficiency consideration
-  void EmitGCMoveEvent(HeapObject* from, HeapObject* to);
+  // Moves are batched into ranges of adjacent objects and written out
+  // before the next event
+  void EmitGCMoveEvent(HeapObject* from, HeapObject* to, int size);
 
   // For all other system events
   void EmitSysEvent(InternalEvent event, ...);
 
+  // Writes out the aggregated state machines (--trace-internals-aggregate),
+  // or flushes the buffered events otherwise
+  void DumpInternalEvents();
+
+  // Drops the aggregated objects that died in the current GC
+  void RemoveDeadInternalObjects();
+
+  // Prints the top deopt loops report (--trace-deopt-loops), to stdout
+  void ReportDeoptLoops();
+
+  // Prints the map transition hotspots (--trace-map-hotspots), to stdout
+  void ReportMapHotspots();
+
   bool is_logging() {
     return logging_nesting_ > 0;
   }
@@ -618,9 +649,39 @@ class Logger {
   char* jsw_msg;
   int jsw_pos;
   map<SharedFunctionInfo*, char*>* jsw_func_info;
+
+  // Binary event stream (--trace-internals-binary), NULL in text mode
+  InternalEventBuffer* jsw_events;
+  InternalEventEncoder* jsw_encoder;
+  InternalEventWriter* jsw_writer;
+
+  // Per allocation site state machines (--trace-internals-aggregate),
+  // NULL when events are logged
+  InternalEventAggregator* jsw_aggregator;
+
+  // Pending GC moves, [from, from + size) has moved to [to, to + size)
+  struct MoveRange {
+    MoveRange(Address from, Address to, int size)
+        : from(from), to(to), size(size) { }
+    Address from;
+    Address to;
+    int size;
+  };
+
+  static const int jsw_max_pending_moves = 4096;
+  static const int jsw_moves_per_record = 10;
+  List<MoveRange> jsw_moves;
+
+  // Objects of the sampled allocation sites (--trace-internals-sample-rate),
+  // NULL when every site is traced
+  InternalObjectMap<bool>* jsw_sampled;
+
+  // Opt/deopt cycles per function (--trace-deopt-loops), NULL when disabled
+  DeoptLoopDetector* jsw_deopt_loops;
   
   // We build a readable function name
-  void get_closure_mark(SharedFunctionInfo*);
+  // No heap allocation happens unless may_allocate is set
+  const char* get_closure_mark(SharedFunctionInfo*, bool may_allocate = true);
 
   //
   JSFunction* get_events_context();
@@ -630,6 +691,30 @@ class Logger {
   void jsw_log(char c);
   void jsw_output(bool force = false);
 
+  // Whether the object event belongs to a sampled allocation site
+  bool jsw_sample(InternalEvent event, JSObject* obj, va_list args);
+  bool jsw_sample_site(SharedFunctionInfo* shared, int index);
+
+  // Feed an object event to jsw_aggregator instead of the log
+  void jsw_aggregate(InternalEvent event, JSObject* obj, va_list args);
+  const char* jsw_untracked_site(JSObject* obj, Vector<char> buffer,
+                                 SharedFunctionInfo** source);
+
+  // Feed a function or map event to jsw_deopt_loops
+  void jsw_detect_deopt_loop(InternalEvent event, JSFunction* func,
+                             SharedFunctionInfo* shared, va_list args);
+  const char* jsw_map_name(Map* map, Vector<char> buffer);
+
+  // Write out the pending GC moves as GCMoveRanges records
+  void jsw_flush_moves();
+
+  // Emit one event field by field, in text or binary format
+  void jsw_begin(InternalEvent event);
+  void jsw_addr(const void* addr);
+  void jsw_int(int value);
+  void jsw_str(const char* s);
+  void jsw_end();
+
   friend class CpuProfiler;
 };
 
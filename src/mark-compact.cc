@@ -41,6 +41,7 @@
 #include "marking-thread.h"
 #include "objects-visiting.h"
 #include "objects-visiting-inl.h"
+#include "parallel-evacuator.h"
 #include "stub-cache.h"
 #include "sweeper-thread.h"
 #include "log.h"
@@ -69,6 +70,7 @@ MarkCompactCollector::MarkCompactCollector() :  // NOLINT
       compacting_(false),
       was_marked_incrementally_(false),
       sweeping_pending_(false),
+      sweeper_threads_sweeping_(0),
       sequential_sweeping_(false),
       tracer_(NULL),
       migration_slots_buffer_(NULL),
@@ -402,6 +404,8 @@ void MarkCompactCollector::CollectGarbage() {
   MarkLiveObjects();
   ASSERT(heap_->incremental_marking()->IsStopped());
 
+  LOG_INTERNAL_EVENT(isolate(), RemoveDeadInternalObjects());
+
   if (FLAG_collect_maps) ClearNonLiveReferences();
 
   ClearWeakMaps();
@@ -551,6 +555,7 @@ void MarkCompactCollector::ClearMarkbits() {
 
 void MarkCompactCollector::StartSweeperThreads() {
   sweeping_pending_ = true;
+  Release_Store(&sweeper_threads_sweeping_, FLAG_sweeper_threads);
   for (int i = 0; i < FLAG_sweeper_threads; i++) {
     isolate()->sweeper_threads()[i]->StartSweeping();
   }
@@ -563,22 +568,34 @@ void MarkCompactCollector::WaitUntilSweepingCompleted() {
     isolate()->sweeper_threads()[i]->WaitForSweeperThread();
   }
   sweeping_pending_ = false;
-  StealMemoryFromSweeperThreads(heap()->paged_space(OLD_DATA_SPACE));
-  StealMemoryFromSweeperThreads(heap()->paged_space(OLD_POINTER_SPACE));
+  heap()->paged_space(OLD_DATA_SPACE)->FinalizeSweptPages();
+  heap()->paged_space(OLD_POINTER_SPACE)->FinalizeSweptPages();
   heap()->paged_space(OLD_DATA_SPACE)->ResetUnsweptFreeBytes();
   heap()->paged_space(OLD_POINTER_SPACE)->ResetUnsweptFreeBytes();
 }
 
 
-intptr_t MarkCompactCollector::
-             StealMemoryFromSweeperThreads(PagedSpace* space) {
-  intptr_t freed_bytes = 0;
-  for (int i = 0; i < FLAG_sweeper_threads; i++) {
-    freed_bytes += isolate()->sweeper_threads()[i]->StealMemory(space);
+void MarkCompactCollector::SweeperThreadDone() {
+  Barrier_AtomicIncrement(&sweeper_threads_sweeping_, -1);
+}
+
+
+bool MarkCompactCollector::AreSweeperThreadsDone() {
+  return Acquire_Load(&sweeper_threads_sweeping_) == 0;
+}
+
+
+void MarkCompactCollector::EnsurePagesSwept(PagedSpace* space) {
+  if (!IsConcurrentSweepingInProgress()) return;
+  SweepInParallel(space);
+  PageIterator it(space);
+  while (it.has_next()) {
+    Page* p = it.next();
+    while (p->parallel_sweeping() == MemoryChunk::SWEEPING_IN_PROGRESS) {
+      Thread::YieldCPU();
+    }
   }
-  space->AddToAccountingStats(freed_bytes);
-  space->DecrementUnsweptFreeBytes(freed_bytes);
-  return freed_bytes;
+  space->FinalizeSweptPages();
 }
 
 
@@ -944,14 +961,6 @@ void MarkCompactCollector::Prepare(GCTracer* tracer) {
 }
 
 
-class DeoptimizeMarkedCodeFilter : public OptimizedFunctionFilter {
- public:
-  virtual bool TakeFunction(JSFunction* function) {
-    return function->code()->marked_for_deoptimization();
-  }
-};
-
-
 void MarkCompactCollector::Finish() {
 #ifdef DEBUG
   ASSERT(state_ == SWEEP_SPACES || state_ == RELOCATE_OBJECTS);
@@ -963,8 +972,7 @@ void MarkCompactCollector::Finish() {
   // objects (empty string, illegal builtin).
   isolate()->stub_cache()->Clear();
 
-  DeoptimizeMarkedCodeFilter filter;
-  Deoptimizer::DeoptimizeAllFunctionsWith(isolate(), &filter);
+  Deoptimizer::DeoptimizeMarkedCode(isolate());
 }
 
 
@@ -2465,6 +2473,26 @@ void MarkCompactCollector::ClearNonLiveReferences() {
       ClearNonLiveDependentCode(PropertyCell::cast(cell)->dependent_code());
     }
   }
+
+  // Iterate over the allocation sites.  Objects of tenuring sites carry no
+  // mementos, so the decision is dropped here to give them another chance
+  // in new space.  The deoptimization happens in Finish.
+  Code* top_code = heap()->TopOptimizedCodeWithoutLazyDeopt();
+  Object* undefined = heap()->undefined_value();
+  for (Object* o = heap()->allocation_sites_list(); o != undefined;) {
+    AllocationSite* site = AllocationSite::cast(o);
+    if (IsMarked(site)) {
+      bool can_deopt = top_code == NULL || !site->dependent_code()->Contains(
+          DependentCode::kAllocationSiteTenuringChangedGroup, top_code);
+      if (FLAG_allocation_site_pretenuring && can_deopt &&
+          site->ResetPretenureDecision()) {
+        site->dependent_code()->MarkCodeForDeoptimization(
+            isolate(), DependentCode::kAllocationSiteTenuringChangedGroup);
+      }
+      ClearNonLiveDependentCode(site->dependent_code());
+    }
+    o = site->weak_next();
+  }
 }
 
 
@@ -2648,13 +2676,24 @@ void MarkCompactCollector::MigrateObject(Address dst,
                                          Address src,
                                          int size,
                                          AllocationSpace dest) {
+  MigrateObject(dst, src, size, dest, &migration_slots_buffer_, NULL);
+}
+
+
+void MarkCompactCollector::MigrateObject(Address dst,
+                                         Address src,
+                                         int size,
+                                         AllocationSpace dest,
+                                         SlotsBuffer** migration_slots_buffer,
+                                         List<Address>* new_space_slots) {
   HEAP_PROFILE(heap(), ObjectMoveEvent(src, dst));
 
   if ( FLAG_trace_internals ) {
 	Object* value = Memory::Object_at(src);
 	if (value != NULL && value->IsHeapObject()) {
 	  LOG(heap()->isolate(), 
-		EmitGCMoveEvent(HeapObject::FromAddress(src), HeapObject::FromAddress(dst)));
+		EmitGCMoveEvent(HeapObject::FromAddress(src),
+				HeapObject::FromAddress(dst), size));
 	}
   }
 
@@ -2669,10 +2708,14 @@ void MarkCompactCollector::MigrateObject(Address dst,
       Memory::Object_at(dst_slot) = value;
 
       if (heap_->InNewSpace(value)) {
-        heap_->store_buffer()->Mark(dst_slot);
+        if (new_space_slots != NULL) {
+          new_space_slots->Add(dst_slot);
+        } else {
+          heap_->store_buffer()->Mark(dst_slot);
+        }
       } else if (value->IsHeapObject() && IsOnEvacuationCandidate(value)) {
         SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                           &migration_slots_buffer_,
+                           migration_slots_buffer,
                            reinterpret_cast<Object**>(dst_slot),
                            SlotsBuffer::IGNORE_OVERFLOW);
       }
@@ -2687,7 +2730,7 @@ void MarkCompactCollector::MigrateObject(Address dst,
 
       if (Page::FromAddress(code_entry)->IsEvacuationCandidate()) {
         SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                           &migration_slots_buffer_,
+                           migration_slots_buffer,
                            SlotsBuffer::CODE_ENTRY_SLOT,
                            code_entry_slot,
                            SlotsBuffer::IGNORE_OVERFLOW);
@@ -2697,7 +2740,7 @@ void MarkCompactCollector::MigrateObject(Address dst,
     PROFILE(isolate(), CodeMoveEvent(src, dst));
     heap()->MoveBlock(dst, src, size);
     SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                       &migration_slots_buffer_,
+                       migration_slots_buffer,
                        SlotsBuffer::RELOCATED_CODE_OBJECT,
                        dst,
                        SlotsBuffer::IGNORE_OVERFLOW);
@@ -2937,8 +2980,8 @@ void MarkCompactCollector::EvacuateNewSpace() {
 }
 
 
-void MarkCompactCollector::EvacuateLiveObjectsFromPage(Page* p) {
-  AlwaysAllocateScope always_allocate;
+void MarkCompactCollector::EvacuateLiveObjectsFromPage(Page* p,
+                                                       EvacuationTask* task) {
   PagedSpace* space = static_cast<PagedSpace*>(p->owner());
   ASSERT(p->IsEvacuationCandidate() && !p->WasSwept());
   MarkBit::CellType* cells = p->markbits()->cells();
@@ -2973,6 +3016,17 @@ void MarkCompactCollector::EvacuateLiveObjectsFromPage(Page* p) {
 
       int size = object->Size();
 
+      if (task != NULL) {
+        MigrateObject(task->Allocate(space, size)->address(),
+                      object_addr,
+                      size,
+                      space->identity(),
+                      task->migration_slots_buffer_address(),
+                      task->new_space_slots());
+        ASSERT(object->map_word().IsForwardingAddress());
+        continue;
+      }
+
       MaybeObject* target = space->AllocateRaw(size);
       if (target->IsFailure()) {
         // OS refused to give us memory.
@@ -2997,6 +3051,7 @@ void MarkCompactCollector::EvacuateLiveObjectsFromPage(Page* p) {
 
 
 void MarkCompactCollector::EvacuatePages() {
+  AlwaysAllocateScope always_allocate;
   int npages = evacuation_candidates_.length();
   for (int i = 0; i < npages; i++) {
     Page* p = evacuation_candidates_[i];
@@ -3006,7 +3061,7 @@ void MarkCompactCollector::EvacuatePages() {
       // During compaction we might have to request a new page.
       // Check that space still have room for that.
       if (static_cast<PagedSpace*>(p->owner())->CanExpand()) {
-        EvacuateLiveObjectsFromPage(p);
+        EvacuateLiveObjectsFromPage(p, NULL);
       } else {
         // Without room for expansion evacuation is not guaranteed to succeed.
         // Pessimistically abandon unevacuated pages.
@@ -3085,9 +3140,9 @@ enum SweepingMode {
 };
 
 
-enum SkipListRebuildingMode {
-  REBUILD_SKIP_LIST,
-  IGNORE_SKIP_LIST
+enum ObjectStartsRebuildingMode {
+  REBUILD_OBJECT_STARTS,
+  IGNORE_OBJECT_STARTS
 };
 
 
@@ -3097,14 +3152,16 @@ enum SkipListRebuildingMode {
 // over it.  Map space is swept precisely, because it is not compacted.
 // Slots in live objects pointing into evacuation candidates are updated
 // if requested.
-template<SweepingMode sweeping_mode, SkipListRebuildingMode skip_list_mode>
+template<SweepingMode sweeping_mode,
+         ObjectStartsRebuildingMode object_starts_mode>
 static void SweepPrecisely(PagedSpace* space,
                            Page* p,
                            ObjectVisitor* v) {
   ASSERT(!p->IsEvacuationCandidate() && !p->WasSwept());
-  ASSERT_EQ(skip_list_mode == REBUILD_SKIP_LIST,
+  ASSERT_EQ(object_starts_mode == REBUILD_OBJECT_STARTS,
             space->identity() == CODE_SPACE);
-  ASSERT((p->skip_list() == NULL) || (skip_list_mode == REBUILD_SKIP_LIST));
+  ASSERT((p->object_starts() == NULL) ||
+         (object_starts_mode == REBUILD_OBJECT_STARTS));
 
   double start_time = 0.0;
   if (FLAG_print_cumulative_gc_stat) {
@@ -3129,10 +3186,9 @@ static void SweepPrecisely(PagedSpace* space,
   Address object_address = free_start;
   int offsets[16];
 
-  SkipList* skip_list = p->skip_list();
-  int curr_region = -1;
-  if ((skip_list_mode == REBUILD_SKIP_LIST) && skip_list) {
-    skip_list->Clear();
+  ObjectStartBitmap* object_starts = p->object_starts();
+  if ((object_starts_mode == REBUILD_OBJECT_STARTS) && object_starts) {
+    object_starts->Clear();
   }
 
   for (;
@@ -3161,16 +3217,9 @@ static void SweepPrecisely(PagedSpace* space,
       if (sweeping_mode == SWEEP_AND_VISIT_LIVE_OBJECTS) {
         live_object->IterateBody(map->instance_type(), size, v);
       }
-      if ((skip_list_mode == REBUILD_SKIP_LIST) && skip_list != NULL) {
-        int new_region_start =
-            SkipList::RegionNumber(free_end);
-        int new_region_end =
-            SkipList::RegionNumber(free_end + size - kPointerSize);
-        if (new_region_start != curr_region ||
-            new_region_end != curr_region) {
-          skip_list->AddObject(free_end, size);
-          curr_region = new_region_end;
-        }
+      if ((object_starts_mode == REBUILD_OBJECT_STARTS) &&
+          object_starts != NULL) {
+        object_starts->AddObject(free_end);
       }
       free_start = free_end + size;
     }
@@ -3317,8 +3366,16 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
     EvacuateNewSpace();
   }
 
+  ParallelEvacuator* parallel_evacuator = heap()->parallel_evacuator();
+  bool evacuate_in_parallel = parallel_evacuator != NULL &&
+      parallel_evacuator->CanEvacuateInParallel(&evacuation_candidates_);
+
   { GCTracer::Scope gc_scope(tracer_, GCTracer::Scope::MC_EVACUATE_PAGES);
-    EvacuatePages();
+    if (evacuate_in_parallel) {
+      parallel_evacuator->EvacuatePages(&evacuation_candidates_);
+    } else {
+      EvacuatePages();
+    }
   }
 
   // Second pass: find pointers to new space and update them.
@@ -3383,26 +3440,34 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
   int npages = evacuation_candidates_.length();
   { GCTracer::Scope gc_scope(
       tracer_, GCTracer::Scope::MC_UPDATE_POINTERS_BETWEEN_EVACUATED);
+    if (evacuate_in_parallel) {
+      parallel_evacuator->UpdatePointersToEvacuated(
+          code_slots_filtering_required);
+    }
+
     for (int i = 0; i < npages; i++) {
       Page* p = evacuation_candidates_[i];
       ASSERT(p->IsEvacuationCandidate() ||
              p->IsFlagSet(Page::RESCAN_ON_EVACUATION));
 
       if (p->IsEvacuationCandidate()) {
-        SlotsBuffer::UpdateSlotsRecordedIn(heap_,
-                                           p->slots_buffer(),
-                                           code_slots_filtering_required);
+        if (!evacuate_in_parallel) {
+          SlotsBuffer::UpdateSlotsRecordedIn(heap_,
+                                             p->slots_buffer(),
+                                             code_slots_filtering_required);
+        }
         if (FLAG_trace_fragmentation) {
           PrintF("  page %p slots buffer: %d\n",
                  reinterpret_cast<void*>(p),
                  SlotsBuffer::SizeOfChain(p->slots_buffer()));
         }
 
-        // Important: skip list should be cleared only after roots were updated
-        // because root iteration traverses the stack and might have to find
-        // code objects from non-updated pc pointing into evacuation candidate.
-        SkipList* list = p->skip_list();
-        if (list != NULL) list->Clear();
+        // Important: object starts should be cleared only after roots were
+        // updated because root iteration traverses the stack and might have
+        // to find code objects from non-updated pc pointing into evacuation
+        // candidate.
+        ObjectStartBitmap* object_starts = p->object_starts();
+        if (object_starts != NULL) object_starts->Clear();
       } else {
         if (FLAG_gc_verbose) {
           PrintF("Sweeping 0x%" V8PRIxPTR " during evacuation.\n",
@@ -3413,15 +3478,15 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
 
         switch (space->identity()) {
           case OLD_DATA_SPACE:
-            SweepConservatively<SWEEP_SEQUENTIALLY>(space, NULL, p);
+            SweepConservatively<SWEEP_SEQUENTIALLY>(space, p);
             break;
           case OLD_POINTER_SPACE:
-            SweepPrecisely<SWEEP_AND_VISIT_LIVE_OBJECTS, IGNORE_SKIP_LIST>(
-                space, p, &updating_visitor);
+            SweepPrecisely<SWEEP_AND_VISIT_LIVE_OBJECTS,
+                           IGNORE_OBJECT_STARTS>(space, p, &updating_visitor);
             break;
           case CODE_SPACE:
-            SweepPrecisely<SWEEP_AND_VISIT_LIVE_OBJECTS, REBUILD_SKIP_LIST>(
-                space, p, &updating_visitor);
+            SweepPrecisely<SWEEP_AND_VISIT_LIVE_OBJECTS,
+                           REBUILD_OBJECT_STARTS>(space, p, &updating_visitor);
             break;
           default:
             UNREACHABLE();
@@ -3799,13 +3864,12 @@ static inline Address StartOfLiveObject(Address block_address, uint32_t cell) {
 
 template<MarkCompactCollector::SweepingParallelism mode>
 static intptr_t Free(PagedSpace* space,
-                     FreeList* free_list,
                      Address start,
                      int size) {
   if (mode == MarkCompactCollector::SWEEP_SEQUENTIALLY) {
     return space->Free(start, size);
   } else {
-    return size - free_list->Free(start, size);
+    return size - FreeList::FreeToSweptPage(space->heap(), start, size);
   }
 }
 
@@ -3814,14 +3878,14 @@ static intptr_t Free(PagedSpace* space,
 // SWEEP_SEQUENTIALLY mode.
 template intptr_t MarkCompactCollector::
     SweepConservatively<MarkCompactCollector::SWEEP_SEQUENTIALLY>(
-        PagedSpace*, FreeList*, Page*);
+        PagedSpace*, Page*);
 
 
 // Force instantiation of templatized SweepConservatively method for
 // SWEEP_IN_PARALLEL mode.
 template intptr_t MarkCompactCollector::
     SweepConservatively<MarkCompactCollector::SWEEP_IN_PARALLEL>(
-        PagedSpace*, FreeList*, Page*);
+        PagedSpace*, Page*);
 
 
 // Sweeps a space conservatively.  After this has been done the larger free
@@ -3833,16 +3897,16 @@ template intptr_t MarkCompactCollector::
 // spaces will not contain the free space map.
 template<MarkCompactCollector::SweepingParallelism mode>
 intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space,
-                                                   FreeList* free_list,
                                                    Page* p) {
   ASSERT(!p->IsEvacuationCandidate() && !p->WasSwept());
-  ASSERT((mode == MarkCompactCollector::SWEEP_IN_PARALLEL &&
-         free_list != NULL) ||
-         (mode == MarkCompactCollector::SWEEP_SEQUENTIALLY &&
-         free_list == NULL));
 
   MarkBit::CellType* cells = p->markbits()->cells();
-  p->MarkSweptConservatively();
+  // A page swept by a sweeper thread is marked as swept and its live bytes
+  // are reset by the main thread when it is finalized.  The flags and the
+  // live bytes can be updated by the main thread at any time.
+  if (mode == MarkCompactCollector::SWEEP_SEQUENTIALLY) {
+    p->MarkSweptConservatively();
+  }
 
   int last_cell_index =
       Bitmap::IndexToCell(
@@ -3867,8 +3931,7 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space,
   }
   size_t size = block_address - p->area_start();
   if (cell_index == last_cell_index) {
-    freed_bytes += Free<mode>(space, free_list, p->area_start(),
-                              static_cast<int>(size));
+    freed_bytes += Free<mode>(space, p->area_start(), static_cast<int>(size));
     ASSERT_EQ(0, p->LiveBytes());
     return freed_bytes;
   }
@@ -3877,8 +3940,7 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space,
   Address free_end = StartOfLiveObject(block_address, cells[cell_index]);
   // Free the first free space.
   size = free_end - p->area_start();
-  freed_bytes += Free<mode>(space, free_list, p->area_start(),
-                            static_cast<int>(size));
+  freed_bytes += Free<mode>(space, p->area_start(), static_cast<int>(size));
 
   // The start of the current free area is represented in undigested form by
   // the address of the last 32-word section that contained a live object and
@@ -3908,7 +3970,7 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space,
           // so now we need to find the start of the first live object at the
           // end of the free space.
           free_end = StartOfLiveObject(block_address, cell);
-          freed_bytes += Free<mode>(space, free_list, free_start,
+          freed_bytes += Free<mode>(space, free_start,
                                     static_cast<int>(free_end - free_start));
         }
       }
@@ -3923,25 +3985,25 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space,
   // Handle the free space at the end of the page.
   if (block_address - free_start > 32 * kPointerSize) {
     free_start = DigestFreeStart(free_start, free_start_cell);
-    freed_bytes += Free<mode>(space, free_list, free_start,
+    freed_bytes += Free<mode>(space, free_start,
                               static_cast<int>(block_address - free_start));
   }
 
-  p->ResetLiveBytes();
+  if (mode == MarkCompactCollector::SWEEP_SEQUENTIALLY) {
+    p->ResetLiveBytes();
+  }
   return freed_bytes;
 }
 
 
-void MarkCompactCollector::SweepInParallel(PagedSpace* space,
-                                           FreeList* private_free_list,
-                                           FreeList* free_list) {
+void MarkCompactCollector::SweepInParallel(PagedSpace* space) {
   PageIterator it(space);
   while (it.has_next()) {
     Page* p = it.next();
 
     if (p->TryParallelSweeping()) {
-      SweepConservatively<SWEEP_IN_PARALLEL>(space, private_free_list, p);
-      free_list->Concatenate(private_free_list);
+      SweepConservatively<SWEEP_IN_PARALLEL>(space, p);
+      space->AddSweptPage(p);
     }
   }
 }
@@ -3964,7 +4026,7 @@ void MarkCompactCollector::SweepSpace(PagedSpace* space, SweeperType sweeper) {
   while (it.has_next()) {
     Page* p = it.next();
 
-    ASSERT(p->parallel_sweeping() == 0);
+    ASSERT(p->parallel_sweeping() == MemoryChunk::SWEEPING_DONE);
     ASSERT(!p->IsEvacuationCandidate());
 
     // Clear sweeping flags indicating that marking bits are still intact.
@@ -3999,7 +4061,7 @@ void MarkCompactCollector::SweepSpace(PagedSpace* space, SweeperType sweeper) {
           PrintF("Sweeping 0x%" V8PRIxPTR " conservatively.\n",
                  reinterpret_cast<intptr_t>(p));
         }
-        SweepConservatively<SWEEP_SEQUENTIALLY>(space, NULL, p);
+        SweepConservatively<SWEEP_SEQUENTIALLY>(space, p);
         pages_swept++;
         break;
       }
@@ -4015,7 +4077,7 @@ void MarkCompactCollector::SweepSpace(PagedSpace* space, SweeperType sweeper) {
             PrintF("Sweeping 0x%" V8PRIxPTR " conservatively.\n",
                    reinterpret_cast<intptr_t>(p));
           }
-          SweepConservatively<SWEEP_SEQUENTIALLY>(space, NULL, p);
+          SweepConservatively<SWEEP_SEQUENTIALLY>(space, p);
           pages_swept++;
           space->SetPagesToSweep(p->next_page());
           lazy_sweeping_active = true;
@@ -4024,12 +4086,14 @@ void MarkCompactCollector::SweepSpace(PagedSpace* space, SweeperType sweeper) {
       }
       case CONCURRENT_CONSERVATIVE:
       case PARALLEL_CONSERVATIVE: {
-        if (!parallel_sweeping_active) {
+        // With concurrent sweeping no page is swept in the pause, allocation
+        // during evacuation expands the space instead.
+        if (!parallel_sweeping_active && sweeper == PARALLEL_CONSERVATIVE) {
           if (FLAG_gc_verbose) {
             PrintF("Sweeping 0x%" V8PRIxPTR " conservatively.\n",
                    reinterpret_cast<intptr_t>(p));
           }
-          SweepConservatively<SWEEP_SEQUENTIALLY>(space, NULL, p);
+          SweepConservatively<SWEEP_SEQUENTIALLY>(space, p);
           pages_swept++;
           parallel_sweeping_active = true;
         } else {
@@ -4037,7 +4101,7 @@ void MarkCompactCollector::SweepSpace(PagedSpace* space, SweeperType sweeper) {
             PrintF("Sweeping 0x%" V8PRIxPTR " conservatively in parallel.\n",
                    reinterpret_cast<intptr_t>(p));
           }
-          p->set_parallel_sweeping(1);
+          p->set_parallel_sweeping(MemoryChunk::SWEEPING_PENDING);
           space->IncreaseUnsweptFreeBytes(p);
         }
         break;
@@ -4048,9 +4112,10 @@ void MarkCompactCollector::SweepSpace(PagedSpace* space, SweeperType sweeper) {
                  reinterpret_cast<intptr_t>(p));
         }
         if (space->identity() == CODE_SPACE) {
-          SweepPrecisely<SWEEP_ONLY, REBUILD_SKIP_LIST>(space, p, NULL);
+          SweepPrecisely<SWEEP_ONLY, REBUILD_OBJECT_STARTS>(
+              space, p, NULL);
         } else {
-          SweepPrecisely<SWEEP_ONLY, IGNORE_SKIP_LIST>(space, p, NULL);
+          SweepPrecisely<SWEEP_ONLY, IGNORE_OBJECT_STARTS>(space, p, NULL);
         }
         pages_swept++;
         break;
@@ -4097,13 +4162,8 @@ void MarkCompactCollector::SweepSpaces() {
   SweepSpace(heap()->old_pointer_space(), how_to_sweep);
   SweepSpace(heap()->old_data_space(), how_to_sweep);
 
-  if (how_to_sweep == PARALLEL_CONSERVATIVE ||
-      how_to_sweep == CONCURRENT_CONSERVATIVE) {
-    // TODO(hpayer): fix race with concurrent sweeper
-    StartSweeperThreads();
-  }
-
   if (how_to_sweep == PARALLEL_CONSERVATIVE) {
+    StartSweeperThreads();
     WaitUntilSweepingCompleted();
   }
 
@@ -4115,6 +4175,12 @@ void MarkCompactCollector::SweepSpaces() {
 
   EvacuateNewSpaceAndCandidates();
 
+  // The sweeper threads are started only now, updating the pointers to new
+  // space above visits slots in dead objects that they would free.
+  if (how_to_sweep == CONCURRENT_CONSERVATIVE) {
+    StartSweeperThreads();
+  }
+
   // ClearNonLiveTransitions depends on precise sweeping of map space to
   // detect whether unmarked map became dead in this collection or in one
   // of the previous ones.
@@ -4271,16 +4337,19 @@ static inline SlotsBuffer::SlotType DecodeSlotType(
 }
 
 
-void SlotsBuffer::UpdateSlots(Heap* heap) {
+void SlotsBuffer::UpdateSlots(Heap* heap, SlotSelection selection) {
   PointersUpdatingVisitor v(heap);
 
   for (int slot_idx = 0; slot_idx < idx_; ++slot_idx) {
     ObjectSlot slot = slots_[slot_idx];
     if (!IsTypedSlot(slot)) {
-      PointersUpdatingVisitor::UpdateSlot(heap, slot);
+      if (selection != TYPED_SLOTS) {
+        PointersUpdatingVisitor::UpdateSlot(heap, slot);
+      }
     } else {
       ++slot_idx;
       ASSERT(slot_idx < idx_);
+      if (selection == UNTYPED_SLOTS) continue;
       UpdateSlot(&v,
                  DecodeSlotType(slot),
                  reinterpret_cast<Address>(slots_[slot_idx]));
@@ -4289,18 +4358,20 @@ void SlotsBuffer::UpdateSlots(Heap* heap) {
 }
 
 
-void SlotsBuffer::UpdateSlotsWithFilter(Heap* heap) {
+void SlotsBuffer::UpdateSlotsWithFilter(Heap* heap, SlotSelection selection) {
   PointersUpdatingVisitor v(heap);
 
   for (int slot_idx = 0; slot_idx < idx_; ++slot_idx) {
     ObjectSlot slot = slots_[slot_idx];
     if (!IsTypedSlot(slot)) {
-      if (!IsOnInvalidatedCodeObject(reinterpret_cast<Address>(slot))) {
+      if (selection != TYPED_SLOTS &&
+          !IsOnInvalidatedCodeObject(reinterpret_cast<Address>(slot))) {
         PointersUpdatingVisitor::UpdateSlot(heap, slot);
       }
     } else {
       ++slot_idx;
       ASSERT(slot_idx < idx_);
+      if (selection == UNTYPED_SLOTS) continue;
       Address pc = reinterpret_cast<Address>(slots_[slot_idx]);
       if (!IsOnInvalidatedCodeObject(pc)) {
         UpdateSlot(&v,
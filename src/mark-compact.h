@@ -41,6 +41,7 @@ typedef bool (*IsAliveFunction)(HeapObject* obj, int* size, int* offset);
 
 // Forward declarations.
 class CodeFlusher;
+class EvacuationTask;
 class GCTracer;
 class MarkCompactCollector;
 class MarkingVisitor;
@@ -110,6 +111,39 @@ class Marking {
     markbit.Next().Set();
   }
 
+  // Atomic color transitions, used while the marking threads of
+  // --concurrent-marking are running.  WhiteToGreyAtomic returns false if
+  // the object was not white or another thread claimed it first.
+  INLINE(static bool WhiteToGreyAtomic(MarkBit markbit)) {
+    MarkBit next = markbit.Next();
+    if (next.cell() == markbit.cell()) {
+      volatile Atomic32* cell =
+          reinterpret_cast<volatile Atomic32*>(markbit.cell());
+      Atomic32 old_value;
+      do {
+        old_value = NoBarrier_Load(cell);
+        if ((old_value & markbit.mask()) != 0) return false;
+      } while (NoBarrier_CompareAndSwap(
+                   cell, old_value,
+                   old_value | markbit.mask() | next.mask()) != old_value);
+      return true;
+    }
+    // The bits are in different cells.  Setting the second bit claims the
+    // object, it stays white for everybody else until the first bit is set.
+    if (markbit.Get()) return false;
+    if (!next.SetAtomic()) return false;
+    markbit.SetAtomic();
+    return true;
+  }
+
+  INLINE(static void BlackToGreyAtomic(MarkBit markbit)) {
+    markbit.Next().SetAtomic();
+  }
+
+  INLINE(static void GreyToBlackAtomic(MarkBit markbit)) {
+    markbit.Next().ClearAtomic();
+  }
+
   // Returns true if the the object whose mark is transferred is marked black.
   bool TransferMark(Address old_start, Address new_start);
 
@@ -324,9 +358,17 @@ class SlotsBuffer {
     return "UNKNOWN SlotType";
   }
 
-  void UpdateSlots(Heap* heap);
+  // Parallel pointer updating leaves the typed slots, which may lie at
+  // unaligned addresses inside code, to the main thread.
+  enum SlotSelection {
+    ALL_SLOTS,
+    UNTYPED_SLOTS,
+    TYPED_SLOTS
+  };
 
-  void UpdateSlotsWithFilter(Heap* heap);
+  void UpdateSlots(Heap* heap, SlotSelection selection);
+
+  void UpdateSlotsWithFilter(Heap* heap, SlotSelection selection);
 
   SlotsBuffer* next() { return next_; }
 
@@ -346,12 +388,13 @@ class SlotsBuffer {
 
   static void UpdateSlotsRecordedIn(Heap* heap,
                                     SlotsBuffer* buffer,
-                                    bool code_slots_filtering_required) {
+                                    bool code_slots_filtering_required,
+                                    SlotSelection selection = ALL_SLOTS) {
     while (buffer != NULL) {
       if (code_slots_filtering_required) {
-        buffer->UpdateSlotsWithFilter(heap);
+        buffer->UpdateSlotsWithFilter(heap, selection);
       } else {
-        buffer->UpdateSlots(heap);
+        buffer->UpdateSlots(heap, selection);
       }
       buffer = buffer->next();
     }
@@ -640,11 +683,10 @@ class MarkCompactCollector {
 #endif
 
   // Sweep a single page from the given space conservatively.
-  // Return a number of reclaimed bytes.
+  // Return a number of reclaimed bytes.  In SWEEP_IN_PARALLEL mode the free
+  // blocks are kept on the page until the main thread finalizes it.
   template<SweepingParallelism type>
-  static intptr_t SweepConservatively(PagedSpace* space,
-                                      FreeList* free_list,
-                                      Page* p);
+  static intptr_t SweepConservatively(PagedSpace* space, Page* p);
 
   INLINE(static bool ShouldSkipEvacuationSlotRecording(Object** anchor)) {
     return Page::FromAddress(reinterpret_cast<Address>(anchor))->
@@ -693,6 +735,16 @@ class MarkCompactCollector {
                      int size,
                      AllocationSpace to_old_space);
 
+  // Records the slots of the moved object in the given buffers instead of
+  // the migration slots buffer and the store buffer, so that objects can be
+  // migrated by several threads at once.
+  void MigrateObject(Address dst,
+                     Address src,
+                     int size,
+                     AllocationSpace to_old_space,
+                     SlotsBuffer** migration_slots_buffer,
+                     List<Address>* new_space_slots);
+
   bool TryPromoteObject(HeapObject* object, int object_size);
 
   inline Object* encountered_weak_maps() { return encountered_weak_maps_; }
@@ -711,13 +763,20 @@ class MarkCompactCollector {
   MarkingParity marking_parity() { return marking_parity_; }
 
   // Concurrent and parallel sweeping support.
-  void SweepInParallel(PagedSpace* space,
-                       FreeList* private_free_list,
-                       FreeList* free_list);
+  void SweepInParallel(PagedSpace* space);
 
   void WaitUntilSweepingCompleted();
 
-  intptr_t StealMemoryFromSweeperThreads(PagedSpace* space);
+  // Called by each sweeper thread when it has swept all its pages.
+  void SweeperThreadDone();
+
+  // True once every sweeper thread is done, WaitUntilSweepingCompleted does
+  // not block then.
+  bool AreSweeperThreadsDone();
+
+  // Sweeps the pages of the space that no sweeper thread has claimed yet and
+  // waits for the ones being swept, so that the space can be scanned.
+  void EnsurePagesSwept(PagedSpace* space);
 
   bool AreSweeperThreadsActivated();
 
@@ -783,6 +842,9 @@ class MarkCompactCollector {
   // True if concurrent or parallel sweeping is currently in progress.
   bool sweeping_pending_;
 
+  // The number of sweeper threads that are still sweeping.
+  volatile AtomicWord sweeper_threads_sweeping_;
+
   bool sequential_sweeping_;
 
   // A pointer to the current stack-allocated GC tracer object during a full
@@ -921,7 +983,9 @@ class MarkCompactCollector {
 
   void EvacuateNewSpace();
 
-  void EvacuateLiveObjectsFromPage(Page* p);
+  // Moves the live objects of p.  If task is not NULL the objects are
+  // allocated in its buffers and their slots are recorded by it.
+  void EvacuateLiveObjectsFromPage(Page* p, EvacuationTask* task);
 
   void EvacuatePages();
 
@@ -946,6 +1010,7 @@ class MarkCompactCollector {
   List<Code*> invalidated_code_;
 
   friend class Heap;
+  friend class ParallelEvacuator;
 };
 
 
@@ -29,27 +29,25 @@
 
 #include "v8.h"
 
+#include "concurrent-marking.h"
 #include "isolate.h"
 #include "v8threads.h"
 
 namespace v8 {
 namespace internal {
 
-MarkingThread::MarkingThread(Isolate* isolate)
+MarkingThread::MarkingThread(Isolate* isolate, int id)
      : Thread("MarkingThread"),
        isolate_(isolate),
        heap_(isolate->heap()),
        start_marking_semaphore_(OS::CreateSemaphore(0)),
        end_marking_semaphore_(OS::CreateSemaphore(0)),
-       stop_semaphore_(OS::CreateSemaphore(0)) {
+       stop_semaphore_(OS::CreateSemaphore(0)),
+       id_(id) {
   NoBarrier_Store(&stop_thread_, static_cast<AtomicWord>(false));
-  id_ = NoBarrier_AtomicIncrement(&id_counter_, 1);
 }
 
 
-Atomic32 MarkingThread::id_counter_ = -1;
-
-
 void MarkingThread::Run() {
   Isolate::SetIsolateThreadLocals(isolate_, NULL);
   DisallowHeapAllocation no_allocation;
@@ -64,6 +62,10 @@ void MarkingThread::Run() {
       return;
     }
 
+    if (heap_->concurrent_marking() != NULL) {
+      heap_->concurrent_marking()->MarkConcurrently(id_);
+    }
+
     end_marking_semaphore_->Signal();
   }
 }
@@ -42,7 +42,7 @@ namespace internal {
 
 class MarkingThread : public Thread {
  public:
-  explicit MarkingThread(Isolate* isolate);
+  MarkingThread(Isolate* isolate, int id);
 
   void Run();
   void Stop();
@@ -63,7 +63,6 @@ class MarkingThread : public Thread {
   Semaphore* stop_semaphore_;
   volatile AtomicWord stop_thread_;
   int id_;
-  static Atomic32 id_counter_;
 };
 
 } }  // namespace v8::internal
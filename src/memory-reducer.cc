@@ -0,0 +1,76 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "v8.h"
+
+#include "memory-reducer.h"
+
+namespace v8 {
+namespace internal {
+
+bool MemoryReducer::NotifyTick(double now_ms, intptr_t allocated) {
+  // The first tick only starts the measurement.
+  bool quiet = false;
+  if (last_tick_ms_ > 0 && now_ms > last_tick_ms_) {
+    double rate = (allocated - last_tick_allocated_) /
+        (now_ms - last_tick_ms_);
+    quiet = rate < kLowAllocationRate;
+  }
+  if (!quiet) quiet_since_ms_ = now_ms;
+  last_tick_ms_ = now_ms;
+  last_tick_allocated_ = allocated;
+
+  switch (state_) {
+    case DONE:
+      if (allocated - allocated_at_last_run_ >= kAllocationToRestart) {
+        state_ = WAIT;
+        runs_ = 0;
+      }
+      return false;
+    case WAIT:
+      return now_ms - quiet_since_ms_ >= kQuietTimeMs;
+  }
+  UNREACHABLE();
+  return false;
+}
+
+
+void MemoryReducer::NotifyRun(double now_ms,
+                              intptr_t allocated,
+                              intptr_t released_bytes) {
+  ASSERT(state_ == WAIT);
+  runs_++;
+  allocated_at_last_run_ = allocated;
+  // The collection is not the mutator's allocation.
+  last_tick_ms_ = now_ms;
+  last_tick_allocated_ = allocated;
+  if (released_bytes < kMinReleasedBytes || runs_ >= kMaxRuns) {
+    state_ = DONE;
+  }
+}
+
+} }  // namespace v8::internal
@@ -0,0 +1,101 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_MEMORY_REDUCER_H_
+#define V8_MEMORY_REDUCER_H_
+
+#include "globals.h"
+
+namespace v8 {
+namespace internal {
+
+// Decides when to shrink the heap of an isolate whose mutator has gone
+// quiet, e.g. one that runs a background tab.  The embedder ticks it
+// through v8::V8::MemoryReducerNotification and the heap does the work:
+//
+//   DONE --- kAllocationToRestart bytes allocated ---> WAIT
+//   WAIT --- allocation rate low for kQuietTimeMs ---> run a compacting GC
+//   run  --- released kMinReleasedBytes, runs left ---> WAIT, else DONE
+//
+// After a run the reducer stays in WAIT, so the next tick runs again if
+// the mutator is still quiet.
+class MemoryReducer {
+ public:
+  enum State {
+    DONE,
+    WAIT
+  };
+
+  // Allocation rates below this, in bytes per millisecond, count as quiet.
+  static const intptr_t kLowAllocationRate = 1 * KB;
+
+  // The rate has to stay low this long before the reducer runs.
+  static const int kQuietTimeMs = 4000;
+
+  // A run that releases less than this ends the reduction.
+  static const intptr_t kMinReleasedBytes = 1 * MB;
+
+  // The most runs in one reduction.
+  static const int kMaxRuns = 3;
+
+  // Allocation after a reduction that makes the next one worthwhile.
+  static const intptr_t kAllocationToRestart = 8 * MB;
+
+  MemoryReducer()
+      : state_(DONE),
+        runs_(0),
+        last_tick_ms_(0),
+        last_tick_allocated_(0),
+        quiet_since_ms_(0),
+        allocated_at_last_run_(0) { }
+
+  // Takes a tick at now_ms, when allocated bytes have been allocated since
+  // the heap was set up.  Returns true if a compacting GC should run now.
+  bool NotifyTick(double now_ms, intptr_t allocated);
+
+  // Reports that a run released released_bytes.
+  void NotifyRun(double now_ms, intptr_t allocated, intptr_t released_bytes);
+
+  State state() { return state_; }
+  int runs() { return runs_; }
+
+ private:
+  State state_;
+  // Runs in the current reduction.
+  int runs_;
+  double last_tick_ms_;
+  intptr_t last_tick_allocated_;
+  // The start of the current quiet period.
+  double quiet_since_ms_;
+  intptr_t allocated_at_last_run_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryReducer);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_MEMORY_REDUCER_H_
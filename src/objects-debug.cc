@@ -912,6 +912,18 @@ void TypeSwitchInfo::TypeSwitchInfoVerify() {
 }
 
 
+void AllocationSite::AllocationSiteVerify() {
+  CHECK(IsAllocationSite());
+  VerifyObjectField(kTransitionInfoOffset);
+  CHECK(transition_info()->IsJSArray());
+  memento_create_count()->SmiVerify();
+  memento_found_count()->SmiVerify();
+  pretenure_decision()->SmiVerify();
+  VerifyObjectField(kDependentCodeOffset);
+  CHECK(dependent_code()->IsDependentCode());
+}
+
+
 void AllocationSiteInfo::AllocationSiteInfoVerify() {
   CHECK(IsAllocationSiteInfo());
   VerifyHeapPointer(payload());
@@ -1332,6 +1332,35 @@ bool JSObject::ShouldTrackAllocationInfo() {
 }
 
 
+void AllocationSite::Initialize() {
+  set_memento_create_count(Smi::FromInt(0));
+  set_memento_found_count(Smi::FromInt(0));
+  set_pretenure_decision(Smi::FromInt(kUndecided));
+  set_dependent_code(DependentCode::cast(GetHeap()->empty_fixed_array()),
+                     SKIP_WRITE_BARRIER);
+}
+
+
+PretenureFlag AllocationSite::GetPretenureMode() {
+  return pretenure_decision()->value() == kTenure ? TENURED : NOT_TENURED;
+}
+
+
+void AllocationSite::IncrementMementoCreateCount() {
+  set_memento_create_count(
+      Smi::FromInt(memento_create_count()->value() + 1));
+}
+
+
+void AllocationSite::IncrementMementoFoundCount() {
+  // Adding the tagged values adds the untagged ones, Smis have a zero tag.
+  NoBarrier_AtomicIncrement(
+      reinterpret_cast<volatile AtomicWord*>(
+          FIELD_ADDR(this, kMementoFoundCountOffset)),
+      reinterpret_cast<AtomicWord>(Smi::FromInt(1)));
+}
+
+
 // Heuristic: We only need to create allocation site info if the boilerplate
 // elements kind is the initial elements kind.
 AllocationSiteMode AllocationSiteInfo::GetMode(
@@ -4461,6 +4490,14 @@ ACCESSORS(SignatureInfo, args, Object, kArgsOffset)
 
 ACCESSORS(TypeSwitchInfo, types, Object, kTypesOffset)
 
+ACCESSORS(AllocationSite, transition_info, Object, kTransitionInfoOffset)
+ACCESSORS(AllocationSite, memento_create_count, Smi,
+          kMementoCreateCountOffset)
+ACCESSORS(AllocationSite, memento_found_count, Smi, kMementoFoundCountOffset)
+ACCESSORS(AllocationSite, pretenure_decision, Smi, kPretenureDecisionOffset)
+ACCESSORS(AllocationSite, dependent_code, DependentCode,
+          kDependentCodeOffset)
+ACCESSORS(AllocationSite, weak_next, Object, kWeakNextOffset)
 ACCESSORS(AllocationSiteInfo, payload, Object, kPayloadOffset)
 
 ACCESSORS(Script, source, Object, kSourceOffset)
@@ -4866,8 +4903,8 @@ void SharedFunctionInfo::TryReenableOptimization(const char* reason) {
     code()->set_optimizable(true);
   }
 
-  if ( FLAG_trace_internals ) {
-	LOG( GetIsolate(),
+  if ( FLAG_trace_internals || FLAG_trace_deopt_loops ) {
+	LOG_OPT_EVENT( GetIsolate(),
 		  EmitFunctionEvent(
 			Logger::ReenableOpt,
 			NULL,
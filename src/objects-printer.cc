@@ -1116,6 +1116,20 @@ void TypeSwitchInfo::TypeSwitchInfoPrint(FILE* out) {
 }
 
 
+void AllocationSite::AllocationSitePrint(FILE* out) {
+  HeapObject::PrintHeader(out, "AllocationSite");
+  PrintF(out, " - transition_info: ");
+  transition_info()->ShortPrint(out);
+  PrintF(out, "\n - memento_create_count: %d",
+         memento_create_count()->value());
+  PrintF(out, "\n - memento_found_count: %d", memento_found_count()->value());
+  PrintF(out, "\n - pretenure_decision: %d", pretenure_decision()->value());
+  PrintF(out, "\n - dependent_code: ");
+  dependent_code()->ShortPrint(out);
+  PrintF(out, "\n");
+}
+
+
 void AllocationSiteInfo::AllocationSiteInfoPrint(FILE* out) {
   HeapObject::PrintHeader(out, "AllocationSiteInfo");
   PrintF(out, " - payload: ");
@@ -1130,8 +1144,8 @@ void AllocationSiteInfo::AllocationSiteInfoPrint(FILE* out) {
       PrintF(out, "\n");
       return;
     }
-  } else if (payload()->IsJSArray()) {
-    PrintF(out, "Array literal ");
+  } else if (payload()->IsAllocationSite()) {
+    PrintF(out, "Array literal site ");
     payload()->ShortPrint(out);
     PrintF(out, "\n");
     return;
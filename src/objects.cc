@@ -32,6 +32,7 @@
 #include "arguments.h"
 #include "bootstrapper.h"
 #include "codegen.h"
+#include "concurrent-marking.h"
 #include "debug.h"
 #include "deoptimizer.h"
 #include "date.h"
@@ -1152,6 +1153,7 @@ bool String::MakeExternal(v8::String::ExternalStringResource* resource) {
   }
   bool is_ascii = this->IsOneByteRepresentation();
   bool is_internalized = this->IsInternalizedString();
+  ConcurrentMarkingPauseScope pause_concurrent_marking(heap);
 
   // Morph the object to an external string by adjusting the map and
   // reinitializing the fields.
@@ -1213,6 +1215,7 @@ bool String::MakeExternal(v8::String::ExternalAsciiStringResource* resource) {
     return false;
   }
   bool is_internalized = this->IsInternalizedString();
+  ConcurrentMarkingPauseScope pause_concurrent_marking(heap);
 
   // Morph the object to an external string by adjusting the map and
   // reinitializing the fields.  Use short version if space is limited.
@@ -2266,6 +2269,8 @@ static void RightTrimFixedArray(Heap* heap, FixedArray* elms, int to_trim) {
 
   int size_delta = to_trim * kPointerSize;
 
+  ConcurrentMarkingPauseScope pause_concurrent_marking(heap);
+
   // Technically in new space this write might be omitted (except for
   // debug mode which iterates through the heap), but to play safer
   // we still do it.
@@ -2464,7 +2469,7 @@ MaybeObject* Map::CopyGeneralizeAllRepresentations() {
 
 void Map::NotifyLeafMapLayoutChange() {
   Isolate* isolate = GetIsolate();
-  LOG_INTERNAL_EVENT(isolate, EmitMapEvent(Logger::BeginDeoptOnMap, this));
+  LOG_OPT_EVENT(isolate, EmitMapEvent(Logger::BeginDeoptOnMap, this));
 
   dependent_code()->DeoptimizeDependentCodeGroup(
       isolate,
@@ -2484,7 +2489,7 @@ void Map::DeprecateTransitionTree() {
   deprecate();
 
   Isolate* isolate = GetIsolate();
-  LOG_INTERNAL_EVENT(isolate, EmitMapEvent(Logger::BeginDeoptOnMap, this));
+  LOG_OPT_EVENT(isolate, EmitMapEvent(Logger::BeginDeoptOnMap, this));
 
   dependent_code()->DeoptimizeDependentCodeGroup(
       isolate, DependentCode::kTransitionGroup);
@@ -4596,6 +4601,7 @@ MaybeObject* JSObject::NormalizeProperties(PropertyNormalizationMode mode,
   int new_instance_size = new_map->instance_size();
   int instance_size_delta = map_of_this->instance_size() - new_instance_size;
   ASSERT(instance_size_delta >= 0);
+  ConcurrentMarkingPauseScope pause_concurrent_marking(current_heap);
   current_heap->CreateFillerObjectAt(this->address() + new_instance_size,
                                      instance_size_delta);
   if (Marking::IsBlack(Marking::MarkBitFrom(this))) {
@@ -8903,13 +8909,14 @@ Handle<String> SeqString::Truncate(Handle<SeqString> string, int new_length) {
   }
 
   int delta = old_size - new_size;
+  Heap* heap = string->GetHeap();
+  ConcurrentMarkingPauseScope pause_concurrent_marking(heap);
   string->set_length(new_length);
 
   Address start_of_string = string->address();
   ASSERT_OBJECT_ALIGNED(start_of_string);
   ASSERT_OBJECT_ALIGNED(start_of_string + new_size);
 
-  Heap* heap = string->GetHeap();
   NewSpace* newspace = heap->new_space();
   if (newspace->Contains(start_of_string) &&
       newspace->top() == start_of_string + old_size) {
@@ -8955,6 +8962,36 @@ AllocationSiteInfo* AllocationSiteInfo::FindForJSObject(JSObject* object) {
 }
 
 
+bool AllocationSite::DigestPretenuringFeedback() {
+  int create_count = memento_create_count()->value();
+  if (create_count < kPretenureMinimumCreated) return false;
+  int found_count = memento_found_count()->value();
+  PretenureFlag old_mode = GetPretenureMode();
+  bool tenure = found_count * 100 >= create_count * kPretenureSurvivalPercent;
+  set_pretenure_decision(Smi::FromInt(tenure ? kTenure : kDontTenure));
+  if (FLAG_trace_pretenuring) {
+    PrintF("AllocationSite %p: %d of %d objects survived, %s\n",
+           reinterpret_cast<void*>(this), found_count, create_count,
+           tenure ? "tenure" : "don't tenure");
+  }
+  set_memento_create_count(Smi::FromInt(0));
+  set_memento_found_count(Smi::FromInt(0));
+  return GetPretenureMode() != old_mode;
+}
+
+
+bool AllocationSite::ResetPretenureDecision() {
+  if (pretenure_decision()->value() != kTenure) return false;
+  if (FLAG_trace_pretenuring) {
+    PrintF("AllocationSite %p: undecided\n", reinterpret_cast<void*>(this));
+  }
+  set_pretenure_decision(Smi::FromInt(kUndecided));
+  set_memento_create_count(Smi::FromInt(0));
+  set_memento_found_count(Smi::FromInt(0));
+  return true;
+}
+
+
 bool AllocationSiteInfo::GetElementsKindPayload(ElementsKind* kind) {
   ASSERT(kind != NULL);
   if (payload()->IsCell()) {
@@ -9304,10 +9341,10 @@ static bool CompileLazyHelper(CompilationInfo* info,
     info->isolate()->clear_pending_exception();
   }
   
-  if ( FLAG_trace_internals && result == true) {
+  if ( (FLAG_trace_internals || FLAG_trace_deopt_loops) && result == true) {
 	JSFunction *closure = *(info->closure());
 	Code* code = closure->code();
-	LOG(info->isolate(),
+	LOG_OPT_EVENT(info->isolate(),
 		EmitFunctionEvent(
 		info->IsOptimizing() ? Logger::GenOptCode : Logger::GenFullCode,
 		closure,
@@ -9882,9 +9919,9 @@ void SharedFunctionInfo::DisableOptimization(const char* reason) {
     ShortPrint();
     PrintF(", reason: %s]\n", reason);
   }
-  if ( FLAG_trace_internals ) {
+  if ( FLAG_trace_internals || FLAG_trace_deopt_loops ) {
 	if ( code()->kind() < Code::STUB ) {
-	  LOG(GetIsolate(),
+	  LOG_OPT_EVENT(GetIsolate(),
 			EmitFunctionEvent(
 			Logger::DisableOpt,
 			NULL,
@@ -11308,6 +11345,8 @@ DependentCode* DependentCode::ForObject(Handle<HeapObject> object,
   AllowDeferredHandleDereference dependencies_are_safe;
   if (group == DependentCode::kPropertyCellChangedGroup) {
     return Handle<PropertyCell>::cast(object)->dependent_code();
+  } else if (group == DependentCode::kAllocationSiteTenuringChangedGroup) {
+    return Handle<AllocationSite>::cast(object)->dependent_code();
   }
   return Handle<Map>::cast(object)->dependent_code();
 }
@@ -11428,15 +11467,17 @@ bool DependentCode::Contains(DependencyGroup group, Code* code) {
 }
 
 
-class DeoptimizeDependentCodeFilter : public OptimizedFunctionFilter {
- public:
-  virtual bool TakeFunction(JSFunction* function) {
-    return function->code()->marked_for_deoptimization();
+void DependentCode::DeoptimizeDependentCodeGroup(
+    Isolate* isolate,
+    DependentCode::DependencyGroup group) {
+  DisallowHeapAllocation no_allocation_scope;
+  if (MarkCodeForDeoptimization(isolate, group)) {
+    Deoptimizer::DeoptimizeMarkedCode(isolate);
   }
-};
+}
 
 
-void DependentCode::DeoptimizeDependentCodeGroup(
+bool DependentCode::MarkCodeForDeoptimization(
     Isolate* isolate,
     DependentCode::DependencyGroup group) {
   DisallowHeapAllocation no_allocation_scope;
@@ -11444,7 +11485,7 @@ void DependentCode::DeoptimizeDependentCodeGroup(
   int start = starts.at(group);
   int end = starts.at(group + 1);
   int code_entries = starts.number_of_entries();
-  if (start == end) return;
+  if (start == end) return false;
   for (int i = start; i < end; i++) {
     if (is_code_at(i)) {
       Code* code = code_at(i);
@@ -11464,8 +11505,7 @@ void DependentCode::DeoptimizeDependentCodeGroup(
     clear_at(i);
   }
   set_number_of_entries(group, 0);
-  DeoptimizeDependentCodeFilter filter;
-  Deoptimizer::DeoptimizeAllFunctionsWith(isolate, &filter);
+  return true;
 }
 
 
@@ -12485,8 +12525,9 @@ MaybeObject* JSObject::UpdateAllocationSiteInfo(ElementsKind to_kind) {
     return this;
   }
 
-  if (info->payload()->IsJSArray()) {
-    JSArray* payload = JSArray::cast(info->payload());
+  if (info->IsAllocationSite()) {
+    JSArray* payload =
+        JSArray::cast(info->GetAllocationSite()->transition_info());
     ElementsKind kind = payload->GetElementsKind();
     if (AllocationSiteInfo::GetMode(kind, to_kind) == TRACK_ALLOCATION_SITE) {
       // If the array is huge, it's not likely to be defined in a local
@@ -16008,6 +16049,18 @@ void PropertyCell::AddDependentCompilationInfo(CompilationInfo* info) {
 }
 
 
+void AllocationSite::AddDependentCompilationInfo(CompilationInfo* info) {
+  Handle<DependentCode> dep(dependent_code());
+  Handle<DependentCode> codes =
+      DependentCode::Insert(dep,
+                            DependentCode::kAllocationSiteTenuringChangedGroup,
+                            info->object_wrapper());
+  if (*codes != dependent_code()) set_dependent_code(*codes);
+  info->dependencies(DependentCode::kAllocationSiteTenuringChangedGroup)->Add(
+      Handle<HeapObject>(this), info->zone());
+}
+
+
 void PropertyCell::AddDependentCode(Handle<Code> code) {
   Handle<DependentCode> codes = DependentCode::Insert(
       Handle<DependentCode>(dependent_code()),
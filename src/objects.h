@@ -386,6 +386,7 @@ const int kStubMinorKeyBits = kBitsPerInt - kSmiTagSize - kStubMajorKeyBits;
   V(OBJECT_TEMPLATE_INFO_TYPE)                                                 \
   V(SIGNATURE_INFO_TYPE)                                                       \
   V(TYPE_SWITCH_INFO_TYPE)                                                     \
+  V(ALLOCATION_SITE_TYPE)                                                      \
   V(ALLOCATION_SITE_INFO_TYPE)                                                 \
   V(SCRIPT_TYPE)                                                               \
   V(CODE_CACHE_TYPE)                                                           \
@@ -550,6 +551,7 @@ const int kStubMinorKeyBits = kBitsPerInt - kSmiTagSize - kStubMajorKeyBits;
   V(SIGNATURE_INFO, SignatureInfo, signature_info)                             \
   V(TYPE_SWITCH_INFO, TypeSwitchInfo, type_switch_info)                        \
   V(SCRIPT, Script, script)                                                    \
+  V(ALLOCATION_SITE, AllocationSite, allocation_site)                          \
   V(ALLOCATION_SITE_INFO, AllocationSiteInfo, allocation_site_info)            \
   V(CODE_CACHE, CodeCache, code_cache)                                         \
   V(POLYMORPHIC_CODE_CACHE, PolymorphicCodeCache, polymorphic_code_cache)      \
@@ -709,6 +711,7 @@ enum InstanceType {
   OBJECT_TEMPLATE_INFO_TYPE,
   SIGNATURE_INFO_TYPE,
   TYPE_SWITCH_INFO_TYPE,
+  ALLOCATION_SITE_TYPE,
   ALLOCATION_SITE_INFO_TYPE,
   SCRIPT_TYPE,
   CODE_CACHE_TYPE,
@@ -5042,7 +5045,10 @@ class DependentCode: public FixedArray {
     // Group of code that depends on global property values in property cells
     // not being changed.
     kPropertyCellChangedGroup,
-    kGroupCount = kPropertyCellChangedGroup + 1
+    // Group of code that allocates objects of an allocation site in the space
+    // given by the pretenuring decision of the site.
+    kAllocationSiteTenuringChangedGroup,
+    kGroupCount = kAllocationSiteTenuringChangedGroup + 1
   };
 
   // Array for holding the index of the first code object of each group.
@@ -5070,6 +5076,11 @@ class DependentCode: public FixedArray {
   void DeoptimizeDependentCodeGroup(Isolate* isolate,
                                     DependentCode::DependencyGroup group);
 
+  // Marks the code of the group for deoptimization and empties the group,
+  // without deoptimizing the code yet.  Returns false if the group was empty.
+  bool MarkCodeForDeoptimization(Isolate* isolate,
+                                 DependentCode::DependencyGroup group);
+
   // The following low-level accessors should only be used by this class
   // and the mark compact collector.
   inline int number_of_entries(DependencyGroup group);
@@ -7465,6 +7476,90 @@ enum AllocationSiteMode {
 };
 
 
+// An AllocationSite is created for each array literal and kept in the
+// literals array of the function in place of the boilerplate.  Objects
+// created at the site carry an AllocationSiteInfo pointing back to it, which
+// lets the scavenger count how many of them survive.  Sites whose objects
+// mostly survive are switched to allocate in old space.
+class AllocationSite: public Struct {
+ public:
+  enum PretenureDecision {
+    kUndecided = 0,
+    kDontTenure = 1,
+    kTenure = 2
+  };
+
+  // Number of mementos that have to be created at a site before its
+  // survival rate is trusted.
+  static const int kPretenureMinimumCreated = 100;
+  // Percentage of surviving objects above which a site is tenured.
+  static const int kPretenureSurvivalPercent = 85;
+
+  // [transition_info]: the boilerplate JSArray of the literal.
+  DECL_ACCESSORS(transition_info, Object)
+
+  // [memento_create_count]: mementos created since the last decision.
+  DECL_ACCESSORS(memento_create_count, Smi)
+
+  // [memento_found_count]: mementos the scavenger found behind surviving
+  // objects since the last decision.
+  DECL_ACCESSORS(memento_found_count, Smi)
+
+  // [pretenure_decision]: a PretenureDecision.
+  DECL_ACCESSORS(pretenure_decision, Smi)
+
+  // [dependent_code]: optimized code that allocates according to the
+  // pretenuring decision.
+  DECL_ACCESSORS(dependent_code, DependentCode)
+
+  // [weak_next]: linked list of all allocation sites.
+  DECL_ACCESSORS(weak_next, Object)
+
+  inline void Initialize();
+
+  inline PretenureFlag GetPretenureMode();
+  inline void IncrementMementoCreateCount();
+  // Called by the scavenger, possibly from several threads at once.
+  inline void IncrementMementoFoundCount();
+
+  // Decides whether to tenure the site once enough mementos were created.
+  // Returns true if the decision changed the space the objects of the site
+  // are allocated in.
+  bool DigestPretenuringFeedback();
+
+  // Makes a tenured site collect feedback in new space again.  Returns true
+  // if the site was tenured.
+  bool ResetPretenureDecision();
+
+  void AddDependentCompilationInfo(CompilationInfo* info);
+
+  static inline AllocationSite* cast(Object* obj);
+
+  DECLARE_PRINTER(AllocationSite)
+  DECLARE_VERIFIER(AllocationSite)
+
+  static const int kTransitionInfoOffset = HeapObject::kHeaderSize;
+  static const int kMementoCreateCountOffset =
+      kTransitionInfoOffset + kPointerSize;
+  static const int kMementoFoundCountOffset =
+      kMementoCreateCountOffset + kPointerSize;
+  static const int kPretenureDecisionOffset =
+      kMementoFoundCountOffset + kPointerSize;
+  static const int kDependentCodeOffset =
+      kPretenureDecisionOffset + kPointerSize;
+  static const int kWeakNextOffset = kDependentCodeOffset + kPointerSize;
+  static const int kSize = kWeakNextOffset + kPointerSize;
+
+  // The fields the marker visits strongly.  The dependent code is weak, and
+  // the list link is processed by Heap::ProcessWeakReferences.
+  static const int kPointerFieldsBeginOffset = kTransitionInfoOffset;
+  static const int kPointerFieldsEndOffset = kDependentCodeOffset;
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(AllocationSite);
+};
+
+
 class AllocationSiteInfo: public Struct {
  public:
   DECL_ACCESSORS(payload, Object)
@@ -7476,6 +7571,14 @@ class AllocationSiteInfo: public Struct {
 
   // Returns NULL if no AllocationSiteInfo is available for object.
   static AllocationSiteInfo* FindForJSObject(JSObject* object);
+
+  // The payload is the AllocationSite of an array literal, or the type
+  // feedback cell of an Array() call.
+  bool IsAllocationSite() { return payload()->IsAllocationSite(); }
+  AllocationSite* GetAllocationSite() {
+    return AllocationSite::cast(payload());
+  }
+
   static inline AllocationSiteMode GetMode(
       ElementsKind boilerplate_elements_kind);
   static inline AllocationSiteMode GetMode(ElementsKind from, ElementsKind to);
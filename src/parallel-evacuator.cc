@@ -0,0 +1,300 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "v8.h"
+
+#include "parallel-evacuator.h"
+
+#include "heap-profiler.h"
+#include "isolate.h"
+#include "store-buffer-inl.h"
+#include "sweeper-thread.h"
+
+namespace v8 {
+namespace internal {
+
+EvacuationTask::EvacuationTask(ParallelEvacuator* evacuator, Heap* heap)
+    : evacuator_(evacuator),
+      heap_(heap),
+      migration_slots_buffer_(NULL) {
+}
+
+
+EvacuationTask::~EvacuationTask() {
+  ASSERT(migration_slots_buffer_ == NULL);
+}
+
+
+HeapObject* EvacuationTask::Allocate(PagedSpace* space, int size) {
+  if (size <= kMaxBufferedObjectSize) {
+    AllocationInfo* buffer = buffer_for(space->identity());
+    if (buffer->limit - buffer->top >= size || RefillBuffer(space)) {
+      Address result = buffer->top;
+      buffer->top += size;
+      return HeapObject::FromAddress(result);
+    }
+  }
+
+  ScopedLock lock(evacuator_->allocation_mutex());
+  Object* result;
+  MaybeObject* maybe_result = space->AllocateRaw(size);
+  if (!maybe_result->ToObject(&result)) {
+    // OS refused to give us memory.
+    V8::FatalProcessOutOfMemory("Evacuation");
+  }
+  return HeapObject::cast(result);
+}
+
+
+bool EvacuationTask::RefillBuffer(PagedSpace* space) {
+  AllocationInfo* buffer = buffer_for(space->identity());
+  ScopedLock lock(evacuator_->allocation_mutex());
+  ReleaseBuffer(space);
+
+  Object* result;
+  MaybeObject* maybe_result = space->AllocateRaw(kBufferSize);
+  if (!maybe_result->ToObject(&result)) return false;
+  buffer->top = HeapObject::cast(result)->address();
+  buffer->limit = buffer->top + kBufferSize;
+  return true;
+}
+
+
+// Must be called with the allocation mutex held.
+void EvacuationTask::ReleaseBuffer(PagedSpace* space) {
+  AllocationInfo* buffer = buffer_for(space->identity());
+  int size = static_cast<int>(buffer->limit - buffer->top);
+  if (size > 0) space->Free(buffer->top, size);
+  buffer->top = buffer->limit = NULL;
+}
+
+
+void EvacuationTask::ReleaseBuffers() {
+  ScopedLock lock(evacuator_->allocation_mutex());
+  ReleaseBuffer(heap_->old_pointer_space());
+  ReleaseBuffer(heap_->old_data_space());
+}
+
+
+void EvacuationTask::FlushRecordedSlots(StoreBuffer* store_buffer) {
+  for (int i = 0; i < new_space_slots_.length(); i++) {
+    store_buffer->Mark(new_space_slots_[i]);
+  }
+  new_space_slots_.Rewind(0);
+}
+
+
+ParallelEvacuator::ParallelEvacuator(Heap* heap, int number_of_tasks)
+    : heap_(heap),
+      number_of_tasks_(number_of_tasks),
+      tasks_(new EvacuationTask*[number_of_tasks]),
+      allocation_mutex_(OS::CreateMutex()),
+      phase_(EVACUATE_PAGES),
+      code_slots_filtering_required_(false) {
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i] = new EvacuationTask(this, heap);
+  }
+  NoBarrier_Store(&next_page_, 0);
+}
+
+
+ParallelEvacuator::~ParallelEvacuator() {
+  for (int i = 0; i < number_of_tasks_; i++) {
+    delete tasks_[i];
+  }
+  delete[] tasks_;
+  delete allocation_mutex_;
+}
+
+
+// The allocation buffers of the tasks can leave parts of pages unused, so
+// room for a page per candidate and per task is required up front.
+static bool HasRoomForEvacuation(PagedSpace* space, int pages) {
+  if (pages == 0) return true;
+  return space->Capacity() + pages * Page::kPageSize <= space->MaxCapacity();
+}
+
+
+bool ParallelEvacuator::CanEvacuateInParallel(List<Page*>* candidates) {
+  if (heap_->mark_compact_collector()->IsConcurrentSweepingInProgress()) {
+    return false;
+  }
+  HeapProfiler* profiler = heap_->isolate()->heap_profiler();
+  if (profiler != NULL && profiler->is_profiling()) return false;
+  if (FLAG_trace_internals) return false;
+
+  int old_pointer_pages = 0;
+  int old_data_pages = 0;
+  int code_pages = 0;
+  for (int i = 0; i < candidates->length(); i++) {
+    Page* p = candidates->at(i);
+    if (!p->IsEvacuationCandidate()) continue;
+    switch (p->owner()->identity()) {
+      case OLD_POINTER_SPACE:
+        old_pointer_pages++;
+        break;
+      case OLD_DATA_SPACE:
+        old_data_pages++;
+        break;
+      case CODE_SPACE:
+        code_pages++;
+        break;
+      default:
+        UNREACHABLE();
+        break;
+    }
+  }
+  if (old_pointer_pages + old_data_pages == 0) return false;
+
+  return HasRoomForEvacuation(heap_->old_pointer_space(),
+                              old_pointer_pages + number_of_tasks_) &&
+      HasRoomForEvacuation(heap_->old_data_space(),
+                           old_data_pages + number_of_tasks_) &&
+      HasRoomForEvacuation(heap_->code_space(), code_pages);
+}
+
+
+void ParallelEvacuator::EvacuatePages(List<Page*>* candidates) {
+  MarkCompactCollector* collector = heap_->mark_compact_collector();
+  ASSERT(pages_.is_empty() && code_pages_.is_empty());
+  for (int i = 0; i < candidates->length(); i++) {
+    Page* p = candidates->at(i);
+    ASSERT(p->IsEvacuationCandidate() ||
+           p->IsFlagSet(Page::RESCAN_ON_EVACUATION));
+    if (!p->IsEvacuationCandidate()) continue;
+    if (p->owner()->identity() == CODE_SPACE) {
+      // The code space is not protected by the allocation mutex, evacuate
+      // code before the other tasks start allocating.
+      AlwaysAllocateScope always_allocate;
+      collector->EvacuateLiveObjectsFromPage(p, NULL);
+      code_pages_.Add(p);
+    } else {
+      pages_.Add(p);
+    }
+  }
+
+  { AlwaysAllocateScope always_allocate;
+    Run(EVACUATE_PAGES);
+  }
+
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i]->ReleaseBuffers();
+    tasks_[i]->FlushRecordedSlots(heap_->store_buffer());
+  }
+}
+
+
+void ParallelEvacuator::UpdatePointersToEvacuated(
+    bool code_slots_filtering_required) {
+  code_slots_filtering_required_ = code_slots_filtering_required;
+  Run(UPDATE_POINTERS);
+
+  for (int i = 0; i < pages_.length(); i++) {
+    SlotsBuffer::UpdateSlotsRecordedIn(heap_,
+                                       pages_[i]->slots_buffer(),
+                                       code_slots_filtering_required,
+                                       SlotsBuffer::TYPED_SLOTS);
+  }
+
+  SlotsBufferAllocator* allocator =
+      &heap_->mark_compact_collector()->slots_buffer_allocator_;
+  for (int i = 0; i < number_of_tasks_; i++) {
+    SlotsBuffer::UpdateSlotsRecordedIn(heap_,
+                                       tasks_[i]->migration_slots_buffer(),
+                                       code_slots_filtering_required,
+                                       SlotsBuffer::TYPED_SLOTS);
+    allocator->DeallocateChain(tasks_[i]->migration_slots_buffer_address());
+  }
+
+  pages_.Rewind(0);
+  code_pages_.Rewind(0);
+}
+
+
+void ParallelEvacuator::Run(Phase phase) {
+  phase_ = phase;
+  NoBarrier_Store(&next_page_, 0);
+
+  SweeperThread** threads = heap_->isolate()->sweeper_threads();
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads[i - 1]->StartEvacuating();
+  }
+
+  if (phase == UPDATE_POINTERS) {
+    // Slots pointing to code are updated while the other tasks update the
+    // untyped slots pointing to the old pointer and old data spaces.
+    for (int i = 0; i < code_pages_.length(); i++) {
+      SlotsBuffer::UpdateSlotsRecordedIn(heap_,
+                                         code_pages_[i]->slots_buffer(),
+                                         code_slots_filtering_required_);
+    }
+  }
+  Process(0);
+
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads[i - 1]->WaitForSweeperThread();
+  }
+}
+
+
+void ParallelEvacuator::ProcessInParallel(int id) {
+  ASSERT(id > 0 && id < number_of_tasks_);
+  Process(id);
+}
+
+
+void ParallelEvacuator::Process(int id) {
+  EvacuationTask* task = tasks_[id];
+  if (phase_ == EVACUATE_PAGES) {
+    MarkCompactCollector* collector = heap_->mark_compact_collector();
+    for (Page* p = NextPage(); p != NULL; p = NextPage()) {
+      collector->EvacuateLiveObjectsFromPage(p, task);
+    }
+  } else {
+    ASSERT(phase_ == UPDATE_POINTERS);
+    SlotsBuffer::UpdateSlotsRecordedIn(heap_,
+                                       task->migration_slots_buffer(),
+                                       code_slots_filtering_required_,
+                                       SlotsBuffer::UNTYPED_SLOTS);
+    for (Page* p = NextPage(); p != NULL; p = NextPage()) {
+      SlotsBuffer::UpdateSlotsRecordedIn(heap_,
+                                         p->slots_buffer(),
+                                         code_slots_filtering_required_,
+                                         SlotsBuffer::UNTYPED_SLOTS);
+    }
+  }
+}
+
+
+Page* ParallelEvacuator::NextPage() {
+  AtomicWord index = NoBarrier_AtomicIncrement(&next_page_, 1) - 1;
+  if (index >= pages_.length()) return NULL;
+  return pages_[static_cast<int>(index)];
+}
+
+} }  // namespace v8::internal
@@ -0,0 +1,159 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_PARALLEL_EVACUATOR_H_
+#define V8_PARALLEL_EVACUATOR_H_
+
+#include "atomicops.h"
+#include "list.h"
+#include "platform.h"
+
+#include "mark-compact.h"
+#include "spaces.h"
+
+namespace v8 {
+namespace internal {
+
+class ParallelEvacuator;
+
+// The state of one thread taking part in a parallel evacuation: its
+// compaction allocation buffers in the old spaces and the slots it found
+// in the objects it moved.
+class EvacuationTask {
+ public:
+  EvacuationTask(ParallelEvacuator* evacuator, Heap* heap);
+  ~EvacuationTask();
+
+  // Allocates size bytes for an object moved out of an old pointer or old
+  // data space evacuation candidate.
+  HeapObject* Allocate(PagedSpace* space, int size);
+
+  // Gives back the unused parts of the allocation buffers.
+  void ReleaseBuffers();
+
+  // Enters the recorded old-to-new slots into the store buffer.  Must be
+  // called from the main thread.
+  void FlushRecordedSlots(StoreBuffer* store_buffer);
+
+  SlotsBuffer* migration_slots_buffer() { return migration_slots_buffer_; }
+  SlotsBuffer** migration_slots_buffer_address() {
+    return &migration_slots_buffer_;
+  }
+  List<Address>* new_space_slots() { return &new_space_slots_; }
+
+ private:
+  static const int kBufferSize = 32 * KB;
+  // Larger objects are allocated directly in the spaces.
+  static const int kMaxBufferedObjectSize = kBufferSize / 4;
+
+  bool RefillBuffer(PagedSpace* space);
+  void ReleaseBuffer(PagedSpace* space);
+
+  AllocationInfo* buffer_for(AllocationSpace space) {
+    if (space == OLD_DATA_SPACE) return &old_data_buffer_;
+    ASSERT(space == OLD_POINTER_SPACE);
+    return &old_pointer_buffer_;
+  }
+
+  ParallelEvacuator* evacuator_;
+  Heap* heap_;
+
+  AllocationInfo old_pointer_buffer_;
+  AllocationInfo old_data_buffer_;
+
+  // Slots of moved objects that point to evacuation candidates.
+  SlotsBuffer* migration_slots_buffer_;
+  // Slots of moved objects that point to new space.
+  List<Address> new_space_slots_;
+
+  DISALLOW_COPY_AND_ASSIGN(EvacuationTask);
+};
+
+
+// Evacuates the candidate pages of the old pointer and old data spaces and
+// updates the slots recorded for all candidates with the main thread and
+// the sweeper threads.  Code space candidates are left to the main thread,
+// moving code has to be reported to the profilers and relocated.
+class ParallelEvacuator {
+ public:
+  // number_of_tasks includes the main thread.
+  ParallelEvacuator(Heap* heap, int number_of_tasks);
+  ~ParallelEvacuator();
+
+  // Returns false if the candidates have to be evacuated by the main thread
+  // alone: the sweeper threads are busy, object moves are being logged, or
+  // a space might run out of room before all its candidates are evacuated.
+  bool CanEvacuateInParallel(List<Page*>* candidates);
+
+  void EvacuatePages(List<Page*>* candidates);
+
+  // Updates the slots recorded in the pages evacuated by EvacuatePages and
+  // in the objects moved by the tasks.  Typed slots may lie at unaligned
+  // addresses inside code and are updated by the main thread alone.
+  void UpdatePointersToEvacuated(bool code_slots_filtering_required);
+
+  // Called by the sweeper thread with the given id.
+  void ProcessInParallel(int id);
+
+  Mutex* allocation_mutex() { return allocation_mutex_; }
+
+ private:
+  enum Phase {
+    EVACUATE_PAGES,
+    UPDATE_POINTERS
+  };
+
+  // Runs phase over pages_ with the main thread as task 0 and the sweeper
+  // threads as the remaining tasks.  The main thread first updates the
+  // slots recorded in code_pages_.
+  void Run(Phase phase);
+
+  void Process(int id);
+
+  // Returns the next page of the current phase, or NULL if all pages have
+  // been taken.
+  Page* NextPage();
+
+  Heap* heap_;
+  int number_of_tasks_;
+  EvacuationTask** tasks_;
+
+  // Protects the spaces while tasks refill their allocation buffers.
+  Mutex* allocation_mutex_;
+
+  Phase phase_;
+  bool code_slots_filtering_required_;
+  List<Page*> pages_;
+  List<Page*> code_pages_;
+  volatile AtomicWord next_page_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelEvacuator);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_PARALLEL_EVACUATOR_H_
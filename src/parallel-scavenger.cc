@@ -0,0 +1,614 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "v8.h"
+
+#include "parallel-scavenger.h"
+
+#include "code-stubs.h"
+#include "isolate.h"
+#include "objects-visiting.h"
+#include "objects-visiting-inl.h"
+#include "scavenger-thread.h"
+#include "store-buffer-inl.h"
+
+namespace v8 {
+namespace internal {
+
+// Visits the bodies of objects copied to to space by a scavenging task.
+class ParallelNewSpaceScavenger
+    : public StaticNewSpaceVisitor<ParallelNewSpaceScavenger> {
+ public:
+  static inline void VisitPointer(Heap* heap, Object** p) {
+    Object* object = *p;
+    if (!heap->InNewSpace(object)) return;
+    ParallelScavenger::ScavengeObject(reinterpret_cast<HeapObject**>(p),
+                                      reinterpret_cast<HeapObject*>(object));
+  }
+};
+
+
+Thread::LocalStorageKey ParallelScavenger::task_key_;
+VisitorDispatchTable<ScavengingCallback> ParallelScavenger::table_;
+
+
+ScavengeTask::ScavengeTask(ParallelScavenger* scavenger, Heap* heap)
+    : scavenger_(scavenger),
+      heap_(heap),
+      push_segment_(new ScavengeSegment()),
+      pop_segment_(new ScavengeSegment()),
+      recorded_slots_(0),
+      promoted_bytes_(0) {
+}
+
+
+ScavengeTask::~ScavengeTask() {
+  delete push_segment_;
+  delete pop_segment_;
+}
+
+
+void ScavengeTask::Push(HeapObject* object) {
+  if (push_segment_->IsFull()) {
+    scavenger_->PublishSegment(push_segment_);
+    push_segment_ = new ScavengeSegment();
+  }
+  push_segment_->objects[push_segment_->size++] = object;
+}
+
+
+bool ScavengeTask::Pop(HeapObject** object) {
+  if (pop_segment_->IsEmpty()) {
+    if (!push_segment_->IsEmpty()) {
+      ScavengeSegment* segment = pop_segment_;
+      pop_segment_ = push_segment_;
+      push_segment_ = segment;
+    } else {
+      ScavengeSegment* segment = scavenger_->StealSegment();
+      if (segment == NULL) return false;
+      delete pop_segment_;
+      pop_segment_ = segment;
+    }
+  }
+  *object = pop_segment_->objects[--pop_segment_->size];
+  return true;
+}
+
+
+void ScavengeTask::PublishWork() {
+  if (!push_segment_->IsEmpty()) {
+    scavenger_->PublishSegment(push_segment_);
+    push_segment_ = new ScavengeSegment();
+  }
+  if (!pop_segment_->IsEmpty()) {
+    scavenger_->PublishSegment(pop_segment_);
+    pop_segment_ = new ScavengeSegment();
+  }
+}
+
+
+void ScavengeTask::ProcessWorklist() {
+  while (true) {
+    HeapObject* object;
+    while (Pop(&object)) ScanObject(object);
+
+    ScavengeSegment* segment = scavenger_->WaitForSegment();
+    if (segment == NULL) break;
+    delete pop_segment_;
+    pop_segment_ = segment;
+  }
+  ASSERT(push_segment_->IsEmpty() && pop_segment_->IsEmpty());
+}
+
+
+void ScavengeTask::ScanObject(HeapObject* object) {
+  Map* map = object->map();
+  if (heap_->InNewSpace(object)) {
+    ParallelNewSpaceScavenger::IterateBody(map, object);
+  } else if (map->instance_type() == JS_FUNCTION_TYPE) {
+    // The weak fields of promoted functions are left to
+    // ProcessWeakReferences, as in Heap::DoScavenge.
+    ScanPromotedObject(object, JSFunction::kNonWeakFieldsEndOffset);
+  } else {
+    ScanPromotedObject(object, object->SizeFromMap(map));
+  }
+}
+
+
+void ScavengeTask::ScanPromotedObject(HeapObject* object, int size) {
+  Address end = object->address() + size;
+  for (Address slot_address = object->address();
+       slot_address < end;
+       slot_address += kPointerSize) {
+    Object** slot = reinterpret_cast<Object**>(slot_address);
+    Object* value = *slot;
+    // The map word and untagged fields are never pointers into from space.
+    if (!value->IsHeapObject() || !heap_->InFromSpace(value)) continue;
+    ParallelScavenger::ScavengeObject(reinterpret_cast<HeapObject**>(slot),
+                                      HeapObject::cast(value));
+    if (heap_->InNewSpace(*slot)) recorded_slots_.Add(slot_address);
+  }
+}
+
+
+void ScavengeTask::ProcessStoreBufferSlice(StoreBufferSlice* slice) {
+  int recorded_before = recorded_slots_.length();
+  if (slice->chunk == NULL) {
+    for (Address* entry = slice->entries_start;
+         entry < slice->entries_end;
+         entry++) {
+      ScavengeOldToNewSlot(*entry);
+    }
+  } else {
+    for (Address slot_address = slice->region_start;
+         slot_address < slice->region_end;
+         slot_address += kPointerSize) {
+      ScavengeOldToNewSlot(slot_address);
+    }
+  }
+  slice->recorded_slots = recorded_slots_.length() - recorded_before;
+}
+
+
+void ScavengeTask::ScavengeOldToNewSlot(Address slot_address) {
+  volatile AtomicWord* slot =
+      reinterpret_cast<volatile AtomicWord*>(slot_address);
+  AtomicWord old_value = NoBarrier_Load(slot);
+  Object* value = reinterpret_cast<Object*>(old_value);
+  // Duplicate entries are skipped once another task has updated the slot.
+  if (!value->IsHeapObject() || !heap_->InFromSpace(value)) return;
+
+  HeapObject* target = HeapObject::cast(value);
+  ParallelScavenger::ScavengeObject(&target, target);
+
+  // A stale entry may lie in memory where another task has just copied a
+  // promoted object.  That task scans the copy itself, so the slot is only
+  // updated if it still holds the old value.
+  if (Release_CompareAndSwap(slot,
+                             old_value,
+                             reinterpret_cast<AtomicWord>(target)) !=
+      old_value) {
+    return;
+  }
+  if (heap_->InNewSpace(target)) recorded_slots_.Add(slot_address);
+}
+
+
+void ScavengeTask::EvacuateObject(Map* map,
+                                  HeapObject** slot,
+                                  HeapObject* object) {
+  int object_size = object->SizeFromMap(map);
+  InstanceType type = map->instance_type();
+  AllocationSpace target_space = heap_->TargetSpaceId(type);
+
+  int allocation_size = object_size;
+  bool double_align = (kDoubleAlignment != kObjectAlignment) &&
+      (type == FIXED_DOUBLE_ARRAY_TYPE);
+  if (double_align) allocation_size += kPointerSize;
+
+  HeapObject* allocation = NULL;
+  AllocationSpace space = target_space;
+  if (scavenger_->ShouldBePromoted(object->address())) {
+    allocation = AllocateInOldSpace(target_space, allocation_size);
+  }
+  if (allocation == NULL) {
+    space = NEW_SPACE;
+    allocation = AllocateInToSpace(allocation_size);
+  }
+  if (allocation == NULL) {
+    // Fragmentation by the allocation buffers can use up to space before
+    // every survivor has been copied, fall back to promotion.
+    space = target_space;
+    allocation = AllocateInOldSpace(target_space, allocation_size);
+    if (allocation == NULL) {
+      V8::FatalProcessOutOfMemory("ParallelScavenger::EvacuateObject");
+    }
+  }
+
+  HeapObject* target = allocation;
+  if (double_align) {
+    if ((OffsetFrom(allocation->address()) & kDoubleAlignmentMask) != 0) {
+      heap_->CreateFillerObjectAt(allocation->address(), kPointerSize);
+      target = HeapObject::FromAddress(allocation->address() + kPointerSize);
+    } else {
+      heap_->CreateFillerObjectAt(
+          allocation->address() + allocation_size - kPointerSize,
+          kPointerSize);
+    }
+  }
+
+  // The copy is private to this task until the forwarding address is
+  // installed.  The map word of object may be overwritten concurrently,
+  // so the map of the copy is set explicitly.
+  heap_->CopyBlock(target->address(), object->address(), object_size);
+  target->set_map_word(MapWord::FromMap(map));
+
+  AtomicWord old_value = Release_CompareAndSwap(
+      reinterpret_cast<volatile AtomicWord*>(object->address()),
+      static_cast<AtomicWord>(MapWord::FromMap(map).ToRawValue()),
+      static_cast<AtomicWord>(
+          MapWord::FromForwardingAddress(target).ToRawValue()));
+  if (old_value !=
+      static_cast<AtomicWord>(MapWord::FromMap(map).ToRawValue())) {
+    // Another task copied the object first.
+    FreeAllocation(allocation->address(), allocation_size, space);
+    *slot = MapWord::FromRawValue(static_cast<uintptr_t>(old_value)).
+        ToForwardingAddress();
+    return;
+  }
+
+  if (FLAG_allocation_site_pretenuring) {
+    heap_->UpdateAllocationSiteFeedback(map, object);
+  }
+
+  // A slot from the store buffer may lie inside the target if the target was
+  // allocated over a dead object.  The copy has already overwritten it, as
+  // the serial scavenger does.
+  Address slot_address = reinterpret_cast<Address>(slot);
+  if (slot_address < allocation->address() ||
+      slot_address >= allocation->address() + allocation_size) {
+    *slot = target;
+  }
+
+  if (space != NEW_SPACE) promoted_bytes_ += object_size;
+  if (target_space == OLD_POINTER_SPACE) Push(target);
+}
+
+
+HeapObject* ScavengeTask::AllocateInToSpace(int size) {
+  if (size <= kMaxBufferedObjectSize) {
+    LocalAllocationBuffer* buffer = &to_space_buffer_;
+    if (buffer->limit - buffer->top < size && !RefillToSpaceBuffer()) {
+      return NULL;
+    }
+    Address result = buffer->top;
+    buffer->top += size;
+    return HeapObject::FromAddress(result);
+  }
+
+  ScopedLock lock(scavenger_->allocation_mutex());
+  Object* result;
+  MaybeObject* maybe_result = heap_->new_space()->AllocateRaw(size);
+  scavenger_->UpdateToSpaceFull();
+  if (!maybe_result->ToObject(&result)) return NULL;
+  return HeapObject::cast(result);
+}
+
+
+bool ScavengeTask::RefillToSpaceBuffer() {
+  LocalAllocationBuffer* buffer = &to_space_buffer_;
+  ScopedLock lock(scavenger_->allocation_mutex());
+  heap_->CreateFillerObjectAt(buffer->top,
+                              static_cast<int>(buffer->limit - buffer->top));
+  buffer->top = buffer->limit = NULL;
+
+  Object* result;
+  MaybeObject* maybe_result = heap_->new_space()->AllocateRaw(kBufferSize);
+  scavenger_->UpdateToSpaceFull();
+  if (!maybe_result->ToObject(&result)) return false;
+  buffer->top = HeapObject::cast(result)->address();
+  buffer->limit = buffer->top + kBufferSize;
+  return true;
+}
+
+
+HeapObject* ScavengeTask::AllocateInOldSpace(AllocationSpace space,
+                                             int size) {
+  if (size <= kMaxBufferedObjectSize) {
+    LocalAllocationBuffer* buffer = buffer_for(space);
+    if (buffer->limit - buffer->top < size && !RefillOldSpaceBuffer(space)) {
+      return NULL;
+    }
+    Address result = buffer->top;
+    buffer->top += size;
+    // The pages of the old spaces may be iterated while the roots are
+    // scavenged, keep the rest of the buffer iterable.
+    heap_->CreateFillerObjectAt(buffer->top,
+                                static_cast<int>(buffer->limit - buffer->top));
+    return HeapObject::FromAddress(result);
+  }
+
+  ScopedLock lock(scavenger_->allocation_mutex());
+  Object* result;
+  MaybeObject* maybe_result;
+  if (size > Page::kMaxNonCodeHeapObjectSize) {
+    maybe_result = heap_->lo_space()->AllocateRaw(size, NOT_EXECUTABLE);
+  } else {
+    maybe_result = heap_->paged_space(space)->AllocateRaw(size);
+  }
+  if (!maybe_result->ToObject(&result)) return NULL;
+  return HeapObject::cast(result);
+}
+
+
+bool ScavengeTask::RefillOldSpaceBuffer(AllocationSpace space) {
+  LocalAllocationBuffer* buffer = buffer_for(space);
+  ScopedLock lock(scavenger_->allocation_mutex());
+  ReleaseOldSpaceBuffer(space);
+
+  Object* result;
+  MaybeObject* maybe_result =
+      heap_->paged_space(space)->AllocateRaw(kBufferSize);
+  if (!maybe_result->ToObject(&result)) return false;
+  buffer->top = HeapObject::cast(result)->address();
+  buffer->limit = buffer->top + kBufferSize;
+  heap_->CreateFillerObjectAt(buffer->top, kBufferSize);
+  return true;
+}
+
+
+// Must be called with the allocation mutex held.
+void ScavengeTask::ReleaseOldSpaceBuffer(AllocationSpace space) {
+  LocalAllocationBuffer* buffer = buffer_for(space);
+  int size = static_cast<int>(buffer->limit - buffer->top);
+  if (size > 0) heap_->paged_space(space)->Free(buffer->top, size);
+  buffer->top = buffer->limit = NULL;
+}
+
+
+void ScavengeTask::FreeAllocation(Address start,
+                                  int size,
+                                  AllocationSpace space) {
+  if (size <= kMaxBufferedObjectSize) {
+    // The allocation is still the last one in its buffer.
+    LocalAllocationBuffer* buffer = buffer_for(space);
+    ASSERT(buffer->top == start + size);
+    buffer->top = start;
+    if (space != NEW_SPACE) {
+      heap_->CreateFillerObjectAt(
+          buffer->top, static_cast<int>(buffer->limit - buffer->top));
+    }
+  } else if (space != NEW_SPACE && size <= Page::kMaxNonCodeHeapObjectSize) {
+    ScopedLock lock(scavenger_->allocation_mutex());
+    heap_->paged_space(space)->Free(start, size);
+  } else {
+    // To space and large object pages are not reused during the scavenge.
+    heap_->CreateFillerObjectAt(start, size);
+  }
+}
+
+
+void ScavengeTask::ReleaseBuffers() {
+  heap_->CreateFillerObjectAt(
+      to_space_buffer_.top,
+      static_cast<int>(to_space_buffer_.limit - to_space_buffer_.top));
+  to_space_buffer_.top = to_space_buffer_.limit = NULL;
+
+  ScopedLock lock(scavenger_->allocation_mutex());
+  ReleaseOldSpaceBuffer(OLD_POINTER_SPACE);
+  ReleaseOldSpaceBuffer(OLD_DATA_SPACE);
+}
+
+
+void ScavengeTask::FlushRecordedSlots(StoreBuffer* store_buffer) {
+  for (int i = 0; i < recorded_slots_.length(); i++) {
+    store_buffer->EnterDirectlyIntoStoreBuffer(recorded_slots_[i]);
+  }
+  recorded_slots_.Rewind(0);
+}
+
+
+ParallelScavenger::ParallelScavenger(Heap* heap, int number_of_tasks)
+    : heap_(heap),
+      number_of_tasks_(number_of_tasks),
+      tasks_(new ScavengeTask*[number_of_tasks]),
+      allocation_mutex_(OS::CreateMutex()),
+      pool_mutex_(OS::CreateMutex()),
+      pool_(NULL),
+      phase_(PROCESS_WORKLISTS),
+      store_buffer_slices_(NULL) {
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i] = new ScavengeTask(this, heap);
+  }
+  NoBarrier_Store(&pool_size_, 0);
+  NoBarrier_Store(&idle_tasks_, 0);
+  NoBarrier_Store(&to_space_full_, 0);
+  NoBarrier_Store(&next_store_buffer_slice_, 0);
+}
+
+
+ParallelScavenger::~ParallelScavenger() {
+  ASSERT(pool_ == NULL);
+  for (int i = 0; i < number_of_tasks_; i++) {
+    delete tasks_[i];
+  }
+  delete[] tasks_;
+  delete pool_mutex_;
+  delete allocation_mutex_;
+}
+
+
+void ParallelScavenger::Initialize() {
+  task_key_ = Thread::CreateThreadLocalKey();
+  for (int i = 0; i < StaticVisitorBase::kVisitorIdCount; i++) {
+    table_.Register(static_cast<StaticVisitorBase::VisitorId>(i),
+                    &EvacuateObject);
+  }
+  ParallelNewSpaceScavenger::Initialize();
+}
+
+
+void ParallelScavenger::EvacuateObject(Map* map,
+                                       HeapObject** slot,
+                                       HeapObject* object) {
+  current_task()->EvacuateObject(map, slot, object);
+}
+
+
+void ParallelScavenger::Prepare() {
+  NoBarrier_Store(&to_space_full_, 0);
+  Thread::SetThreadLocal(task_key_, tasks_[0]);
+}
+
+
+void ParallelScavenger::ProcessWorklists() {
+  tasks_[0]->PublishWork();
+  NoBarrier_Store(&idle_tasks_, 0);
+
+  ScavengerThread** threads = heap_->isolate()->scavenger_threads();
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads[i - 1]->StartScavenging();
+  }
+  tasks_[0]->ProcessWorklist();
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads[i - 1]->WaitForScavengerThread();
+  }
+
+  ASSERT(pool_ == NULL);
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i]->ReleaseBuffers();
+  }
+}
+
+
+void ParallelScavenger::ProcessStoreBuffer(List<StoreBufferSlice>* slices) {
+  store_buffer_slices_ = slices;
+  NoBarrier_Store(&next_store_buffer_slice_, 0);
+  phase_ = PROCESS_STORE_BUFFER;
+
+  ScavengerThread** threads = heap_->isolate()->scavenger_threads();
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads[i - 1]->StartScavenging();
+  }
+  ProcessStoreBufferSlices(tasks_[0]);
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads[i - 1]->WaitForScavengerThread();
+  }
+
+  phase_ = PROCESS_WORKLISTS;
+  store_buffer_slices_ = NULL;
+}
+
+
+void ParallelScavenger::ProcessStoreBufferSlices(ScavengeTask* task) {
+  List<StoreBufferSlice>* slices = store_buffer_slices_;
+  while (true) {
+    int index = Barrier_AtomicIncrement(&next_store_buffer_slice_, 1) - 1;
+    if (index >= slices->length()) return;
+    task->ProcessStoreBufferSlice(&slices->at(index));
+  }
+}
+
+
+void ParallelScavenger::StartStoreBufferDeduplication() {
+  ASSERT(phase_ == PROCESS_WORKLISTS);
+  phase_ = DEDUPLICATE_STORE_BUFFER;
+  heap_->isolate()->scavenger_threads()[0]->StartScavenging();
+}
+
+
+void ParallelScavenger::WaitForStoreBufferDeduplication() {
+  ASSERT(phase_ == DEDUPLICATE_STORE_BUFFER);
+  heap_->isolate()->scavenger_threads()[0]->WaitForScavengerThread();
+  phase_ = PROCESS_WORKLISTS;
+}
+
+
+void ParallelScavenger::ScavengeInParallel(int id) {
+  ASSERT(id > 0 && id < number_of_tasks_);
+  if (phase_ == DEDUPLICATE_STORE_BUFFER) {
+    ASSERT(id == 1);
+    heap_->store_buffer()->Deduplicate();
+    return;
+  }
+  Thread::SetThreadLocal(task_key_, tasks_[id]);
+  if (phase_ == PROCESS_STORE_BUFFER) {
+    ProcessStoreBufferSlices(tasks_[id]);
+  } else {
+    tasks_[id]->ProcessWorklist();
+  }
+  Thread::SetThreadLocal(task_key_, NULL);
+}
+
+
+void ParallelScavenger::FlushRecordedSlots() {
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i]->FlushRecordedSlots(heap_->store_buffer());
+  }
+}
+
+
+void ParallelScavenger::Finish() {
+  for (int i = 0; i < number_of_tasks_; i++) {
+    heap_->tracer()->increment_promoted_objects_size(
+        tasks_[i]->promoted_bytes());
+    tasks_[i]->clear_promoted_bytes();
+  }
+  Thread::SetThreadLocal(task_key_, NULL);
+}
+
+
+// Must be called with the allocation mutex held.
+void ParallelScavenger::UpdateToSpaceFull() {
+  NewSpace* new_space = heap_->new_space();
+  if (new_space->Size() >= (new_space->EffectiveCapacity() >> 2)) {
+    Release_Store(&to_space_full_, 1);
+  }
+}
+
+
+void ParallelScavenger::PublishSegment(ScavengeSegment* segment) {
+  ScopedLock lock(pool_mutex_);
+  segment->next = pool_;
+  pool_ = segment;
+  Release_Store(&pool_size_, Acquire_Load(&pool_size_) + 1);
+}
+
+
+ScavengeSegment* ParallelScavenger::StealSegment() {
+  if (Acquire_Load(&pool_size_) == 0) return NULL;
+  ScopedLock lock(pool_mutex_);
+  ScavengeSegment* segment = pool_;
+  if (segment != NULL) {
+    pool_ = segment->next;
+    segment->next = NULL;
+    Release_Store(&pool_size_, Acquire_Load(&pool_size_) - 1);
+  }
+  return segment;
+}
+
+
+ScavengeSegment* ParallelScavenger::WaitForSegment() {
+  // A task only publishes segments while it is busy, and it drains the pool
+  // before it becomes idle itself.  So no work is left once every task has
+  // been seen idle with an empty pool.
+  Barrier_AtomicIncrement(&idle_tasks_, 1);
+  while (true) {
+    if (Acquire_Load(&pool_size_) > 0) {
+      Barrier_AtomicIncrement(&idle_tasks_, -1);
+      ScavengeSegment* segment = StealSegment();
+      if (segment != NULL) return segment;
+      Barrier_AtomicIncrement(&idle_tasks_, 1);
+    } else if (Acquire_Load(&idle_tasks_) == number_of_tasks_) {
+      return NULL;
+    }
+    Thread::YieldCPU();
+  }
+}
+
+} }  // namespace v8::internal
@@ -0,0 +1,272 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef V8_PARALLEL_SCAVENGER_H_
+#define V8_PARALLEL_SCAVENGER_H_
+
+#include "atomicops.h"
+#include "list.h"
+#include "platform.h"
+
+#include "heap.h"
+
+namespace v8 {
+namespace internal {
+
+class ParallelScavenger;
+
+// A fixed size block of objects that still have to be scanned.  Tasks push
+// and pop objects in private segments and exchange whole segments through
+// the global pool of the ParallelScavenger.
+struct ScavengeSegment {
+  static const int kCapacity = 64;
+
+  ScavengeSegment() : next(NULL), size(0) { }
+
+  bool IsEmpty() { return size == 0; }
+  bool IsFull() { return size == kCapacity; }
+
+  ScavengeSegment* next;
+  int size;
+  HeapObject* objects[kCapacity];
+};
+
+
+// Bump pointer allocation area private to one scavenging task.
+struct LocalAllocationBuffer {
+  LocalAllocationBuffer() : top(NULL), limit(NULL) { }
+
+  Address top;
+  Address limit;
+};
+
+
+// The state of one thread taking part in a parallel scavenge: its local
+// work list, its local allocation buffers in to space and in the old
+// spaces, and the old-to-new slots it found in promoted objects.
+class ScavengeTask {
+ public:
+  ScavengeTask(ParallelScavenger* scavenger, Heap* heap);
+  ~ScavengeTask();
+
+  // Copies object to to space or promotes it, and updates slot.
+  void EvacuateObject(Map* map, HeapObject** slot, HeapObject* object);
+
+  // Scans the copied objects until there is no work left for any task.
+  void ProcessWorklist();
+
+  // Scavenges the objects referenced from the slots of slice and records
+  // the slots that still point to new space.
+  void ProcessStoreBufferSlice(StoreBufferSlice* slice);
+
+  // Makes the unscanned objects of this task available to the others.
+  void PublishWork();
+
+  // Gives back the unused parts of the local allocation buffers.
+  void ReleaseBuffers();
+
+  // Enters the recorded old-to-new slots into the store buffer.  Must be
+  // called from the main thread in a StoreBufferRebuildScope.
+  void FlushRecordedSlots(StoreBuffer* store_buffer);
+
+  intptr_t promoted_bytes() { return promoted_bytes_; }
+  void clear_promoted_bytes() { promoted_bytes_ = 0; }
+
+ private:
+  static const int kBufferSize = 8 * KB;
+  // Larger objects are allocated directly in the spaces.
+  static const int kMaxBufferedObjectSize = kBufferSize / 4;
+
+  void Push(HeapObject* object);
+  bool Pop(HeapObject** object);
+
+  void ScanObject(HeapObject* object);
+  void ScanPromotedObject(HeapObject* object, int size);
+  void ScavengeOldToNewSlot(Address slot_address);
+
+  HeapObject* AllocateInToSpace(int size);
+  HeapObject* AllocateInOldSpace(AllocationSpace space, int size);
+  bool RefillToSpaceBuffer();
+  bool RefillOldSpaceBuffer(AllocationSpace space);
+  void ReleaseOldSpaceBuffer(AllocationSpace space);
+  void FreeAllocation(Address start, int size, AllocationSpace space);
+
+  LocalAllocationBuffer* buffer_for(AllocationSpace space) {
+    if (space == NEW_SPACE) return &to_space_buffer_;
+    if (space == OLD_DATA_SPACE) return &old_data_buffer_;
+    ASSERT(space == OLD_POINTER_SPACE);
+    return &old_pointer_buffer_;
+  }
+
+  ParallelScavenger* scavenger_;
+  Heap* heap_;
+
+  ScavengeSegment* push_segment_;
+  ScavengeSegment* pop_segment_;
+
+  LocalAllocationBuffer to_space_buffer_;
+  LocalAllocationBuffer old_pointer_buffer_;
+  LocalAllocationBuffer old_data_buffer_;
+
+  List<Address> recorded_slots_;
+  intptr_t promoted_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScavengeTask);
+};
+
+
+// Scavenges new space with the main thread and the scavenger threads
+// (--parallel-scavenge).  Objects are copied by whichever task reaches them
+// first: the copy is made in a local allocation buffer and the forwarding
+// address is installed with a compare-and-swap, the losing task drops its
+// copy.  Copied objects that contain pointers are queued in segmented work
+// lists, full segments go to a global pool from which idle tasks steal.
+//
+// The roots and the other sources of pointers into new space are still
+// visited on the main thread through the regular scavenging visitor table.
+// The store buffer is split into slices that all tasks process
+// (--parallel-store-buffer), and the transitive closure is computed in
+// parallel.
+class ParallelScavenger {
+ public:
+  // number_of_tasks includes the main thread.
+  ParallelScavenger(Heap* heap, int number_of_tasks);
+  ~ParallelScavenger();
+
+  static void Initialize();
+
+  // The scavenging visitor table that copies objects in parallel.
+  static VisitorDispatchTable<ScavengingCallback>* GetTable() {
+    return &table_;
+  }
+
+  // Binds the main thread to the first task at the start of a scavenge.
+  void Prepare();
+
+  // Scans all queued objects with the main thread and the scavenger
+  // threads.  Returns when the work lists of all tasks are empty.
+  void ProcessWorklists();
+
+  // Processes the slices with the main thread and the scavenger threads.
+  // The copied objects stay in the work lists of the tasks.
+  void ProcessStoreBuffer(List<StoreBufferSlice>* slices);
+
+  // Runs StoreBuffer::Deduplicate on the first scavenger thread while the
+  // mutator runs.
+  void StartStoreBufferDeduplication();
+  void WaitForStoreBufferDeduplication();
+
+  // Called by the scavenger thread with the given id.  Runs the part of the
+  // current phase that belongs to the thread.
+  void ScavengeInParallel(int id);
+
+  void FlushRecordedSlots();
+
+  // Unbinds the main thread and accounts the promoted bytes.
+  void Finish();
+
+  // Updates slot with the new location of the from space object.
+  static inline void ScavengeObject(HeapObject** slot, HeapObject* object);
+
+  Heap* heap() { return heap_; }
+
+ private:
+  friend class ScavengeTask;
+
+  enum Phase {
+    PROCESS_WORKLISTS,
+    PROCESS_STORE_BUFFER,
+    DEDUPLICATE_STORE_BUFFER
+  };
+
+  void ProcessStoreBufferSlices(ScavengeTask* task);
+
+  static void EvacuateObject(Map* map, HeapObject** slot, HeapObject* object);
+
+  static ScavengeTask* current_task() {
+    return reinterpret_cast<ScavengeTask*>(Thread::GetThreadLocal(task_key_));
+  }
+
+  // Objects are promoted once to space is a quarter full, like in
+  // Heap::ShouldBePromoted.
+  bool ShouldBePromoted(Address old_address) {
+    return Acquire_Load(&to_space_full_) != 0 ||
+        heap_->IsBelowAgeMark(old_address);
+  }
+  void UpdateToSpaceFull();
+
+  void PublishSegment(ScavengeSegment* segment);
+  ScavengeSegment* StealSegment();
+  // Waits for work from the other tasks.  Returns NULL once all tasks are
+  // idle and the pool is empty.
+  ScavengeSegment* WaitForSegment();
+
+  Mutex* allocation_mutex() { return allocation_mutex_; }
+
+  Heap* heap_;
+  int number_of_tasks_;
+  ScavengeTask** tasks_;
+
+  // Protects the spaces while tasks refill their allocation buffers.
+  Mutex* allocation_mutex_;
+
+  Mutex* pool_mutex_;
+  ScavengeSegment* pool_;
+  volatile AtomicWord pool_size_;
+  volatile Atomic32 idle_tasks_;
+
+  volatile AtomicWord to_space_full_;
+
+  // Set by the main thread before it starts the scavenger threads.
+  Phase phase_;
+  List<StoreBufferSlice>* store_buffer_slices_;
+  volatile Atomic32 next_store_buffer_slice_;
+
+  static Thread::LocalStorageKey task_key_;
+  static VisitorDispatchTable<ScavengingCallback> table_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelScavenger);
+};
+
+
+void ParallelScavenger::ScavengeObject(HeapObject** slot,
+                                       HeapObject* object) {
+  // Another task may install the forwarding address at any time.
+  AtomicWord value = Acquire_Load(
+      reinterpret_cast<volatile AtomicWord*>(object->address()));
+  MapWord first_word = MapWord::FromRawValue(static_cast<uintptr_t>(value));
+  if (first_word.IsForwardingAddress()) {
+    *slot = first_word.ToForwardingAddress();
+    return;
+  }
+  EvacuateObject(first_word.ToMap(), slot, object);
+}
+
+} }  // namespace v8::internal
+
+#endif  // V8_PARALLEL_SCAVENGER_H_
@@ -458,6 +458,11 @@ bool VirtualMemory::UncommitRegion(void* base, size_t size) {
 }
 
 
+bool VirtualMemory::DiscardRegion(void* base, size_t size) {
+  return VirtualAlloc(base, size, MEM_RESET, PAGE_READWRITE) != NULL;
+}
+
+
 bool VirtualMemory::ReleaseRegion(void* base, size_t size) {
   return VirtualFree(base, 0, MEM_RELEASE) != 0;
 }
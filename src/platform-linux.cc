@@ -755,6 +755,11 @@ bool VirtualMemory::UncommitRegion(void* base, size_t size) {
 }
 
 
+bool VirtualMemory::DiscardRegion(void* base, size_t size) {
+  return madvise(base, size, MADV_DONTNEED) == 0;
+}
+
+
 bool VirtualMemory::ReleaseRegion(void* base, size_t size) {
   return munmap(base, size) == 0;
 }
@@ -471,6 +471,11 @@ bool VirtualMemory::UncommitRegion(void* address, size_t size) {
 }
 
 
+bool VirtualMemory::DiscardRegion(void* address, size_t size) {
+  return madvise(address, size, MADV_DONTNEED) == 0;
+}
+
+
 bool VirtualMemory::ReleaseRegion(void* address, size_t size) {
   return munmap(address, size) == 0;
 }
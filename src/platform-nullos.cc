@@ -384,6 +384,12 @@ bool VirtualMemory::UncommitRegion(void* base, size_t size) {
 }
 
 
+bool VirtualMemory::DiscardRegion(void* base, size_t size) {
+  UNIMPLEMENTED();
+  return false;
+}
+
+
 bool VirtualMemory::ReleaseRegion(void* base, size_t size) {
   UNIMPLEMENTED();
   return false;
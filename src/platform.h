@@ -440,6 +440,11 @@ class VirtualMemory {
 
   static bool UncommitRegion(void* base, size_t size);
 
+  // Tells the OS that the contents of a committed region are no longer
+  // needed, so that the physical pages backing it can be reclaimed.  The
+  // region stays committed, its contents are undefined afterwards.
+  static bool DiscardRegion(void* base, size_t size);
+
   // Must be called with a base pointer that has been returned by ReserveRegion
   // and the same size it was reserved with.
   static bool ReleaseRegion(void* base, size_t size);
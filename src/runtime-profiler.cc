@@ -162,9 +162,9 @@ void RuntimeProfiler::AttemptOnStackReplacement(JSFunction* function) {
   SharedFunctionInfo* shared = function->shared();
   // If the code is not optimizable, don't try OSR.
   if (!shared->code()->optimizable()) {
-	if ( FLAG_trace_internals ) {
+	if ( FLAG_trace_internals || FLAG_trace_deopt_loops ) {
 	  Code* code = shared->code();
-	  LOG(function->GetIsolate(),
+	  LOG_OPT_EVENT(function->GetIsolate(),
 			EmitFunctionEvent(
 			Logger::OptFailed,
 			function,
@@ -179,9 +179,9 @@ void RuntimeProfiler::AttemptOnStackReplacement(JSFunction* function) {
   // allocated arguments object.  The optimized code would bypass it for
   // arguments accesses, which is unsound.  Don't try OSR.
   if (shared->uses_arguments()) {
-	if ( FLAG_trace_internals ) {
+	if ( FLAG_trace_internals || FLAG_trace_deopt_loops ) {
 	  Code* code = shared->code();
-	  LOG(function->GetIsolate(),
+	  LOG_OPT_EVENT(function->GetIsolate(),
 			EmitFunctionEvent(
 			Logger::OptFailed,
 			function,
@@ -341,11 +341,11 @@ void RuntimeProfiler::OptimizeNow() {
     if (shared->optimization_disabled()) {
 	  // We track the opt failed status immediately
 	  // because later v8 tries to reenable optimization, which erases the opt disable information
-	  if ( FLAG_trace_internals ) {
+	  if ( FLAG_trace_internals || FLAG_trace_deopt_loops ) {
 		//PrintF("------>optimizeNow exit = %s\n", shared->DebugName()->ToCString());
 		//Flush();
 		Code* code = shared->code();
-		LOG(function->GetIsolate(),
+		LOG_OPT_EVENT(function->GetIsolate(),
 			  EmitFunctionEvent(
 			  Logger::OptFailed,
 			  function,
@@ -37,6 +37,7 @@
 #include "codegen.h"
 #include "compilation-cache.h"
 #include "compiler.h"
+#include "concurrent-marking.h"
 #include "cpu.h"
 #include "cpu-profiler.h"
 #include "dateparser-inl.h"
@@ -503,6 +504,32 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateObjectLiteralShallow) {
 }
 
 
+static Handle<AllocationSite> GetLiteralAllocationSite(
+    Isolate* isolate,
+    Handle<FixedArray> literals,
+    int literals_index,
+    Handle<FixedArray> elements) {
+  // Check if boilerplate exists. If not, create it first.
+  Handle<Object> literal_site(literals->get(literals_index), isolate);
+  Handle<AllocationSite> site;
+  if (*literal_site == isolate->heap()->undefined_value()) {
+    ASSERT(*elements != isolate->heap()->empty_fixed_array());
+    Handle<Object> boilerplate =
+        Runtime::CreateArrayLiteralBoilerplate(isolate, literals, elements);
+    if (boilerplate.is_null()) return site;
+    site = isolate->factory()->NewAllocationSite(
+        Handle<JSObject>::cast(boilerplate));
+    // Update the functions literal and return the site.
+    literals->set(literals_index, *site);
+	LOG_INTERNAL_EVENT(isolate, EmitObjectEvent(Logger::CreateArrayBoilerplate, JSArray::cast(*boilerplate), literals_index));
+  } else {
+    site = Handle<AllocationSite>::cast(literal_site);
+  }
+
+  return site;
+}
+
+
 RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateArrayLiteral) {
   HandleScope scope(isolate);
   ASSERT(args.length() == 3);
@@ -510,18 +537,12 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateArrayLiteral) {
   CONVERT_SMI_ARG_CHECKED(literals_index, 1);
   CONVERT_ARG_HANDLE_CHECKED(FixedArray, elements, 2);
 
-  // Check if boilerplate exists. If not, create it first.
-  Handle<Object> boilerplate(literals->get(literals_index), isolate);
-  if (*boilerplate == isolate->heap()->undefined_value()) {
-    ASSERT(*elements != isolate->heap()->empty_fixed_array());
-    boilerplate =
-        Runtime::CreateArrayLiteralBoilerplate(isolate, literals, elements);
-    if (boilerplate.is_null()) return Failure::Exception();
-    // Update the functions literal and return the boilerplate.
-    literals->set(literals_index, *boilerplate);
-	LOG_INTERNAL_EVENT(isolate, EmitObjectEvent(Logger::CreateArrayBoilerplate, JSArray::cast(*boilerplate), literals_index));
-  }
-  return JSObject::cast(*boilerplate)->DeepCopy(isolate);
+  Handle<AllocationSite> site = GetLiteralAllocationSite(isolate, literals,
+      literals_index, elements);
+  RETURN_IF_EMPTY_HANDLE(isolate, site);
+
+  JSObject* boilerplate = JSObject::cast(site->transition_info());
+  return boilerplate->DeepCopy(isolate);
 }
 
 
@@ -532,30 +553,34 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateArrayLiteralShallow) {
   CONVERT_SMI_ARG_CHECKED(literals_index, 1);
   CONVERT_ARG_HANDLE_CHECKED(FixedArray, elements, 2);
 
-  // Check if boilerplate exists. If not, create it first.
-  Handle<Object> boilerplate(literals->get(literals_index), isolate);
-  if (*boilerplate == isolate->heap()->undefined_value()) {
-    ASSERT(*elements != isolate->heap()->empty_fixed_array());
-    boilerplate =
-        Runtime::CreateArrayLiteralBoilerplate(isolate, literals, elements);
-    if (boilerplate.is_null()) return Failure::Exception();
-    // Update the functions literal and return the boilerplate.
-    literals->set(literals_index, *boilerplate);
-	LOG_INTERNAL_EVENT(isolate, EmitObjectEvent(Logger::CreateArrayBoilerplate, JSArray::cast(*boilerplate), literals_index));
-  }
-  if (JSObject::cast(*boilerplate)->elements()->map() ==
+  Handle<AllocationSite> site = GetLiteralAllocationSite(isolate, literals,
+      literals_index, elements);
+  RETURN_IF_EMPTY_HANDLE(isolate, site);
+
+  JSObject* boilerplate = JSObject::cast(site->transition_info());
+  if (boilerplate->elements()->map() ==
       isolate->heap()->fixed_cow_array_map()) {
     isolate->counters()->cow_arrays_created_runtime()->Increment();
   }
 
-  JSObject* boilerplate_object = JSObject::cast(*boilerplate);
+  // Copies from a site that tenures are allocated in old space directly and
+  // do not carry a memento.
+  if (site->GetPretenureMode() == TENURED) {
+    return isolate->heap()->CopyJSObject(boilerplate, TENURED);
+  }
+
+  // Pretenuring feedback needs a memento behind every copy, whatever the
+  // elements kind of the boilerplate.
   AllocationSiteMode mode = AllocationSiteInfo::GetMode(
-      boilerplate_object->GetElementsKind());
+      boilerplate->GetElementsKind());
+  if (FLAG_allocation_site_pretenuring && FLAG_track_allocation_sites) {
+    mode = TRACK_ALLOCATION_SITE;
+  }
   if (mode == TRACK_ALLOCATION_SITE) {
-    return isolate->heap()->CopyJSObjectWithAllocationSite(boilerplate_object);
+    return isolate->heap()->CopyJSObjectWithAllocationSite(boilerplate, *site);
   }
 
-  return isolate->heap()->CopyJSObject(boilerplate_object);
+  return isolate->heap()->CopyJSObject(boilerplate);
 }
 
 
@@ -3853,6 +3878,7 @@ MUST_USE_RESULT static MaybeObject* StringReplaceGlobalRegExpWithEmptyString(
   int allocated_string_size = ResultSeqString::SizeFor(new_length);
   int delta = allocated_string_size - string_size;
 
+  ConcurrentMarkingPauseScope pause_concurrent_marking(isolate->heap());
   answer->set_length(position);
   if (delta == 0) return *answer;
 
@@ -5198,8 +5224,8 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_StoreArrayLiteralElement) {
   CONVERT_ARG_HANDLE_CHECKED(FixedArray, literals, 3);
   CONVERT_SMI_ARG_CHECKED(literal_index, 4);
 
-  Object* raw_boilerplate_object = literals->get(literal_index);
-  Handle<JSArray> boilerplate_object(JSArray::cast(raw_boilerplate_object));
+  AllocationSite* site = AllocationSite::cast(literals->get(literal_index));
+  Handle<JSArray> boilerplate_object(JSArray::cast(site->transition_info()));
   ElementsKind elements_kind = object->GetElementsKind();
   ASSERT(IsFastElementsKind(elements_kind));
   // Smis should never trigger transitions.
@@ -8112,8 +8138,8 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_LazyRecompile) {
 	Code* new_code = shared->code();
 	function->ReplaceCode(new_code);
 	// Perhaps the optimization channel is disabled
-	if ( FLAG_trace_internals ) {
-	  LOG(function->GetIsolate(),
+	if ( FLAG_trace_internals || FLAG_trace_deopt_loops ) {
+	  LOG_OPT_EVENT(function->GetIsolate(),
 			EmitFunctionEvent(
 			Logger::OptFailed,
 			*function,
@@ -8149,8 +8175,8 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_LazyRecompile) {
     PrintF(": optimized compilation failed]\n");
   }
 
-  if ( FLAG_trace_internals ) {
-	  LOG(function->GetIsolate(),
+  if ( FLAG_trace_internals || FLAG_trace_deopt_loops ) {
+	  LOG_OPT_EVENT(function->GetIsolate(),
 		  EmitFunctionEvent(
 		  Logger::OptFailed,
 		  *function,
@@ -8549,9 +8575,9 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CompileForOnStackReplacement) {
     res = Smi::FromInt(-1);
   }
 
-  if ( FLAG_trace_internals && !succeeded) {
+  if ( (FLAG_trace_internals || FLAG_trace_deopt_loops) && !succeeded) {
 	Code* code = function->code();
-	LOG(function->GetIsolate(),
+	LOG_OPT_EVENT(function->GetIsolate(),
 		EmitFunctionEvent(
 		Logger::OptFailed,
 		  *function,
@@ -13852,6 +13878,9 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_LogObjectCreate) {
   Logger::InternalEvent event = (instance->IsJSArray() ? Logger::CreateArrayLiteral : Logger::CreateObjectLiteral);
   FixedArray* boilerplates = def_function->literals();
   HeapObject* constructor = HeapObject::cast( boilerplates->get(index) );
+  if ( constructor->IsAllocationSite() )
+    constructor = HeapObject::cast(
+        AllocationSite::cast(constructor)->transition_info() );
   
   LOG( isolate,
 	  	EmitObjectEvent(
@@ -13897,6 +13926,16 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_LogSetCheckpoint) {
 }
 
 
+RUNTIME_FUNCTION(MaybeObject*, Runtime_DumpInternalEvents) {
+  SealHandleScope shs(isolate);
+  ASSERT(args.length() == 0);
+  LOG_INTERNAL_EVENT(isolate, ReportMapHotspots());
+  LOG_INTERNAL_EVENT(isolate, DumpInternalEvents());
+  LOG_OPT_EVENT(isolate, ReportDeoptLoops());
+  return isolate->heap()->undefined_value();
+}
+
+
 RUNTIME_FUNCTION(MaybeObject*, Runtime_IS_VAR) {
   UNREACHABLE();  // implemented as macro in the parser
   return NULL;
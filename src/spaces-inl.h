@@ -277,7 +277,7 @@ MaybeObject* PagedSpace::AllocateRaw(int size_in_bytes) {
   HeapObject* object = AllocateLinearly(size_in_bytes);
   if (object != NULL) {
     if (identity() == CODE_SPACE) {
-      SkipList::Update(object->address(), size_in_bytes);
+      ObjectStartBitmap::Update(object->address());
     }
     return object;
   }
@@ -289,7 +289,7 @@ MaybeObject* PagedSpace::AllocateRaw(int size_in_bytes) {
   object = free_list_.Allocate(size_in_bytes);
   if (object != NULL) {
     if (identity() == CODE_SPACE) {
-      SkipList::Update(object->address(), size_in_bytes);
+      ObjectStartBitmap::Update(object->address());
     }
     return object;
   }
@@ -297,7 +297,7 @@ MaybeObject* PagedSpace::AllocateRaw(int size_in_bytes) {
   object = SlowAllocateRaw(size_in_bytes);
   if (object != NULL) {
     if (identity() == CODE_SPACE) {
-      SkipList::Update(object->address(), size_in_bytes);
+      ObjectStartBitmap::Update(object->address());
     }
     return object;
   }
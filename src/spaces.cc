@@ -27,9 +27,11 @@
 
 #include "v8.h"
 
+#include "compiler-intrinsics.h"
 #include "macro-assembler.h"
 #include "mark-compact.h"
 #include "platform.h"
+#include "unmapper-thread.h"
 
 namespace v8 {
 namespace internal {
@@ -123,8 +125,9 @@ bool HeapObjectIterator::AdvanceToNextPage() {
 // CodeRange
 
 
-CodeRange::CodeRange(Isolate* isolate)
+CodeRange::CodeRange(Isolate* isolate, Executability executable)
     : isolate_(isolate),
+      executable_(executable),
       code_range_(NULL),
       free_list_(0),
       allocation_list_(0),
@@ -132,10 +135,11 @@ CodeRange::CodeRange(Isolate* isolate)
 }
 
 
-bool CodeRange::SetUp(const size_t requested) {
+bool CodeRange::SetUp(const size_t requested, const size_t alignment) {
   ASSERT(code_range_ == NULL);
 
-  code_range_ = new VirtualMemory(requested);
+  code_range_ = alignment == 0 ? new VirtualMemory(requested)
+                               : new VirtualMemory(requested, alignment);
   CHECK(code_range_ != NULL);
   if (!code_range_->IsReserved()) {
     delete code_range_;
@@ -144,13 +148,13 @@ bool CodeRange::SetUp(const size_t requested) {
   }
 
   // We are sure that we have mapped a block of requested addresses.
-  ASSERT(code_range_->size() == requested);
+  ASSERT(code_range_->size() >= requested);
   LOG(isolate_, NewEvent("CodeRange", code_range_->address(), requested));
   Address base = reinterpret_cast<Address>(code_range_->address());
   Address aligned_base =
       RoundUp(reinterpret_cast<Address>(code_range_->address()),
-              MemoryChunk::kAlignment);
-  size_t size = code_range_->size() - (aligned_base - base);
+              Max(alignment, static_cast<size_t>(MemoryChunk::kAlignment)));
+  size_t size = Min(code_range_->size() - (aligned_base - base), requested);
   allocation_list_.Add(FreeBlock(aligned_base, size));
   current_allocation_block_index_ = 0;
   return true;
@@ -228,12 +232,19 @@ Address CodeRange::AllocateRawMemory(const size_t requested_size,
   }
   ASSERT(*allocated <= current.size);
   ASSERT(IsAddressAligned(current.start, MemoryChunk::kAlignment));
-  if (!MemoryAllocator::CommitExecutableMemory(code_range_,
-                                               current.start,
-                                               commit_size,
-                                               *allocated)) {
-    *allocated = 0;
-    return NULL;
+  if (executable_ == EXECUTABLE) {
+    if (!MemoryAllocator::CommitExecutableMemory(code_range_,
+                                                 current.start,
+                                                 commit_size,
+                                                 *allocated)) {
+      *allocated = 0;
+      return NULL;
+    }
+  } else if (commit_size > 0) {
+    if (!code_range_->Commit(current.start, commit_size, false)) {
+      *allocated = 0;
+      return NULL;
+    }
   }
   allocation_list_[current_allocation_block_index_].start += *allocated;
   allocation_list_[current_allocation_block_index_].size -= *allocated;
@@ -244,8 +255,30 @@ Address CodeRange::AllocateRawMemory(const size_t requested_size,
 }
 
 
+Address CodeRange::AllocateAlignedRawMemory(const size_t size,
+                                            const size_t alignment) {
+  ASSERT(executable_ == NOT_EXECUTABLE);
+  ASSERT(IsAligned(alignment, MemoryChunk::kAlignment));
+  ASSERT(IsAligned(size, MemoryChunk::kAlignment));
+  size_t allocated;
+  Address start = AllocateRawMemory(
+      size + alignment - MemoryChunk::kAlignment, 0, &allocated);
+  if (start == NULL) return NULL;
+  // Give back the parts before and after the aligned block.
+  Address aligned_start = RoundUp(start, alignment);
+  if (aligned_start > start) {
+    FreeRawMemory(start, aligned_start - start);
+  }
+  Address end = start + allocated;
+  if (end > aligned_start + size) {
+    FreeRawMemory(aligned_start + size, end - (aligned_start + size));
+  }
+  return aligned_start;
+}
+
+
 bool CodeRange::CommitRawMemory(Address start, size_t length) {
-  return code_range_->Commit(start, length, true);
+  return code_range_->Commit(start, length, executable_ == EXECUTABLE);
 }
 
 
@@ -269,6 +302,28 @@ void CodeRange::TearDown() {
 }
 
 
+// -----------------------------------------------------------------------------
+// ObjectStartBitmap
+
+Address ObjectStartBitmap::StartFor(Address addr) {
+  Address page_start = reinterpret_cast<Address>(
+      OffsetFrom(addr) & ~Page::kPageAlignmentMask);
+  uint32_t index = IndexOf(addr);
+  int cell_index = static_cast<int>(Bitmap::IndexToCell(index));
+  // Ignore the objects that start above addr in its own cell.
+  uint32_t mask = 0xFFFFFFFFu >>
+      (Bitmap::kBitIndexMask - (index & Bitmap::kBitIndexMask));
+  uint32_t cell = cells_[cell_index] & mask;
+  while (cell == 0) {
+    if (--cell_index < 0) return NULL;
+    cell = cells_[cell_index];
+  }
+  int bit = Bitmap::kBitIndexMask - CompilerIntrinsics::CountLeadingZeros(cell);
+  return page_start +
+      ((Bitmap::CellToIndex(cell_index) + bit) << kPointerSizeLog2);
+}
+
+
 // -----------------------------------------------------------------------------
 // MemoryAllocator
 //
@@ -278,7 +333,10 @@ MemoryAllocator::MemoryAllocator(Isolate* isolate)
       capacity_(0),
       capacity_executable_(0),
       size_(0),
-      size_executable_(0) {
+      size_executable_(0),
+      pool_hits_(0),
+      unmapper_thread_(NULL),
+      heap_range_(NULL) {
 }
 
 
@@ -289,6 +347,24 @@ bool MemoryAllocator::SetUp(intptr_t capacity, intptr_t capacity_executable) {
 
   size_ = 0;
   size_executable_ = 0;
+  pool_hits_ = 0;
+
+  if (FLAG_concurrent_unmapping) {
+    unmapper_thread_ = new UnmapperThread();
+    unmapper_thread_->Start();
+  }
+
+#if V8_TARGET_ARCH_X64
+  const size_t kHeapRangeSize = static_cast<size_t>(4) * GB;
+  if (FLAG_heap_range && capacity_ <= kHeapRangeSize) {
+    heap_range_ = new CodeRange(isolate_, NOT_EXECUTABLE);
+    if (!heap_range_->SetUp(kHeapRangeSize, kHeapRangeSize)) {
+      // Without the range the heap is spread over the address space.
+      delete heap_range_;
+      heap_range_ = NULL;
+    }
+  }
+#endif
 
   return true;
 }
@@ -301,6 +377,18 @@ void MemoryAllocator::TearDown() {
   // ASSERT(size_executable_ == 0);
   capacity_ = 0;
   capacity_executable_ = 0;
+
+  ReleasePooledChunks();
+  pooled_chunks_.Free();
+
+  if (unmapper_thread_ != NULL) {
+    unmapper_thread_->Stop();
+    delete unmapper_thread_;
+    unmapper_thread_ = NULL;
+  }
+
+  delete heap_range_;
+  heap_range_ = NULL;
 }
 
 
@@ -322,7 +410,11 @@ void MemoryAllocator::FreeMemory(VirtualMemory* reservation,
   ASSERT(!isolate_->code_range()->contains(
       static_cast<Address>(reservation->address())));
   ASSERT(executable == NOT_EXECUTABLE || !isolate_->code_range()->exists());
-  reservation->Release();
+  if (unmapper_thread_ != NULL) {
+    unmapper_thread_->Unmap(reservation);
+  } else {
+    reservation->Release();
+  }
 }
 
 
@@ -342,6 +434,9 @@ void MemoryAllocator::FreeMemory(Address base,
   if (isolate_->code_range()->contains(static_cast<Address>(base))) {
     ASSERT(executable == EXECUTABLE);
     isolate_->code_range()->FreeRawMemory(base, size);
+  } else if (heap_range_->contains(base)) {
+    ASSERT(executable == NOT_EXECUTABLE);
+    heap_range_->FreeRawMemory(base, size);
   } else {
     ASSERT(executable == NOT_EXECUTABLE || !isolate_->code_range()->exists());
     bool result = VirtualMemory::ReleaseRegion(base, size);
@@ -365,6 +460,19 @@ Address MemoryAllocator::ReserveAlignedMemory(size_t size,
 }
 
 
+Address MemoryAllocator::ReserveAlignedHeapMemory(size_t size,
+                                                  size_t alignment,
+                                                  VirtualMemory* controller) {
+  if (!heap_range_->exists()) {
+    return ReserveAlignedMemory(size, alignment, controller);
+  }
+  Address base = heap_range_->AllocateAlignedRawMemory(size, alignment);
+  if (base == NULL) return NULL;
+  size_ += size;
+  return base;
+}
+
+
 Address MemoryAllocator::AllocateAlignedMemory(size_t reserve_size,
                                                size_t commit_size,
                                                size_t alignment,
@@ -463,7 +571,8 @@ MemoryChunk* MemoryChunk::Initialize(Heap* heap,
   chunk->set_owner(owner);
   chunk->InitializeReservedMemory();
   chunk->slots_buffer_ = NULL;
-  chunk->skip_list_ = NULL;
+  chunk->object_starts_ = NULL;
+  chunk->store_buffer_counter_ = 0;
   chunk->write_barrier_counter_ = kWriteBarrierCounterGranularity;
   chunk->progress_bar_ = 0;
   chunk->high_water_mark_ = static_cast<int>(area_start - base);
@@ -473,6 +582,9 @@ MemoryChunk* MemoryChunk::Initialize(Heap* heap,
   chunk->available_in_large_free_list_ = 0;
   chunk->available_in_huge_free_list_ = 0;
   chunk->non_available_small_blocks_ = 0;
+  chunk->swept_free_list_ = NULL;
+  chunk->next_swept_chunk_ = NULL;
+  chunk->card_table_ = NULL;
   chunk->ResetLiveBytes();
   Bitmap::Clear(chunk);
   chunk->initialize_scan_on_scavenge(false);
@@ -513,8 +625,10 @@ bool MemoryChunk::CommitArea(size_t requested) {
         return false;
       }
     } else {
-      CodeRange* code_range = heap_->isolate()->code_range();
-      ASSERT(code_range->exists() && IsFlagSet(IS_EXECUTABLE));
+      CodeRange* code_range = IsFlagSet(IS_EXECUTABLE)
+          ? heap_->isolate()->code_range()
+          : heap_->isolate()->memory_allocator()->heap_range();
+      ASSERT(code_range->exists());
       if (!code_range->CommitRawMemory(start, length)) return false;
     }
 
@@ -529,8 +643,10 @@ bool MemoryChunk::CommitArea(size_t requested) {
     if (reservation_.IsReserved()) {
       if (!reservation_.Uncommit(start, length)) return false;
     } else {
-      CodeRange* code_range = heap_->isolate()->code_range();
-      ASSERT(code_range->exists() && IsFlagSet(IS_EXECUTABLE));
+      CodeRange* code_range = IsFlagSet(IS_EXECUTABLE)
+          ? heap_->isolate()->code_range()
+          : heap_->isolate()->memory_allocator()->heap_range();
+      ASSERT(code_range->exists());
       if (!code_range->UncommitRawMemory(start, length)) return false;
     }
   }
@@ -662,15 +778,27 @@ MemoryChunk* MemoryAllocator::AllocateChunk(intptr_t reserve_area_size,
   } else {
     chunk_size = RoundUp(MemoryChunk::kObjectStartOffset + reserve_area_size,
                          OS::CommitPageSize());
+    if (chunk_size == static_cast<size_t>(Page::kPageSize) &&
+        commit_area_size == reserve_area_size &&
+        !pooled_chunks_.is_empty()) {
+      return AllocatePooledChunk(executable, owner);
+    }
     size_t commit_size = RoundUp(MemoryChunk::kObjectStartOffset +
                                  commit_area_size, OS::CommitPageSize());
-    base = AllocateAlignedMemory(chunk_size,
-                                 commit_size,
-                                 MemoryChunk::kAlignment,
-                                 executable,
-                                 &reservation);
-
-    if (base == NULL) return NULL;
+    if (heap_range_->exists()) {
+      base = heap_range_->AllocateRawMemory(chunk_size,
+                                            commit_size,
+                                            &chunk_size);
+      if (base == NULL) return NULL;
+      size_ += chunk_size;
+    } else {
+      base = AllocateAlignedMemory(chunk_size,
+                                   commit_size,
+                                   MemoryChunk::kAlignment,
+                                   executable,
+                                   &reservation);
+      if (base == NULL) return NULL;
+    }
 
     if (Heap::ShouldZapGarbage()) {
       ZapBlock(base, Page::kObjectStartOffset + commit_area_size);
@@ -703,6 +831,45 @@ MemoryChunk* MemoryAllocator::AllocateChunk(intptr_t reserve_area_size,
 }
 
 
+MemoryChunk* MemoryAllocator::AllocatePooledChunk(Executability executable,
+                                                  Space* owner) {
+  ASSERT(executable == NOT_EXECUTABLE);
+  MemoryChunk* chunk = pooled_chunks_.RemoveLast();
+  pool_hits_++;
+
+  // The whole page is still committed, only the header has to be rebuilt.
+  VirtualMemory reservation;
+  reservation.TakeControl(chunk->reserved_memory());
+  size_t chunk_size = Page::kPageSize;
+  ASSERT(reservation.size() == chunk_size);
+  size_ += chunk_size;
+
+  Address base = chunk->address();
+  if (Heap::ShouldZapGarbage()) {
+    ZapBlock(base, chunk_size);
+  }
+
+  isolate_->counters()->memory_allocated()->
+      Increment(static_cast<int>(chunk_size));
+
+  LOG(isolate_, NewEvent("MemoryChunk", base, chunk_size));
+  if (owner != NULL) {
+    ObjectSpace space = static_cast<ObjectSpace>(1 << owner->identity());
+    PerformAllocationCallback(space, kAllocationActionAllocate, chunk_size);
+  }
+
+  MemoryChunk* result = MemoryChunk::Initialize(isolate_->heap(),
+                                                base,
+                                                chunk_size,
+                                                base + Page::kObjectStartOffset,
+                                                base + chunk_size,
+                                                executable,
+                                                owner);
+  result->set_reserved_memory(&reservation);
+  return result;
+}
+
+
 void Page::ResetFreeListStatistics() {
   non_available_small_blocks_ = 0;
   available_in_small_free_list_ = 0;
@@ -747,10 +914,19 @@ void MemoryAllocator::Free(MemoryChunk* chunk) {
       reinterpret_cast<Address>(chunk), chunk->IsEvacuationCandidate());
 
   delete chunk->slots_buffer();
-  delete chunk->skip_list();
+  delete chunk->object_starts();
+  delete chunk->card_table();
 
   VirtualMemory* reservation = chunk->reserved_memory();
-  if (reservation->IsReserved()) {
+  if (CanPool(chunk)) {
+    // Account for the chunk as freed but keep its memory mapped.
+    size_t size = reservation->size();
+    ASSERT(size_ >= size);
+    size_ -= size;
+    isolate_->counters()->memory_allocated()->
+        Decrement(static_cast<int>(size));
+    pooled_chunks_.Add(chunk);
+  } else if (reservation->IsReserved()) {
     FreeMemory(reservation, chunk->executable());
   } else {
     FreeMemory(chunk->address(),
@@ -760,6 +936,27 @@ void MemoryAllocator::Free(MemoryChunk* chunk) {
 }
 
 
+void MemoryAllocator::ReleasePooledChunks() {
+  // The pooled chunks are no longer accounted for in size_.
+  while (!pooled_chunks_.is_empty()) {
+    pooled_chunks_.RemoveLast()->reserved_memory()->Release();
+  }
+}
+
+
+bool MemoryAllocator::CanPool(MemoryChunk* chunk) {
+  if (pooled_chunks_.length() >= FLAG_max_pooled_pages) return false;
+  if (chunk->executable() == EXECUTABLE) return false;
+  VirtualMemory* reservation = chunk->reserved_memory();
+  // Only chunks whose page is committed in full can be handed out again
+  // without committing memory.
+  return reservation->IsReserved() &&
+      reservation->size() == static_cast<size_t>(Page::kPageSize) &&
+      chunk->size() == static_cast<size_t>(Page::kPageSize) &&
+      chunk->area_end() == chunk->address() + Page::kPageSize;
+}
+
+
 bool MemoryAllocator::CommitBlock(Address start,
                                   size_t size,
                                   Executability executable) {
@@ -925,7 +1122,8 @@ PagedSpace::PagedSpace(Heap* heap,
       free_list_(this),
       was_swept_conservatively_(false),
       first_unswept_page_(Page::FromAddress(NULL)),
-      unswept_free_bytes_(0) {
+      unswept_free_bytes_(0),
+      swept_pages_(0) {
   if (id == CODE_SPACE) {
     area_size_ = heap->isolate()->memory_allocator()->
         CodePageAreaSize();
@@ -1198,7 +1396,7 @@ bool NewSpace::SetUp(int reserved_semispace_capacity,
 
   size_t size = 2 * reserved_semispace_capacity;
   Address base =
-      heap()->isolate()->memory_allocator()->ReserveAlignedMemory(
+      heap()->isolate()->memory_allocator()->ReserveAlignedHeapMemory(
           size, size, &reservation_);
   if (base == NULL) return false;
 
@@ -1264,9 +1462,12 @@ void NewSpace::TearDown() {
 
   LOG(heap()->isolate(), DeleteEvent("InitialChunk", chunk_base_));
 
-  ASSERT(reservation_.IsReserved());
-  heap()->isolate()->memory_allocator()->FreeMemory(&reservation_,
-                                                    NOT_EXECUTABLE);
+  MemoryAllocator* allocator = heap()->isolate()->memory_allocator();
+  if (reservation_.IsReserved()) {
+    allocator->FreeMemory(&reservation_, NOT_EXECUTABLE);
+  } else {
+    allocator->FreeMemory(chunk_base_, chunk_size_, NOT_EXECUTABLE);
+  }
   chunk_base_ = NULL;
   chunk_size_ = 0;
 }
@@ -1280,7 +1481,12 @@ void NewSpace::Flip() {
 void NewSpace::Grow() {
   // Double the semispace size but only up to maximum capacity.
   ASSERT(Capacity() < MaximumCapacity());
-  int new_capacity = Min(MaximumCapacity(), 2 * static_cast<int>(Capacity()));
+  GrowTo(Min(MaximumCapacity(), 2 * static_cast<int>(Capacity())));
+}
+
+
+void NewSpace::GrowTo(int new_capacity) {
+  ASSERT(new_capacity > Capacity() && new_capacity <= MaximumCapacity());
   if (to_space_.GrowTo(new_capacity)) {
     // Only grow from space if we managed to grow to-space.
     if (!from_space_.GrowTo(new_capacity)) {
@@ -1298,7 +1504,12 @@ void NewSpace::Grow() {
 
 
 void NewSpace::Shrink() {
-  int new_capacity = Max(InitialCapacity(), 2 * SizeAsInt());
+  ShrinkTo(InitialCapacity());
+}
+
+
+void NewSpace::ShrinkTo(int new_capacity) {
+  new_capacity = Max(new_capacity, Max(InitialCapacity(), 2 * SizeAsInt()));
   int rounded_new_capacity = RoundUp(new_capacity, Page::kPageSize);
   if (rounded_new_capacity < Capacity() &&
       to_space_.ShrinkTo(rounded_new_capacity))  {
@@ -1614,6 +1825,21 @@ bool SemiSpace::ShrinkTo(int new_capacity) {
 }
 
 
+void SemiSpace::Discard() {
+  if (!is_committed()) return;
+  NewSpacePageIterator it(this);
+  while (it.has_next()) {
+    NewSpacePage* page = it.next();
+    // The header shares the first OS page with the start of the area.
+    Address start = RoundUp(page->area_start(), OS::CommitPageSize());
+    Address end = page->area_end();
+    if (start < end) {
+      VirtualMemory::DiscardRegion(start, end - start);
+    }
+  }
+}
+
+
 void SemiSpace::FlipPages(intptr_t flags, intptr_t mask) {
   anchor_.set_owner(this);
   // Fixup back-pointers to anchor. Address of anchor changes
@@ -2032,29 +2258,6 @@ void FreeListNode::set_next(FreeListNode* next) {
 }
 
 
-intptr_t FreeListCategory::Concatenate(FreeListCategory* category) {
-  intptr_t free_bytes = 0;
-  if (category->top_ != NULL) {
-    ASSERT(category->end_ != NULL);
-    // This is safe (not going to deadlock) since Concatenate operations
-    // are never performed on the same free lists at the same time in
-    // reverse order.
-    ScopedLock lock_target(mutex_);
-    ScopedLock lock_source(category->mutex());
-    free_bytes = category->available();
-    if (end_ == NULL) {
-      end_ = category->end();
-    } else {
-      category->end()->set_next(top_);
-    }
-    top_ = category->top();
-    available_ += category->available();
-    category->Reset();
-  }
-  return free_bytes;
-}
-
-
 void FreeListCategory::Reset() {
   top_ = NULL;
   end_ = NULL;
@@ -2151,16 +2354,6 @@ FreeList::FreeList(PagedSpace* owner)
 }
 
 
-intptr_t FreeList::Concatenate(FreeList* free_list) {
-  intptr_t free_bytes = 0;
-  free_bytes += small_list_.Concatenate(free_list->small_list());
-  free_bytes += medium_list_.Concatenate(free_list->medium_list());
-  free_bytes += large_list_.Concatenate(free_list->large_list());
-  free_bytes += huge_list_.Concatenate(free_list->huge_list());
-  return free_bytes;
-}
-
-
 void FreeList::Reset() {
   small_list_.Reset();
   medium_list_.Reset();
@@ -2203,6 +2396,26 @@ int FreeList::Free(Address start, int size_in_bytes) {
 }
 
 
+int FreeList::FreeToSweptPage(Heap* heap, Address start, int size_in_bytes) {
+  if (size_in_bytes == 0) return 0;
+
+  FreeListNode* node = FreeListNode::FromAddress(start);
+  node->set_size(heap, size_in_bytes);
+  Page* page = Page::FromAddress(start);
+
+  // The page is not visible to the main thread until it is finalized, so
+  // its statistics can be updated here.
+  if (size_in_bytes < kSmallListMin) {
+    page->add_non_available_small_blocks(size_in_bytes);
+    return size_in_bytes;
+  }
+
+  node->set_next(page->swept_free_list());
+  page->set_swept_free_list(node);
+  return 0;
+}
+
+
 FreeListNode* FreeList::FindNodeFor(int size_in_bytes, int* node_size) {
   FreeListNode* node = NULL;
   Page* page = NULL;
@@ -2585,7 +2798,7 @@ bool PagedSpace::AdvanceSweeper(intptr_t bytes_to_sweep) {
       freed_bytes +=
           MarkCompactCollector::
               SweepConservatively<MarkCompactCollector::SWEEP_SEQUENTIALLY>(
-                  this, NULL, p);
+                  this, p);
     }
     p = next_page;
   } while (p != anchor() && freed_bytes < bytes_to_sweep);
@@ -2621,12 +2834,12 @@ bool PagedSpace::EnsureSweeperProgress(intptr_t size_in_bytes) {
   MarkCompactCollector* collector = heap()->mark_compact_collector();
   if (collector->AreSweeperThreadsActivated()) {
     if (collector->IsConcurrentSweepingInProgress()) {
-      if (collector->StealMemoryFromSweeperThreads(this) < size_in_bytes) {
-        if (!collector->sequential_sweeping()) {
-          collector->WaitUntilSweepingCompleted();
-          return true;
-        }
+      if (collector->AreSweeperThreadsDone()) {
+        // Does not block, the threads have already signalled.
+        collector->WaitUntilSweepingCompleted();
+        return true;
       }
+      FinalizeSweptPages();
       return false;
     }
     return true;
@@ -2636,6 +2849,57 @@ bool PagedSpace::EnsureSweeperProgress(intptr_t size_in_bytes) {
 }
 
 
+void PagedSpace::AddSweptPage(Page* p) {
+  ASSERT(p->parallel_sweeping() == MemoryChunk::SWEEPING_IN_PROGRESS);
+  p->set_parallel_sweeping(MemoryChunk::SWEEPING_FINALIZE);
+  AtomicWord head;
+  do {
+    head = NoBarrier_Load(&swept_pages_);
+    p->set_next_swept_chunk(reinterpret_cast<MemoryChunk*>(head));
+  } while (Release_CompareAndSwap(&swept_pages_,
+                                  head,
+                                  reinterpret_cast<AtomicWord>(p)) != head);
+}
+
+
+intptr_t PagedSpace::FinalizeSweptPages() {
+  // Take the whole stack at once.  Pages are only ever pushed concurrently,
+  // so there is no ABA problem.
+  AtomicWord head;
+  do {
+    head = Acquire_Load(&swept_pages_);
+  } while (head != 0 &&
+           Acquire_CompareAndSwap(&swept_pages_, head, 0) != head);
+
+  intptr_t freed_bytes = 0;
+  Page* p = reinterpret_cast<Page*>(head);
+  while (p != NULL) {
+    Page* next_page = static_cast<Page*>(p->next_swept_chunk());
+    ASSERT(p->parallel_sweeping() == MemoryChunk::SWEEPING_FINALIZE);
+    if (FLAG_gc_verbose) {
+      PrintF("Sweeping 0x%" V8PRIxPTR " finalized.\n",
+             reinterpret_cast<intptr_t>(p));
+    }
+    // The live bytes are still those found by the marker, adjusted by the
+    // mutator, so this takes back exactly what SweepSpace estimated.
+    DecreaseUnsweptFreeBytes(p);
+    FreeListNode* node = p->swept_free_list();
+    while (node != NULL) {
+      FreeListNode* next_node = node->next();
+      freed_bytes += Free(node->address(), node->Size());
+      node = next_node;
+    }
+    p->set_swept_free_list(NULL);
+    p->set_next_swept_chunk(NULL);
+    p->MarkSweptConservatively();
+    p->ResetLiveBytes();
+    p->set_parallel_sweeping(MemoryChunk::SWEEPING_DONE);
+    p = next_page;
+  }
+  return freed_bytes;
+}
+
+
 HeapObject* PagedSpace::SlowAllocateRaw(int size_in_bytes) {
   // Allocation in this space has failed.
 
@@ -2675,6 +2939,18 @@ HeapObject* PagedSpace::SlowAllocateRaw(int size_in_bytes) {
     if (object != NULL) return object;
   }
 
+  // Likewise, wait for the sweeper threads.  Not while sweeping sequentially,
+  // the threads may not have been started yet.
+  MarkCompactCollector* collector = heap()->mark_compact_collector();
+  if (collector->IsConcurrentSweepingInProgress() &&
+      !collector->sequential_sweeping()) {
+    collector->WaitUntilSweepingCompleted();
+
+    // Retry the free list allocation.
+    HeapObject* object = free_list_.Allocate(size_in_bytes);
+    if (object != NULL) return object;
+  }
+
   // Finally, fail.
   return NULL;
 }
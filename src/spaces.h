@@ -29,6 +29,7 @@
 #define V8_SPACES_H_
 
 #include "allocation.h"
+#include "atomicops.h"
 #include "hashmap.h"
 #include "list.h"
 #include "log.h"
@@ -115,8 +116,10 @@ class Isolate;
 class PagedSpace;
 class MemoryAllocator;
 class AllocationInfo;
+class UnmapperThread;
 class Space;
 class FreeList;
+class FreeListNode;
 class MemoryChunk;
 
 class MarkBit {
@@ -139,6 +142,29 @@ class MarkBit {
   inline bool Get() { return (*cell_ & mask_) != 0; }
   inline void Clear() { *cell_ &= ~mask_; }
 
+  // Variants for use while the marking threads of --concurrent-marking may
+  // change other bits of the same cell.  SetAtomic returns false if the bit
+  // was already set.
+  inline bool SetAtomic() {
+    volatile Atomic32* cell = reinterpret_cast<volatile Atomic32*>(cell_);
+    Atomic32 old_value;
+    do {
+      old_value = NoBarrier_Load(cell);
+      if ((old_value & mask_) != 0) return false;
+    } while (NoBarrier_CompareAndSwap(cell, old_value, old_value | mask_) !=
+             old_value);
+    return true;
+  }
+
+  inline void ClearAtomic() {
+    volatile Atomic32* cell = reinterpret_cast<volatile Atomic32*>(cell_);
+    Atomic32 old_value;
+    do {
+      old_value = NoBarrier_Load(cell);
+    } while (NoBarrier_CompareAndSwap(cell, old_value, old_value & ~mask_) !=
+             old_value);
+  }
+
   inline bool data_only() { return data_only_; }
 
   inline MarkBit Next() {
@@ -291,7 +317,8 @@ class Bitmap {
 };
 
 
-class SkipList;
+class CardTable;
+class ObjectStartBitmap;
 class SlotsBuffer;
 
 // MemoryChunk represents a memory region owned by a specific space.
@@ -456,18 +483,40 @@ class MemoryChunk {
   // Return all current flags.
   intptr_t GetFlags() { return flags_; }
 
-  intptr_t parallel_sweeping() const {
-    return parallel_sweeping_;
+  // A page handed to the sweeper threads goes from SWEEPING_PENDING to
+  // SWEEPING_IN_PROGRESS when a thread claims it and to SWEEPING_FINALIZE
+  // when its free blocks are ready to be merged into the owner's free list.
+  // The main thread finalizes the page and sets it back to SWEEPING_DONE.
+  enum ParallelSweepingState {
+    SWEEPING_DONE,
+    SWEEPING_PENDING,
+    SWEEPING_IN_PROGRESS,
+    SWEEPING_FINALIZE
+  };
+
+  ParallelSweepingState parallel_sweeping() {
+    return static_cast<ParallelSweepingState>(
+        Acquire_Load(&parallel_sweeping_));
   }
 
-  void set_parallel_sweeping(intptr_t state) {
-    parallel_sweeping_ = state;
+  void set_parallel_sweeping(ParallelSweepingState state) {
+    Release_Store(&parallel_sweeping_, state);
   }
 
   bool TryParallelSweeping() {
-    return NoBarrier_CompareAndSwap(&parallel_sweeping_, 1, 0) == 1;
+    return NoBarrier_CompareAndSwap(&parallel_sweeping_,
+                                    SWEEPING_PENDING,
+                                    SWEEPING_IN_PROGRESS) == SWEEPING_PENDING;
   }
 
+  // The free blocks found by a sweeper thread, linked through the blocks.
+  FreeListNode* swept_free_list() { return swept_free_list_; }
+  void set_swept_free_list(FreeListNode* node) { swept_free_list_ = node; }
+
+  // Link in the owner's queue of pages waiting for finalization.
+  MemoryChunk* next_swept_chunk() { return next_swept_chunk_; }
+  void set_next_swept_chunk(MemoryChunk* chunk) { next_swept_chunk_ = chunk; }
+
   // Manage live byte count (count of bytes known to be live,
   // because they are marked black).
   void ResetLiveBytes() {
@@ -530,6 +579,14 @@ class MemoryChunk {
 
   static void IncrementLiveBytesFromMutator(Address address, int by);
 
+  // Used by the marking threads and by the write barrier while the marking
+  // threads are running.
+  static void IncrementLiveBytesAtomically(Address address, int by) {
+    MemoryChunk* chunk = MemoryChunk::FromAddress(address);
+    NoBarrier_AtomicIncrement(
+        reinterpret_cast<volatile Atomic32*>(&chunk->live_byte_count_), by);
+  }
+
   static const intptr_t kAlignment =
       (static_cast<uintptr_t>(1) << kPageSizeBits);
 
@@ -549,7 +606,7 @@ class MemoryChunk {
 
   static const size_t kHeaderSize = kWriteBarrierCounterOffset + kPointerSize +
                                     kIntSize + kIntSize + kPointerSize +
-                                    5 * kPointerSize;
+                                    5 * kPointerSize + 3 * kPointerSize;
 
   static const int kBodyOffset =
       CODE_POINTER_ALIGN(kHeaderSize + Bitmap::kSize);
@@ -629,12 +686,20 @@ class MemoryChunk {
     return (flags_ & kSkipEvacuationSlotsRecordingMask) != 0;
   }
 
-  inline SkipList* skip_list() {
-    return skip_list_;
+  inline ObjectStartBitmap* object_starts() {
+    return object_starts_;
   }
 
-  inline void set_skip_list(SkipList* skip_list) {
-    skip_list_ = skip_list;
+  inline void set_object_starts(ObjectStartBitmap* object_starts) {
+    object_starts_ = object_starts;
+  }
+
+  inline CardTable* card_table() {
+    return card_table_;
+  }
+
+  inline void set_card_table(CardTable* card_table) {
+    card_table_ = card_table;
   }
 
   inline SlotsBuffer* slots_buffer() {
@@ -692,7 +757,7 @@ class MemoryChunk {
   // Count of bytes marked black on page.
   int live_byte_count_;
   SlotsBuffer* slots_buffer_;
-  SkipList* skip_list_;
+  ObjectStartBitmap* object_starts_;
   intptr_t write_barrier_counter_;
   // Used by the incremental marker to keep track of the scanning progress in
   // large objects that have a progress bar and are scanned in increments.
@@ -701,7 +766,7 @@ class MemoryChunk {
   // count highest number of bytes ever allocated on the page.
   int high_water_mark_;
 
-  intptr_t parallel_sweeping_;
+  AtomicWord parallel_sweeping_;
 
   // PagedSpace free-list statistics.
   intptr_t available_in_small_free_list_;
@@ -710,6 +775,14 @@ class MemoryChunk {
   intptr_t available_in_huge_free_list_;
   intptr_t non_available_small_blocks_;
 
+  // Used by concurrent sweeping, see ParallelSweepingState.
+  FreeListNode* swept_free_list_;
+  MemoryChunk* next_swept_chunk_;
+
+  // Large fixed arrays that have many pointers to new space record the
+  // slots the mutator writes to in a card table, see StoreBuffer.
+  CardTable* card_table_;
+
   static MemoryChunk* Initialize(Heap* heap,
                                  Address base,
                                  size_t size,
@@ -902,16 +975,18 @@ class Space : public Malloced {
 // displacements.  This happens automatically on 32-bit platforms, where 32-bit
 // displacements cover the entire 4GB virtual address space.  On 64-bit
 // platforms, we support this using the CodeRange object, which reserves and
-// manages a range of virtual memory.
+// manages a range of virtual memory.  The same machinery manages the
+// non-executable heap range of the MemoryAllocator if --heap-range is on.
 class CodeRange {
  public:
-  explicit CodeRange(Isolate* isolate);
+  explicit CodeRange(Isolate* isolate, Executability executable = EXECUTABLE);
   ~CodeRange() { TearDown(); }
 
   // Reserves a range of virtual memory, but does not commit any of it.
+  // The range starts at a multiple of alignment, if one is given.
   // Can only be called once, at heap initialization time.
   // Returns false on failure.
-  bool SetUp(const size_t requested_size);
+  bool SetUp(const size_t requested_size, const size_t alignment = 0);
 
   // Frees the range of virtual memory, and frees the data structures used to
   // manage it.
@@ -934,6 +1009,10 @@ class CodeRange {
   MUST_USE_RESULT Address AllocateRawMemory(const size_t requested_size,
                                             const size_t commit_size,
                                             size_t* allocated);
+  // Allocates exactly size bytes at a multiple of alignment, which must be a
+  // multiple of MemoryChunk::kAlignment.  None of it is committed.
+  MUST_USE_RESULT Address AllocateAlignedRawMemory(const size_t size,
+                                                   const size_t alignment);
   bool CommitRawMemory(Address start, size_t length);
   bool UncommitRawMemory(Address start, size_t length);
   void FreeRawMemory(Address buf, size_t length);
@@ -941,6 +1020,8 @@ class CodeRange {
  private:
   Isolate* isolate_;
 
+  Executability executable_;
+
   // The reserved range of virtual memory that all code objects are put in.
   VirtualMemory* code_range_;
   // Plain old data class, just a struct plus a constructor.
@@ -983,53 +1064,99 @@ class CodeRange {
 };
 
 
-class SkipList {
+// Records where objects start on a code space page, one bit per word, so
+// that the code object containing a pc can be found without walking the
+// page.  Allocation sets the bit of every new object and precise sweeping
+// rebuilds the bitmap from the mark bits, so a set bit always marks the
+// start of an object that still exists.
+class ObjectStartBitmap {
  public:
-  SkipList() {
+  ObjectStartBitmap() {
     Clear();
   }
 
   void Clear() {
-    for (int idx = 0; idx < kSize; idx++) {
-      starts_[idx] = reinterpret_cast<Address>(-1);
-    }
+    memset(cells_, 0, sizeof(cells_));
   }
 
-  Address StartFor(Address addr) {
-    return starts_[RegionNumber(addr)];
+  void AddObject(Address addr) {
+    uint32_t index = IndexOf(addr);
+    cells_[Bitmap::IndexToCell(index)] |=
+        1u << (index & Bitmap::kBitIndexMask);
   }
 
-  void AddObject(Address addr, int size) {
-    int start_region = RegionNumber(addr);
-    int end_region = RegionNumber(addr + size - kPointerSize);
-    for (int idx = start_region; idx <= end_region; idx++) {
-      if (starts_[idx] > addr) starts_[idx] = addr;
+  // Returns the start of the closest recorded object at or below addr, or
+  // NULL if there is none.
+  Address StartFor(Address addr);
+
+  static void Update(Address addr) {
+    Page* page = Page::FromAddress(addr);
+    ObjectStartBitmap* bitmap = page->object_starts();
+    if (bitmap == NULL) {
+      bitmap = new ObjectStartBitmap();
+      page->set_object_starts(bitmap);
     }
+
+    bitmap->AddObject(addr);
   }
 
-  static inline int RegionNumber(Address addr) {
-    return (OffsetFrom(addr) & Page::kPageAlignmentMask) >> kRegionSizeLog2;
+ private:
+  static uint32_t IndexOf(Address addr) {
+    return static_cast<uint32_t>(
+        (OffsetFrom(addr) & Page::kPageAlignmentMask) >> kPointerSizeLog2);
   }
 
-  static void Update(Address addr, int size) {
-    Page* page = Page::FromAddress(addr);
-    SkipList* list = page->skip_list();
-    if (list == NULL) {
-      list = new SkipList();
-      page->set_skip_list(list);
-    }
+  static const int kCellCount = Bitmap::kLength >> Bitmap::kBitsPerCellLog2;
+
+  uint32_t cells_[kCellCount];
+};
+
 
-    list->AddObject(addr, size);
+// Covers the object area of a large fixed array with one byte per card of
+// kCardSize bytes.  A dirty card may contain pointers to new space; the
+// scavenger scans only the dirty cards instead of the whole array.
+class CardTable {
+ public:
+  static const int kCardSizeLog2 = 9;
+  static const int kCardSize = 1 << kCardSizeLog2;
+
+  CardTable(Address start, Address end)
+      : start_(start),
+        length_(static_cast<int>(
+            (end - start + kCardSize - 1) >> kCardSizeLog2)),
+        cards_(NewArray<uint8_t>(length_)) {
+    memset(cards_, 0, length_);
   }
 
- private:
-  static const int kRegionSizeLog2 = 13;
-  static const int kRegionSize = 1 << kRegionSizeLog2;
-  static const int kSize = Page::kPageSize / kRegionSize;
+  ~CardTable() {
+    DeleteArray(cards_);
+  }
 
-  STATIC_ASSERT(Page::kPageSize % kRegionSize == 0);
+  int length() { return length_; }
 
-  Address starts_[kSize];
+  Address CardStart(int card) {
+    return start_ + (static_cast<intptr_t>(card) << kCardSizeLog2);
+  }
+
+  bool IsDirty(int card) { return cards_[card] != 0; }
+
+  void MarkDirty(Address slot) {
+    ASSERT(slot >= start_ && slot < CardStart(length_));
+    cards_[(slot - start_) >> kCardSizeLog2] = 1;
+  }
+
+  void MarkAllDirty() {
+    memset(cards_, 1, length_);
+  }
+
+  void ClearCard(int card) { cards_[card] = 0; }
+
+ private:
+  Address start_;
+  int length_;
+  uint8_t* cards_;
+
+  DISALLOW_COPY_AND_ASSIGN(CardTable);
 };
 
 
@@ -1094,6 +1221,12 @@ class MemoryAllocator {
   Address ReserveAlignedMemory(size_t requested,
                                size_t alignment,
                                VirtualMemory* controller);
+  // Like ReserveAlignedMemory, but takes the memory from the heap range if
+  // there is one.  The controller is then left unreserved and the memory
+  // has to be given back with FreeMemory(Address, ...).
+  Address ReserveAlignedHeapMemory(size_t requested,
+                                   size_t alignment,
+                                   VirtualMemory* controller);
   Address AllocateAlignedMemory(size_t reserve_size,
                                 size_t commit_size,
                                 size_t alignment,
@@ -1103,6 +1236,21 @@ class MemoryAllocator {
   void FreeMemory(VirtualMemory* reservation, Executability executable);
   void FreeMemory(Address addr, size_t size, Executability executable);
 
+  // Number of chunks that were taken from the page pool instead of being
+  // mapped afresh.
+  int pool_hits() { return pool_hits_; }
+
+  // Bytes held by the page pool.
+  intptr_t PoolSize() {
+    return static_cast<intptr_t>(pooled_chunks_.length()) * Page::kPageSize;
+  }
+
+  // Gives the memory of the pooled chunks back to the operating system.
+  void ReleasePooledChunks();
+
+  // The range that holds all non-executable chunks, or NULL.
+  CodeRange* heap_range() { return heap_range_; }
+
   // Commit a contiguous block of memory from the initial chunk.  Assumes that
   // the address is not NULL, the size is greater than zero, and that the
   // block is contained in the initial chunk.  Returns true if it succeeded
@@ -1163,6 +1311,23 @@ class MemoryAllocator {
   // Allocated executable space size in bytes.
   size_t size_executable_;
 
+  // Freed non-executable pages whose memory is still mapped, to be reused by
+  // AllocateChunk before reserving new memory.
+  List<MemoryChunk*> pooled_chunks_;
+  int pool_hits_;
+
+  // Releases the reservations of freed chunks if --concurrent-unmapping.
+  UnmapperThread* unmapper_thread_;
+
+  // A 4GB region aligned to 4GB that the non-executable chunks and the new
+  // space are allocated from if --heap-range.  Their addresses then share
+  // the upper 32 bits, so that a pointer into them fits in a 32-bit offset.
+  CodeRange* heap_range_;
+
+  // Returns true if the freed chunk can be kept in the page pool.
+  bool CanPool(MemoryChunk* chunk);
+  MemoryChunk* AllocatePooledChunk(Executability executable, Space* owner);
+
   struct MemoryAllocationCallbackRegistration {
     MemoryAllocationCallbackRegistration(MemoryAllocationCallback callback,
                                          ObjectSpace space,
@@ -1441,15 +1606,8 @@ class FreeListCategory {
   FreeListCategory() :
       top_(NULL),
       end_(NULL),
-      mutex_(OS::CreateMutex()),
       available_(0) {}
 
-  ~FreeListCategory() {
-    delete mutex_;
-  }
-
-  intptr_t Concatenate(FreeListCategory* category);
-
   void Reset();
 
   void Free(FreeListNode* node, int size_in_bytes);
@@ -1473,8 +1631,6 @@ class FreeListCategory {
   int available() const { return available_; }
   void set_available(int available) { available_ = available; }
 
-  Mutex* mutex() { return mutex_; }
-
 #ifdef DEBUG
   intptr_t SumFreeList();
   int FreeListLength();
@@ -1483,7 +1639,6 @@ class FreeListCategory {
  private:
   FreeListNode* top_;
   FreeListNode* end_;
-  Mutex* mutex_;
 
   // Total available bytes in all blocks of this free list category.
   int available_;
@@ -1517,8 +1672,6 @@ class FreeList BASE_EMBEDDED {
  public:
   explicit FreeList(PagedSpace* owner);
 
-  intptr_t Concatenate(FreeList* free_list);
-
   // Clear the free list.
   void Reset();
 
@@ -1536,6 +1689,11 @@ class FreeList BASE_EMBEDDED {
   // aligned, and the size should be a non-zero multiple of the word size.
   int Free(Address start, int size_in_bytes);
 
+  // Like Free, but places the block on the swept free list of its page.
+  // Used by the sweeper threads, which never touch the free list of the
+  // space; the blocks are moved there when the page is finalized.
+  static int FreeToSweptPage(Heap* heap, Address start, int size_in_bytes);
+
   // Allocate a block of size 'size_in_bytes' from the free list.  The block
   // is unitialized.  A failure is returned if no block is available.  The
   // number of bytes lost to fragmentation is returned in the output parameter
@@ -1628,6 +1786,9 @@ class PagedSpace : public Space {
   // Current capacity without growing (Size() + Available()).
   intptr_t Capacity() { return accounting_stats_.Capacity(); }
 
+  // The capacity the space may grow to.
+  intptr_t MaxCapacity() { return max_capacity_; }
+
   // Total amount of memory committed for this space.  For paged
   // spaces this equals the capacity.
   intptr_t CommittedMemory() { return Capacity(); }
@@ -1798,11 +1959,19 @@ class PagedSpace : public Space {
 
   bool AdvanceSweeper(intptr_t bytes_to_sweep);
 
-  // When parallel sweeper threads are active and the main thread finished
-  // its sweeping phase, this function waits for them to complete, otherwise
-  // AdvanceSweeper with size_in_bytes is called.
+  // When sweeper threads are active this function finalizes the pages they
+  // have swept so far and returns whether they are done, without waiting for
+  // them.  Otherwise AdvanceSweeper with size_in_bytes is called.
   bool EnsureSweeperProgress(intptr_t size_in_bytes);
 
+  // Called by a sweeper thread when it has swept a page.  The page is pushed
+  // on a lock-free stack that only the main thread pops.
+  void AddSweptPage(Page* p);
+
+  // Merges the free blocks of the pages the sweeper threads have swept so far
+  // into the free list of this space.  Returns the number of bytes freed.
+  intptr_t FinalizeSweptPages();
+
   bool IsLazySweepingComplete() {
     return !first_unswept_page_->is_valid();
   }
@@ -1861,6 +2030,10 @@ class PagedSpace : public Space {
   // done conservatively.
   intptr_t unswept_free_bytes_;
 
+  // The pages swept by the sweeper threads that still have to be finalized,
+  // linked through MemoryChunk::next_swept_chunk.
+  AtomicWord swept_pages_;
+
   // Expands the space by allocating a fixed number of pages. Returns false if
   // it cannot allocate requested number of pages from OS, or if the hard heap
   // size limit has been hit.
@@ -1874,7 +2047,6 @@ class PagedSpace : public Space {
   MUST_USE_RESULT virtual HeapObject* SlowAllocateRaw(int size_in_bytes);
 
   friend class PageIterator;
-  friend class SweeperThread;
 };
 
 
@@ -2042,6 +2214,10 @@ class SemiSpace : public Space {
   // semispace and less than the current capacity.
   bool ShrinkTo(int new_capacity);
 
+  // Discards the contents of the pages, which must not hold live objects.
+  // The page headers are kept.
+  void Discard();
+
   // Returns the start address of the first page of the space.
   Address space_start() {
     ASSERT(anchor_.next_page() != &anchor_);
@@ -2293,9 +2469,22 @@ class NewSpace : public Space {
   // their maximum capacity.
   void Grow();
 
+  // Grow the capacity of the semispaces to the given capacity, which must
+  // be page aligned and not above the maximum capacity.
+  void GrowTo(int new_capacity);
+
   // Shrink the capacity of the semispaces.
   void Shrink();
 
+  // Shrink the capacity of the semispaces towards the given capacity.  The
+  // semispaces keep at least their initial capacity and twice the size of
+  // the live objects.
+  void ShrinkTo(int new_capacity);
+
+  // Lets the OS reclaim the physical memory of the from space pages.  They
+  // stay committed and are used again after the next flip.
+  void DiscardFromSpace() { from_space_.Discard(); }
+
   // True if the address or object lies in the address range of either
   // semispace (not necessarily below the allocation pointer).
   bool Contains(Address a) {
@@ -2474,6 +2663,8 @@ class NewSpace : public Space {
     return from_space_.Uncommit();
   }
 
+  bool IsFromSpaceCommitted() { return from_space_.is_committed(); }
+
   inline intptr_t inline_allocation_limit_step() {
     return inline_allocation_limit_step_;
   }
@@ -30,6 +30,7 @@
 #include <algorithm>
 
 #include "v8.h"
+#include "parallel-scavenger.h"
 #include "store-buffer-inl.h"
 #include "v8-counters.h"
 
@@ -53,7 +54,11 @@ StoreBuffer::StoreBuffer(Heap* heap)
       virtual_memory_(NULL),
       hash_set_1_(NULL),
       hash_set_2_(NULL),
-      hash_sets_are_empty_(true) {
+      hash_sets_are_empty_(true),
+      deduplication_in_progress_(false),
+      deduplication_limit_(NULL),
+      deduplication_result_(NULL),
+      length_after_deduplication_(0) {
 }
 
 
@@ -109,6 +114,7 @@ void StoreBuffer::SetUp() {
 
 
 void StoreBuffer::TearDown() {
+  FinishConcurrentDeduplication();
   delete virtual_memory_;
   delete old_virtual_memory_;
   delete[] hash_set_1_;
@@ -120,8 +126,56 @@ void StoreBuffer::TearDown() {
 
 
 void StoreBuffer::StoreBufferOverflow(Isolate* isolate) {
-  isolate->heap()->store_buffer()->Compact();
+  StoreBuffer* store_buffer = isolate->heap()->store_buffer();
+  store_buffer->Compact();
   isolate->counters()->store_buffer_overflows()->Increment();
+  if (FLAG_concurrent_store_buffer_dedup && !store_buffer->during_gc_) {
+    store_buffer->StartConcurrentDeduplication();
+  }
+}
+
+
+void StoreBuffer::StartConcurrentDeduplication() {
+  ParallelScavenger* scavenger = heap_->parallel_scavenger();
+  if (scavenger == NULL || deduplication_in_progress_) return;
+  if (old_buffer_is_sorted_) return;
+  // Wait until the old buffer has grown by a full new buffer.
+  if ((old_top_ - old_start_) - length_after_deduplication_ <
+      kStoreBufferLength) {
+    return;
+  }
+  deduplication_in_progress_ = true;
+  deduplication_limit_ = old_top_;
+  deduplication_result_ = NULL;
+  scavenger->StartStoreBufferDeduplication();
+}
+
+
+void StoreBuffer::Deduplicate() {
+  // Only exact duplicates are removed.  Entries that no longer point to new
+  // space are left alone: the mutator may be storing a new space pointer
+  // into them right now, and the filtering hash sets would then keep the
+  // entry from being added again.
+  std::sort(old_start_, deduplication_limit_);
+  deduplication_result_ = std::unique(old_start_, deduplication_limit_);
+}
+
+
+void StoreBuffer::FinishConcurrentDeduplication() {
+  if (!deduplication_in_progress_) return;
+  heap_->parallel_scavenger()->WaitForStoreBufferDeduplication();
+  deduplication_in_progress_ = false;
+
+  intptr_t appended = old_top_ - deduplication_limit_;
+  if (appended > 0) {
+    memmove(deduplication_result_,
+            deduplication_limit_,
+            appended * sizeof(*old_top_));
+  }
+  old_top_ = deduplication_result_ + appended;
+  old_buffer_is_sorted_ = (appended == 0);
+  length_after_deduplication_ = old_top_ - old_start_;
+  heap_->isolate()->counters()->store_buffer_deduplications()->Increment();
 }
 
 
@@ -160,11 +214,20 @@ void StoreBuffer::EnsureSpace(intptr_t space_needed) {
 
   if (SpaceAvailable(space_needed)) return;
 
+  FinishConcurrentDeduplication();
+  if (SpaceAvailable(space_needed)) return;
+
   if (old_buffer_is_filtered_) return;
   ASSERT(may_move_store_buffer_entries_);
   Compact();
 
   old_buffer_is_filtered_ = true;
+
+  if (HasCardMarkedPages()) {
+    MoveEntriesToCardTables();
+    if (SpaceAvailable(space_needed)) return;
+  }
+
   bool page_has_scan_on_scavenge_flag = false;
 
   PointerChunkIterator it(heap_);
@@ -211,6 +274,7 @@ void StoreBuffer::ExemptPopularPages(int prime_sample_step, int threshold) {
     chunk->set_store_buffer_counter(0);
   }
   bool created_new_scan_on_scavenge_pages = false;
+  bool created_new_card_tables = false;
   MemoryChunk* previous_chunk = NULL;
   for (Address* p = old_start_; p < old_top_; p += prime_sample_step) {
     Address addr = *p;
@@ -222,8 +286,12 @@ void StoreBuffer::ExemptPopularPages(int prime_sample_step, int threshold) {
     }
     int old_counter = containing_chunk->store_buffer_counter();
     if (old_counter == threshold) {
-      containing_chunk->set_scan_on_scavenge(true);
-      created_new_scan_on_scavenge_pages = true;
+      if (EnableCardMarking(containing_chunk)) {
+        created_new_card_tables = true;
+      } else {
+        containing_chunk->set_scan_on_scavenge(true);
+        created_new_scan_on_scavenge_pages = true;
+      }
     }
     containing_chunk->set_store_buffer_counter(old_counter + 1);
     previous_chunk = containing_chunk;
@@ -231,11 +299,70 @@ void StoreBuffer::ExemptPopularPages(int prime_sample_step, int threshold) {
   if (created_new_scan_on_scavenge_pages) {
     Filter(MemoryChunk::SCAN_ON_SCAVENGE);
   }
+  if (created_new_card_tables) {
+    MoveEntriesToCardTables();
+  }
   old_buffer_is_filtered_ = true;
 }
 
 
+bool StoreBuffer::EnableCardMarking(MemoryChunk* chunk) {
+  if (!FLAG_card_marking) return false;
+  // The chunks queued for freeing have fake headers every kPageSize bytes,
+  // see Heap::FreeQueuedChunks.
+  if (chunk->owner() != heap_->lo_space() ||
+      chunk->IsFlagSet(MemoryChunk::ABOUT_TO_BE_FREED)) {
+    return false;
+  }
+  if (chunk->card_table() == NULL) {
+    ASSERT(reinterpret_cast<LargePage*>(chunk)->GetObject()->IsFixedArray());
+    chunk->set_card_table(new CardTable(chunk->area_start(),
+                                        chunk->area_end()));
+  }
+  return true;
+}
+
+
+bool StoreBuffer::HasCardMarkedPages() {
+  for (LargePage* page = heap_->lo_space()->first_page();
+       page != NULL;
+       page = page->next_page()) {
+    if (page->card_table() != NULL) return true;
+  }
+  return false;
+}
+
+
+void StoreBuffer::MoveEntriesToCardTables() {
+  FinishConcurrentDeduplication();
+  Address* new_top = old_start_;
+  MemoryChunk* previous_chunk = NULL;
+  for (Address* p = old_start_; p < old_top_; p++) {
+    Address addr = *p;
+    MemoryChunk* containing_chunk = NULL;
+    if (previous_chunk != NULL && previous_chunk->Contains(addr)) {
+      containing_chunk = previous_chunk;
+    } else {
+      containing_chunk = MemoryChunk::FromAnyPointerAddress(addr);
+      previous_chunk = containing_chunk;
+    }
+    if (containing_chunk->IsFlagSet(MemoryChunk::ABOUT_TO_BE_FREED) ||
+        containing_chunk->card_table() == NULL) {
+      *new_top++ = addr;
+    } else {
+      containing_chunk->card_table()->MarkDirty(addr);
+    }
+  }
+  old_top_ = new_top;
+
+  // Filtering hash sets are inconsistent with the store buffer after this
+  // operation.
+  ClearFilteringHashSets();
+}
+
+
 void StoreBuffer::Filter(int flag) {
+  FinishConcurrentDeduplication();
   Address* new_top = old_start_;
   MemoryChunk* previous_chunk = NULL;
   for (Address* p = old_start_; p < old_top_; p++) {
@@ -260,6 +387,7 @@ void StoreBuffer::Filter(int flag) {
 
 
 void StoreBuffer::SortUniq() {
+  FinishConcurrentDeduplication();
   Compact();
   if (old_buffer_is_sorted_) return;
   std::sort(old_start_, old_top_);
@@ -275,6 +403,17 @@ void StoreBuffer::SortUniq() {
 
 bool StoreBuffer::PrepareForIteration() {
   Compact();
+  // Large fixed arrays that overflowed the store buffer while being scavenged
+  // are scanned through their cards from now on, starting with all of them.
+  for (LargePage* page = heap_->lo_space()->first_page();
+       page != NULL;
+       page = page->next_page()) {
+    if (page->scan_on_scavenge() && EnableCardMarking(page)) {
+      page->set_scan_on_scavenge(false);
+      page->card_table()->MarkAllDirty();
+    }
+  }
+
   PointerChunkIterator it(heap_);
   MemoryChunk* chunk;
   bool page_has_scan_on_scavenge_flag = false;
@@ -286,6 +425,10 @@ bool StoreBuffer::PrepareForIteration() {
     Filter(MemoryChunk::SCAN_ON_SCAVENGE);
   }
 
+  if (HasCardMarkedPages()) {
+    MoveEntriesToCardTables();
+  }
+
   // Filtering hash sets are inconsistent with the store buffer after
   // iteration.
   ClearFilteringHashSets();
@@ -296,6 +439,7 @@ bool StoreBuffer::PrepareForIteration() {
 
 #ifdef DEBUG
 void StoreBuffer::Clean() {
+  FinishConcurrentDeduplication();
   ClearFilteringHashSets();
   Uniq();  // Also removes things that no longer point to new space.
   EnsureSpace(kStoreBufferSize / 2);
@@ -307,6 +451,7 @@ static Address* in_store_buffer_1_element_cache = NULL;
 
 bool StoreBuffer::CellIsInStoreBuffer(Address cell_address) {
   if (!FLAG_enable_slow_asserts) return true;
+  FinishConcurrentDeduplication();
   if (in_store_buffer_1_element_cache != NULL &&
       *in_store_buffer_1_element_cache == cell_address) {
     return true;
@@ -343,6 +488,7 @@ void StoreBuffer::ClearFilteringHashSets() {
 
 
 void StoreBuffer::GCPrologue() {
+  FinishConcurrentDeduplication();
   ClearFilteringHashSets();
   during_gc_ = true;
 }
@@ -392,6 +538,7 @@ void StoreBuffer::VerifyPointers(LargeObjectSpace* space) {
 
 void StoreBuffer::Verify() {
 #ifdef VERIFY_HEAP
+  FinishConcurrentDeduplication();
   VerifyPointers(heap_->old_pointer_space(),
                  &StoreBuffer::FindPointersToNewSpaceInRegion);
   VerifyPointers(heap_->map_space(),
@@ -403,6 +550,7 @@ void StoreBuffer::Verify() {
 
 void StoreBuffer::GCEpilogue() {
   during_gc_ = false;
+  length_after_deduplication_ = old_top_ - old_start_;
 #ifdef VERIFY_HEAP
   if (FLAG_verify_heap) {
     Verify();
@@ -429,6 +577,24 @@ void StoreBuffer::FindPointersToNewSpaceInRegion(
 }
 
 
+bool StoreBuffer::FindPointersToNewSpaceInCard(
+    Address start, Address end, ObjectSlotCallback slot_callback) {
+  bool has_pointers_to_new_space = false;
+  for (Address slot_address = start;
+       slot_address < end;
+       slot_address += kPointerSize) {
+    Object** slot = reinterpret_cast<Object**>(slot_address);
+    if (heap_->InNewSpace(*slot)) {
+      HeapObject* object = reinterpret_cast<HeapObject*>(*slot);
+      ASSERT(object->IsHeapObject());
+      slot_callback(reinterpret_cast<HeapObject**>(slot), object);
+      if (heap_->InNewSpace(*slot)) has_pointers_to_new_space = true;
+    }
+  }
+  return has_pointers_to_new_space;
+}
+
+
 // Compute start address of the first map following given addr.
 static inline Address MapStartAlign(Address addr) {
   Address page = Page::FromAddress(addr)->area_start();
@@ -591,6 +757,7 @@ void StoreBuffer::IteratePointersToNewSpace(ObjectSlotCallback slot_callback) {
   // but we can't simply figure that out from slot address
   // because slot can belong to a large object.
   IteratePointersInStoreBuffer(slot_callback);
+  IteratePointersOnCardMarkedPages(slot_callback);
 
   // We are done scanning all the pointers that were in the store buffer, but
   // there may be some pages marked scan_on_scavenge that have pointers to new
@@ -602,41 +769,147 @@ void StoreBuffer::IteratePointersToNewSpace(ObjectSlotCallback slot_callback) {
   // space left on the page we will keep the pointers in the store buffer and
   // remove the flag from the page.
   if (some_pages_to_scan) {
-    if (callback_ != NULL) {
-      (*callback_)(heap_, NULL, kStoreBufferStartScanningPagesEvent);
+    IteratePointersOnScanOnScavengePages(slot_callback);
+  }
+}
+
+
+void StoreBuffer::IteratePointersOnScanOnScavengePages(
+    ObjectSlotCallback slot_callback) {
+  if (callback_ != NULL) {
+    (*callback_)(heap_, NULL, kStoreBufferStartScanningPagesEvent);
+  }
+  PointerChunkIterator it(heap_);
+  MemoryChunk* chunk;
+  while ((chunk = it.next()) != NULL) {
+    if (chunk->scan_on_scavenge()) {
+      chunk->set_scan_on_scavenge(false);
+      if (callback_ != NULL) {
+        (*callback_)(heap_, chunk, kStoreBufferScanningPageEvent);
+      }
+      if (chunk->owner() == heap_->lo_space()) {
+        LargePage* large_page = reinterpret_cast<LargePage*>(chunk);
+        HeapObject* array = large_page->GetObject();
+        ASSERT(array->IsFixedArray());
+        Address start = array->address();
+        Address end = start + array->Size();
+        FindPointersToNewSpaceInRegion(start, end, slot_callback);
+      } else {
+        Page* page = reinterpret_cast<Page*>(chunk);
+        PagedSpace* owner = reinterpret_cast<PagedSpace*>(page->owner());
+        FindPointersToNewSpaceOnPage(
+            owner,
+            page,
+            (owner == heap_->map_space() ?
+               &StoreBuffer::FindPointersToNewSpaceInMapsRegion :
+               &StoreBuffer::FindPointersToNewSpaceInRegion),
+            slot_callback);
+      }
     }
-    PointerChunkIterator it(heap_);
-    MemoryChunk* chunk;
-    while ((chunk = it.next()) != NULL) {
-      if (chunk->scan_on_scavenge()) {
-        chunk->set_scan_on_scavenge(false);
-        if (callback_ != NULL) {
-          (*callback_)(heap_, chunk, kStoreBufferScanningPageEvent);
-        }
-        if (chunk->owner() == heap_->lo_space()) {
-          LargePage* large_page = reinterpret_cast<LargePage*>(chunk);
-          HeapObject* array = large_page->GetObject();
-          ASSERT(array->IsFixedArray());
-          Address start = array->address();
-          Address end = start + array->Size();
-          FindPointersToNewSpaceInRegion(start, end, slot_callback);
-        } else {
-          Page* page = reinterpret_cast<Page*>(chunk);
-          PagedSpace* owner = reinterpret_cast<PagedSpace*>(page->owner());
-          FindPointersToNewSpaceOnPage(
-              owner,
-              page,
-              (owner == heap_->map_space() ?
-                 &StoreBuffer::FindPointersToNewSpaceInMapsRegion :
-                 &StoreBuffer::FindPointersToNewSpaceInRegion),
-              slot_callback);
-        }
+  }
+  if (callback_ != NULL) {
+    (*callback_)(heap_, NULL, kStoreBufferScanningPageEvent);
+  }
+}
+
+
+void StoreBuffer::IteratePointersOnCardMarkedPages(
+    ObjectSlotCallback slot_callback) {
+  for (LargePage* page = heap_->lo_space()->first_page();
+       page != NULL;
+       page = page->next_page()) {
+    CardTable* cards = page->card_table();
+    if (cards == NULL) continue;
+    // The array may have been trimmed since the card table was made.
+    HeapObject* array = page->GetObject();
+    Address object_end = array->address() + array->Size();
+    for (int card = 0; card < cards->length(); card++) {
+      if (!cards->IsDirty(card)) continue;
+      cards->ClearCard(card);
+      Address start = cards->CardStart(card);
+      if (start >= object_end) continue;
+      Address end = Min(start + CardTable::kCardSize, object_end);
+      if (FindPointersToNewSpaceInCard(start, end, slot_callback)) {
+        cards->MarkDirty(start);
+      }
+    }
+  }
+}
+
+
+void StoreBuffer::IteratePointersToNewSpaceInParallel(
+    ParallelScavenger* scavenger,
+    ObjectSlotCallback slot_callback) {
+  bool some_pages_to_scan = PrepareForIteration();
+
+  List<StoreBufferSlice> slices;
+  for (Address* start = old_start_;
+       start < old_top_;
+       start += kEntriesPerSlice) {
+    StoreBufferSlice slice;
+    slice.entries_start = start;
+    slice.entries_end = Min(start + kEntriesPerSlice, old_top_);
+    slice.region_start = slice.region_end = NULL;
+    slice.chunk = NULL;
+    slice.recorded_slots = 0;
+    slices.Add(slice);
+  }
+
+  // Unlike the pages of the paged spaces, large objects can be scanned
+  // without regard to the linear allocation areas that the scavenging tasks
+  // move.  The slices of one page are adjacent in the list.
+  if (some_pages_to_scan) {
+    for (LargePage* page = heap_->lo_space()->first_page();
+         page != NULL;
+         page = page->next_page()) {
+      if (!page->scan_on_scavenge()) continue;
+      page->set_scan_on_scavenge(false);
+      HeapObject* array = page->GetObject();
+      ASSERT(array->IsFixedArray());
+      Address end = array->address() + array->Size();
+      for (Address start = array->address();
+           start < end;
+           start += kRegionSliceSize) {
+        StoreBufferSlice slice;
+        slice.entries_start = slice.entries_end = NULL;
+        slice.region_start = start;
+        slice.region_end = Min(start + kRegionSliceSize, end);
+        slice.chunk = page;
+        slice.recorded_slots = 0;
+        slices.Add(slice);
       }
     }
-    if (callback_ != NULL) {
-      (*callback_)(heap_, NULL, kStoreBufferScanningPageEvent);
+  }
+
+  // The surviving slots are collected by the tasks and entered again below.
+  old_top_ = old_start_;
+  scavenger->ProcessStoreBuffer(&slices);
+  scavenger->FlushRecordedSlots();
+
+  IteratePointersOnCardMarkedPages(slot_callback);
+
+  if (some_pages_to_scan) {
+    IteratePointersOnScanOnScavengePages(slot_callback);
+  }
+
+  // A large object that still has too many pointers to new space stays
+  // scanned on scavenge, see StoreBufferRebuilder::Callback.
+  bool created_new_scan_on_scavenge_pages = false;
+  int i = 0;
+  while (i < slices.length()) {
+    MemoryChunk* chunk = slices[i].chunk;
+    int recorded_slots = 0;
+    do {
+      recorded_slots += slices[i++].recorded_slots;
+    } while (i < slices.length() && slices[i].chunk == chunk);
+    if (chunk != NULL && recorded_slots >= (old_limit_ - old_top_) >> 2) {
+      chunk->set_scan_on_scavenge(true);
+      created_new_scan_on_scavenge_pages = true;
     }
   }
+  if (created_new_scan_on_scavenge_pages) {
+    Filter(MemoryChunk::SCAN_ON_SCAVENGE);
+  }
 }
 
 
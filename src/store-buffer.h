@@ -37,8 +37,10 @@
 namespace v8 {
 namespace internal {
 
+class MemoryChunk;
 class Page;
 class PagedSpace;
+class ParallelScavenger;
 class StoreBuffer;
 
 typedef void (*ObjectSlotCallback)(HeapObject** from, HeapObject* to);
@@ -46,6 +48,19 @@ typedef void (*ObjectSlotCallback)(HeapObject** from, HeapObject* to);
 typedef void (StoreBuffer::*RegionCallback)(
     Address start, Address end, ObjectSlotCallback slot_callback);
 
+// A part of the old-to-new slots that is processed by one scavenging task:
+// either a run of store buffer entries or, if chunk is not NULL, a range of
+// the slots of a large fixed array that is scanned on scavenge.
+struct StoreBufferSlice {
+  Address* entries_start;
+  Address* entries_end;
+  Address region_start;
+  Address region_end;
+  MemoryChunk* chunk;
+  // The number of slots that still point to new space afterwards.
+  int recorded_slots;
+};
+
 // Used to implement the write barrier by collecting addresses of pointers
 // between spaces.
 class StoreBuffer {
@@ -83,12 +98,32 @@ class StoreBuffer {
   // surviving old-to-new pointers into the store buffer to rebuild it.
   void IteratePointersToNewSpace(ObjectSlotCallback callback);
 
+  // Like IteratePointersToNewSpace, but the store buffer entries and the
+  // large objects that are scanned on scavenge are split into slices that
+  // the tasks of the parallel scavenger process at the same time.  Paged
+  // pages that are scanned on scavenge are still visited with callback.
+  void IteratePointersToNewSpaceInParallel(ParallelScavenger* scavenger,
+                                           ObjectSlotCallback callback);
+
+  // Sorts the old buffer and removes duplicates on a scavenger thread while
+  // the mutator keeps appending to it (--concurrent-store-buffer-dedup).
+  // Called when the store buffer overflows outside of GC.
+  void StartConcurrentDeduplication();
+  // Runs on the scavenger thread.
+  void Deduplicate();
+  // Waits for the scavenger thread and moves the entries that were appended
+  // meanwhile behind the deduplicated ones.  Must be called before anything
+  // but Compact touches the old buffer.
+  void FinishConcurrentDeduplication();
+
   static const int kStoreBufferOverflowBit = 1 << (14 + kPointerSizeLog2);
   static const int kStoreBufferSize = kStoreBufferOverflowBit;
   static const int kStoreBufferLength = kStoreBufferSize / sizeof(Address);
   static const int kOldStoreBufferLength = kStoreBufferLength * 16;
   static const int kHashSetLengthLog2 = 12;
   static const int kHashSetLength = 1 << kHashSetLengthLog2;
+  static const int kEntriesPerSlice = 2 * KB;
+  static const int kRegionSliceSize = 16 * KB;
 
   void Compact();
 
@@ -158,16 +193,38 @@ class StoreBuffer {
   uintptr_t* hash_set_2_;
   bool hash_sets_are_empty_;
 
+  // The old buffer up to deduplication_limit_ belongs to the scavenger
+  // thread while deduplication_in_progress_.  It leaves the end of the
+  // deduplicated entries in deduplication_result_.
+  bool deduplication_in_progress_;
+  Address* deduplication_limit_;
+  Address* deduplication_result_;
+  // The length of the old buffer after the last deduplication.
+  intptr_t length_after_deduplication_;
+
   void ClearFilteringHashSets();
 
   bool SpaceAvailable(intptr_t space_needed);
   void Uniq();
   void ExemptPopularPages(int prime_sample_step, int threshold);
 
+  // Gives chunk a card table if it holds a large fixed array.  Returns false
+  // if the chunk has to be scanned on scavenge instead.
+  bool EnableCardMarking(MemoryChunk* chunk);
+  bool HasCardMarkedPages();
+  // Removes the entries for chunks with a card table from the old buffer and
+  // marks their cards dirty instead.
+  void MoveEntriesToCardTables();
+
   void FindPointersToNewSpaceInRegion(Address start,
                                       Address end,
                                       ObjectSlotCallback slot_callback);
 
+  // Returns true if pointers to new space are left in the card.
+  bool FindPointersToNewSpaceInCard(Address start,
+                                    Address end,
+                                    ObjectSlotCallback slot_callback);
+
   // For each region of pointers on a page in use from an old space call
   // visit_pointer_region callback.
   // If either visit_pointer_region or callback can cause an allocation
@@ -197,6 +254,13 @@ class StoreBuffer {
 
   void IteratePointersInStoreBuffer(ObjectSlotCallback slot_callback);
 
+  // Visits the pages marked scan_on_scavenge and clears the mark.
+  void IteratePointersOnScanOnScavengePages(ObjectSlotCallback slot_callback);
+
+  // Visits the dirty cards of the large fixed arrays that have a card table.
+  // The cards that still point to new space afterwards stay dirty.
+  void IteratePointersOnCardMarkedPages(ObjectSlotCallback slot_callback);
+
 #ifdef VERIFY_HEAP
   void VerifyPointers(PagedSpace* space, RegionCallback region_callback);
   void VerifyPointers(LargeObjectSpace* space);
@@ -30,6 +30,7 @@
 #include "v8.h"
 
 #include "isolate.h"
+#include "parallel-evacuator.h"
 #include "v8threads.h"
 
 namespace v8 {
@@ -37,7 +38,7 @@ namespace internal {
 
 static const int kSweeperThreadStackSize = 64 * KB;
 
-SweeperThread::SweeperThread(Isolate* isolate)
+SweeperThread::SweeperThread(Isolate* isolate, int id)
      : Thread(Thread::Options("v8:SweeperThread", kSweeperThreadStackSize)),
        isolate_(isolate),
        heap_(isolate->heap()),
@@ -45,12 +46,9 @@ SweeperThread::SweeperThread(Isolate* isolate)
        start_sweeping_semaphore_(OS::CreateSemaphore(0)),
        end_sweeping_semaphore_(OS::CreateSemaphore(0)),
        stop_semaphore_(OS::CreateSemaphore(0)),
-       free_list_old_data_space_(heap_->paged_space(OLD_DATA_SPACE)),
-       free_list_old_pointer_space_(heap_->paged_space(OLD_POINTER_SPACE)),
-       private_free_list_old_data_space_(heap_->paged_space(OLD_DATA_SPACE)),
-       private_free_list_old_pointer_space_(
-           heap_->paged_space(OLD_POINTER_SPACE)) {
+       id_(id) {
   NoBarrier_Store(&stop_thread_, static_cast<AtomicWord>(false));
+  NoBarrier_Store(&evacuating_, static_cast<AtomicWord>(false));
 }
 
 
@@ -68,24 +66,19 @@ void SweeperThread::Run() {
       return;
     }
 
-    collector_->SweepInParallel(heap_->old_data_space(),
-                                &private_free_list_old_data_space_,
-                                &free_list_old_data_space_);
-    collector_->SweepInParallel(heap_->old_pointer_space(),
-                                &private_free_list_old_pointer_space_,
-                                &free_list_old_pointer_space_);
-    end_sweeping_semaphore_->Signal();
-  }
-}
-
+    if (Acquire_Load(&evacuating_)) {
+      heap_->parallel_evacuator()->ProcessInParallel(id_);
+      Release_Store(&evacuating_, static_cast<AtomicWord>(false));
+      end_sweeping_semaphore_->Signal();
+      continue;
+    }
 
-intptr_t SweeperThread::StealMemory(PagedSpace* space) {
-  if (space->identity() == OLD_POINTER_SPACE) {
-    return space->free_list()->Concatenate(&free_list_old_pointer_space_);
-  } else if (space->identity() == OLD_DATA_SPACE) {
-    return space->free_list()->Concatenate(&free_list_old_data_space_);
+    // The old pointer space goes first, a scavenge has to wait for it.
+    collector_->SweepInParallel(heap_->old_pointer_space());
+    collector_->SweepInParallel(heap_->old_data_space());
+    collector_->SweeperThreadDone();
+    end_sweeping_semaphore_->Signal();
   }
-  return 0;
 }
 
 
@@ -102,6 +95,12 @@ void SweeperThread::StartSweeping() {
 }
 
 
+void SweeperThread::StartEvacuating() {
+  Release_Store(&evacuating_, static_cast<AtomicWord>(true));
+  start_sweeping_semaphore_->Signal();
+}
+
+
 void SweeperThread::WaitForSweeperThread() {
   end_sweeping_semaphore_->Wait();
 }
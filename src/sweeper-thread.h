@@ -42,13 +42,17 @@ namespace internal {
 
 class SweeperThread : public Thread {
  public:
-  explicit SweeperThread(Isolate* isolate);
+  // id is the index of the evacuation task run by this thread, the main
+  // thread runs task 0.
+  SweeperThread(Isolate* isolate, int id);
 
   void Run();
   void Stop();
   void StartSweeping();
+  // Takes part in the parallel evacuation of the candidate pages instead of
+  // sweeping.  Also finished by WaitForSweeperThread.
+  void StartEvacuating();
   void WaitForSweeperThread();
-  intptr_t StealMemory(PagedSpace* space);
 
   ~SweeperThread() {
     delete start_sweeping_semaphore_;
@@ -63,11 +67,9 @@ class SweeperThread : public Thread {
   Semaphore* start_sweeping_semaphore_;
   Semaphore* end_sweeping_semaphore_;
   Semaphore* stop_semaphore_;
-  FreeList free_list_old_data_space_;
-  FreeList free_list_old_pointer_space_;
-  FreeList private_free_list_old_data_space_;
-  FreeList private_free_list_old_pointer_space_;
   volatile AtomicWord stop_thread_;
+  volatile AtomicWord evacuating_;
+  int id_;
 };
 
 } }  // namespace v8::internal
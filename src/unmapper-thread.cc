@@ -0,0 +1,86 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "unmapper-thread.h"
+
+#include "v8.h"
+
+namespace v8 {
+namespace internal {
+
+static const int kUnmapperThreadStackSize = 32 * KB;
+
+UnmapperThread::UnmapperThread()
+     : Thread(Thread::Options("v8:UnmapperThread", kUnmapperThreadStackSize)),
+       mutex_(OS::CreateMutex()),
+       pending_semaphore_(OS::CreateSemaphore(0)) {
+  NoBarrier_Store(&stop_thread_, static_cast<AtomicWord>(false));
+}
+
+
+void UnmapperThread::Run() {
+  while (true) {
+    pending_semaphore_->Wait();
+
+    Region region;
+    {
+      ScopedLock lock(mutex_);
+      if (regions_.is_empty()) {
+        // Only the signal of Stop is left once the queue is drained.
+        ASSERT(Acquire_Load(&stop_thread_));
+        return;
+      }
+      region = regions_.RemoveLast();
+    }
+    bool result = VirtualMemory::ReleaseRegion(region.address, region.size);
+    USE(result);
+    ASSERT(result);
+  }
+}
+
+
+void UnmapperThread::Stop() {
+  Release_Store(&stop_thread_, static_cast<AtomicWord>(true));
+  pending_semaphore_->Signal();
+  Join();
+}
+
+
+void UnmapperThread::Unmap(VirtualMemory* reservation) {
+  ASSERT(reservation->IsReserved());
+  Region region;
+  region.address = reservation->address();
+  region.size = reservation->size();
+  reservation->Reset();
+  {
+    ScopedLock lock(mutex_);
+    regions_.Add(region);
+  }
+  pending_semaphore_->Signal();
+}
+
+} }  // namespace v8::internal
@@ -0,0 +1,70 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_UNMAPPER_THREAD_H_
+#define V8_UNMAPPER_THREAD_H_
+
+#include "atomicops.h"
+#include "list.h"
+#include "platform.h"
+
+namespace v8 {
+namespace internal {
+
+// Releases the reservations of freed memory chunks in the background, so
+// that the munmap calls are not part of the GC pause.
+class UnmapperThread : public Thread {
+ public:
+  UnmapperThread();
+
+  void Run();
+  // Releases the regions still queued and ends the thread.
+  void Stop();
+  // Takes over the reservation and queues it for release.
+  void Unmap(VirtualMemory* reservation);
+
+  ~UnmapperThread() {
+    delete pending_semaphore_;
+    delete mutex_;
+  }
+
+ private:
+  struct Region {
+    void* address;
+    size_t size;
+  };
+
+  Mutex* mutex_;
+  // Signaled once for every queued region and once by Stop.
+  Semaphore* pending_semaphore_;
+  List<Region> regions_;
+  volatile AtomicWord stop_thread_;
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_UNMAPPER_THREAD_H_
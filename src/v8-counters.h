@@ -140,7 +140,8 @@ namespace internal {
   SC(pc_to_code_cached, V8.PcToCodeCached)                            \
   /* The store-buffer implementation of the write barrier. */         \
   SC(store_buffer_compactions, V8.StoreBufferCompactions)             \
-  SC(store_buffer_overflows, V8.StoreBufferOverflows)
+  SC(store_buffer_overflows, V8.StoreBufferOverflows)                 \
+  SC(store_buffer_deduplications, V8.StoreBufferDeduplications)
 
 
 #define STATS_COUNTER_LIST_2(SC)                                      \
@@ -241,6 +242,9 @@ namespace internal {
   SC(soft_deopts_requested, V8.SoftDeoptsRequested)                   \
   SC(soft_deopts_inserted, V8.SoftDeoptsInserted)                     \
   SC(soft_deopts_executed, V8.SoftDeoptsExecuted)                     \
+  SC(opt_deopt_cycles, V8.OptDeoptCycles)                             \
+  SC(deopt_loops, V8.DeoptLoops)                                      \
+  SC(deopts_on_map_change, V8.DeoptsOnMapChange)                      \
   SC(new_space_bytes_available, V8.MemoryNewSpaceBytesAvailable)      \
   SC(new_space_bytes_committed, V8.MemoryNewSpaceBytesCommitted)      \
   SC(new_space_bytes_used, V8.MemoryNewSpaceBytesUsed)                \
@@ -197,6 +197,12 @@ bool V8::IdleNotification(int hint) {
 }
 
 
+bool V8::IdleNotificationDeadline(int idle_time_in_ms) {
+  if (!FLAG_use_idle_notification) return true;
+  return HEAP->IdleNotificationDeadline(idle_time_in_ms);
+}
+
+
 void V8::AddCallCompletedCallback(CallCompletedCallback callback) {
   if (call_completed_callbacks_ == NULL) {  // Lazy init.
     call_completed_callbacks_ = new List<CallCompletedCallback>();
@@ -289,20 +295,43 @@ void V8::InitializeOncePerProcessImpl() {
   } else if (!FLAG_concurrent_sweeping && !FLAG_parallel_sweeping) {
     FLAG_sweeper_threads = 0;
   }
+  if (FLAG_sweeper_threads == 0) FLAG_parallel_compaction = false;
+
+#if !V8_TARGET_ARCH_IA32 && !V8_TARGET_ARCH_X64
+  // Concurrent marking relies on the stores of generated code becoming
+  // visible in program order.
+  FLAG_concurrent_marking = false;
+#endif
 
-  if (FLAG_parallel_marking) {
+  if (FLAG_parallel_marking || FLAG_concurrent_marking) {
     if (FLAG_marking_threads <= 0) {
       FLAG_marking_threads = SystemThreadManager::
           NumberOfParallelSystemThreads(
-              SystemThreadManager::PARALLEL_MARKING);
+              FLAG_concurrent_marking
+                  ? SystemThreadManager::CONCURRENT_MARKING
+                  : SystemThreadManager::PARALLEL_MARKING);
     }
     if (FLAG_marking_threads == 0) {
       FLAG_parallel_marking = false;
+      FLAG_concurrent_marking = false;
     }
   } else {
     FLAG_marking_threads = 0;
   }
 
+  if (FLAG_parallel_scavenge) {
+    if (FLAG_scavenger_threads <= 0) {
+      FLAG_scavenger_threads = SystemThreadManager::
+          NumberOfParallelSystemThreads(
+              SystemThreadManager::PARALLEL_SCAVENGING);
+    }
+    if (FLAG_scavenger_threads == 0) {
+      FLAG_parallel_scavenge = false;
+    }
+  } else {
+    FLAG_scavenger_threads = 0;
+  }
+
   if (FLAG_parallel_recompilation &&
       SystemThreadManager::NumberOfParallelSystemThreads(
           SystemThreadManager::PARALLEL_RECOMPILATION) == 0) {
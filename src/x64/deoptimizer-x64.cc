@@ -100,6 +100,28 @@ void Deoptimizer::DeoptimizeFunctionWithPreparedFunctionList(
   node->set_next(data->deoptimizing_code_list_);
   data->deoptimizing_code_list_ = node;
 
+  // Log the action before the code submitted for GC
+  if ( FLAG_trace_internals || FLAG_trace_deopt_loops ) {
+	// Generate deopt events for all functions on the code list
+	SharedFunctionInfo* shared = function->shared();
+	Code* new_code = shared->code();
+	Object* undefined = function->GetHeap()->undefined_value();
+	Object* current = function;
+
+	while (current != undefined) {
+	  JSFunction* func = JSFunction::cast(current);
+	  current = func->next_function_link();
+	  LOG_OPT_EVENT(isolate,
+		EmitFunctionEvent(
+		  Logger::ForceDeopt,
+		  func,
+		  new_code,
+		  shared, code
+		)
+	  );
+	}
+  }
+
   // We might be in the middle of incremental marking with compaction.
   // Tell collector to treat this code object in a special way and
   // ignore all slots that might have been recorded on it.
@@ -258,6 +258,8 @@
         '../../src/compilation-cache.h',
         '../../src/compiler.cc',
         '../../src/compiler.h',
+        '../../src/concurrent-marking.cc',
+        '../../src/concurrent-marking.h',
         '../../src/contexts.cc',
         '../../src/contexts.h',
         '../../src/conversions-inl.h',
@@ -280,6 +282,8 @@
         '../../src/debug-agent.h',
         '../../src/debug.cc',
         '../../src/debug.h',
+        '../../src/deopt-loop-detector.cc',
+        '../../src/deopt-loop-detector.h',
         '../../src/deoptimizer.cc',
         '../../src/deoptimizer.h',
         '../../src/disasm.h',
@@ -318,6 +322,8 @@
         '../../src/full-codegen.h',
         '../../src/func-name-inferrer.cc',
         '../../src/func-name-inferrer.h',
+        '../../src/gc-idle-time-handler.cc',
+        '../../src/gc-idle-time-handler.h',
         '../../src/gdb-jit.cc',
         '../../src/gdb-jit.h',
         '../../src/global-handles.cc',
@@ -343,10 +349,14 @@
         '../../src/hydrogen-instructions.h',
         '../../src/hydrogen.cc',
         '../../src/hydrogen.h',
+        '../../src/hydrogen-check-elimination.cc',
+        '../../src/hydrogen-check-elimination.h',
         '../../src/hydrogen-gvn.cc',
         '../../src/hydrogen-gvn.h',
         '../../src/hydrogen-infer-representation.cc',
         '../../src/hydrogen-infer-representation.h',
+        '../../src/hydrogen-load-elimination.cc',
+        '../../src/hydrogen-load-elimination.h',
         '../../src/hydrogen-uint32-analysis.cc',
         '../../src/hydrogen-uint32-analysis.h',
         '../../src/hydrogen-osr.cc',
@@ -377,7 +387,11 @@
         '../../src/lithium.h',
         '../../src/liveedit.cc',
         '../../src/liveedit.h',
+        '../../src/log-aggregator.cc',
+        '../../src/log-aggregator.h',
         '../../src/log-inl.h',
+        '../../src/log-internals.cc',
+        '../../src/log-internals.h',
         '../../src/log-utils.cc',
         '../../src/log-utils.h',
         '../../src/log.cc',
@@ -387,6 +401,8 @@
         '../../src/mark-compact.h',
         '../../src/marking-thread.h',
         '../../src/marking-thread.cc',
+        '../../src/memory-reducer.cc',
+        '../../src/memory-reducer.h',
         '../../src/messages.cc',
         '../../src/messages.h',
         '../../src/natives.h',
@@ -401,6 +417,10 @@
         '../../src/once.h',
         '../../src/optimizing-compiler-thread.h',
         '../../src/optimizing-compiler-thread.cc',
+        '../../src/parallel-evacuator.cc',
+        '../../src/parallel-evacuator.h',
+        '../../src/parallel-scavenger.cc',
+        '../../src/parallel-scavenger.h',
         '../../src/parser.cc',
         '../../src/parser.h',
         '../../src/platform-posix.h',
@@ -444,6 +464,8 @@
         '../../src/scanner-character-streams.h',
         '../../src/scanner.cc',
         '../../src/scanner.h',
+        '../../src/scavenger-thread.cc',
+        '../../src/scavenger-thread.h',
         '../../src/scopeinfo.cc',
         '../../src/scopeinfo.h',
         '../../src/scopes.cc',
@@ -486,6 +508,8 @@
         '../../src/unicode-inl.h',
         '../../src/unicode.cc',
         '../../src/unicode.h',
+        '../../src/unmapper-thread.cc',
+        '../../src/unmapper-thread.h',
         '../../src/uri.h',
         '../../src/utils-inl.h',
         '../../src/utils.cc',
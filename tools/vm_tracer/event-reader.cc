@@ -0,0 +1,250 @@
+// Decoding the events logged by V8 --trace-internals
+
+#include <cstring>
+#include <cctype>
+#include "event-reader.hh"
+
+
+EventReader*
+EventReader::open(const char* log_file)
+{
+  FILE* file = fopen( log_file, "rb" );
+  if ( file == NULL ) return NULL;
+
+  // A binary log starts with "JSWB", version and pointer size
+  char header[6];
+  bool binary = false;
+  if ( fread(header, 1, sizeof(header), file) == sizeof(header) &&
+       memcmp(header, BinaryEventReader::kMagic, 4) == 0 ) {
+    if ( header[4] != BinaryEventReader::kVersion ) {
+      fprintf( stderr, "Unsupported binary log version %d\n", header[4] );
+      fclose(file);
+      return NULL;
+    }
+    binary = true;
+  }
+  else {
+    rewind(file);
+  }
+
+  // The file is read ahead on another thread while the events are handled
+  LogStream* stream = new LogStream(file);
+  if ( !stream->start() ) {
+    fprintf( stderr, "Cannot start the log reader thread\n" );
+    delete stream;
+    return NULL;
+  }
+
+  if ( binary )
+    return new BinaryEventReader(stream);
+  return new TextEventReader(stream);
+}
+
+
+// ---------------Text log-------------------
+TextEventReader::TextEventReader(LogStream* s)
+  : stream(s)
+{
+}
+
+
+TextEventReader::~TextEventReader()
+{
+  delete stream;
+}
+
+
+bool
+TextEventReader::read_number(int base, int* value)
+{
+  int c;
+  while ( (c = stream->peek()) != EOF && isspace(c) )
+    stream->get();
+
+  bool negative = false;
+  if ( c == '-' || c == '+' ) {
+    negative = (c == '-');
+    stream->get();
+    c = stream->peek();
+  }
+
+  // Wraps around like the conversion of fscanf
+  unsigned int result = 0;
+  int digits = 0;
+  while ( c != EOF ) {
+    int d;
+    if ( c >= '0' && c <= '9' ) d = c - '0';
+    else if ( base == 16 && c >= 'a' && c <= 'f' ) d = c - 'a' + 10;
+    else if ( base == 16 && c >= 'A' && c <= 'F' ) d = c - 'A' + 10;
+    else break;
+
+    result = result * base + d;
+    digits++;
+    stream->get();
+    c = stream->peek();
+  }
+
+  if ( digits == 0 ) return false;
+  *value = negative ? -(int)result : (int)result;
+  return true;
+}
+
+
+bool
+TextEventReader::next_event(int* event)
+{
+  return read_number(10, event);
+}
+
+
+int
+TextEventReader::read_int()
+{
+  int value = 0;
+  read_number(10, &value);
+  return value;
+}
+
+
+int
+TextEventReader::read_addr()
+{
+  int value = 0;
+  read_number(16, &value);
+  return value;
+}
+
+
+void
+TextEventReader::read_str(char* buf, int size)
+{
+  // Strings are always the last field of a line
+  int c;
+  while ( (c = stream->peek()) != EOF && isspace(c) )
+    stream->get();
+
+  int len = 0;
+  while ( len < size - 1 &&
+	  (c = stream->peek()) != EOF && c != '\t' && c != '\n' ) {
+    buf[len++] = c;
+    stream->get();
+  }
+  buf[len] = '\0';
+}
+
+
+// ---------------Binary log-------------------
+const char BinaryEventReader::kMagic[] = { 'J', 'S', 'W', 'B' };
+
+
+BinaryEventReader::BinaryEventReader(LogStream* s)
+  : stream(s),
+    remaining(0)
+{
+}
+
+
+BinaryEventReader::~BinaryEventReader()
+{
+  delete stream;
+}
+
+
+bool
+BinaryEventReader::read_varint(unsigned long long* value, bool in_record)
+{
+  unsigned long long result = 0;
+  int shift = 0;
+  int c;
+
+  do {
+    if ( in_record && remaining <= 0 ) return false;
+    c = stream->get();
+    if ( c == EOF ) return false;
+    if ( in_record ) remaining--;
+    result |= (unsigned long long)(c & 0x7f) << shift;
+    shift += 7;
+  } while ( c & 0x80 );
+
+  *value = result;
+  return true;
+}
+
+
+bool
+BinaryEventReader::read_string_record()
+{
+  unsigned long long id, len;
+  if ( !read_varint(&id, false) || !read_varint(&len, false) )
+    return false;
+
+  string s(len, '\0');
+  if ( len > 0 && stream->read(&s[0], len) != (int)len )
+    return false;
+
+  if ( id >= strings.size() ) strings.resize(id + 1);
+  strings[id] = s;
+  return true;
+}
+
+
+bool
+BinaryEventReader::next_event(int* event)
+{
+  // Skip the fields the last handler did not consume
+  while ( remaining > 0 ) {
+    if ( stream->get() == EOF ) return false;
+    remaining--;
+  }
+
+  while ( true ) {
+    int c = stream->get();
+    if ( c == EOF ) return false;
+
+    if ( c == kStringRecord ) {
+      if ( !read_string_record() ) return false;
+      continue;
+    }
+
+    unsigned long long len;
+    if ( !read_varint(&len, false) ) return false;
+    remaining = (long)len;
+    *event = c;
+    return true;
+  }
+}
+
+
+int
+BinaryEventReader::read_int()
+{
+  unsigned long long value;
+  if ( !read_varint(&value) ) return 0;
+
+  // Zigzag decoding
+  unsigned int zz = (unsigned int)value;
+  return (int)(zz >> 1) ^ -(int)(zz & 1);
+}
+
+
+int
+BinaryEventReader::read_addr()
+{
+  unsigned long long value;
+  if ( !read_varint(&value) ) return 0;
+
+  // Same truncation as the %x of the text log
+  return (int)value;
+}
+
+
+void
+BinaryEventReader::read_str(char* buf, int size)
+{
+  unsigned long long id;
+  buf[0] = '\0';
+  if ( !read_varint(&id) || id >= strings.size() ) return;
+
+  strncpy( buf, strings[id].c_str(), size - 1 );
+  buf[size - 1] = '\0';
+}
@@ -0,0 +1,88 @@
+// Decoding the events logged by V8 --trace-internals
+// Both the text log and the compact binary log (--trace-internals-binary)
+// are read through the same interface.
+
+#ifndef EVENT_READER_H
+#define EVENT_READER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "log-stream.hh"
+
+using std::string;
+using std::vector;
+
+
+class EventReader
+{
+ public:
+  virtual ~EventReader() { }
+
+  // Move to the next event, return false at the end of the log
+  virtual bool next_event(int* event) = 0;
+
+  // Fields of the current event, in the order V8 emits them
+  virtual int read_int() = 0;
+  virtual int read_addr() = 0;
+  // Copy the next string field to buf, at most size bytes including '\0'
+  virtual void read_str(char* buf, int size) = 0;
+
+ public:
+  // Open the log file and pick the decoder by looking at its header
+  static EventReader* open(const char* log_file);
+};
+
+
+class TextEventReader : public EventReader
+{
+ public:
+  TextEventReader(LogStream*);
+  ~TextEventReader();
+
+  bool next_event(int*);
+  int read_int();
+  int read_addr();
+  void read_str(char*, int);
+
+ private:
+  // Same as fscanf " %d" and " %x", false when there is no number
+  bool read_number(int base, int* value);
+
+ private:
+  LogStream* stream;
+};
+
+
+// See src/log-internals.h for the layout of the binary log
+class BinaryEventReader : public EventReader
+{
+ public:
+  static const char kMagic[];
+  static const int kVersion = 1;
+  static const int kStringRecord = 0xff;
+
+ public:
+  BinaryEventReader(LogStream*);
+  ~BinaryEventReader();
+
+  bool next_event(int*);
+  int read_int();
+  int read_addr();
+  void read_str(char*, int);
+
+ private:
+  // Read a varint, decrementing remaining when it is part of a record
+  bool read_varint(unsigned long long*, bool in_record = true);
+  bool read_string_record();
+
+ private:
+  LogStream* stream;
+  // Unread bytes of the current record
+  long remaining;
+  // Strings defined so far, indexed by id
+  vector<string> strings;
+};
+
+
+#endif
@@ -52,6 +52,8 @@
   V(GCMoveShared,         gc_move_shared, "GCMoveShared")		\
   V(GCMoveMap,            gc_move_map,  "GCMoveMap")			\
   V(NotifyStackDeoptAll, notify_stack_deopt_all,  "StackDeoptAll")	\
-  V(SetCheckpoint,        set_checkpoint, "SetCheckpoint")  
+  V(SetCheckpoint,        set_checkpoint, "SetCheckpoint")	\
+  V(ForDebug,             for_debug, "ForDebug")		\
+  V(GCMoveRanges,         gc_move_ranges, "GCMoveRanges")
 
 #endif
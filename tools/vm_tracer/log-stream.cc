@@ -0,0 +1,137 @@
+// Streaming the log file through a background reader thread
+
+#include <cstring>
+#include "log-stream.hh"
+
+
+LogStream::LogStream(FILE* f)
+  : file(f),
+    started(false),
+    head(0),
+    count(0),
+    eof(false),
+    stopping(false),
+    current(NULL),
+    pos(NULL),
+    end(NULL)
+{
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&not_empty, NULL);
+  pthread_cond_init(&not_full, NULL);
+
+  for ( int i = 0; i < kMaxBlocks; ++i )
+    blocks[i] = new Block;
+}
+
+
+LogStream::~LogStream()
+{
+  if ( started ) {
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_signal(&not_full);
+    pthread_mutex_unlock(&lock);
+    pthread_join(thread, NULL);
+  }
+
+  for ( int i = 0; i < kMaxBlocks; ++i )
+    delete blocks[i];
+
+  pthread_cond_destroy(&not_full);
+  pthread_cond_destroy(&not_empty);
+  pthread_mutex_destroy(&lock);
+  fclose(file);
+}
+
+
+bool
+LogStream::start()
+{
+  if ( pthread_create(&thread, NULL, reader_main, this) != 0 )
+    return false;
+
+  started = true;
+  return true;
+}
+
+
+void*
+LogStream::reader_main(void* arg)
+{
+  ((LogStream*)arg)->read_blocks();
+  return NULL;
+}
+
+
+void
+LogStream::read_blocks()
+{
+  while ( true ) {
+    pthread_mutex_lock(&lock);
+    while ( count == kMaxBlocks && !stopping )
+      pthread_cond_wait(&not_full, &lock);
+    if ( stopping ) {
+      pthread_mutex_unlock(&lock);
+      return;
+    }
+    // This slot is not visible to the decoder until count grows
+    Block* block = blocks[(head + count) % kMaxBlocks];
+    pthread_mutex_unlock(&lock);
+
+    block->size = fread(block->data, 1, kBlockSize, file);
+
+    pthread_mutex_lock(&lock);
+    if ( block->size > 0 )
+      count++;
+    else
+      eof = true;
+    pthread_cond_signal(&not_empty);
+    pthread_mutex_unlock(&lock);
+
+    if ( block->size == 0 ) return;
+  }
+}
+
+
+bool
+LogStream::next_block()
+{
+  pthread_mutex_lock(&lock);
+
+  if ( current != NULL ) {
+    head = (head + 1) % kMaxBlocks;
+    count--;
+    current = NULL;
+    pthread_cond_signal(&not_full);
+  }
+
+  while ( count == 0 && !eof )
+    pthread_cond_wait(&not_empty, &lock);
+
+  if ( count > 0 ) {
+    current = blocks[head];
+    pos = current->data;
+    end = pos + current->size;
+  }
+
+  pthread_mutex_unlock(&lock);
+  return current != NULL;
+}
+
+
+int
+LogStream::read(char* buf, int n)
+{
+  int copied = 0;
+
+  while ( copied < n ) {
+    if ( pos == end && !next_block() ) break;
+    int len = end - pos;
+    if ( len > n - copied ) len = n - copied;
+    memcpy(buf + copied, pos, len);
+    pos += len;
+    copied += len;
+  }
+
+  return copied;
+}
@@ -0,0 +1,79 @@
+// Streaming the log file through a background reader thread
+// The log is read in fixed size blocks kept in a bounded ring, so the
+// memory used for the input does not depend on the log size.
+
+#ifndef LOG_STREAM_H
+#define LOG_STREAM_H
+
+#include <cstdio>
+#include <pthread.h>
+
+
+class LogStream
+{
+ public:
+  static const int kBlockSize = 1 << 20;
+  // At most this many blocks are read ahead of the decoder
+  static const int kMaxBlocks = 4;
+
+ public:
+  // The stream owns the file and reads it from the current position
+  LogStream(FILE*);
+  ~LogStream();
+
+  // Start the reader thread
+  bool start();
+
+  int get()
+  {
+    if ( pos == end && !next_block() ) return EOF;
+    return (unsigned char)*pos++;
+  }
+
+  int peek()
+  {
+    if ( pos == end && !next_block() ) return EOF;
+    return (unsigned char)*pos;
+  }
+
+  // Copy the next n bytes to buf, return how many were available
+  int read(char* buf, int n);
+
+ private:
+  struct Block
+  {
+    char data[kBlockSize];
+    int size;
+  };
+
+ private:
+  // Give the current block back to the reader and wait for the next one
+  bool next_block();
+
+  static void* reader_main(void*);
+  void read_blocks();
+
+ private:
+  FILE* file;
+  pthread_t thread;
+  bool started;
+
+  pthread_mutex_t lock;
+  pthread_cond_t not_empty;
+  pthread_cond_t not_full;
+
+  // Ring of blocks, [head, head + count) are filled
+  Block* blocks[kMaxBlocks];
+  int head;
+  int count;
+  bool eof;
+  bool stopping;
+
+  // The block being decoded, it stays at the head of the ring
+  Block* current;
+  const char* pos;
+  const char* end;
+};
+
+
+#endif
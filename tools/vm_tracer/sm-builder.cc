@@ -7,6 +7,7 @@
 #include "type-info.hh"
 #include "miner.hh"
 #include "jsweeter_events.h"
+#include "event-reader.hh"
 
 using namespace std;
 
@@ -27,12 +28,12 @@ enum InternalEvent {
 
 
 // Define the events handler prototype
-typedef void (*EventHandler)(FILE*);
+typedef void (*EventHandler)(EventReader*);
 
 
 // Handler declarations
 #define DeclEventHandler(name, handler, desc)	\
-  static void handler(FILE*);
+  static void handler(EventReader*);
 
 OBJECT_EVENTS_LIST(DeclEventHandler)
 FUNCTION_EVENTS_LIST(DeclEventHandler)
@@ -40,7 +41,7 @@ MAP_EVENTS_LIST(DeclEventHandler)
 SYS_EVENTS_LIST(DeclEventHandler)
 
 static void
-null_handler(FILE* file) { }
+null_handler(EventReader* reader) { }
 
 #undef DeclEventHandler
 
@@ -156,16 +157,12 @@ ReplaceSetMapTransition( int context, int o_addr, int old_map_id, int map_id, co
 
 // ---------------Events Handlers------------------
 static void
-create_boilerplate_common(FILE* file, const char* msg)
+create_boilerplate_common(EventReader* reader, const char* msg)
 {
-  int def_function;
-  int o_addr;
-  int map_id;
-  int index;
-
-  fscanf( file, "%x %x %x %d",
-	  &def_function,
-	  &o_addr, &map_id, &index );
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int map_id = reader->read_addr();
+  int index = reader->read_int();
 
   StateMachine::Mtype type = StateMachine::MBoilerplate;
 
@@ -195,36 +192,34 @@ create_boilerplate_common(FILE* file, const char* msg)
 
 
 static void 
-create_obj_boilerplate(FILE* file)
+create_obj_boilerplate(EventReader* reader)
 {
-  create_boilerplate_common(file, events_text[CreateObjBoilerplate]);
+  create_boilerplate_common(reader, events_text[CreateObjBoilerplate]);
 }
 
 
 static void 
-create_array_boilerplate(FILE* file)
+create_array_boilerplate(EventReader* reader)
 {
-  create_boilerplate_common(file, events_text[CreateArrayBoilerplate]);
+  create_boilerplate_common(reader, events_text[CreateArrayBoilerplate]);
 }
 
 
 static void
-create_obj_common(FILE* file, StateMachine::Mtype type, const char* msg)
+create_obj_common(EventReader* reader, StateMachine::Mtype type, const char* msg)
 {
-  int def_function;
-  int o_addr;
-  int alloc_sig;
-  int map_id, code;
+  int code;
   char name_buf[256];
 
-  fscanf( file, "%x %x %x %x",
-	  &def_function, &o_addr, 
-	  &alloc_sig, &map_id);
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int alloc_sig = reader->read_addr();
+  int map_id = reader->read_addr();
   
   if ( type == StateMachine::MFunction )
-    fscanf( file, "%x", &code );
+    code = reader->read_addr();
   
-  fscanf( file, " %[^\t\n]", name_buf );
+  reader->read_str( name_buf, sizeof(name_buf) );
   
   // We lookup the instance first, because some operations may already use this object
   InstanceDescriptor* i_desc = find_instance(o_addr, type, true, false);
@@ -276,49 +271,46 @@ create_obj_common(FILE* file, StateMachine::Mtype type, const char* msg)
 
 
 static void 
-create_object_literal(FILE* file)
+create_object_literal(EventReader* reader)
 {
-  create_obj_common(file, StateMachine::MObject, events_text[CreateObjectLiteral]);
+  create_obj_common(reader, StateMachine::MObject, events_text[CreateObjectLiteral]);
 }
 
 
 static void 
-create_array_literal(FILE* file)
+create_array_literal(EventReader* reader)
 {
-  create_obj_common(file, StateMachine::MObject, events_text[CreateArrayLiteral]);
+  create_obj_common(reader, StateMachine::MObject, events_text[CreateArrayLiteral]);
 }
 
 
 static void 
-create_new_object(FILE* file)
+create_new_object(EventReader* reader)
 {
-  create_obj_common(file, StateMachine::MObject, events_text[CreateNewObject]);
+  create_obj_common(reader, StateMachine::MObject, events_text[CreateNewObject]);
 }
 
 
 static void 
-create_new_array(FILE* file)
+create_new_array(EventReader* reader)
 {
-  create_obj_common(file, StateMachine::MObject, events_text[CreateNewArray]);
+  create_obj_common(reader, StateMachine::MObject, events_text[CreateNewArray]);
 }
 
 
 static void
-create_function(FILE* file)
+create_function(EventReader* reader)
 {
-  create_obj_common(file, StateMachine::MFunction, events_text[CreateFunction]);
+  create_obj_common(reader, StateMachine::MFunction, events_text[CreateFunction]);
 }
 
 
 static void
-copy_object(FILE* file)
+copy_object(EventReader* reader)
 {
-  int def_function;
-  int dst, src;
-
-  fscanf( file, 
-	  "%x %x %x", 
-	  &def_function, &dst, &src);
+  int def_function = reader->read_addr();
+  int dst = reader->read_addr();
+  int src = reader->read_addr();
 
   InstanceDescriptor* src_desc = find_instance(src, StateMachine::MObject);
   if ( src_desc == NULL ) return;
@@ -334,16 +326,13 @@ copy_object(FILE* file)
 
 
 static void
-change_func_prototype(FILE* file)
+change_func_prototype(EventReader* reader)
 {
-  int def_function;
-  int o_addr;
-  int proto;
   char msg[128];
   
-  fscanf( file, "%x %x %x",
-	  &def_function,
-	  &o_addr, &proto );
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int proto = reader->read_addr();
   /*
   sprintf(msg, "%s: %x",
 	  events_text[ChangeFuncPrototype], proto);
@@ -353,19 +342,15 @@ change_func_prototype(FILE* file)
 
 
 static void
-change_obj_prototype(FILE* file)
+change_obj_prototype(EventReader* reader)
 {
-  int def_function;
-  int o_addr;
-  int old_map_id, new_map_id;
-  int proto;
   char msg[128];
 
-  fscanf( file, "%x %x %x %x %x",
-	  &def_function,
-	  &o_addr, 
-	  &old_map_id, &new_map_id, 
-	  &proto );
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int old_map_id = reader->read_addr();
+  int new_map_id = reader->read_addr();
+  int proto = reader->read_addr();
   
   sprintf(msg, "%s: %x",
 	  events_text[ChangeObjPrototype], proto);
@@ -374,15 +359,11 @@ change_obj_prototype(FILE* file)
 
 
 static void
-set_map(FILE* file)
+set_map(EventReader* reader)
 {
-  int def_function;
-  int o_addr;
-  int map_id;
-
-  fscanf( file, "%x %x %x",
-	  &def_function,
-	  &o_addr, &map_id );
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int map_id = reader->read_addr();
   
   InstanceDescriptor* i_desc = lookup_object(o_addr);
   ObjectMachine* osm = (ObjectMachine*)i_desc->sm;
@@ -391,172 +372,136 @@ set_map(FILE* file)
 
 
 static void
-migrate_to_map(FILE* file)
+migrate_to_map(EventReader* reader)
 {
-  int def_function;
-  int o_addr;
-  int old_map_id, map_id;
-
-  fscanf( file, "%x %x %x %x",
-	  &def_function,
-	  &o_addr, 
-	  &old_map_id, &map_id );
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int old_map_id = reader->read_addr();
+  int map_id = reader->read_addr();
   
   SimpleObjectTransition( def_function, o_addr, old_map_id, map_id, events_text[MigrateToMap] );
 }
 
 
 static void
-field_update_common(FILE* file, char* msg)
+field_update_common(EventReader* reader, char* msg, int size)
 {
-  int def_function;
-  int o_addr;
-  int old_map_id, map_id;
-
-  fscanf( file, "%x %x %x %x %[^\t\n]",
-	  &def_function,
-	  &o_addr, 
-	  &old_map_id, &map_id, 
-	  msg + strlen(msg) );
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int old_map_id = reader->read_addr();
+  int map_id = reader->read_addr();
+  int len = strlen(msg);
+  reader->read_str( msg + len, size - len );
   
   ReplaceSetMapTransition( def_function, o_addr, old_map_id, map_id, msg ); 
 }
 
 
 static void
-new_field(FILE* file)
+new_field(EventReader* reader)
 {
   char msg[256];
   sprintf( msg, "%s: ", events_text[NewField]);
-  field_update_common(file, msg);
+  field_update_common(reader, msg, sizeof(msg));
 }
 
 
 static void
-del_field(FILE* file)
+del_field(EventReader* reader)
 {
   char msg[256];
   sprintf( msg, "%s: ", events_text[DelField]);
-  field_update_common(file, msg);
+  field_update_common(reader, msg, sizeof(msg));
 }
 
 
 static void
-update_field(FILE* file)
+update_field(EventReader* reader)
 {
   char msg[256];
   sprintf( msg, "%s: ", events_text[UpdateField]);
-  field_update_common(file, msg);
+  field_update_common(reader, msg, sizeof(msg));
 }
 
 
 static void
-elem_transition(FILE* file)
+elem_transition(EventReader* reader)
 {
-  int def_function;
-  int o_addr;
-  int old_map_id, map_id;
-  int bytes;
-
-  fscanf( file, "%x %x %x %x %d",
-	  &def_function,
-	  &o_addr, 
-	  &old_map_id, &map_id, 
-	  &bytes );
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int old_map_id = reader->read_addr();
+  int map_id = reader->read_addr();
+  int bytes = reader->read_int();
 
   ReplaceSetMapTransition( def_function, o_addr, old_map_id, map_id, events_text[ElemTransition], bytes );
 }
 
 
 static void
-cow_copy(FILE* file)
+cow_copy(EventReader* reader)
 {
-  int def_function;
-  int o_addr;
-  int bytes;
-  
-  fscanf( file, "%x %x %d",
-	  &def_function,
-	  &o_addr, &bytes );
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int bytes = reader->read_int();
 
   ReplaceSetMapTransition( def_function, o_addr, -1, -1, events_text[CowCopy], bytes );
 }
 
 
 static void
-expand_array(FILE* file)
+expand_array(EventReader* reader)
 {
-  int def_function;
-  int o_addr;
-  int bytes;
-  
-  fscanf( file, "%x %x %d",
-	  &def_function,
-	  &o_addr, &bytes );
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int bytes = reader->read_int();
 
   ReplaceSetMapTransition( def_function, o_addr, -1, -1, events_text[ExpandArray], bytes );
 }
 
 
 static void
-elem_to_slow(FILE* file)
+elem_to_slow(EventReader* reader)
 {
-  int def_function;
-  int o_addr;
-  int old_map_id, map_id;
-
-  fscanf( file, "%x %x %x %x",
-	  &def_function,
-	  &o_addr, 
-	  &old_map_id, &map_id );
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int old_map_id = reader->read_addr();
+  int map_id = reader->read_addr();
 
   ReplaceSetMapTransition( def_function, o_addr, old_map_id, map_id, events_text[ElemToSlowMode] );
 }
 
 
 static void
-prop_to_slow(FILE* file)
+prop_to_slow(EventReader* reader)
 {
-  int def_function;
-  int o_addr;
-  int old_map_id, map_id;
-    
-  fscanf( file, "%x %x %x %x",
-	  &def_function,
-	  &o_addr, 
-	  &old_map_id, &map_id);
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int old_map_id = reader->read_addr();
+  int map_id = reader->read_addr();
 
   ReplaceSetMapTransition( def_function, o_addr, old_map_id, map_id, events_text[PropertyToSlowMode]);
 }
 
 
 static void
-elem_to_fast(FILE* file)
+elem_to_fast(EventReader* reader)
 {
-  int def_function;
-  int o_addr;
-  int old_map_id, map_id;
-
-  fscanf( file, "%x %x %x %x",
-	  &def_function,
-	  &o_addr, 
-	  &old_map_id, &map_id );
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int old_map_id = reader->read_addr();
+  int map_id = reader->read_addr();
 
   ReplaceSetMapTransition( def_function, o_addr, old_map_id, map_id, events_text[ElemToFastMode] );
 }
 
 
 static void
-prop_to_fast(FILE* file)
+prop_to_fast(EventReader* reader)
 {
-  int def_function;
-  int o_addr;
-  int old_map_id, map_id;
-    
-  fscanf( file, "%x %x %x %x",
-	  &def_function,
-	  &o_addr, 
-	  &old_map_id, &map_id);
+  int def_function = reader->read_addr();
+  int o_addr = reader->read_addr();
+  int old_map_id = reader->read_addr();
+  int map_id = reader->read_addr();
 
   ReplaceSetMapTransition( def_function, o_addr, old_map_id, map_id, events_text[PropertyToFastMode] );
 }
@@ -575,25 +520,24 @@ SimpleFunctionTransition( int context, int f_addr, int code, const char* msg, in
 
 
 static void
-gen_full_code(FILE* file)
+gen_full_code(EventReader* reader)
 {
-  int f_addr, code;
-  fscanf( file, "%x %x", 
-	  &f_addr, &code );
+  int f_addr = reader->read_addr();
+  int code = reader->read_addr();
   SimpleFunctionTransition( -1, f_addr, code, events_text[GenFullCode] );
 }
 
 
 static void
-gen_opt_code(FILE* file)
+gen_opt_code(EventReader* reader)
 {
-  int f_addr, code;
   char opt_buf[256];
   
   sprintf( opt_buf, "%s: ", events_text[GenOptCode] );
-  fscanf( file, "%x %x %[^\t\n]", 
-	  &f_addr, &code, 
-	  opt_buf + strlen(opt_buf) );
+  int len = strlen(opt_buf);
+  int f_addr = reader->read_addr();
+  int code = reader->read_addr();
+  reader->read_str( opt_buf + len, sizeof(opt_buf) - len );
   
   Transition* trans = SimpleFunctionTransition( -1, f_addr, code, opt_buf );
   State* s = trans->source;
@@ -603,14 +547,15 @@ gen_opt_code(FILE* file)
 
 
 static void
-gen_osr_code(FILE* file)
+gen_osr_code(EventReader* reader)
 {
-  int f_addr, code;
   char opt_buf[256];
 
   sprintf( opt_buf, "%s: ", events_text[GenOsrCode] );
-  fscanf( file, "%x %x %[^\t\n]",
-          &f_addr, &code, opt_buf + strlen(opt_buf) );
+  int len = strlen(opt_buf);
+  int f_addr = reader->read_addr();
+  int code = reader->read_addr();
+  reader->read_str( opt_buf + len, sizeof(opt_buf) - len );
 
   Transition* trans = SimpleFunctionTransition( -1, f_addr, code, opt_buf );
   State* s = trans->source;
@@ -620,22 +565,21 @@ gen_osr_code(FILE* file)
 
 
 static void
-set_code(FILE* file)
+set_code(EventReader* reader)
 {
-  int f_addr, code;
-
-  fscanf( file, "%x %x", &f_addr, &code );
+  int f_addr = reader->read_addr();
+  int code = reader->read_addr();
 }
 
 
 static void
-disable_opt(FILE* file)
+disable_opt(EventReader* reader)
 {
-  int shared, f_addr;
   char opt_buf[256];
 
-  fscanf( file, "%x %x %[^\t\n]",
-          &f_addr, &shared, opt_buf );
+  int f_addr = reader->read_addr();
+  int shared = reader->read_addr();
+  reader->read_str( opt_buf, sizeof(opt_buf) );
 
   StateMachine* sm = find_signature(shared, StateMachine::MFunction);
   if ( sm == NULL ) return;
@@ -645,13 +589,13 @@ disable_opt(FILE* file)
 
 
 static void
-reenable_opt(FILE* file)
+reenable_opt(EventReader* reader)
 {
-  int shared, f_addr;
   char opt_buf[256];
 
-  fscanf( file, "%x %x %[^\t\n]",
-          &f_addr, &shared, opt_buf );
+  int f_addr = reader->read_addr();
+  int shared = reader->read_addr();
+  reader->read_str( opt_buf, sizeof(opt_buf) );
 
   StateMachine* sm = find_signature(shared, StateMachine::MFunction);
   if ( sm == NULL ) return;
@@ -661,17 +605,16 @@ reenable_opt(FILE* file)
 
 
 static void
-opt_failed(FILE* file)
+opt_failed(EventReader* reader)
 {
-  int f_addr, new_code;
   char opt_buf[256];
 
   sprintf( opt_buf, "%s: ", events_text[OptFailed] );
   int last_pos = strlen(opt_buf);
   
-  fscanf( file, "%x %x %[^\t\n]",
-          &f_addr, 
-	  &new_code, opt_buf + last_pos );
+  int f_addr = reader->read_addr();
+  int new_code = reader->read_addr();
+  reader->read_str( opt_buf + last_pos, sizeof(opt_buf) - last_pos );
 
   InstanceDescriptor* i_desc = find_instance(f_addr, StateMachine::MFunction);
   if ( i_desc == NULL ) return;
@@ -714,21 +657,19 @@ do_deopt_common(int context, int f_addr, int old_code, int new_code, const char*
 
 
 static void
-regular_deopt(FILE* file)
+regular_deopt(EventReader* reader)
 {
-  int f_addr;
-  int context;
-  int old_code, new_code;
-  int failed_obj, exp_map_id;
   char deopt_buf[256];
 
   sprintf( deopt_buf, "%s: ", events_text[RegularDeopt] );
-  fscanf( file, "%x %x %x %x %x %x %[^\t\n]",
-	  &f_addr,
-	  &context,
-	  &old_code, &new_code,
-	  &failed_obj, &exp_map_id,
-	  deopt_buf + strlen(deopt_buf) );
+  int len = strlen(deopt_buf);
+  int f_addr = reader->read_addr();
+  int context = reader->read_addr();
+  int old_code = reader->read_addr();
+  int new_code = reader->read_addr();
+  int failed_obj = reader->read_addr();
+  int exp_map_id = reader->read_addr();
+  reader->read_str( deopt_buf + len, sizeof(deopt_buf) - len );
 
   // We first model this transition
   Transition* trans = do_deopt_common( context, f_addr, old_code, new_code, deopt_buf);
@@ -792,34 +733,25 @@ regular_deopt(FILE* file)
 
 
 static void
-deopt_as_inline(FILE* file)
+deopt_as_inline(EventReader* reader)
 {
-  int f_addr;
-  int context;
-  int old_code, new_code;
-  int real_deopt_func;
-
-  fscanf( file, "%x %x %x %x %x",
-	  &f_addr, 
-	  &context,
-	  &old_code, &new_code,
-	  &real_deopt_func );
+  int f_addr = reader->read_addr();
+  int context = reader->read_addr();
+  int old_code = reader->read_addr();
+  int new_code = reader->read_addr();
+  int real_deopt_func = reader->read_addr();
   
   do_deopt_common( context, f_addr, old_code, new_code, events_text[DeoptAsInline] );
 }
 
 
 static void
-force_deopt(FILE* file)
+force_deopt(EventReader* reader)
 {
-  int f_addr;
-  int context;
-  int old_code, new_code;
-
-  fscanf( file, "%x %x %x %x",
-	  &f_addr, 
-	  &context,
-	  &old_code, &new_code );
+  int f_addr = reader->read_addr();
+  int context = reader->read_addr();
+  int old_code = reader->read_addr();
+  int new_code = reader->read_addr();
 
   Transition* trans = do_deopt_common( context, f_addr, old_code, new_code, events_text[ForceDeopt] );
   if ( trans == NULL ) return;
@@ -841,10 +773,9 @@ register_map_notifier(Map* r)
 
 
 static void
-begin_deopt_on_map(FILE* file)
+begin_deopt_on_map(EventReader* reader)
 {
-  int map_id;
-  fscanf( file, "%x", &map_id );
+  int map_id = reader->read_addr();
 
   // Map change can result in code deoptimization
   Map* map_d = find_map(map_id);
@@ -853,10 +784,10 @@ begin_deopt_on_map(FILE* file)
 
 
 static void
-gc_move_object(FILE* file)
+gc_move_object(EventReader* reader)
 {
-  int from, to;
-  fscanf( file, "%x %x", &from, &to );
+  int from = reader->read_addr();
+  int to = reader->read_addr();
   return;
   // Update the specific instance
   for ( int i = StateMachine::MBoilerplate; i <= StateMachine::MFunction; ++i ) {
@@ -887,10 +818,10 @@ gc_move_object(FILE* file)
 
 
 static void
-gc_move_map(FILE* file)
+gc_move_map(EventReader* reader)
 {
-  int old_id, new_id;
-  fscanf( file, "%x %x", &old_id, &new_id );
+  int old_id = reader->read_addr();
+  int new_id = reader->read_addr();
 
   Map* map_d = find_map(old_id);
   if ( map_d == Map::null_map ) return;
@@ -899,10 +830,10 @@ gc_move_map(FILE* file)
 
 
 static void
-gc_move_shared(FILE* file)
+gc_move_shared(EventReader* reader)
 {
-  int from, to;
-  fscanf( file, "%x %x", &from, &to );
+  int from = reader->read_addr();
+  int to = reader->read_addr();
 
   // Update functioin machine
   StateMachine::Mtype type = StateMachine::MFunction;
@@ -923,11 +854,10 @@ gc_move_shared(FILE* file)
 
 
 static void
-gc_move_code(FILE* file)
+gc_move_code(EventReader* reader)
 {
-  int old_code, new_code;
-  fscanf( file, "%x %x", 
-	  &old_code, &new_code );
+  int old_code = reader->read_addr();
+  int new_code = reader->read_addr();
 
   Code* code_d = find_code(old_code);
   if ( code_d == Code::null_code ) return;
@@ -944,15 +874,54 @@ gc_move_code(FILE* file)
 }
 
 
+// Signatures in [from, from + size) have moved to [to, to + size)
+static void
+relocate_signatures(StateMachine::Mtype type, int from, int to, int size)
+{
+  map<int, StateMachine*> &t_mac = machines[type];
+  vector<pair<int, StateMachine*> > moved;
+  map<int, StateMachine*>::iterator it = t_mac.lower_bound(from);
+
+  while ( it != t_mac.end() &&
+	  (unsigned)(it->first - from) < (unsigned)size ) {
+    moved.push_back(*it);
+    t_mac.erase(it++);
+  }
+
+  for ( int i = 0; i < moved.size(); ++i )
+    t_mac[moved[i].first - from + to] = moved[i].second;
+}
+
+
+// The GC moves are batched into ranges of adjacent objects
 static void
-notify_stack_deopt_all(FILE* file)
+gc_move_ranges(EventReader* reader)
+{
+  int count = reader->read_int();
+
+  for ( int i = 0; i < count; ++i ) {
+    int from = reader->read_addr();
+    int to = reader->read_addr();
+    int size = reader->read_int();
+
+    relocate_maps_and_codes(from, to, size);
+
+    // Same signatures as gc_move_shared
+    relocate_signatures(StateMachine::MFunction, from, to, size);
+    relocate_signatures(StateMachine::MObject, from, to, size);
+  }
+}
+
+
+static void
+notify_stack_deopt_all(EventReader* reader)
 {
   sys_result_in_force_deopt("Stack guard tells deoptimization");
 }
 
 
 static void
-set_checkpoint(FILE* file)
+set_checkpoint(EventReader* reader)
 {
   int id;
   char f_buf[256];
@@ -965,6 +934,14 @@ set_checkpoint(FILE* file)
 }
 
 
+static void
+for_debug(EventReader* reader)
+{
+  char msg[256];
+  reader->read_str( msg, sizeof(msg) );
+}
+
+
 // ---------------Public interfaces-------------------
 
 StateMachine* 
@@ -1094,27 +1071,22 @@ sanity_check()
 bool 
 build_automata(const char* log_file)
 {
-  FILE* file;
   int event_type;
   
-  file = fopen( log_file, "r" );
-  if ( file == NULL ) return false;
+  EventReader* reader = EventReader::open( log_file );
+  if ( reader == NULL ) return false;
   
   prepare_machines();
-  int i = 0;
-  while ( fscanf(file, "%d", &event_type) == 1 ) {
-    printf("Before %d: %d, ", i, event_type);
+  while ( reader->next_event(&event_type) ) {
     //printf( "%d\n", event_type );
-    handlers[event_type](file);
+    if ( event_type < 0 || event_type > events_count ) break;
+    handlers[event_type](reader);
     //sanity_check();
-    printf("after %d\n", i);
-    fflush(stdout);
-    ++i;
   }
   
   register_map_notifier(NULL);
   clean_machines();
-  fclose(file);
+  delete reader;
   return true;
 }
 
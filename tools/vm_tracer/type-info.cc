@@ -97,3 +97,31 @@ Code* find_code(int new_code, bool create)
   
   return res;
 }
+
+
+// Collect the entries with keys in [from, from + size)
+template<class T>
+static void
+collect_range(map<int, T*>& table, int from, int size, vector<T*>& res)
+{
+  typename map<int, T*>::iterator it = table.lower_bound(from);
+
+  for ( ; it != table.end() &&
+	  (unsigned)(it->first - from) < (unsigned)size; ++it )
+    res.push_back(it->second);
+}
+
+
+void
+relocate_maps_and_codes(int from, int to, int size)
+{
+  vector<Map*> maps;
+  collect_range(all_maps, from, size, maps);
+  for ( int i = 0; i < maps.size(); ++i )
+    maps[i]->update_map(maps[i]->map_id - from + to);
+
+  vector<Code*> codes;
+  collect_range(all_codes, from, size, codes);
+  for ( int i = 0; i < codes.size(); ++i )
+    codes[i]->update_code(codes[i]->code_id - from + to);
+}
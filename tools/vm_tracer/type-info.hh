@@ -15,5 +15,9 @@ find_map(int new_map, bool create=true);
 Code* 
 find_code(int new_code, bool create=true);
 
+// Maps and codes in [from, from + size) have moved to [to, to + size)
+void
+relocate_maps_and_codes(int from, int to, int size);
+
 
 #endif